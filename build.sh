@@ -0,0 +1,28 @@
+#!/usr/bin/env bash
+set -e
+cd "$(dirname "$0")"
+
+echo "============================"
+echo "        Hikai Build"
+echo "============================"
+
+echo "Building engine..."
+echo "----------------------------"
+./engine/build.sh
+echo "----------------------------"
+
+echo "Building editor..."
+echo "----------------------------"
+./editor/build.sh
+echo "----------------------------"
+
+mkdir -p bin
+
+echo "Copying libhikai.so..."
+cp engine/bin/libhikai.so bin/
+
+echo "Copying editor..."
+cp editor/bin/editor bin/
+
+echo "============================"
+echo "Build successful"
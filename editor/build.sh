@@ -0,0 +1,35 @@
+#!/usr/bin/env bash
+set -e
+cd "$(dirname "$0")"
+
+SOURCE_DIR=src
+BUILD_DIR=build
+OUT_DIR=bin
+
+INCLUDE_DIRS="-Isrc -I../engine/src -I../engine/src/vendor -I../engine/src/hkstl"
+LIBS="-L../engine/bin -lhikai -Wl,-rpath,\$ORIGIN"
+DEFINES="-DHKDEBUG"
+
+EXE_NAME=editor
+
+COMPILER_FLAGS="-std=c++17 -g -Wall -Wextra"
+
+COMPILER=${CXX:-g++}
+
+mkdir -p "$BUILD_DIR" "$OUT_DIR"
+
+find "$SOURCE_DIR" -name "*.cpp" | while read -r source; do
+    object="$BUILD_DIR/$(basename "${source%.cpp}").o"
+
+    if [ ! -f "$object" ]; then
+        echo "Compiling $source"
+    elif [ "$source" -nt "$object" ]; then
+        echo "Recompiling $source"
+    else
+        continue
+    fi
+
+    $COMPILER $DEFINES $COMPILER_FLAGS $INCLUDE_DIRS -c "$source" -o "$object"
+done
+
+$COMPILER -o "$OUT_DIR/$EXE_NAME" "$BUILD_DIR"/*.o $LIBS
@@ -4,6 +4,8 @@
 
 #include "utils/thumbnails.h"
 
+#include <unordered_map>
+
 void AssetBrowser::init()
 {
     is_open_ = true;
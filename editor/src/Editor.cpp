@@ -36,21 +36,27 @@ void Editor::init()
         hkm::fromAxisAngle({0.f, 1.f, 0.f}, 0.f * hkm::degree2rad);
 
     // FIX: temp
-    u32 handle = 0;
-    handle = hk::assets()->load("Rei Plush.fbx");
-    scene_.addModel(handle, { 0.f, .001f, rot });
+    // Imports run on workers in parallel, textures keep streaming after
+    const u32 rei     = hk::assets()->loadAsync("Rei Plush.fbx");
+    const u32 knight  = hk::assets()->loadAsync("Knight_All.fbx");
+    const u32 samurai = hk::assets()->loadAsync("Samurai.fbx");
+    const u32 warrior = hk::assets()->loadAsync("warrior.fbx");
+    const u32 sponza  = hk::assets()->loadAsync("sponza.obj");
 
-    handle = hk::assets()->load("Knight_All.fbx");
-    scene_.addModel(handle, { {1.5f, 0.f, 0.f}, .001f, rot });
+    hk::assets()->wait(rei);
+    scene_.addModel(rei, { 0.f, .001f, rot });
 
-    handle = hk::assets()->load("Samurai.fbx");
-    scene_.addModel(handle, { {-1.5f, 0.f, 0.f}, 1.f, rot });
+    hk::assets()->wait(knight);
+    scene_.addModel(knight, { {1.5f, 0.f, 0.f}, .001f, rot });
 
-    handle = hk::assets()->load("warrior.fbx");
-    scene_.addModel(handle, { {.0f, 0.f, 1.5f}, .001f, rot });
+    hk::assets()->wait(samurai);
+    scene_.addModel(samurai, { {-1.5f, 0.f, 0.f}, 1.f, rot });
 
-    handle = hk::assets()->load("sponza.obj");
-    scene_.addModel(handle, { {.0f, 0.f, .0f}, .01f, rot });
+    hk::assets()->wait(warrior);
+    scene_.addModel(warrior, { {.0f, 0.f, 1.5f}, .001f, rot });
+
+    hk::assets()->wait(sponza);
+    scene_.addModel(sponza, { {.0f, 0.f, .0f}, .01f, rot });
 
     hk::Light light;
     light.type = hk::Light::Type::POINT_LIGHT;
@@ -73,15 +79,11 @@ void Editor::init()
     cam.setPerspective(60.f, aspect, .1f, 1.5f);
     cam.setWorldOffset({ 0.f, 0.5f, -1.5f });
     cam.update();
-    hk::Entity *entity = new hk::Entity();
-    entity->attachCamera(cam);
     hk::SceneNode camera_node;
     camera_node.name = "Camera";
-    camera_node.object = true;
     camera_node.loaded = Transform(cam.viewInv());
-    camera_node.entity = entity;
     camera_node.debug_draw = true;
-    scene_.addNode(camera_node);
+    scene_.addNode(camera_node)->attachCamera(cam);
 }
 
 void Editor::deinit()
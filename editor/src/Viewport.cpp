@@ -99,7 +99,7 @@ void Viewport::showGizmo(hk::SceneNode *selected)
         hkm::mat4f proj = camera_->projection(); proj(1, 1) *= -1;
 
         f32 bounding_size = .0f;
-        hkm::mat4f matrix = selected->world.toMat4f();
+        hkm::mat4f matrix = selected->worldMatrix();
 
         if (ImGuizmo::Manipulate(*camera_->view().n, *proj.n,
                                  gizmo_op_, gizmo_mode_,
@@ -108,11 +108,10 @@ void Viewport::showGizmo(hk::SceneNode *selected)
                                  bounding_size ? &bounding_size : NULL))
         {
             hkm::mat4f parentInv =
-                hkm::inverse(selected->parent->world.toMat4f());
+                hkm::inverse(selected->parent->worldMatrix());
 
             // FIX: ffs, why they work in wrong order(
-            selected->local = Transform(matrix * parentInv);
-            selected->dirty = true;
+            selected->setLocal(Transform(matrix * parentInv));
         }
     }
 }
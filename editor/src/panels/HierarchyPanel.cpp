@@ -68,13 +68,7 @@ void HierarchyPanel::display()
                         const ImGuiPayload *payload;
                         if (!child->object && (payload = ImGui::AcceptDragDropPayload("SCENE_NODE"))) {
                             hk::SceneNode *node = *reinterpret_cast<hk::SceneNode**>(payload->Data);
-                            child->children.push_back(node);
-                            child->dirty = true;
-
-                            auto it = std::find(node->parent->children.begin(), node->parent->children.end(), node);
-                            node->parent->children.erase(it);
-
-                            node->parent = child;
+                            scene_->reparent(node, child);
                         }
                         ImGui::EndDragDropTarget();
                     }
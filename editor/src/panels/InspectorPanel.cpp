@@ -34,14 +34,16 @@ void InspectorPanel::display(hk::SceneNode *node)
                 addTransform(node);
 
                 if (node->object) {
-                    if (node->entity->hndlMesh) {
-                        hk::MeshAsset &mesh = hk::assets()->getMesh(node->entity->hndlMesh);
-                        addMeshInfo(mesh);
+                    if (hk::MeshRenderer *renderer = node->get<hk::MeshRenderer>()) {
+                        if (renderer->mesh) {
+                            addMeshInfo(hk::assets()->getMesh(renderer->mesh));
+                        }
+
+                        if (renderer->material) { addMaterialInfo(node); }
                     }
 
-                    if (node->entity->hndlMaterial) { addMaterialInfo(node); }
-                    if (node->entity->light)        { addLightInfo(node); }
-                    if (node->entity->camera)       { addCameraInfo(node); }
+                    if (node->get<hk::Light>())  { addLightInfo(node); }
+                    if (node->get<hk::Camera>()) { addCameraInfo(node); }
                 }
             }
 
@@ -79,7 +81,7 @@ void InspectorPanel::addTransform(hk::SceneNode *node)
 {
     if (ImGui::CollapsingHeader("Transform", ImGuiTreeNodeFlags_DefaultOpen)) {
 
-        Transform tr = node->local;
+        Transform tr = node->local();
 
         b8 pos = false;
         b8 scale = false;
@@ -153,19 +155,17 @@ void InspectorPanel::addTransform(hk::SceneNode *node)
         // tr.rotation = hkm::fromEulerAngles(rot * hkm::degree2rad);
 
         if (pos || scale || rota) {
-            node->local = tr;
-            node->dirty = true;
+            node->setLocal(tr);
         }
 
         // FIX: debug
         if (ImGui::TreeNodeEx("WorldTransform")) {
-            hk::imgui::utils::drawMatrix4x4(node->world.toMat4f());
+            hk::imgui::utils::drawMatrix4x4(node->worldMatrix());
             ImGui::TreePop();
         }
 
         if (ImGui::Button("Reset")) {
-            node->local = node->loaded;
-            node->dirty = true;
+            node->setLocal(node->loaded);
         }
     }
 }
@@ -201,11 +201,10 @@ void InspectorPanel::addMaterialInfo(hk::SceneNode *node)
         ImGui::PopStyleVar();
 
         if (material_swaped) {
-            node->entity->attachMaterial(materials.at(idx)->handle);
-            node->dirty = true;
+            node->attachMaterial(materials.at(idx)->handle);
         }
 
-        hk::MaterialAsset &material = hk::assets()->getMaterial(node->entity->hndlMaterial);
+        hk::MaterialAsset &material = hk::assets()->getMaterial(node->get<hk::MeshRenderer>()->material);
 
         if (ImGui::BeginComboPreview()) {
             ImGui::Image(hke::thumbnail::get(material.data.map_handles[hk::Material::BASECOLOR]), {40.f, 40.f});
@@ -217,8 +216,7 @@ void InspectorPanel::addMaterialInfo(hk::SceneNode *node)
             hk::MaterialAsset *mat = new hk::MaterialAsset();
             mat->name = "New Material";
 
-            node->entity->attachMaterial(hk::assets()->create(hk::Asset::Type::MATERIAL, mat));
-            node->dirty = true;
+            node->attachMaterial(hk::assets()->create(hk::Asset::Type::MATERIAL, mat));
         }
 
         // Toggles
@@ -287,27 +285,26 @@ void InspectorPanel::addMaterialInfo(hk::SceneNode *node)
 
 void InspectorPanel::addLightInfo(hk::SceneNode *node)
 {
-    hk::Light &light = *node->entity->light;
+    hk::Light light = *node->get<hk::Light>();
 
-    if (ImGui::CollapsingHeader("Light", ImGuiTreeNodeFlags_DefaultOpen)) {
-        if (ImGui::ColorEdit4("Color", &light.color[0])) {
-            node->entity->attachLight(light);
-        }
+    b8 changed = false;
 
-        if (ImGui::InputFloat("Range", &light.range)) {
-            node->entity->attachLight(light);
-        }
+    if (ImGui::CollapsingHeader("Light", ImGuiTreeNodeFlags_DefaultOpen)) {
+        changed |= ImGui::ColorEdit4("Color", &light.color[0]);
+        changed |= ImGui::InputFloat("Range", &light.range);
 
-        if (node->entity->light->type == hk::Light::Type::SPOT_LIGHT) {
-            ImGui::DragFloat("Inner", &light.inner_cutoff, 0.5f, 0, 45);
-            ImGui::DragFloat("Outer", &light.outer_cutoff, 0.5f, 0, 45);
+        if (light.type == hk::Light::Type::SPOT_LIGHT) {
+            changed |= ImGui::DragFloat("Inner", &light.inner_cutoff, 0.5f, 0, 45);
+            changed |= ImGui::DragFloat("Outer", &light.outer_cutoff, 0.5f, 0, 45);
         }
     }
+
+    if (changed) { node->attachLight(light); }
 }
 
 void InspectorPanel::addCameraInfo(hk::SceneNode *node)
 {
-    hk::Camera &camera = *node->entity->camera;
+    hk::Camera camera = *node->get<hk::Camera>();
 
     b8 changed = false;
 
@@ -325,6 +322,6 @@ void InspectorPanel::addCameraInfo(hk::SceneNode *node)
 
     if (changed) {
         camera.setPerspective(fov, aspect, near, far);
-        node->entity->attachCamera(camera);
+        node->attachCamera(camera);
     }
 }
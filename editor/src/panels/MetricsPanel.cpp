@@ -1,5 +1,8 @@
 #include "MetricsPanel.h"
 
+#include <algorithm>
+#include <cstring>
+
 void MetricsPanel::init()
 {
     is_open_ = false;
@@ -17,6 +20,9 @@ void MetricsPanel::display()
         if (ImGui::Begin("Metrics", &is_open_)) {
 
             addLogMetrics();
+            addMemoryMetrics();
+            addProfiler();
+            addGpuTimings();
 
         } ImGui::End();
     });
@@ -28,5 +34,172 @@ void MetricsPanel::addLogMetrics()
         hk::log::DebugInfo log = hk::log::getDebugInfo();
 
         ImGui::Text("Logs Issued: %d", log.logsIssued);
+        ImGui::Text("Logs Dropped: %d", log.logsDropped);
+    }
+}
+
+void MetricsPanel::addMemoryMetrics()
+{
+    if (ImGui::CollapsingHeader("Memory")) {
+        const hk::mem::FrameInfo &frame = hk::mem::frame_info();
+
+        constexpr f32 kb = 1024.f;
+        ImGui::Text("Frame Memory: %.1f / %.1f KB",
+                    frame.used / kb, frame.capacity / kb);
+        ImGui::Text("Frame Memory Peak: %.1f KB", frame.peak / kb);
+        ImGui::Text("Frame Memory Overflow: %.1f KB", frame.overflow / kb);
+    }
+}
+
+void MetricsPanel::addProfiler()
+{
+    if (!ImGui::CollapsingHeader("Profiler")) { return; }
+
+    b8 capture = hk::profiler::capturing();
+    if (ImGui::Checkbox("Capture", &capture)) {
+        hk::profiler::capture(capture);
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Checkbox("Pause", &profiler_paused_)) {
+        profiler_frame_ = hk::profiler::frame_index() - 1;
+    }
+
+    ImGui::SetNextItemWidth(120.f);
+    ImGui::InputInt("Frames", &export_frames_);
+    export_frames_ = std::clamp(export_frames_, 1, 120);
+
+    ImGui::SameLine();
+    if (ImGui::Button("Export Trace")) {
+        u64 last = profiler_paused_ ? profiler_frame_ :
+                                      hk::profiler::frame_index() - 1;
+        u64 first = last >= static_cast<u64>(export_frames_ - 1) ?
+                    last - (export_frames_ - 1) : 0;
+        hk::profiler::export_trace("profile.json", first, last);
+    }
+
+    if (!profiler_paused_) {
+        profiler_frame_ = hk::profiler::frame_index() - 1;
+    }
+
+    const hk::profiler::Frame *frame = hk::profiler::find_frame(profiler_frame_);
+    if (!frame) {
+        ImGui::TextDisabled("No captured frame");
+        return;
+    }
+
+    ImGui::Text("Frame %llu: %.3f ms, %u events",
+                static_cast<unsigned long long>(frame->index),
+                (frame->end - frame->begin) / 1e6, frame->events.size());
+    if (frame->dropped) {
+        ImGui::SameLine();
+        ImGui::TextColored({ 1.f, .4f, .4f, 1.f }, "(%u dropped)", frame->dropped);
+    }
+
+    drawFlameGraph(*frame);
+}
+
+void MetricsPanel::addGpuTimings()
+{
+    if (!ImGui::CollapsingHeader("GPU Timings")) { return; }
+
+    if (!hk::gpu_profiler::supported()) {
+        ImGui::TextDisabled("Timestamps are not supported");
+        return;
+    }
+
+    const hk::gpu_profiler::Results &gpu = hk::gpu_profiler::results();
+    ImGui::Text("Frame %llu: %.3f ms",
+                static_cast<unsigned long long>(gpu.frame), gpu.ms);
+
+    if (!ImGui::BeginTable("##gpu", 2, ImGuiTableFlags_RowBg)) { return; }
+
+    ImGui::TableSetupColumn("Pass");
+    ImGui::TableSetupColumn("ms", ImGuiTableColumnFlags_WidthFixed, 80.f);
+    ImGui::TableHeadersRow();
+
+    for (auto &region : gpu.regions) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Indent(region.depth * 12.f + 1.f);
+        ImGui::TextUnformatted(region.name);
+        ImGui::Unindent(region.depth * 12.f + 1.f);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", region.ms);
+    }
+
+    ImGui::EndTable();
+}
+
+void MetricsPanel::drawFlameGraph(const hk::profiler::Frame &frame)
+{
+    constexpr f32 row_height = 18.f;
+
+    // Rows are laid out per thread, each thread as deep as its deepest scope
+    hk::vector<u32> row_offset;
+    for (auto &event : frame.events) {
+        if (event.thread >= row_offset.size()) {
+            row_offset.resize(event.thread + 1);
+        }
+        row_offset[event.thread] = std::max(row_offset[event.thread],
+                                            event.depth + 1);
+    }
+
+    u32 rows = 0;
+    for (u32 &offset : row_offset) {
+        u32 depth = offset;
+        offset = rows;
+        rows += depth;
+    }
+
+    if (!rows) { return; }
+
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    f32 width = ImGui::GetContentRegionAvail().x;
+    f32 height = rows * row_height;
+
+    ImGui::InvisibleButton("##flame", { width, height });
+    b8 hovered = ImGui::IsItemHovered();
+    ImVec2 mouse = ImGui::GetMousePos();
+
+    ImDrawList *draw = ImGui::GetWindowDrawList();
+
+    const f64 duration = static_cast<f64>(frame.end - frame.begin);
+    const f64 scale = duration > 0 ? width / duration : 0;
+
+    for (auto &event : frame.events) {
+        // Scopes from other threads may cross frame boundaries
+        u64 begin = std::max(event.begin, frame.begin);
+        u64 end = std::min(event.end, frame.end);
+        if (end <= begin) { continue; }
+
+        f32 x0 = origin.x + static_cast<f32>((begin - frame.begin) * scale);
+        f32 x1 = origin.x + static_cast<f32>((end - frame.begin) * scale);
+        f32 y0 = origin.y + (row_offset[event.thread] + event.depth) * row_height;
+        f32 y1 = y0 + row_height - 1.f;
+
+        if (x1 - x0 < 1.f) { x1 = x0 + 1.f; }
+
+        // Stable colour per scope name
+        u64 hash = hk::hash_bytes(event.name, std::strlen(event.name));
+        ImU32 color = IM_COL32(80 + (hash & 0x7F),
+                               80 + ((hash >> 8) & 0x7F),
+                               80 + ((hash >> 16) & 0x7F), 255);
+
+        draw->AddRectFilled({ x0, y0 }, { x1, y1 }, color);
+
+        if (x1 - x0 > 30.f) {
+            draw->PushClipRect({ x0, y0 }, { x1, y1 }, true);
+            draw->AddText({ x0 + 2.f, y0 + 2.f }, IM_COL32_BLACK, event.name);
+            draw->PopClipRect();
+        }
+
+        if (hovered && mouse.x >= x0 && mouse.x < x1 &&
+            mouse.y >= y0 && mouse.y < y1)
+        {
+            ImGui::SetTooltip("%s\n%.3f ms\nThread %u",
+                              event.name, (event.end - event.begin) / 1e6,
+                              event.thread);
+        }
     }
 }
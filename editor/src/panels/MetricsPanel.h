@@ -12,9 +12,18 @@ public:
 
 private:
     void addLogMetrics();
+    void addMemoryMetrics();
+    void addProfiler();
+    void drawFlameGraph(const hk::profiler::Frame &frame);
+    void addGpuTimings();
 
 public:
     b8 is_open_;
+
+private:
+    b8 profiler_paused_ = false;
+    u64 profiler_frame_ = 0; // Shown frame while paused
+    i32 export_frames_ = 60;
 };
 
 #endif // HK_METRICS_PANEL_H
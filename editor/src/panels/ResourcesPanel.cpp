@@ -1,5 +1,7 @@
 #include "ResourcesPanel.h"
 
+#include "renderer/memory.h"
+
 #include <algorithm>
 
 void ResourcesPanel::init(Renderer *renderer)
@@ -40,9 +42,6 @@ void ResourcesPanel::display()
                     ImGui::TableSetupScrollFreeze(0, 1);
                     ImGui::TableHeadersRow();
 
-                    auto &metadata = hk::bkr::metadata();
-                    auto &descriptors = hk::bkr::descriptors();
-
                     // ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs();
                     // if (specs && specs->SpecsDirty) {
                     //     u32 column = specs->Specs[0].ColumnIndex;
@@ -76,8 +75,8 @@ void ResourcesPanel::display()
                     // }
 
                     for (u32 i = 0; i < hk::bkr::size(); ++i) {
-                        const auto &meta = metadata.at(i);
-                        const auto &desc = descriptors.at(i);
+                        const auto &meta = hk::bkr::metadata(i);
+                        const auto &desc = hk::bkr::descriptor(i);
 
                         ImGui::TableNextRow();
 
@@ -119,12 +118,9 @@ void ResourcesPanel::display()
                     ImGui::TableSetupScrollFreeze(0, 1);
                     ImGui::TableHeadersRow();
 
-                    auto &metadata = hk::bkr::image_metadata();
-                    auto &descriptors = hk::bkr::image_descriptors();
-
                     for (u32 i = 0; i < hk::bkr::image_size(); ++i) {
-                        const auto &meta = metadata.at(i);
-                        const auto &desc = descriptors.at(i);
+                        const auto &meta = hk::bkr::image_metadata(i);
+                        const auto &desc = hk::bkr::image_descriptor(i);
 
                         ImGui::TableNextRow();
 
@@ -165,6 +161,87 @@ void ResourcesPanel::display()
                 ImGui::TreePop();
             }
 
+            if (ImGui::TreeNode("Device Memory")) {
+                constexpr f32 mb = 1024.f * 1024.f;
+
+                const hk::bkr::MemoryStats stats = hk::bkr::memory_stats();
+
+                if (ImGui::BeginTable("##Heaps", 4, flags)) {
+                    ImGui::TableSetupColumn("Heap");
+                    ImGui::TableSetupColumn("Size");
+                    ImGui::TableSetupColumn("Budget");
+                    ImGui::TableSetupColumn("Usage");
+
+                    ImGui::TableSetupScrollFreeze(0, 1);
+                    ImGui::TableHeadersRow();
+
+                    for (u32 i = 0; i < stats.heaps.size(); ++i) {
+                        const auto &heap = stats.heaps[i];
+
+                        ImGui::TableNextRow();
+
+                        ImGui::TableSetColumnIndex(0);
+                        ImGui::Text("%u%s", i, heap.device_local ? " (Device)" : "");
+
+                        ImGui::TableSetColumnIndex(1);
+                        ImGui::Text("%.1f MB", heap.size / mb);
+
+                        ImGui::TableSetColumnIndex(2);
+                        ImGui::Text("%.1f MB", heap.budget / mb);
+
+                        ImGui::TableSetColumnIndex(3);
+                        ImGui::Text("%.1f MB", heap.usage / mb);
+                    }
+
+                    ImGui::EndTable();
+                }
+
+                if (ImGui::BeginTable("##MemoryTypes", 7, flags)) {
+                    ImGui::TableSetupColumn("Type");
+                    ImGui::TableSetupColumn("Blocks");
+                    ImGui::TableSetupColumn("Allocations");
+                    ImGui::TableSetupColumn("Reserved");
+                    ImGui::TableSetupColumn("Used");
+                    ImGui::TableSetupColumn("Free Ranges");
+                    ImGui::TableSetupColumn("Largest Free");
+
+                    ImGui::TableSetupScrollFreeze(0, 1);
+                    ImGui::TableHeadersRow();
+
+                    for (u32 i = 0; i < stats.types.size(); ++i) {
+                        const auto &type = stats.types[i];
+                        if (!type.reserved) { continue; }
+
+                        ImGui::TableNextRow();
+
+                        ImGui::TableSetColumnIndex(0);
+                        ImGui::Text("%u : heap %u", i, type.heap);
+
+                        ImGui::TableSetColumnIndex(1);
+                        ImGui::Text("%u", type.blocks);
+
+                        ImGui::TableSetColumnIndex(2);
+                        ImGui::Text("%u (%u dedicated)", type.allocations, type.dedicated);
+
+                        ImGui::TableSetColumnIndex(3);
+                        ImGui::Text("%.1f MB", type.reserved / mb);
+
+                        ImGui::TableSetColumnIndex(4);
+                        ImGui::Text("%.1f MB", type.used / mb);
+
+                        ImGui::TableSetColumnIndex(5);
+                        ImGui::Text("%u", type.free_ranges);
+
+                        ImGui::TableSetColumnIndex(6);
+                        ImGui::Text("%.1f MB", type.largest_free / mb);
+                    }
+
+                    ImGui::EndTable();
+                }
+
+                ImGui::TreePop();
+            }
+
             if (ImGui::TreeNode("Assets")) {
                 if (ImGui::BeginTable("##Resources", 3, flags)) {
                     ImGui::TableSetupColumn("ID");
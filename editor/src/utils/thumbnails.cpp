@@ -7,23 +7,27 @@ namespace hke::thumbnail {
 static Renderer *r;
 
 // void* == VkDescriptorSet
-static std::unordered_map<u32, void*> cache;
+static hk::flat_map<u32, void*> cache;
 
 void init(Renderer *renderer)
 {
     r = renderer;
     cache.clear();
+
+    // Async textures are cached with fallback image until loaded
+    hk::event::subscribe(hk::event::EVENT_ASSET_LOADED,
+        [](const hk::event::EventContext &context, void*) {
+            remove(context.u32[0]);
+        });
 }
 
 void* get(u32 handle)
 {
-    if (cache.count(handle)) { return cache[handle]; }
+    if (void **cached = cache.find(handle)) { return *cached; }
 
     hk::ImageHandle image = hk::assets()->getTexture(handle).image;
 
-    cache[handle] = hk::imgui::addTexture(image, r->samplers_.linear.repeat);
-
-    return cache[handle];
+    return cache[handle] = hk::imgui::addTexture(image, r->samplers_.linear.repeat);
 }
 
 void remove(u32 handle)
@@ -0,0 +1,40 @@
+#!/usr/bin/env bash
+set -e
+cd "$(dirname "$0")"
+
+SOURCE_DIR=src
+BUILD_DIR=build
+OUT_DIR=bin
+
+INCLUDE_DIRS="-Isrc -Isrc/vendor -Isrc/hkstl"
+DEFINES="-DHKDEBUG -DHKDLL_OUT"
+LIBS="-lvulkan -ldxcompiler -lassimp -lpthread -ldl"
+
+LIB_NAME=libhikai.so
+
+# -fPIC   - Position independent code, required for shared library
+# -g      - Debug information
+# -Wall   - Closest to /W4 of build.bat
+COMPILER_FLAGS="-std=c++17 -fPIC -g -Wall -Wextra"
+
+COMPILER=${CXX:-g++}
+
+mkdir -p "$BUILD_DIR" "$OUT_DIR"
+
+# Objects are flat like in build.bat, so source names have to be unique.
+# Platform sources are guarded by their own ifdefs
+find "$SOURCE_DIR" -name "*.cpp" | while read -r source; do
+    object="$BUILD_DIR/$(basename "${source%.cpp}").o"
+
+    if [ ! -f "$object" ]; then
+        echo "Compiling $source"
+    elif [ "$source" -nt "$object" ]; then
+        echo "Recompiling $source"
+    else
+        continue
+    fi
+
+    $COMPILER $DEFINES $COMPILER_FLAGS $INCLUDE_DIRS -c "$source" -o "$object"
+done
+
+$COMPILER -shared -o "$OUT_DIR/$LIB_NAME" "$BUILD_DIR"/*.o $LIBS
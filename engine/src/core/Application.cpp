@@ -1,7 +1,11 @@
 #include "Application.h"
 
 #include "input.h"
-#include "hkstl/filewatch.h"
+#include "jobs.h"
+#include "profiler.h"
+
+#include "hkstl/Filewatch.h"
+#include "hkstl/memory/hkframe.h"
 #include "resources/AssetManager.h"
 #include "platform/filesystem.h"
 
@@ -20,22 +24,38 @@ Application::Application(const AppDesc &desc)
     hk::spec::update_cpu_specs();
     hk::spec::update_system_specs();
 
+    hkm::simd::init();
+    hk::jobs::init();
+    hk::profiler::init();
+    hk::mem::init_frame(frame_memory_);
+
     hk::event::init();
     hk::event::subscribe(hk::event::EVENT_APP_SHUTDOWN, shutdown, this);
 
-    window_ = new Window();
-    window_->init(desc.title, desc.width, desc.height);
-    window_->enableRawMouseInput();
+#ifdef HKLINUX
+    if (!desc_.headless) {
+        LOG_WARN("No windowing backend on Linux, running headless");
+        desc_.headless = true;
+    }
+#endif
+
+    if (!desc_.headless) {
+        window_ = new Window();
+        window_->init(desc.title, desc.width, desc.height);
+        window_->enableRawMouseInput();
+    }
 
     hk::input::init();
 
     // FIX: temp development fix
     hk::assets()->init(hk::filesystem::canonical("..\\editor\\assets"));
 
-    renderer_ = new Renderer();
-    renderer_->init(window_);
+    if (!desc_.headless) {
+        renderer_ = new Renderer();
+        renderer_->init(window_);
 
-    hk::spec::update_adapter_specs();
+        hk::spec::update_adapter_specs();
+    }
 
     scene_.init();
 
@@ -52,14 +72,14 @@ void Application::run()
     hk::DrawContext ctx;
 
     while (running) {
-        if (!window_->ProcessMessages()) {
+        if (window_ && !window_->ProcessMessages()) {
             running = false;
             break;
         }
 
         dt = static_cast<f32>(clock_.update());
 
-        if (!window_->isVisible()) {
+        if (window_ && !window_->isVisible()) {
             continue;
         }
 
@@ -69,35 +89,60 @@ void Application::run()
             dt += static_cast<f32>(clock_.update());
         }
 
-        renderer_->updateFrameData(
-        {
-            camera_.position(),
-            camera_.viewProjection(),
+        // Frame wait is left out, so frames show only actual work
+        hk::profiler::frame();
+        hk::mem::next_frame();
+        HK_PROFILE_SCOPE("Application::run");
+
+        if (renderer_) {
+            renderer_->updateFrameData(
             {
-                static_cast<f32>(window_->width()),
-                static_cast<f32>(window_->height())
-            },
-            time_since_start_
-        });
+                camera_.position(),
+                camera_.viewProjection(),
+                {
+                    static_cast<f32>(window_->width()),
+                    static_cast<f32>(window_->height())
+                },
+                time_since_start_
+            });
+        }
 
         time_since_start_ += dt;
 
-        update(dt);
-        hk::input::update();
+        {
+            HK_PROFILE_SCOPE("Application::update");
+            update(dt);
+            hk::input::update();
+        }
 
+        hk::assets()->update();
         hk::event::dispatch(); // FIX: why dispatch is here?
 
         fixed_dt += dt;
         while (fixed_dt >= ms_per_frame) {
+            HK_PROFILE_SCOPE("Application::fixedUpdate");
             fixedUpdate();
             fixed_dt -= ms_per_frame;
         }
 
         scene_.update();
-        scene_.updateDrawContext(ctx, *renderer_);
 
-        render();
-        renderer_->draw(ctx);
+        if (renderer_) {
+            scene_.updateDrawContext(ctx, *renderer_);
+            scene_.cull(camera_, ctx);
+        } else {
+            // Nothing consumes draw changes without a renderer
+            scene_.discardDrawChanges();
+        }
+
+        {
+            HK_PROFILE_SCOPE("Application::render");
+            render();
+        }
+
+        if (renderer_) {
+            renderer_->draw(ctx);
+        }
 
         hk::log::dispatch();
     }
@@ -107,10 +152,13 @@ void Application::cleanup()
 {
     scene_.deinit();
     hk::assets()->deinit();
-    renderer_->deinit();
+    if (renderer_) { renderer_->deinit(); }
     hk::filewatch::deinit();
     hk::input::deinit();
-    window_->deinit();
+    hk::jobs::deinit();
+    hk::profiler::deinit();
+    hk::mem::deinit_frame();
+    if (window_) { window_->deinit(); }
     hk::event::deinit();
 }
 
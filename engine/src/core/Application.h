@@ -17,6 +17,10 @@ struct AppDesc {
     u32 width = 400;
     u32 height = 400;
     std::string title = "Sandbox";
+
+    // Runs without window, swapchain and renderer.
+    // Used for asset baking, simulation and benchmarks on build servers
+    b8 headless = false;
 };
 
 class Application {
@@ -44,13 +48,17 @@ public:
     static void shutdown(hk::event::EventContext ctx, void*);
     static b8 running;
 
+    b8 isHeadless() const { return desc_.headless; }
+
 protected:
     hk::SceneGraph scene_;
-    Renderer *renderer_;
-    Window *window_;
+    Renderer *renderer_ = nullptr;
+    Window *window_ = nullptr;
 
     AppDesc desc_;
     const f32 desired_frame_rate_ = 60.f;
+    // Scratch memory reset every frame, see hk::mem::frame()
+    const u64 frame_memory_ = 4 * 1024 * 1024;
 
     hk::Camera camera_;
 
@@ -1,14 +1,126 @@
 #include "SceneGraph.h"
 
+#include "jobs.h"
+#include "profiler.h"
 #include "renderer/ui/debug_draw.h"
 
+#include "hkstl/memory/hkframe.h"
+
 namespace hk {
 
+/* ===== SceneNode ===== */
+const Transform& SceneNode::local() const
+{
+    return graph_->locals_[slot_];
+}
+
+void SceneNode::setLocal(const Transform &transform)
+{
+    graph_->locals_[slot_] = transform;
+    graph_->markDirty(slot_);
+}
+
+const hkm::mat4f& SceneNode::worldMatrix() const
+{
+    return graph_->world_matrices_[slot_];
+}
+
+Transform SceneNode::world() const
+{
+    return Transform(graph_->world_matrices_[slot_]);
+}
+
+void SceneNode::attachMesh(u32 handle)
+{
+    ecs::Registry &registry = graph_->registry_;
+
+    if (!registry.has<MeshRenderer>(entity)) {
+        object = true;
+        idxObject = graph_->createObject(this);
+    }
+
+    registry.get_or_emplace<MeshRenderer>(entity).mesh = handle;
+    registry.get_or_emplace<MeshChanged>(entity);
+
+    const hk::MeshAsset &asset = hk::assets()->getMesh(handle);
+    registry.emplace_or_replace<Bounds>(entity, Bounds{asset.mesh.min, asset.mesh.max});
+
+    // World bounds are recomputed with transform
+    graph_->markDirty(slot_);
+}
+
+void SceneNode::attachMaterial(u32 handle)
+{
+    ecs::Registry &registry = graph_->registry_;
+
+    if (!registry.has<MeshRenderer>(entity)) {
+        object = true;
+        idxObject = graph_->createObject(this);
+    }
+
+    registry.get_or_emplace<MeshRenderer>(entity).material = handle;
+    registry.get_or_emplace<MaterialChanged>(entity);
+}
+
+void SceneNode::attachLight(const Light &light)
+{
+    ecs::Registry &registry = graph_->registry_;
+
+    if (!registry.has<Light>(entity)) {
+        object = true;
+        idxObject = graph_->lights_++;
+    }
+
+    registry.emplace_or_replace<Light>(entity, light);
+    registry.get_or_emplace<LightChanged>(entity);
+}
+
+void SceneNode::attachCamera(const Camera &camera)
+{
+    object = true;
+    graph_->registry_.emplace_or_replace<Camera>(entity, camera);
+
+    // Camera follows node on the next update
+    graph_->markDirty(slot_);
+}
+
+/* ===== SceneGraph ===== */
+static constexpr b8 test_bit(const hk::vector<u64> &bits, u32 idx)
+{
+    return bits[idx >> 6] & (1ull << (idx & 63));
+}
+
+static constexpr void set_bit(hk::vector<u64> &bits, u32 idx)
+{
+    bits[idx >> 6] |= (1ull << (idx & 63));
+}
+
 void SceneGraph::init()
 {
-    root_ = new SceneNode();
+    node_pool_.init<SceneNode>(256);
+
+    // FIX: material event should be subscribed by handle
+    // otherwise graph receives events from all materials
+    hndlMaterialEvent_ = hk::event::subscribe(hk::event::EVENT_MATERIAL_MODIFIED,
+        [&](const hk::event::EventContext &context, void *listener) {
+            (void)listener;
+
+            const u32 handle = context.u32[0];
+
+            registry_.view<MeshRenderer>().each(
+                [&](ecs::Entity entity, MeshRenderer &renderer) {
+                    if (renderer.material != handle) { return; }
+
+                    registry_.get_or_emplace<MaterialChanged>(entity);
+                });
+        },
+    this);
+
+    root_ = createNode(nullptr, Transform());
     root_->name = "World";
-    root_->dirty = false;
+
+    // Root never moves, its world matrix stays identity
+    dirty_local_[0] = 0;
 
     size_ = 0;
 }
@@ -16,123 +128,379 @@ void SceneGraph::init()
 void SceneGraph::deinit()
 {
     LOG_DEBUG("Destroying Scene Graph");
+
+    for (auto node : nodes_) {
+        hk::mem::destroy(node_pool_, node);
+    }
+    root_ = nullptr;
+
+    hk::event::unsubscribe(hndlMaterialEvent_);
+    hndlMaterialEvent_ = 0;
+
+    registry_.deinit();
+
+    nodes_.clear();
+    parents_.clear();
+    locals_.clear();
+    local_matrices_.clear();
+    world_matrices_.clear();
+    dirty_local_.clear();
+    dirty_world_.clear();
+
+    bounds_.clear();
+    proxies_.clear();
+    object_nodes_.clear();
+    bvh_.clear();
+
+    dirty_.clear();
+
+    node_pool_.deinit();
 }
 
-void SceneGraph::update()
+SceneNode* SceneGraph::createNode(SceneNode *parent, const Transform &local)
 {
-    std::function<void(SceneNode*, b8)> traverseSceneGraph;
-    traverseSceneGraph = [&](SceneNode *node, b8 propagate) {
+    SceneNode *node = hk::mem::create<SceneNode>(node_pool_);
 
-        if (node->dirty || propagate) {
-            Transform tr = (node->parent) ? node->parent->world : Transform();
+    node->graph_ = this;
+    node->slot_ = nodes_.size();
+    node->parent = parent;
+    node->loaded = local;
 
-            // FIX: Why the fuck it works the other way around?
-            // should be parent->world * node->local
-            node->world = node->local * tr;
+    node->entity = registry_.create();
+    registry_.emplace<Hierarchy>(node->entity, Hierarchy{node});
 
-            node->visible = node->parent->visible;
+    nodes_.push_back(node);
+    parents_.push_back(parent ? parent->slot_ : 0);
+    locals_.push_back(local);
+    local_matrices_.push_back(local.toMat4f());
+    world_matrices_.push_back(hkm::mat4f::identity());
 
-            node->dirty = false;
-            propagate = true;
+    if ((node->slot_ >> 6) >= dirty_local_.size()) {
+        dirty_local_.push_back(0);
+        dirty_world_.push_back(0);
+    }
+
+    markDirty(node->slot_);
+
+    if (parent) { parent->children.push_back(node); }
+
+    return node;
+}
+
+u32 SceneGraph::createObject(SceneNode *node)
+{
+    // Object enters hierarchy once its world bounds are computed
+    bounds_.emplace_back();
+    proxies_.push_back(hk::bvh::none);
+    object_nodes_.push_back(node);
+
+    return objects_++;
+}
+
+void SceneGraph::markDirty(u32 slot)
+{
+    set_bit(dirty_local_, slot);
+}
 
-            if (node->object) { dirty_.push(node); }
+void SceneGraph::reparent(SceneNode *node, SceneNode *parent)
+{
+    if (!node || !parent || node == root_ || node->parent == parent) {
+        return;
+    }
+
+    // Can't move node inside its own subtree
+    for (SceneNode *it = parent; it; it = it->parent) {
+        if (it == node) {
+            LOG_WARN("Can't reparent", node->name, "to its own child");
+            return;
+        }
+    }
+
+    auto &siblings = node->parent->children;
+    for (u32 i = 0; i < siblings.size(); ++i) {
+        if (siblings[i] == node) {
+            siblings.erase(i);
+            break;
         }
+    }
+
+    parent->children.push_back(node);
+    node->parent = parent;
+
+    parents_[node->slot_] = parent->slot_;
+
+    // Descendants always come after node, only node vs parent order matters
+    if (parent->slot_ > node->slot_) { unsorted_ = true; }
+
+    markDirty(node->slot_);
+}
+
+void SceneGraph::sort()
+{
+    HK_PROFILE_FUNCTION();
+
+    // Storage is permuted in place, old order is copied into frame memory
+    hk::mem::Linear &scratch = hk::mem::frame();
+
+    // Breadth first order keeps parents before children and siblings together
+    hk::vector<SceneNode*> order(scratch);
+    order.reserve(nodes_.size());
+    order.push_back(root_);
+
+    for (u32 i = 0; i < order.size(); ++i) {
+        for (auto child : order[i]->children) {
+            order.push_back(child);
+        }
+    }
+
+    ALWAYS_ASSERT(order.size() == nodes_.size(),
+                  "Scene graph hierarchy is inconsistent with its storage");
+
+    const u32 count = order.size();
+
+    hk::vector<Transform> locals(scratch);
+    hk::vector<hkm::mat4f> local_matrices(scratch);
+    hk::vector<hkm::mat4f> world_matrices(scratch);
+    hk::vector<u64> dirty_local(scratch);
+
+    locals.assign(locals_.begin(), locals_.end());
+    local_matrices.assign(local_matrices_.begin(), local_matrices_.end());
+    world_matrices.assign(world_matrices_.begin(), world_matrices_.end());
+    dirty_local.assign(dirty_local_.begin(), dirty_local_.end());
 
-        // FIX: probably temp (or not)
-        if (node->object && node->visible && node->entity) {
-            if (node->entity->dirty.any()) {
-                dirty_.push(node);
+    for (auto &bits : dirty_local_) { bits = 0; }
+
+    for (u32 i = 0; i < count; ++i) {
+        u32 old = order[i]->slot_;
+
+        locals_[i] = locals[old];
+        local_matrices_[i] = local_matrices[old];
+        world_matrices_[i] = world_matrices[old];
+
+        if (test_bit(dirty_local, old)) { set_bit(dirty_local_, i); }
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        order[i]->slot_ = i;
+        nodes_[i] = order[i];
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        parents_[i] = order[i]->parent ? order[i]->parent->slot_ : 0;
+    }
+
+    unsorted_ = false;
+}
+
+void SceneGraph::updateWorldMatrices()
+{
+    HK_PROFILE_FUNCTION();
+    const u32 count = parents_.size();
+
+    // Local matrices don't depend on each other, 64 slots per bitmap word
+    constexpr u32 words_per_job = 16;
+    hk::jobs::parallel_for(0, dirty_local_.size(), words_per_job,
+        [&](u32 begin, u32 end) {
+            for (u32 word = begin; word < end; ++word) {
+                const u64 bits = dirty_local_[word];
+                if (!bits) { continue; }
+
+                // Convert runs of consecutive dirty slots at once
+                u32 bit = 0;
+                while (bit < 64) {
+                    if (!(bits & (1ull << bit))) { ++bit; continue; }
+
+                    u32 last = bit;
+                    while (last < 64 && (bits & (1ull << last))) { ++last; }
+
+                    const u32 first = (word << 6) + bit;
+                    toMat4f(&locals_[first], &local_matrices_[first], last - bit);
+
+                    bit = last;
+                }
             }
+        });
+
+    for (auto &bits : dirty_world_) { bits = 0; }
+
+    // Slot 0 is root, parents always precede children
+    // and siblings are stored next to each other, so they are composed in runs
+    for (u32 i = 1; i < count;) {
+        const u32 parent = parents_[i];
+        const b8 parent_dirty = test_bit(dirty_world_, parent);
+
+        u32 end = i;
+        while (end < count && parents_[end] == parent &&
+               (parent_dirty || test_bit(dirty_local_, end)))
+        {
+            ++end;
         }
 
-        // Draw debug sphere around lights
-        if (node->object && node->debug_draw && node->entity && node->entity->light) {
-            hk::Light &light = *node->entity->light;
+        if (end == i) { ++i; continue; }
+
+        // FIX: Why the fuck it works the other way around?
+        // should be parent->world * node->local
+        hkm::mul(&local_matrices_[i], world_matrices_[parent],
+                 &world_matrices_[i], end - i);
+
+        for (u32 j = i; j < end; ++j) { set_bit(dirty_world_, j); }
+
+        i = end;
+    }
+
+    for (auto &bits : dirty_local_) { bits = 0; }
+}
+
+void SceneGraph::update()
+{
+    HK_PROFILE_FUNCTION();
 
-            hkm::vec4f color = node->entity->light->color;
+    if (unsorted_) { sort(); }
+
+    updateWorldMatrices();
+
+    for (u32 slot = 1; slot < nodes_.size(); ++slot) {
+        SceneNode *node = nodes_[slot];
+
+        if (test_bit(dirty_world_, slot)) {
+            node->visible = node->parent->visible;
+
+            if (node->object) { dirty_.push_back(node); }
+        }
+    }
+
+    // Changes stay tagged until draw context picks them up,
+    // so they are queued again after discarded frames
+    const auto queue = [&](ecs::Entity, Hierarchy &hierarchy, const auto &) {
+        if (hierarchy.node->visible) { dirty_.push_back(hierarchy.node); }
+    };
+
+    registry_.view<Hierarchy, MeshChanged>().each(queue);
+    registry_.view<Hierarchy, MaterialChanged>().each(queue);
+    registry_.view<Hierarchy, LightChanged>().each(queue);
+
+    // World bounds of moved objects, each job writes only its own objects
+    registry_.view<Hierarchy, Bounds>().parallel_each(
+        [&](ecs::Entity, Hierarchy &hierarchy, Bounds &bounds) {
+            const SceneNode *node = hierarchy.node;
+            if (!test_bit(dirty_world_, node->slot_)) { return; }
+
+            hkm::vec3f min;
+            hkm::vec3f max;
+            hkm::transformAABBs(node->worldMatrix(), &bounds.min, &bounds.max, &min, &max, 1);
+
+            bounds_[node->idxObject] = hkm::aabb(min, max);
+        });
+
+    // Tree changes only when box leaves its enlarged one
+    u32 changed = 0;
+    registry_.view<Hierarchy, Bounds>().each(
+        [&](ecs::Entity, Hierarchy &hierarchy, Bounds&) {
+            const SceneNode *node = hierarchy.node;
+            if (!test_bit(dirty_world_, node->slot_)) { return; }
+
+            const u32 idx = node->idxObject;
+            u32 &proxy = proxies_[idx];
+
+            if (proxy == hk::bvh::none) {
+                proxy = bvh_.insert(bounds_[idx], idx);
+                ++changed;
+            } else if (bvh_.move(proxy, bounds_[idx])) {
+                ++changed;
+            }
+        });
+
+    // Loaded models and mass moves leave worse tree than full build
+    if (changed > 64 && changed > bvh_.size() / 2) { bvh_.rebuild(); }
+
+    // Cameras follow their nodes, each camera is touched only by one job
+    registry_.view<Hierarchy, Camera>().parallel_each(
+        [&](ecs::Entity, Hierarchy &hierarchy, Camera &camera) {
+            if (!test_bit(dirty_world_, hierarchy.node->slot_)) { return; }
+
+            Transform world = hierarchy.node->world();
+
+            camera.setWorldOffset(world.pos);
+            camera.setWorldRotation(world.rotation);
+            camera.update();
+        });
+
+    // Draw debug sphere around lights
+    registry_.view<Hierarchy, Light>().each(
+        [&](ecs::Entity, Hierarchy &hierarchy, Light &light) {
+            if (!hierarchy.node->debug_draw) { return; }
+
+            Transform world = hierarchy.node->world();
+
+            hkm::vec4f color = light.color;
             hk::dd::ShapeDesc desc = {};
             desc.color = {color.x, color.y, color.z};
             desc.thickness = 6.f;
 
-            hkm::vec3f normal = hkm::vec3f(0, 0, 1) * node->world.rotation;
+            hkm::vec3f normal = hkm::vec3f(0, 0, 1) * world.rotation;
 
-            switch(node->entity->light->type) {
+            switch(light.type) {
             case Light::Type::POINT_LIGHT: {
                 desc.thickness = 3.f;
-                hk::dd::sphere(desc, node->world.pos, light.range);
+                hk::dd::sphere(desc, world.pos, light.range);
             } break;
             case Light::Type::SPOT_LIGHT: {
-                // hk::dd::circle({{c.x, c.y, c.z}, 3}, node->world.pos, .5f, normal);
-                hk::dd::line(desc, node->world.pos, node->world.pos + normal * .2f);
+                // hk::dd::circle({{c.x, c.y, c.z}, 3}, world.pos, .5f, normal);
+                hk::dd::line(desc, world.pos, world.pos + normal * .2f);
                 desc.thickness = 3.f;
                 hk::dd::conical_frustum(
                         desc,
-                        node->world.pos, light.inner_cutoff,
-                        node->world.pos + normal * light.range, light.outer_cutoff);
+                        world.pos, light.inner_cutoff,
+                        world.pos + normal * light.range, light.outer_cutoff);
             } break;
             case Light::Type::DIRECTIONAL_LIGHT: {
-                hk::dd::line(desc, node->world.pos, node->world.pos + normal * .2f);
+                hk::dd::line(desc, world.pos, world.pos + normal * .2f);
             } break;
 
             default: break;
             }
-        }
+        });
 
-        if (node->object && node->debug_draw && node->entity && node->entity->camera) {
-            hk::Camera &camera = *node->entity->camera;
+    registry_.view<Hierarchy, Camera>().each(
+        [&](ecs::Entity, Hierarchy &hierarchy, Camera &camera) {
+            if (!hierarchy.node->debug_draw) { return; }
 
             // hk::dd::line({{1, 0, 0}, 5, false}, camera.position(), camera.position() + camera.top());
             // hk::dd::line({{0, 0, 1}, 5, false}, camera.position(), camera.position() + camera.right());
             // hk::dd::line({{0, 1, 0}, 5, false}, camera.position(), camera.position() + camera.forward());
 
             hk::dd::view_frustum({{0, 1, 0}, 3, true}, camera.viewProjectionInv());
-        }
-
-        for (auto child : node->children) {
-            traverseSceneGraph(child, propagate);
-        }
-    };
+        });
+}
 
-    traverseSceneGraph(root_, root_->dirty);
+void SceneGraph::discardDrawChanges()
+{
+    dirty_.clear();
 }
 
-void SceneGraph::addNode(const SceneNode &node)
+SceneNode* SceneGraph::addNode(const SceneNode &node)
 {
-    SceneNode *snode = new SceneNode();
     SceneNode *parent = node.parent ? node.parent : root_;
+    SceneNode *snode = createNode(parent, node.loaded);
 
     snode->idx = size_++;
     snode->name = node.name;
     snode->object = node.object;
-    snode->dirty = true;
-    snode->parent = parent;
-    snode->loaded = node.loaded;
-    snode->local = node.loaded;
-    snode->entity = node.entity;
     snode->debug_draw = node.debug_draw;
     snode->visible = node.visible;
 
-    if (snode->object && snode->entity && snode->entity->hndlMesh) {
-        ++objects_;
-        dirty_.push(snode);
-    }
-
-    parent->children.push_back(snode);
+    return snode;
 }
 
 void SceneGraph::addModel(u32 handle, const Transform &transform)
 {
     hk::ModelAsset model = hk::assets()->getModel(handle);
 
-    SceneNode *parent = new SceneNode();
+    SceneNode *parent = createNode(root_, transform);
     parent->idx = size_++;
     parent->name = model.name;
     parent->object = false;
-    parent->dirty = true;
     parent->handle = handle;
-    parent->parent = root_;
-    parent->loaded = transform;
-    parent->local = parent->loaded;
 
     u32 hndlMesh = model.hndlRootMesh;
     hk::MeshAsset mesh = hk::assets()->getMesh(hndlMesh);
@@ -140,112 +508,80 @@ void SceneGraph::addModel(u32 handle, const Transform &transform)
     std::function<void(SceneNode*, hk::MeshAsset*)> addMeshes;
     addMeshes = [&](SceneNode *parent, hk::MeshAsset* asset){
         for (auto &child : asset->children) {
-            SceneNode *node = new SceneNode();
+            SceneNode *node = createNode(parent, child->instances.at(0));
             node->idx = size_++;
             node->name = child->name;
-            node->object = true;
-            node->dirty = true;
-            node->parent = parent;
-            node->loaded = child->instances.at(0);
-            node->local = node->loaded;
-
-            Entity *entity = new Entity();
-            entity->attachMesh(child->handle);
+
+            node->attachMesh(child->handle);
             if (child->hndlTextures.size()) {
-                entity->attachMaterial(child->hndlTextures.at(0));
+                node->attachMaterial(child->hndlTextures.at(0));
             }
-            node->entity = entity;
-
-            node->idxObject = objects_;
-            ++objects_;
-
-            parent->children.push_back(node);
 
             addMeshes(node, child);
         }
     };
 
     addMeshes(parent, &mesh);
-
-    root_->children.push_back(parent);
 }
 
 void SceneGraph::addLight(const Light &light, const Transform &transform)
 {
-    SceneNode *node = new SceneNode();
-    node->idx = size_++;
-    node->name = "Light TEST";
-    node->object = true;
-    node->dirty = true;
-    node->parent = root_;
-    node->loaded = transform;
-    node->local = node->loaded;
+    Transform loaded = transform;
 
     if (hkm::toEulerAngles(transform.rotation).length() < 0.01f) {
         switch (light.type) {
         case Light::Type::SPOT_LIGHT: {
-            node->loaded.rotation =
+            loaded.rotation =
                 hkm::fromAxisAngle({1, 0, 0}, 90.f * hkm::degree2rad);
-            node->local.rotation = node->loaded.rotation;
         } break;
         case Light::Type::DIRECTIONAL_LIGHT: {
-            node->loaded.rotation =
+            loaded.rotation =
                 hkm::fromAxisAngle({1, 0, 0}, 45.f * hkm::degree2rad);
-            node->local.rotation = node->loaded.rotation;
         } break;
         default: break;
         }
     }
 
+    SceneNode *node = createNode(root_, loaded);
+    node->idx = size_++;
+    node->name = "Light TEST";
     node->debug_draw = true;
 
-    Entity *entity = new Entity();
-    entity->attachLight(light);
-    node->entity = entity;
-
-    node->idxObject = lights_;
-    ++lights_;
-
-    root_->children.push_back(node);
+    node->attachLight(light);
 }
 
 void SceneGraph::updateDrawContext(DrawContext &context, Renderer &renderer)
 {
-    if (dirty_.empty()) { return; }
+    HK_PROFILE_FUNCTION();
 
-    // FIX: why is this here again?
-    vkDeviceWaitIdle(renderer.device_);
+    if (dirty_.empty()) { return; }
 
     context.objects.resize(objects_);
     context.lights.resize(lights_);
 
-    for (; !dirty_.empty(); dirty_.pop()) {
-        SceneNode *node = dirty_.front();
+    for (SceneNode *node : dirty_) {
+        const ecs::Entity entity = node->entity;
 
-        // If node is a Mesh object
-        if (node->entity->hndlMesh || node->entity->hndlMaterial) {
+        if (MeshRenderer *mesh = registry_.try_get<MeshRenderer>(entity)) {
             RenderObject &object = context.objects.at(node->idxObject);
 
-            // TODO: build only once
-            if (node->entity->dirty.test(0)) {
-                hk::MeshAsset mesh = hk::assets()->getMesh(node->entity->hndlMesh);
-                object.create(mesh.mesh, mesh.name);
-
-                node->entity->dirty.flip(0);
+            // Node can be queued several times, tags are removed on first visit
+            if (registry_.remove<MeshChanged>(entity)) {
+                const hk::MeshAsset &asset = hk::assets()->getMesh(mesh->mesh);
+                object.create(asset.mesh, asset.name);
             }
 
             // TODO: i don't think that works right, if i clear position,
             // that means it can't be more that one instance?
             object.instances.clear();
-            object.instances.push_back(node->world.toMat4f());
+            object.instances.push_back(node->worldMatrix());
 
-            if (node->entity->dirty.test(1)) {
-                hk::MaterialAsset asset = hk::assets()->getMaterial(node->entity->hndlMaterial);
+            if (registry_.remove<MaterialChanged>(entity)) {
+                hk::MaterialAsset &asset = hk::assets()->getMaterial(mesh->material);
                 object.rm.material = &asset.data;
 
                 object.rm.build(
                     renderer.offscreen_.render_pass_,
-                    sizeof(InstanceData),
                     renderer.global_desc_layout.handle(),
                     renderer.offscreen_.set_layout_.handle(),
                     renderer.offscreen_.formats_,
@@ -253,55 +589,39 @@ void SceneGraph::updateDrawContext(DrawContext &context, Renderer &renderer)
                     asset.name);
 
                 object.material = object.rm.write(renderer.global_desc_alloc);
-
-                node->entity->dirty.flip(1);
-            }
-        } else if (node->entity->light) {
-            RenderLight &light = context.lights.at(node->idxObject);
-
-            light.transform = node->world;
-
-            if (node->entity->dirty.test(2)) {
-                light.light = node->entity->light;
-
-                node->entity->dirty.flip(2);
             }
-        } else if (node->entity->camera) {
-            hk::Camera &camera = *node->entity->camera;
+        } else if (Light *light = registry_.try_get<Light>(entity)) {
+            RenderLight &render = context.lights.at(node->idxObject);
 
-            camera.setWorldOffset(node->world.pos);
-            camera.setWorldRotation(node->world.rotation);
-            camera.update();
-
-            if (node->entity->dirty.test(3)) {
-                node->entity->dirty.flip(3);
-            }
+            if (registry_.remove<LightChanged>(entity)) { render.light = *light; }
+            render.transform = node->world();
         }
     }
+    dirty_.clear();
 
     // FIX: temp
     LightSources sources;
     for (u32 i = 0; i < context.lights.size(); ++i) {
-        auto light = context.lights.at(i);
+        const auto &light = context.lights.at(i);
 
-        if (light.light->type == hk::Light::Type::POINT_LIGHT) {
-            sources.point_lights[sources.point_count].color = light.light->color;
-            sources.point_lights[sources.point_count].intensity = light.light->intensity;
+        if (light.light.type == hk::Light::Type::POINT_LIGHT) {
+            sources.point_lights[sources.point_count].color = light.light.color;
+            sources.point_lights[sources.point_count].intensity = light.light.intensity;
 
             sources.point_lights[sources.point_count].pos = light.transform.pos;
 
             ++sources.point_count;
-        } else if (light.light->type == hk::Light::Type::SPOT_LIGHT) {
-            sources.spot_lights[sources.spot_count].color = light.light->color;
-            sources.spot_lights[sources.spot_count].inner_cutoff = light.light->inner_cutoff;
-            sources.spot_lights[sources.spot_count].outer_cutoff = light.light->outer_cutoff;
+        } else if (light.light.type == hk::Light::Type::SPOT_LIGHT) {
+            sources.spot_lights[sources.spot_count].color = light.light.color;
+            sources.spot_lights[sources.spot_count].inner_cutoff = light.light.inner_cutoff;
+            sources.spot_lights[sources.spot_count].outer_cutoff = light.light.outer_cutoff;
 
             sources.spot_lights[sources.spot_count].pos = light.transform.pos;
             sources.spot_lights[sources.spot_count].dir = hkm::toEulerAngles(light.transform.rotation);
 
             ++sources.spot_count;
-        } else if (light.light->type == hk::Light::Type::DIRECTIONAL_LIGHT) {
-            sources.directional_lights[sources.directinal_count].color = light.light->color;
+        } else if (light.light.type == hk::Light::Type::DIRECTIONAL_LIGHT) {
+            sources.directional_lights[sources.directinal_count].color = light.light.color;
             sources.directional_lights[sources.directinal_count].dir =
                 hkm::toEulerAngles(light.transform.rotation);
 
@@ -311,4 +631,49 @@ void SceneGraph::updateDrawContext(DrawContext &context, Renderer &renderer)
     renderer.updateLights(sources);
 }
 
+void SceneGraph::cull(const Camera &camera, DrawContext &context)
+{
+    HK_PROFILE_FUNCTION();
+
+    hkm::vec4f planes[6];
+    hkm::frustumPlanes(camera.viewProjection(), planes);
+
+    // Draw context may lag behind objects that weren't picked up yet
+    const u32 count = context.objects.size();
+
+    context.visible.clear();
+    bvh_.query(planes, [&](u32 idx) {
+        if (idx < count) { context.visible.push_back(idx); }
+    });
+}
+
+SceneNode* SceneGraph::raycast(const hkm::vec3f &origin, const hkm::vec3f &dir,
+                               f32 max_distance) const
+{
+    SceneNode *out = nullptr;
+
+    bvh_.raycast(origin, dir, max_distance, [&](u32 idx, f32 distance) {
+        out = object_nodes_[idx];
+        return distance;
+    });
+
+    return out;
+}
+
+SceneNode* SceneGraph::nearest(const hkm::vec3f &point, f32 max_distance) const
+{
+    const u32 idx = bvh_.nearest(point, max_distance);
+    return idx == hk::bvh::none ? nullptr : object_nodes_[idx];
+}
+
+void SceneGraph::overlap(const hkm::aabb &box, hk::vector<SceneNode*> &out) const
+{
+    bvh_.query(box, [&](u32 idx) { out.push_back(object_nodes_[idx]); });
+}
+
+void SceneGraph::overlap(const hkm::vec3f &center, f32 radius, hk::vector<SceneNode*> &out) const
+{
+    bvh_.query(center, radius, [&](u32 idx) { out.push_back(object_nodes_[idx]); });
+}
+
 }
@@ -1,7 +1,9 @@
 #ifndef HK_SCENE_GRAPH_H
 #define HK_SCENE_GRAPH_H
 
-#include "renderer/object/Entity.h"
+#include "core/ecs.h"
+
+#include "renderer/object/Components.h"
 #include "renderer/object/Transform.h"
 
 #include "resources/AssetManager.h"
@@ -10,10 +12,17 @@
 
 #include "renderer/Renderer.h"
 
-#include <queue>
+#include "hkstl/containers/hkbvh.h"
+#include "hkstl/memory/hkpool.h"
 
 namespace hk {
 
+class SceneGraph;
+
+/* SceneNode is a view over SceneGraph transform storage.
+ * Local and world transforms live in flat arrays inside the graph,
+ * components live in graph registry under node entity,
+ * node only keeps hierarchy and object info for the editor and draw context */
 struct SceneNode {
     u32 idx;
 
@@ -22,20 +31,14 @@ struct SceneNode {
 
     std::string name;
 
-    Transform local;
-    Transform world;
     Transform loaded;
 
     // SceneNode can be either object (Mesh, Light, Camera, etc)
     // or just collection of other nodes
     b8 object = false;
-    // FIX: add enum what object type is it (than why need entity component?)
-
-    // Viable only when node is an object
-    Entity *entity = nullptr;
 
-    // Change propagates to all children
-    b8 dirty = false;
+    // Every node has one, components make node an object
+    ecs::Entity entity;
 
     // FIX: Unsure about this
     // only needed when node is a Model object
@@ -45,6 +48,33 @@ struct SceneNode {
 
     b8 debug_draw = false;
     b8 visible = true;
+
+    /* ===== Transform Storage View ===== */
+    HKAPI const Transform& local() const;
+    // Change propagates to all children on the next SceneGraph::update
+    HKAPI void setLocal(const Transform &transform);
+
+    HKAPI const hkm::mat4f& worldMatrix() const;
+    // Decomposes world matrix, prefer worldMatrix() when possible
+    HKAPI Transform world() const;
+
+    constexpr u32 slot() const { return slot_; }
+
+    /* ===== Components ===== */
+    HKAPI void attachMesh(u32 handle);
+    HKAPI void attachMaterial(u32 handle);
+    HKAPI void attachLight(const Light &light);
+    HKAPI void attachCamera(const Camera &camera);
+
+    // nullptr when node doesn't have component
+    template<typename T>
+    T* get();
+
+private:
+    SceneGraph *graph_ = nullptr;
+    u32 slot_ = 0; // Index into SceneGraph storage, changes on resort
+
+    friend class SceneGraph;
 };
 
 class SceneGraph {
@@ -54,16 +84,49 @@ public:
 
     void update();
 
-    HKAPI void addNode(const SceneNode &node);
+    // Components are attached to returned node
+    HKAPI SceneNode* addNode(const SceneNode &node);
     HKAPI void addModel(u32 handle, const Transform &transform = Transform());
     HKAPI void addLight(const Light &light, const Transform &transform = Transform());
 
+    // Moves node with its subtree under new parent
+    HKAPI void reparent(SceneNode *node, SceneNode *parent);
+
     void updateDrawContext(DrawContext &context, Renderer &renderer);
 
+    // Fills context.visible with objects inside camera frustum
+    void cull(const Camera &camera, DrawContext &context);
+
+    /* ===== Spatial Queries =====
+     * Over world bounds of mesh objects as of the last update */
+
+    // Object with closest box hit by ray, distance is in dir lengths
+    HKAPI SceneNode* raycast(const hkm::vec3f &origin, const hkm::vec3f &dir,
+                             f32 max_distance = FLT_MAX) const;
+    // Object with box closest to point, nullptr if none is within max_distance
+    HKAPI SceneNode* nearest(const hkm::vec3f &point, f32 max_distance = FLT_MAX) const;
+
+    // Appends objects with boxes overlapping box or sphere
+    HKAPI void overlap(const hkm::aabb &box, hk::vector<SceneNode*> &out) const;
+    HKAPI void overlap(const hkm::vec3f &center, f32 radius, hk::vector<SceneNode*> &out) const;
+
+    // Drops queued draw context changes, used when nothing is rendered
+    void discardDrawChanges();
+
 public:
     SceneNode *root() { return root_; }
+    ecs::Registry& registry() { return registry_; }
     constexpr u32 size() const { return size_; }
     constexpr u32 objects() const { return objects_; }
+    const hk::bvh& spatial() const { return bvh_; }
+
+private:
+    SceneNode* createNode(SceneNode *parent, const Transform &local);
+    u32 createObject(SceneNode *node);
+
+    void markDirty(u32 slot);
+    void sort();
+    void updateWorldMatrices();
 
 private:
     SceneNode *root_ = nullptr;
@@ -72,10 +135,50 @@ private:
     u32 objects_ = 0; // Amount of objects in a scene
     u32 lights_ = 0;  // Amount of lights in a scene
 
-    // Queue with nodes that requires change in draw context
-    std::queue<SceneNode*> dirty_;
+    /* ===== Transform Storage =====
+     * Structure of arrays indexed by node slot.
+     * Slots are sorted topologically: parent slot is always less than
+     * the slot of its children, so world matrices are computed
+     * in a single linear pass without recursion */
+    hk::vector<u32> parents_;
+    hk::vector<Transform> locals_;
+    hk::vector<hkm::mat4f> local_matrices_;
+    hk::vector<hkm::mat4f> world_matrices_;
+    hk::vector<SceneNode*> nodes_;
+
+    // One bit per slot
+    hk::vector<u64> dirty_local_; // local transform changed by user
+    hk::vector<u64> dirty_world_; // world matrix recomputed this update
+
+    // Set on reparent, slots have to be resorted before next update
+    b8 unsorted_ = false;
+
+    /* ===== Object Bounds =====
+     * Indexed by idxObject. Hierarchy over world boxes is kept
+     * up to date with moved objects and answers culling and queries */
+    hk::vector<hkm::aabb> bounds_;
+    hk::vector<u32> proxies_; // hk::bvh::none until bounds are known
+    hk::vector<SceneNode*> object_nodes_;
+    hk::bvh bvh_;
+
+    // Nodes that require change in draw context, in order of arrival.
+    // Cleared after use, so its capacity is reused between frames
+    hk::vector<SceneNode*> dirty_;
+
+    hk::mem::Pool node_pool_;
+
+    ecs::Registry registry_;
+    u32 hndlMaterialEvent_ = 0;
+
+    friend struct SceneNode;
 };
 
+template<typename T>
+T* SceneNode::get()
+{
+    return graph_->registry_.try_get<T>(entity);
+}
+
 }
 
 #endif // HK_SCENE_GRAPH_H
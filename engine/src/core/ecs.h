@@ -0,0 +1,363 @@
+#ifndef HK_ECS_H
+#define HK_ECS_H
+
+#include "hkcommon.h"
+
+#include "core/jobs.h"
+
+#include "hkstl/containers/hkvector.h"
+#include "hkstl/containers/hkflat_map.h"
+#include "hkstl/strings/hkstring_id.h"
+#include "hkstl/utility/hkhandle.h"
+
+#include <tuple>
+
+/* Sparse set entity component storage.
+ * Every component type has its own pool with components packed in a dense
+ * array, sparse array maps entity index to dense position. Queries walk the
+ * smallest pool and skip entities missing other components.
+ * Adding or removing component of a type invalidates pointers into its pool */
+namespace hk::ecs {
+
+using Entity = Handle<struct EntityTag>;
+
+// Same across engine and app modules, unlike static counters
+template<typename T>
+constexpr u64 type_id()
+{
+#ifdef _MSC_VER
+    return string_id::hash(__FUNCSIG__);
+#else
+    return string_id::hash(__PRETTY_FUNCTION__);
+#endif
+}
+
+/* ===== Storage ===== */
+class Storage {
+public:
+    static constexpr u32 none = static_cast<u32>(-1);
+
+    virtual ~Storage() = default;
+
+    // Returns false when entity doesn't have component
+    virtual b8 remove(Entity entity) = 0;
+    virtual void clear() = 0;
+
+    inline b8 contains(Entity entity) const
+    {
+        return entity.index < sparse_.size() && sparse_[entity.index] != none &&
+               dense_[sparse_[entity.index]].value == entity.value;
+    }
+
+    inline u32 size() const { return dense_.size(); }
+    inline b8 empty() const { return dense_.empty(); }
+
+    // Entity of component at dense position
+    inline Entity entity(u32 pos) const { return dense_[pos]; }
+    inline const Entity* entities() const { return dense_.data(); }
+
+protected:
+    // Dense position of new component
+    u32 link(Entity entity)
+    {
+        if (entity.index >= sparse_.size()) { sparse_.resize(entity.index + 1, none); }
+
+        sparse_[entity.index] = dense_.size();
+        dense_.push_back(entity);
+
+        return sparse_[entity.index];
+    }
+
+    // Moves last entity into hole, caller mirrors it in component array
+    u32 unlink(Entity entity)
+    {
+        const u32 pos = sparse_[entity.index];
+        const Entity last = dense_.back();
+
+        dense_[pos] = last;
+        sparse_[last.index] = pos;
+
+        dense_.pop_back();
+        sparse_[entity.index] = none;
+
+        return pos;
+    }
+
+protected:
+    hk::vector<u32> sparse_;   // Entity index -> dense position
+    hk::vector<Entity> dense_; // Dense position -> entity
+};
+
+template<typename T>
+class Pool final : public Storage {
+public:
+    template<typename... Args>
+    T& emplace(Entity entity, Args&& ...args)
+    {
+        DEV_ASSERT(!contains(entity), "ecs: Entity already has component");
+
+        link(entity);
+        return data_.emplace_back(hk::forward<Args>(args)...);
+    }
+
+    b8 remove(Entity entity) override
+    {
+        if (!contains(entity)) { return false; }
+
+        const u32 pos = unlink(entity);
+        if (pos != data_.size() - 1) { data_[pos] = hk::move(data_.back()); }
+        data_.pop_back();
+
+        return true;
+    }
+
+    void clear() override
+    {
+        for (const Entity &entity : dense_) { sparse_[entity.index] = none; }
+
+        dense_.clear();
+        data_.clear();
+    }
+
+    inline T& get(Entity entity)
+    {
+        DEV_ASSERT(contains(entity), "ecs: Entity doesn't have component");
+        return data_[sparse_[entity.index]];
+    }
+
+    inline T* try_get(Entity entity)
+    {
+        return contains(entity) ? &data_[sparse_[entity.index]] : nullptr;
+    }
+
+    inline T& at(u32 pos) { return data_[pos]; }
+    inline T* data() { return data_.data(); }
+
+private:
+    hk::vector<T> data_;
+};
+
+/* ===== View ===== */
+// Entities that have every one of Ts, components must not be added
+// or removed for Ts while view is iterated
+template<typename... Ts>
+class View {
+public:
+    explicit View(Pool<Ts>& ...pools) : pools_(&pools...)
+    {
+        lead_ = nullptr;
+        (pick(pools), ...);
+    }
+
+    // Upper bound of matches, size of smallest pool
+    inline u32 size_hint() const { return lead_->size(); }
+
+    inline b8 contains(Entity entity) const
+    {
+        return std::apply([entity](auto* ...pools) {
+            return (pools->contains(entity) && ...);
+        }, pools_);
+    }
+
+    // func(Entity, Ts&...)
+    template<typename Func>
+    void each(Func &&func)
+    {
+        // Reverse order keeps iteration valid when func removes
+        // components of other types from current entity
+        for (u32 i = lead_->size(); i-- > 0;) {
+            visit(lead_->entity(i), func);
+        }
+    }
+
+    /* Splits matches between job workers,
+     * func has to touch only components of entity it was given */
+    template<typename Func>
+    void parallel_each(Func &&func, u32 grain = 256)
+    {
+        hk::jobs::parallel_for(0, lead_->size(), grain, [&](u32 begin, u32 end) {
+            for (u32 i = begin; i < end; ++i) { visit(lead_->entity(i), func); }
+        });
+    }
+
+private:
+    inline void pick(Storage &pool)
+    {
+        if (!lead_ || pool.size() < lead_->size()) { lead_ = &pool; }
+    }
+
+    template<typename Func>
+    inline void visit(Entity entity, Func &func)
+    {
+        if (!contains(entity)) { return; }
+
+        std::apply([&](auto* ...pools) {
+            func(entity, pools->get(entity)...);
+        }, pools_);
+    }
+
+private:
+    std::tuple<Pool<Ts>*...> pools_;
+    Storage *lead_;
+};
+
+/* ===== Registry ===== */
+class Registry {
+public:
+    Registry() = default;
+    ~Registry() { deinit(); }
+
+    Registry(const Registry&) = delete;
+    Registry& operator=(const Registry&) = delete;
+
+    // Destroys all entities and component pools
+    void deinit()
+    {
+        for (auto &entry : storages_) { delete entry.value; }
+        storages_.clear();
+
+        generations_.clear();
+        free_.clear();
+        alive_ = 0;
+    }
+
+    /* ===== Entities ===== */
+
+    Entity create()
+    {
+        u32 index;
+
+        if (free_.size()) {
+            index = free_.back();
+            free_.pop_back();
+        } else {
+            index = generations_.size();
+            ALWAYS_ASSERT(index < (1u << Entity::index_bits), "ecs: Out of entities");
+            generations_.push_back(1);
+        }
+
+        ++alive_;
+        return entity(index, generations_[index]);
+    }
+
+    // Removes every component entity has
+    void destroy(Entity entity)
+    {
+        if (!alive(entity)) { return; }
+
+        for (auto &entry : storages_) { entry.value->remove(entity); }
+
+        // Zero generation is skipped, zero entity always stays invalid
+        u32 &gen = generations_[entity.index];
+        gen = (gen + 1) & ((1u << Entity::gen_bits) - 1);
+        if (!gen) { gen = 1; }
+
+        free_.push_back(entity.index);
+        --alive_;
+    }
+
+    inline b8 alive(Entity entity) const
+    {
+        return entity.value && entity.index < generations_.size() &&
+               generations_[entity.index] == entity.gen;
+    }
+
+    inline u32 size() const { return alive_; }
+
+    /* ===== Components ===== */
+
+    template<typename T, typename... Args>
+    inline T& emplace(Entity entity, Args&& ...args)
+    {
+        DEV_ASSERT(alive(entity), "ecs: Entity is not alive");
+        return storage<T>().emplace(entity, hk::forward<Args>(args)...);
+    }
+
+    template<typename T, typename... Args>
+    T& emplace_or_replace(Entity entity, Args&& ...args)
+    {
+        Pool<T> &pool = storage<T>();
+
+        if (T *component = pool.try_get(entity)) {
+            *component = T(hk::forward<Args>(args)...);
+            return *component;
+        }
+
+        DEV_ASSERT(alive(entity), "ecs: Entity is not alive");
+        return pool.emplace(entity, hk::forward<Args>(args)...);
+    }
+
+    // Arguments are used only when entity doesn't have component yet
+    template<typename T, typename... Args>
+    T& get_or_emplace(Entity entity, Args&& ...args)
+    {
+        Pool<T> &pool = storage<T>();
+
+        if (T *component = pool.try_get(entity)) { return *component; }
+
+        DEV_ASSERT(alive(entity), "ecs: Entity is not alive");
+        return pool.emplace(entity, hk::forward<Args>(args)...);
+    }
+
+    // Returns false when entity didn't have component
+    template<typename T>
+    inline b8 remove(Entity entity) { return storage<T>().remove(entity); }
+
+    template<typename T>
+    inline b8 has(Entity entity) const
+    {
+        const Storage *pool = find(type_id<T>());
+        return pool && pool->contains(entity);
+    }
+
+    template<typename T>
+    inline T& get(Entity entity) { return storage<T>().get(entity); }
+
+    // nullptr when entity doesn't have component
+    template<typename T>
+    inline T* try_get(Entity entity) { return storage<T>().try_get(entity); }
+
+    // Removes component from every entity
+    template<typename T>
+    inline void clear() { storage<T>().clear(); }
+
+    // Pool is created on first use
+    template<typename T>
+    Pool<T>& storage()
+    {
+        Storage *&pool = storages_[type_id<T>()];
+        if (!pool) { pool = new Pool<T>(); }
+
+        return static_cast<Pool<T>&>(*pool);
+    }
+
+    template<typename... Ts>
+    inline View<Ts...> view() { return View<Ts...>(storage<Ts>()...); }
+
+private:
+    static inline Entity entity(u32 index, u32 gen)
+    {
+        Entity out;
+        out.value = 0;
+        out.index = index;
+        out.gen = gen;
+        return out;
+    }
+
+    inline const Storage* find(u64 type) const
+    {
+        Storage *const *pool = storages_.find(type);
+        return pool ? *pool : nullptr;
+    }
+
+private:
+    hk::flat_map<u64, Storage*> storages_; // type_id -> pool
+
+    hk::vector<u32> generations_;
+    hk::vector<u32> free_;
+    u32 alive_ = 0;
+};
+
+}
+
+#endif // HK_ECS_H
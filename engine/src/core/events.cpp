@@ -1,90 +1,310 @@
 #include "events.h"
+#include "profiler.h"
 
 #include "hkstl/Logger.h"
+#include "hkstl/containers/hkmpmc_ring.h"
+
+#include <atomic>
+#include <mutex>
 
 namespace hk::event {
 
-static std::unordered_map<u32, std::vector<Subscriber>> subscribers;
+/* Ring first, locked overflow vector after it, so nothing is lost
+ * when producers outrun dispatch. Overflow allocates, but only once
+ * ring is full, which should never happen in a normal frame */
+template<u32 N>
+class Queue {
+public:
+    void push(const Event &event)
+    {
+        if (ring_.push(event)) { return; }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        overflow_.push_back(event);
+        overflow_size_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Appends everything queued so far to out
+    void drain(hk::vector<Event> &out)
+    {
+        Event event;
+        while (ring_.pop(event)) {
+            out.push_back(event);
+        }
+
+        if (!overflow_size_.load(std::memory_order_relaxed)) { return; }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (u32 i = 0; i < overflow_.size(); ++i) {
+            out.push_back(overflow_[i]);
+        }
+        overflow_.clear();
+        overflow_size_.store(0, std::memory_order_relaxed);
+    }
+
+    void clear()
+    {
+        ring_.clear();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        overflow_.clear();
+        overflow_size_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    hk::mpmc_ring<Event, N> ring_;
+
+    std::mutex mutex_;
+    hk::vector<Event> overflow_;
+    std::atomic<u32> overflow_size_ { 0 };
+};
+
+// Subscribers are owned by main thread, count is readable from any thread
+struct Channel {
+    hk::vector<Subscriber> subscribers;
+    std::atomic<u32> count { 0 };
+};
+
+/* Mouse moves are coalesced per frame instead of being queued,
+ * position keeps the latest value, raw deltas are summed */
+struct MouseAccumulator {
+    std::atomic<u64> position { 0 };
+    std::atomic<b8> moved { false };
+
+    std::atomic<u64> raw_delta { 0 };
+    std::atomic<b8> raw_moved { false };
+};
+
+static struct EventsContext {
+    Channel channels[MAX_CODES];
+
+    // Handle is code in upper bits and serial in lower ones
+    u32 serial = 0;
+
+    Queue<256> system;
+    Queue<1024> input;
+    MouseAccumulator mouse;
+
+    // Reused every frame, so dispatch doesn't allocate
+    hk::vector<Event> batch;
 
-// TODO: make size customizable, maybe through init
-/* PERF: Don't want to add a separate event system for input
- * but without separating other events and input events
- * they just overflow buffer with mouse move events.
- * So current size is a compromise, I guess.
- * Probably will change it in the future, but right know it's not
- * an issue */
-static hk::ring_buffer<Event, 1000, true> buffer;
+    // Callbacks may change subscribers while their channel is iterated,
+    // such changes are applied once dispatch is finished
+    b8 dispatching = false;
+    b8 removed = false;
+    hk::vector<Subscriber> added;
+} ctx;
+
+static constexpr u32 serial_bits = 24;
+static constexpr u32 serial_mask = (1u << serial_bits) - 1;
+
+static b8 is_input(u32 code)
+{
+    return code >= EVENT_KEY_PRESSED && code <= EVENT_MOUSE_WHEEL;
+}
+
+static u64 pack(const EventContext &context)
+{
+    return context.u64;
+}
+
+static EventContext unpack(u64 value)
+{
+    EventContext context;
+    context.u64 = value;
+    return context;
+}
+
+static void reset()
+{
+    for (auto &channel : ctx.channels) {
+        channel.subscribers.clear();
+        channel.count = 0;
+    }
+
+    ctx.system.clear();
+    ctx.input.clear();
+    ctx.batch.clear();
+
+    ctx.dispatching = false;
+    ctx.removed = false;
+    ctx.added.clear();
+
+    ctx.mouse.moved = false;
+    ctx.mouse.raw_moved = false;
+    ctx.mouse.raw_delta = 0;
+}
 
 void init()
 {
     LOG_INFO("Event System initialized");
-    buffer.clear();
-    subscribers.clear();
+    reset();
 }
 
 void deinit()
 {
-    buffer.clear();
-    subscribers.clear();
+    reset();
 }
 
-b8 subscribe(u32 code, const EventCallback &callback, void *listener)
+u32 subscribe(u32 code, const EventCallback &callback, void *listener)
 {
-    for (auto &sub : subscribers[code]) {
-        if (sub.listener == listener &&
-            sub.callback.target<EventCallback>() ==
-            callback.target<EventCallback>())
-        {
-            LOG_WARN("Trying to register already existing callback");
-            return false;
-        }
+    ALWAYS_ASSERT(code < MAX_CODES, "Event code is out of range");
+
+    Channel &channel = ctx.channels[code];
+
+    // Serial starts from 1, so 0 is never a valid handle
+    ctx.serial = (ctx.serial + 1) & serial_mask;
+    if (!ctx.serial) { ctx.serial = 1; }
+
+    const u32 handle = (code << serial_bits) | ctx.serial;
+
+    if (ctx.dispatching) {
+        ctx.added.push_back({listener, callback, handle});
+        return handle;
     }
 
-    subscribers[code].push_back({listener, callback});
-    return true;
+    channel.subscribers.push_back({listener, callback, handle});
+    channel.count.store(channel.subscribers.size(), std::memory_order_release);
+
+    return handle;
 }
 
-// TODO: maybe unsubscribe by uuid?
-b8 unsubscribe(u32 code, const EventCallback &callback, void *listener)
+b8 unsubscribe(u32 handle)
 {
-    for (u32 i = 0; i < subscribers[code].size(); i++) {
-        auto &sub = subscribers[code].at(i);
-        if (sub.listener == listener &&
-                sub.callback.target<EventCallback>() ==
-                callback.target<EventCallback>())
-        {
-            subscribers[code].erase(subscribers[code].begin() + i);
+    const u32 code = handle >> serial_bits;
+    if (!handle || code >= MAX_CODES) { return false; }
+
+    Channel &channel = ctx.channels[code];
+
+    for (u32 i = 0; i < channel.subscribers.size(); ++i) {
+        if (channel.subscribers[i].handle != handle) { continue; }
+
+        if (ctx.dispatching) {
+            // Callback may be running right now, remove it later
+            channel.subscribers[i].handle = 0;
+            ctx.removed = true;
             return true;
         }
+
+        channel.subscribers.erase(i);
+        channel.count.store(channel.subscribers.size(), std::memory_order_release);
+        return true;
+    }
+
+    for (u32 i = 0; i < ctx.added.size(); ++i) {
+        if (ctx.added[i].handle != handle) { continue; }
+
+        ctx.added.erase(i);
+        return true;
     }
 
     LOG_WARN("Event to unsubscribe was not found");
     return false;
-
 }
 
 b8 fire(u32 code, const EventContext &userdata, void *sender)
 {
-    if (!subscribers[code].size()) { return true; }
+    if (code >= MAX_CODES) {
+        LOG_WARN("Event code is out of range:", code);
+        return false;
+    }
+
+    if (!ctx.channels[code].count.load(std::memory_order_acquire)) {
+        return true;
+    }
+
+    switch (code) {
+    case EVENT_MOUSE_MOVED: {
+        ctx.mouse.position.store(pack(userdata), std::memory_order_relaxed);
+        ctx.mouse.moved.store(true, std::memory_order_release);
+    } break;
+
+    case EVENT_RAW_MOUSE_MOVED: {
+        u64 expected = ctx.mouse.raw_delta.load(std::memory_order_relaxed);
+        EventContext sum;
+        do {
+            sum = unpack(expected);
+            sum.i32[0] += userdata.i32[0];
+            sum.i32[1] += userdata.i32[1];
+        } while (!ctx.mouse.raw_delta.compare_exchange_weak(expected, pack(sum)));
+
+        ctx.mouse.raw_moved.store(true, std::memory_order_release);
+    } break;
+
+    default: {
+        if (is_input(code)) {
+            ctx.input.push({sender, code, userdata});
+        } else {
+            ctx.system.push({sender, code, userdata});
+        }
+    } break;
+    }
 
-    buffer.push({sender, code, userdata});
     return true;
 }
 
+static void dispatch(const Event &event)
+{
+    for (auto &sub : ctx.channels[event.code].subscribers) {
+        if (!sub.handle) { continue; } // Unsubscribed during dispatch
+
+        sub.callback(event.userdata, sub.listener);
+    }
+}
+
+static void apply_changes()
+{
+    if (ctx.removed) {
+        for (auto &channel : ctx.channels) {
+            for (u32 i = channel.subscribers.size(); i-- > 0;) {
+                if (!channel.subscribers[i].handle) { channel.subscribers.erase(i); }
+            }
+            channel.count.store(channel.subscribers.size(), std::memory_order_release);
+        }
+        ctx.removed = false;
+    }
+
+    for (auto &sub : ctx.added) {
+        Channel &channel = ctx.channels[sub.handle >> serial_bits];
+        channel.subscribers.push_back(hk::move(sub));
+        channel.count.store(channel.subscribers.size(), std::memory_order_release);
+    }
+    ctx.added.clear();
+}
+
 void dispatch()
 {
-    Event event;
-    while (buffer.pop(event)) {
+    HK_PROFILE_FUNCTION();
+
+    // Events fired during dispatch are handled next frame
+    ctx.batch.clear();
+    ctx.dispatching = true;
+
+    ctx.input.drain(ctx.batch);
+
+    if (ctx.mouse.moved.exchange(false, std::memory_order_acquire)) {
+        const u64 position = ctx.mouse.position.load(std::memory_order_relaxed);
+        ctx.batch.push_back({nullptr, EVENT_MOUSE_MOVED, unpack(position)});
+    }
 
+    if (ctx.mouse.raw_moved.exchange(false, std::memory_order_acquire)) {
+        const u64 delta = ctx.mouse.raw_delta.exchange(0, std::memory_order_relaxed);
+        ctx.batch.push_back({nullptr, EVENT_RAW_MOUSE_MOVED, unpack(delta)});
+    }
+
+    ctx.system.drain(ctx.batch);
+
+    for (u32 i = 0; i < ctx.batch.size(); ++i) {
         // LOG_DEBUG("Dispatching",
-        //           getEventStr(static_cast<hk::EventCode>(event.code)),
-        //           "to", subscribers[event.code].size(),
+        //           getEventStr(static_cast<hk::EventCode>(ctx.batch[i].code)),
+        //           "to", ctx.channels[ctx.batch[i].code].subscribers.size(),
         //           "subscriber(s)");
 
-        for (auto &sub : subscribers[event.code]) {
-            sub.callback(event.userdata, sub.listener);
-        }
+        dispatch(ctx.batch[i]);
     }
+
+    ctx.dispatching = false;
+    apply_changes();
 }
 
 }
@@ -3,24 +3,23 @@
 
 #include "hkcommon.h"
 #include "hkstl/containers/hkvector.h"
-#include "hkstl/containers/hkring_buffer.h"
 
 #include <functional>
-#include <unordered_map>
 
 namespace hk::event {
 
 struct EventContext {
+    // Qualified types, GCC rejects members that change meaning of a name
     union {
-        u16 u16[4];
-        i16 i16[4];
+        ::u16 u16[4];
+        ::i16 i16[4];
 
-        u32 u32[2];
-        i32 i32[2];
+        ::u32 u32[2];
+        ::i32 i32[2];
 
-        f32 f32[2];
+        ::f32 f32[2];
 
-        u64 u64;
+        ::u64 u64;
     };
 };
 
@@ -37,14 +36,21 @@ struct Event {
 struct Subscriber {
     void *listener;
     EventCallback callback;
+    u32 handle;
 };
 
-HKAPI b8 subscribe(u32 code, const EventCallback &callback,
-                   void *listener = nullptr);
+// Application codes must stay below it, subscribers are stored per code
+constexpr u32 MAX_CODES = 256;
 
-HKAPI b8 unsubscribe(u32 code, const EventCallback &callback,
-                     void *listener = nullptr);
+// Returns handle for unsubscribe, never 0
+HKAPI u32 subscribe(u32 code, const EventCallback &callback,
+                    void *listener = nullptr);
 
+HKAPI b8 unsubscribe(u32 handle);
+
+/* Safe to call from any thread, callbacks are invoked by dispatch()
+ * Mouse moves are merged into one event per frame,
+ * input and other events are queued separately and never dropped */
 HKAPI b8 fire(u32 code, const EventContext &userdata,
               void *sender = nullptr);
 
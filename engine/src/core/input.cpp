@@ -30,6 +30,8 @@ static KeyboardState keyboard;
 static MouseState mouse;
 static b8 initialized = false;
 
+static u32 subscriptions[7] = {};
+
 void update()
 {
     mouse.z_delta = 0;
@@ -152,14 +154,14 @@ void init()
 {
     initialized = true;
 
-    hk::event::subscribe(hk::event::EVENT_KEY_PRESSED, registerKeyPress);
-    hk::event::subscribe(hk::event::EVENT_KEY_RELEASED, registerKeyPress);
+    subscriptions[0] = hk::event::subscribe(hk::event::EVENT_KEY_PRESSED,  registerKeyPress);
+    subscriptions[1] = hk::event::subscribe(hk::event::EVENT_KEY_RELEASED, registerKeyPress);
 
-    hk::event::subscribe(hk::event::EVENT_MOUSE_MOVED,     registerMouseMove);
-    hk::event::subscribe(hk::event::EVENT_RAW_MOUSE_MOVED, registerRawMouseMove);
-    hk::event::subscribe(hk::event::EVENT_MOUSE_PRESSED,   registerMousePress);
-    hk::event::subscribe(hk::event::EVENT_MOUSE_RELEASED,  registerMousePress);
-    hk::event::subscribe(hk::event::EVENT_MOUSE_WHEEL,     registerMouseWheel);
+    subscriptions[2] = hk::event::subscribe(hk::event::EVENT_MOUSE_MOVED,     registerMouseMove);
+    subscriptions[3] = hk::event::subscribe(hk::event::EVENT_RAW_MOUSE_MOVED, registerRawMouseMove);
+    subscriptions[4] = hk::event::subscribe(hk::event::EVENT_MOUSE_PRESSED,   registerMousePress);
+    subscriptions[5] = hk::event::subscribe(hk::event::EVENT_MOUSE_RELEASED,  registerMousePress);
+    subscriptions[6] = hk::event::subscribe(hk::event::EVENT_MOUSE_WHEEL,     registerMouseWheel);
 
     LOG_INFO("Input Subsystem initialized");
 }
@@ -168,14 +170,10 @@ void deinit()
 {
     if (!initialized) { return; }
 
-    hk::event::unsubscribe(hk::event::EVENT_KEY_PRESSED,  registerKeyPress);
-    hk::event::unsubscribe(hk::event::EVENT_KEY_RELEASED, registerKeyPress);
-
-    hk::event::unsubscribe(hk::event::EVENT_MOUSE_MOVED,     registerMouseMove);
-    hk::event::unsubscribe(hk::event::EVENT_RAW_MOUSE_MOVED, registerRawMouseMove);
-    hk::event::unsubscribe(hk::event::EVENT_MOUSE_PRESSED,   registerMousePress);
-    hk::event::unsubscribe(hk::event::EVENT_MOUSE_RELEASED,  registerMousePress);
-    hk::event::unsubscribe(hk::event::EVENT_MOUSE_WHEEL,     registerMouseWheel);
+    for (u32 &handle : subscriptions) {
+        hk::event::unsubscribe(handle);
+        handle = 0;
+    }
 
     LOG_INFO("Input Subsystem deinitialized");
 }
@@ -223,6 +221,7 @@ void registerRawMouseMove(const hk::event::EventContext &mouseinfo, void*)
         return;
     }
 
+    // Sum of all raw moves since last dispatch
     i32 x_delta = mouseinfo.i32[0];
     i32 y_delta = mouseinfo.i32[1];
 
@@ -0,0 +1,389 @@
+#include "jobs.h"
+
+#include "utils/spec.h"
+#include "hkstl/Logger.h"
+#include "hkstl/containers/hkvector.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hk::jobs {
+
+static constexpr i64 deque_capacity = 4096; // Power of 2
+static constexpr i64 deque_mask = deque_capacity - 1;
+
+// Spins before worker goes to sleep
+static constexpr u32 idle_spins = 64;
+
+/* Chase-Lev work-stealing deque
+ * "Correct and Efficient Work-Stealing for Weak Memory Models", Le et al.
+ * Fixed capacity, push fails when deque is full */
+class Deque {
+public:
+    b8 push(const Job &job)
+    {
+        i64 b = bottom_.load(std::memory_order_relaxed);
+        i64 t = top_.load(std::memory_order_acquire);
+
+        if (b - t >= deque_capacity) { return false; }
+
+        slots_[b & deque_mask].store(job);
+
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    // Owner only
+    b8 pop(Job &job)
+    {
+        i64 b = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(b, std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        i64 t = top_.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        job = slots_[b & deque_mask].load();
+
+        if (t == b) {
+            // Last job, race against thieves
+            b8 won = top_.compare_exchange_strong(t, t + 1,
+                                                  std::memory_order_seq_cst,
+                                                  std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+
+        return true;
+    }
+
+    b8 steal(Job &job)
+    {
+        i64 t = top_.load(std::memory_order_acquire);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        i64 b = bottom_.load(std::memory_order_acquire);
+
+        if (t >= b) { return false; }
+
+        Job out = slots_[t & deque_mask].load();
+
+        if (!top_.compare_exchange_strong(t, t + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed))
+        {
+            return false;
+        }
+
+        job = out;
+        return true;
+    }
+
+private:
+    // Fields are atomic since thief may read slot while owner rewrites it,
+    // such read is always discarded by failed CAS
+    struct Slot {
+        std::atomic<JobFunc> func;
+        std::atomic<void*> data;
+        std::atomic<Counter*> counter;
+
+        void store(const Job &job)
+        {
+            func.store(job.func, std::memory_order_relaxed);
+            data.store(job.data, std::memory_order_relaxed);
+            counter.store(job.counter, std::memory_order_relaxed);
+        }
+
+        Job load() const
+        {
+            return {
+                func.load(std::memory_order_relaxed),
+                data.load(std::memory_order_relaxed),
+                counter.load(std::memory_order_relaxed),
+            };
+        }
+    };
+
+    alignas(64) std::atomic<i64> top_ { 0 };
+    alignas(64) std::atomic<i64> bottom_ { 0 };
+
+    alignas(64) Slot slots_[deque_capacity];
+};
+
+static struct JobsContext {
+    u32 count = 0; // Workers including main thread
+    Deque *deques = nullptr;
+    std::vector<std::thread> threads;
+
+    std::atomic<b8> running { false };
+
+    std::atomic<u32> pending { 0 };  // Jobs sitting in queues
+    std::atomic<u32> sleeping { 0 };
+    std::mutex mutex;
+    std::condition_variable wake;
+
+    // Jobs submitted from threads outside of job system
+    std::mutex external_mutex;
+    hk::vector<Job> external;
+    std::atomic<u32> external_size { 0 };
+} ctx;
+
+static thread_local u32 this_worker = ~0u;
+
+static void notify()
+{
+    if (!ctx.sleeping.load()) { return; }
+
+    // Empty lock makes sure sleeper either sees pending jobs or is notified
+    { std::lock_guard<std::mutex> lock(ctx.mutex); }
+    ctx.wake.notify_all();
+}
+
+static void execute(const Job &job)
+{
+    job.func(job.data);
+
+    if (job.counter) {
+        job.counter->value.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+static b8 find_job(u32 idx, Job &job)
+{
+    if (idx < ctx.count && ctx.deques[idx].pop(job)) {
+        ctx.pending.fetch_sub(1);
+        return true;
+    }
+
+    // Start stealing from neighbour to spread contention
+    for (u32 i = 1; i <= ctx.count; ++i) {
+        u32 victim = (idx + i) % ctx.count;
+        if (victim == idx) { continue; }
+
+        if (ctx.deques[victim].steal(job)) {
+            ctx.pending.fetch_sub(1);
+            return true;
+        }
+    }
+
+    if (ctx.external_size.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(ctx.external_mutex);
+        if (ctx.external.size()) {
+            job = ctx.external.back();
+            ctx.external.pop_back();
+            ctx.external_size.fetch_sub(1, std::memory_order_relaxed);
+            ctx.pending.fetch_sub(1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void worker_loop(u32 idx)
+{
+    this_worker = idx;
+
+    Job job;
+    u32 spins = 0;
+
+    while (ctx.running.load(std::memory_order_relaxed)) {
+        if (find_job(idx, job)) {
+            execute(job);
+            spins = 0;
+            continue;
+        }
+
+        if (++spins < idle_spins) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(ctx.mutex);
+        ctx.sleeping.fetch_add(1);
+        ctx.wake.wait(lock, []() {
+            return ctx.pending.load() || !ctx.running.load();
+        });
+        ctx.sleeping.fetch_sub(1);
+
+        spins = 0;
+    }
+}
+
+void init()
+{
+    ctx.count = hk::spec::cpu().threads ? hk::spec::cpu().threads : 1;
+    ctx.deques = new Deque[ctx.count];
+
+    ctx.pending = 0;
+    ctx.sleeping = 0;
+    ctx.running = true;
+
+    // Main thread
+    this_worker = 0;
+
+    ctx.threads.reserve(ctx.count - 1);
+    for (u32 i = 1; i < ctx.count; ++i) {
+        ctx.threads.emplace_back(worker_loop, i);
+    }
+
+    LOG_INFO("Job System initialized with", ctx.count, "workers");
+}
+
+void deinit()
+{
+    ctx.running = false;
+
+    { std::lock_guard<std::mutex> lock(ctx.mutex); }
+    ctx.wake.notify_all();
+
+    for (auto &thread : ctx.threads) {
+        thread.join();
+    }
+    ctx.threads.clear();
+
+    delete[] ctx.deques;
+    ctx.deques = nullptr;
+    ctx.count = 0;
+
+    ctx.external.clear();
+    ctx.external_size = 0;
+}
+
+u32 workers()
+{
+    return ctx.count;
+}
+
+u32 worker()
+{
+    return this_worker < ctx.count ? this_worker : ctx.count;
+}
+
+void submit(const Job &job)
+{
+    DEV_ASSERT(job.func, "Job without function");
+
+    if (job.counter) {
+        job.counter->value.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Not initialized yet, run in place
+    if (!ctx.count) {
+        execute(job);
+        return;
+    }
+
+    ctx.pending.fetch_add(1);
+
+    if (this_worker < ctx.count) {
+        if (!ctx.deques[this_worker].push(job)) {
+            // Deque is full, no point in queueing more
+            ctx.pending.fetch_sub(1);
+            execute(job);
+            return;
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(ctx.external_mutex);
+        ctx.external.push_back(job);
+        ctx.external_size.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    notify();
+}
+
+void submit(const Job *jobs, u32 count)
+{
+    for (u32 i = 0; i < count; ++i) {
+        submit(jobs[i]);
+    }
+}
+
+void wait(Counter *counter)
+{
+    const u32 idx = this_worker;
+
+    Job job;
+    while (counter->value.load(std::memory_order_acquire)) {
+        if (ctx.count && find_job(idx, job)) {
+            execute(job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+/* ===== Parallel For ===== */
+struct ForContext {
+    const RangeFunc *func;
+
+    u32 end;
+    u32 grain;
+    std::atomic<u32> next;
+};
+
+// Every job claims chunks until range is exhausted,
+// so slow chunks don't leave other workers without work
+static void for_job(void *data)
+{
+    ForContext &fc = *reinterpret_cast<ForContext*>(data);
+
+    for (;;) {
+        u32 begin = fc.next.fetch_add(fc.grain, std::memory_order_relaxed);
+        if (begin >= fc.end) { break; }
+
+        u32 end = fc.end - begin > fc.grain ? begin + fc.grain : fc.end;
+        (*fc.func)(begin, end);
+    }
+}
+
+void parallel_for(u32 begin, u32 end, u32 grain, const RangeFunc &func)
+{
+    if (begin >= end) { return; }
+
+    const u32 size = end - begin;
+    const u32 count = ctx.count ? ctx.count : 1;
+
+    if (!grain) {
+        // Few chunks per worker to balance uneven work
+        grain = size / (count * 4);
+        grain = grain ? grain : 1;
+    }
+
+    const u32 chunks = (size + grain - 1) / grain;
+
+    if (chunks <= 1 || count == 1) {
+        func(begin, end);
+        return;
+    }
+
+    ForContext fc;
+    fc.func = &func;
+    fc.end = end;
+    fc.grain = grain;
+    fc.next = begin;
+
+    Counter counter;
+
+    // Calling thread participates as well
+    const u32 helpers = (chunks < count ? chunks : count) - 1;
+    for (u32 i = 0; i < helpers; ++i) {
+        submit({ for_job, &fc, &counter });
+    }
+
+    for_job(&fc);
+
+    wait(&counter);
+}
+
+}
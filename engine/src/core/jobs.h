@@ -0,0 +1,59 @@
+#ifndef HK_JOBS_H
+#define HK_JOBS_H
+
+#include "hkcommon.h"
+#include "hkstl/utility/hktypes.h"
+
+#include <atomic>
+#include <functional>
+
+/* Work-stealing job system.
+ * One worker per logical processor, main thread is worker 0 and
+ * executes jobs only while waiting on a counter.
+ * Each worker owns a Chase-Lev deque: owner pushes and pops at the bottom,
+ * idle workers steal from the top of other deques */
+namespace hk::jobs {
+
+// Amount of unfinished jobs, acts as a fence for wait()
+struct Counter {
+    std::atomic<u32> value { 0 };
+};
+
+using JobFunc = void(*)(void *data);
+
+struct Job {
+    JobFunc func = nullptr;
+    void *data = nullptr;
+
+    // Decremented when job is finished, can be nullptr
+    Counter *counter = nullptr;
+};
+
+void init();
+void deinit();
+
+// Including main thread
+HKAPI u32 workers();
+// Index of calling worker, workers() for threads outside of job system
+HKAPI u32 worker();
+
+HKAPI void submit(const Job &job);
+HKAPI void submit(const Job *jobs, u32 count);
+
+// Executes pending jobs until counter reaches zero
+HKAPI void wait(Counter *counter);
+
+using RangeFunc = std::function<void(u32 begin, u32 end)>;
+
+// Splits [begin, end) into chunks of grain indices and blocks until
+// all of them are processed. Grain of 0 picks chunk size by worker count
+HKAPI void parallel_for(u32 begin, u32 end, u32 grain, const RangeFunc &func);
+
+inline void parallel_for(u32 count, const RangeFunc &func)
+{
+    parallel_for(0, count, 0, func);
+}
+
+}
+
+#endif // HK_JOBS_H
@@ -0,0 +1,298 @@
+#include "profiler.h"
+
+#include "platform/filesystem.h"
+#include "hkstl/Logger.h"
+#include "hkstl/containers/hkspsc_ring.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace hk::profiler {
+
+static constexpr u32 ring_capacity = 8192; // Events per thread between frames
+static constexpr u32 max_depth = 64;
+static constexpr u32 history_size = 128;  // Frames kept for export
+
+struct ThreadBuffer {
+    u32 id = 0;
+    std::atomic<u32> dropped { 0 };
+
+    hk::spsc_ring<Event, ring_capacity> ring;
+};
+
+static struct ProfilerContext {
+    std::chrono::steady_clock::time_point start;
+
+    std::atomic<b8> capturing { false };
+
+    // Bumped on init, so threads re-register after restart
+    std::atomic<u32> generation { 0 };
+
+    std::mutex mutex; // Guards buffers list, not rings themselves
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+    u64 index = 0;
+    u64 frame_begin = 0;
+    b8 frame_captured = false; // Capture was on at some point during frame
+
+    Frame history[history_size];
+} ctx;
+
+static constexpr u64 no_frame = ~0ull;
+
+struct OpenScope {
+    const char *name;
+    u64 begin;
+};
+
+static thread_local ThreadBuffer *this_buffer = nullptr;
+static thread_local u32 this_generation = 0;
+static thread_local u32 this_depth = 0;
+static thread_local OpenScope this_stack[max_depth];
+
+static u64 now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - ctx.start).count();
+}
+
+static ThreadBuffer* buffer()
+{
+    u32 generation = ctx.generation.load(std::memory_order_acquire);
+
+    if (this_buffer && this_generation == generation) { return this_buffer; }
+
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+
+    ctx.buffers.push_back(std::make_unique<ThreadBuffer>());
+    ThreadBuffer *out = ctx.buffers.back().get();
+    out->id = static_cast<u32>(ctx.buffers.size() - 1);
+
+    this_buffer = out;
+    this_generation = generation;
+    this_depth = 0;
+
+    return out;
+}
+
+void init()
+{
+    ctx.start = std::chrono::steady_clock::now();
+
+    ctx.index = 0;
+    ctx.frame_begin = 0;
+    ctx.frame_captured = false;
+
+    for (Frame &frame : ctx.history) {
+        frame.index = no_frame;
+        frame.events.clear();
+    }
+
+    ctx.generation.fetch_add(1, std::memory_order_release);
+
+    // Main thread is always thread 0
+    buffer();
+}
+
+void deinit()
+{
+    ctx.capturing.store(false);
+
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+
+    // Threads still holding buffers see generation change on next scope
+    ctx.generation.fetch_add(1, std::memory_order_release);
+    ctx.buffers.clear();
+
+    for (Frame &frame : ctx.history) {
+        frame.index = no_frame;
+        frame.events = hk::vector<Event>();
+    }
+}
+
+void frame()
+{
+    u64 time = now();
+
+    b8 enabled = ctx.capturing.load(std::memory_order_relaxed);
+    ctx.frame_captured |= enabled;
+
+    if (ctx.frame_captured) {
+        Frame &out = ctx.history[ctx.index % history_size];
+        out.index = ctx.index;
+        out.begin = ctx.frame_begin;
+        out.end = time;
+        out.dropped = 0;
+        out.events.clear();
+
+        // PERF: events of long jobs land in frame they were finished in
+        std::lock_guard<std::mutex> lock(ctx.mutex);
+        for (auto &buffer : ctx.buffers) {
+            Event event;
+            while (buffer->ring.pop(event)) {
+                out.events.push_back(event);
+            }
+            out.dropped += buffer->dropped.exchange(0);
+        }
+
+        std::sort(out.events.begin(), out.events.end(),
+                  [](const Event &a, const Event &b) {
+            if (a.thread != b.thread) { return a.thread < b.thread; }
+            if (a.begin != b.begin) { return a.begin < b.begin; }
+            return a.depth < b.depth;
+        });
+
+        if (out.dropped) {
+            LOG_WARN("Profiler dropped", out.dropped, "events in frame", out.index);
+        }
+    }
+
+    ++ctx.index;
+    ctx.frame_begin = time;
+    ctx.frame_captured = enabled;
+}
+
+void capture(b8 enable)
+{
+    ctx.capturing.store(enable, std::memory_order_relaxed);
+}
+
+b8 capturing()
+{
+    return ctx.capturing.load(std::memory_order_relaxed);
+}
+
+u64 frame_index()
+{
+    return ctx.index;
+}
+
+const Frame* find_frame(u64 index)
+{
+    const Frame &frame = ctx.history[index % history_size];
+    return frame.index == index ? &frame : nullptr;
+}
+
+void begin(const char *name)
+{
+    buffer();
+
+    if (this_depth < max_depth) {
+        this_stack[this_depth] = { name, now() };
+    }
+
+    ++this_depth;
+}
+
+void end()
+{
+    ThreadBuffer *buf = buffer();
+
+    // Unbalanced end, probably came right after re-registration
+    if (!this_depth) { return; }
+
+    --this_depth;
+
+    if (this_depth >= max_depth) { return; }
+
+    Event event;
+    event.name = this_stack[this_depth].name;
+    event.begin = this_stack[this_depth].begin;
+    event.end = now();
+    event.thread = buf->id;
+    event.depth = this_depth;
+
+    if (!buf->ring.push(event)) {
+        buf->dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+static void append_escaped(std::string &out, const char *str)
+{
+    for (; *str; ++str) {
+        char c = *str;
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<u8>(c) < 0x20) {
+            out += ' ';
+        } else {
+            out += c;
+        }
+    }
+}
+
+static void append_event(std::string &out, const char *name, u64 begin, u64 end,
+                         u32 thread, b8 &first)
+{
+    char buf[128];
+
+    out += first ? "\n" : ",\n";
+    first = false;
+
+    out += "{\"name\":\"";
+    append_escaped(out, name);
+
+    // Trace format expects microseconds
+    std::snprintf(buf, sizeof(buf),
+                  "\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                  thread, begin / 1000.0, (end - begin) / 1000.0);
+    out += buf;
+}
+
+b8 export_trace(const std::string &path, u64 first, u64 last)
+{
+    if (first > last) { std::swap(first, last); }
+
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    b8 is_first = true;
+    u32 threads = 0;
+    u32 frames = 0;
+
+    for (u64 i = first; i <= last; ++i) {
+        const Frame *frame = find_frame(i);
+        if (!frame) { continue; }
+
+        std::string name = "Frame " + std::to_string(frame->index);
+        append_event(out, name.c_str(), frame->begin, frame->end, 0, is_first);
+
+        for (const Event &event : frame->events) {
+            append_event(out, event.name, event.begin, event.end,
+                         event.thread, is_first);
+            threads = std::max(threads, event.thread + 1);
+        }
+
+        ++frames;
+    }
+
+    for (u32 i = 0; i < threads; ++i) {
+        char buf[128];
+        std::snprintf(buf, sizeof(buf),
+                      ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+                      "\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+                      i, i ? "Thread" : "Main", i);
+        out += buf;
+    }
+
+    out += "\n]}\n";
+
+    if (!frames) {
+        LOG_WARN("No captured frames to export in range", first, "-", last);
+        return false;
+    }
+
+    if (!hk::filesystem::write_file(path, out.data(), out.size())) {
+        LOG_ERROR("Failed to write profiler trace:", path);
+        return false;
+    }
+
+    LOG_INFO("Profiler trace with", frames, "frames written to", path);
+    return true;
+}
+
+}
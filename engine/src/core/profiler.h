@@ -0,0 +1,82 @@
+#ifndef HK_PROFILER_H
+#define HK_PROFILER_H
+
+#include "hkcommon.h"
+#include "hkstl/utility/hktypes.h"
+#include "hkstl/containers/hkvector.h"
+
+#include <string>
+
+/* Frame scoped hierarchical CPU profiler.
+ * Scopes are recorded into per-thread lock-free rings and collected
+ * into frame history once per frame by the main thread.
+ * Disabled capture costs one relaxed load per scope */
+namespace hk::profiler {
+
+struct Event {
+    const char *name = nullptr; // Must outlive profiler, literals only
+    u64 begin = 0;              // ns since init
+    u64 end = 0;
+    u32 thread = 0;             // Registration order, main thread is 0
+    u32 depth = 0;              // Nesting level inside thread
+};
+
+struct Frame {
+    u64 index = 0;
+    u64 begin = 0;
+    u64 end = 0;
+
+    u32 dropped = 0; // Events lost to full thread rings
+
+    hk::vector<Event> events; // Sorted by thread, then begin
+};
+
+void init();
+void deinit();
+
+// Closes current frame and opens next one, Application calls it
+HKAPI void frame();
+
+HKAPI void capture(b8 enable);
+HKAPI b8 capturing();
+
+// Index of frame currently being recorded
+HKAPI u64 frame_index();
+
+// nullptr if frame is not in history anymore or wasn't captured
+HKAPI const Frame* find_frame(u64 index);
+
+// Writes frames [first, last] from history as Chrome trace JSON,
+// opens in chrome://tracing or ui.perfetto.dev
+HKAPI b8 export_trace(const std::string &path, u64 first, u64 last);
+
+HKAPI void begin(const char *name);
+HKAPI void end();
+
+class Scope {
+public:
+    Scope(const char *name) : active_(capturing()) { if (active_) { begin(name); } }
+    ~Scope() { if (active_) { end(); } }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    b8 active_;
+};
+
+}
+
+#define HK_PROFILE_CONCAT_IMPL(a, b) a##b
+#define HK_PROFILE_CONCAT(a, b) HK_PROFILE_CONCAT_IMPL(a, b)
+
+#ifndef HK_NO_PROFILE
+    #define HK_PROFILE_SCOPE(name) \
+        hk::profiler::Scope HK_PROFILE_CONCAT(hk_profile_scope_, __COUNTER__)(name)
+#else
+    #define HK_PROFILE_SCOPE(name)
+#endif
+
+#define HK_PROFILE_FUNCTION() HK_PROFILE_SCOPE(__FUNCTION__)
+
+#endif // HK_PROFILER_H
@@ -4,7 +4,10 @@
 #include "core/Application.h"
 #include "core/Clock.h"
 #include "core/input.h"
+#include "core/ecs.h"
 #include "core/events.h"
+#include "core/jobs.h"
+#include "core/profiler.h"
 #include "core/SceneGraph.h"
 
 #include "platform/platform.h"
@@ -12,6 +15,7 @@
 #include "platform/utils.h"
 
 #include "renderer/object/Camera.h"
+#include "renderer/gpu_profiler.h"
 #include "renderer/ui/imguiwrapper.h"
 
 #include "resources/AssetManager.h"
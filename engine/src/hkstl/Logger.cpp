@@ -1,81 +1,236 @@
 #include "Logger.h"
 
 #include "containers/hkvector.h"
-#include "containers/hkring_buffer.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
-#include <iomanip>
-#include <forward_list>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace hk::log {
 
-// For now handles will just be indexes
-// Don't even think there is a need for more complex logic
-static u32 cntHandlers = 0;
+static constexpr u32 ring_size = 256 * 1024; // Per logging thread, power of 2
+static constexpr u64 ring_mask = ring_size - 1;
 
-/* PERF: Could be 2 vectors as well, inspect which option is faster
- * https://stackoverflow.com/questions/77546017/
-   best-c-data-structure-for-fast-iteration-and-fast-insertion-removal-time
- */
-static std::forward_list<LoggerCallback> handlers;
+// Sink wakes up on its own at least this often
+static constexpr auto sink_interval = std::chrono::milliseconds(10);
 
-// Instead of using dynamic array here,
-// handlers should store all the logs they need in themselves.
-static hk::ring_buffer<Log, 100, true> logs;
+struct Header {
+    u32 size; // Whole record including header
+    u32 args; // Encoded arguments, record is aligned past them
+    u64 ticks;
+    Site site; // Padding if caller is nullptr
+};
 
-// #ifdef HKDEBUG
-static DebugInfo debug_info;
-// #endif
+static constexpr u32 record_align = 8;
+static constexpr u32 max_record = ring_size / 4;
 
-void init()
+static u32 record_size(u32 args)
 {
-    LOG_INFO("Logger initialized");
-    handlers.clear();
-    cntHandlers = 0;
+    return (sizeof(Header) + args + record_align - 1) & ~(record_align - 1);
 }
 
-void deinit()
+/* Single producer single consumer byte ring owned by one thread
+ * Records never wrap, producer pads the end of ring instead */
+struct ThreadLog {
+    alignas(64) std::atomic<u64> tail { 0 };
+    u64 head_cache = 0; // Producer's view of head
+
+    alignas(64) std::atomic<u64> head { 0 };
+
+    // Thread exited, ring is freed once drained
+    std::atomic<b8> retired { false };
+
+    alignas(64) u8 data[ring_size];
+};
+
+struct Handler {
+    u32 handle;
+    Sink sink;
+    LoggerCallback callback;
+};
+
+static struct LoggerContext {
+    std::chrono::steady_clock::time_point steady_start;
+    std::chrono::system_clock::time_point system_start;
+
+    std::mutex rings_mutex;
+    std::vector<std::unique_ptr<ThreadLog>> rings;
+
+    std::mutex handlers_mutex;
+    hk::vector<Handler> handlers;
+    u32 next_handle = 0;
+    std::atomic<b8> has_main_handlers { false };
+
+    // Formatted logs waiting for dispatch() on main thread
+    std::mutex pending_mutex;
+    hk::vector<Log> pending;
+
+    // Whoever drains rings holds it, sink thread or flush before init
+    std::mutex drain_mutex;
+
+    std::thread sink;
+    std::atomic<b8> running { false };
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    std::condition_variable drained;
+
+    std::atomic<u64> committed { 0 };
+    std::atomic<u64> processed { 0 };
+    std::atomic<u32> dropped { 0 };
+
+    // Strftime is only called once a second
+    i64 cached_second = -1;
+    char cached_time[32] = {};
+} ctx;
+
+static thread_local b8 is_sink_thread = false;
+
+/* ===== Producer side ===== */
+struct ThreadRegistration {
+    ThreadLog *ring = nullptr;
+
+    ~ThreadRegistration()
+    {
+        if (ring) { ring->retired.store(true, std::memory_order_release); }
+    }
+};
+
+static thread_local ThreadRegistration this_registration;
+
+static ThreadLog* thread_ring()
 {
-    LOG_INFO("Logger deinitialized");
-    handlers.clear();
-    cntHandlers = 0;
+    if (this_registration.ring) { return this_registration.ring; }
+
+    std::lock_guard<std::mutex> lock(ctx.rings_mutex);
+    ctx.rings.push_back(std::make_unique<ThreadLog>());
+    this_registration.ring = ctx.rings.back().get();
+
+    return this_registration.ring;
+}
+
+static void notify_sink()
+{
+    ctx.wake.notify_one();
 }
 
-u32 addMessageHandler(LoggerCallback callback)
+namespace detail {
+
+u8* reserve(const Site &site, u32 size)
 {
-    if (handlers.empty()) {
-        handlers.push_front(callback);
-        return cntHandlers++;
+    ThreadLog &ring = *thread_ring();
+
+    const u32 needed = record_size(size);
+    if (needed > max_record) {
+        ctx.dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    const u64 tail = ring.tail.load(std::memory_order_relaxed);
+    const u64 offset = tail & ring_mask;
+    const u64 padding = offset + needed > ring_size ? ring_size - offset : 0;
+
+    // Full ring waits for sink, so floods slow the thread down instead of
+    // losing logs. Without sink to wait on logs are dropped and counted
+    const b8 must_wait = !is_sink_thread &&
+                         ctx.running.load(std::memory_order_relaxed);
+
+    while (ring_size - (tail - ring.head_cache) < padding + needed) {
+        ring.head_cache = ring.head.load(std::memory_order_acquire);
+        if (ring_size - (tail - ring.head_cache) >= padding + needed) { break; }
+
+        if (!must_wait) {
+            ctx.dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        notify_sink();
+        std::this_thread::yield();
+    }
+
+    // Gaps too small for header are skipped by consumer on its own
+    if (padding >= sizeof(Header)) {
+        Header pad = {};
+        pad.size = static_cast<u32>(padding);
+        std::memcpy(ring.data + offset, &pad, sizeof(pad));
     }
+    if (padding) {
+        ring.tail.store(tail + padding, std::memory_order_release);
+    }
+
+    const u64 start = (tail + padding) & ring_mask;
 
-    auto it = handlers.begin();
-    std::advance(it, cntHandlers - 1);
-    handlers.insert_after(it, callback);
-    return cntHandlers++;
+    Header header;
+    header.size = needed;
+    header.args = size;
+    header.ticks = std::chrono::steady_clock::now().time_since_epoch().count();
+    header.site = site;
+    std::memcpy(ring.data + start, &header, sizeof(header));
+
+    return ring.data + start + sizeof(Header);
 }
 
-void removeMessageHandler(u32 handle)
+void commit(const Site &site, u32 size)
 {
-    if (handle == 0) {
-        handlers.pop_front();
-        --cntHandlers;
-        return;
+    ThreadLog &ring = *this_registration.ring;
+
+    const u64 tail = ring.tail.load(std::memory_order_relaxed);
+    ring.tail.store(tail + record_size(size), std::memory_order_release);
+
+    // Release, so drain() seeing the count also sees the tail store
+    ctx.committed.fetch_add(1, std::memory_order_release);
+
+    if (site.level <= Level::LVL_ERROR ||
+        tail - ring.head_cache > ring_size / 2)
+    {
+        notify_sink();
     }
-    auto it = handlers.begin();
-    std::advance(it, handle - 1);
-    handlers.erase_after(it);
-    --cntHandlers;
+
+    // Crash usually follows, make sure message is out
+    if (site.level == Level::LVL_FATAL) { flush(); }
 }
 
-void log(const MsgInfo &info)
+}
+
+/* ===== Consumer side ===== */
+struct Entry {
+    u64 ticks;
+    Log log;
+};
+
+static std::string format_time(u64 ticks)
 {
-    std::time_t now = std::time(nullptr);
-    std::tm tm;
-    char time_str[32];
-    localtime_s(&tm, &now);
-    std::strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", &tm);
+    using namespace std::chrono;
+
+    auto since_start = steady_clock::duration(ticks) - ctx.steady_start.time_since_epoch();
+    auto wall = ctx.system_start + duration_cast<system_clock::duration>(since_start);
+
+    std::time_t now = system_clock::to_time_t(wall);
+
+    if (now != ctx.cached_second) {
+        std::tm tm;
+#ifdef _MSC_VER
+        localtime_s(&tm, &now);
+#else
+        localtime_r(&now, &tm);
+#endif
+        std::strftime(ctx.cached_time, sizeof(ctx.cached_time),
+                      "%Y-%m-%d %H:%M:%S", &tm);
+        ctx.cached_second = now;
+    }
 
-    std::string caller = info.callerName;
+    return ctx.cached_time;
+}
+
+static std::string format_caller(const char *signature)
+{
+    std::string caller = signature;
 #ifdef _MSC_VER
     // Removes all __cdecl instances from __FUNCSIG__
     std::string r = "__cdecl ";
@@ -87,33 +242,297 @@ void log(const MsgInfo &info)
         caller.erase(i, r.length());
     }
 #endif
+    return caller;
+}
+
+static void format_args(const u8 *data, u32 size, std::string &out)
+{
+    const u8 *end = data + size;
+    char buf[64];
+
+    for (b8 first = true; data < end; first = false) {
+        detail::Tag tag = static_cast<detail::Tag>(*data++);
+
+        if (!first) { out += ' '; }
 
-    // Obtaining only file name instead of full path
-    std::string file =
-        info.filePath.substr(info.filePath.find_last_of("/\\") + 1);
+        if (tag == detail::Tag::STR) {
+            u32 length;
+            std::memcpy(&length, data, sizeof(length));
+            out.append(reinterpret_cast<const char*>(data + sizeof(length)), length);
+            data += sizeof(length) + length;
+            continue;
+        }
 
-    Log log =
-        { info.level, caller, file, info.lineNumber, time_str, info.args };
+        u64 bits;
+        std::memcpy(&bits, data, sizeof(bits));
+        data += sizeof(bits);
 
-    logs.push(log);
+        // Same output as operator<< with default stream flags
+        switch (tag) {
+        case detail::Tag::I64: {
+            i64 value;
+            std::memcpy(&value, &bits, sizeof(value));
+            std::snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(value));
+        } break;
+        case detail::Tag::U64: {
+            std::snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(bits));
+        } break;
+        case detail::Tag::F64: {
+            f64 value;
+            std::memcpy(&value, &bits, sizeof(value));
+            std::snprintf(buf, sizeof(buf), "%g", value);
+        } break;
+        case detail::Tag::BOOL: {
+            std::snprintf(buf, sizeof(buf), "%d", bits ? 1 : 0);
+        } break;
+        case detail::Tag::CHAR: {
+            buf[0] = static_cast<char>(bits);
+            buf[1] = '\0';
+        } break;
+        case detail::Tag::PTR: {
+            std::snprintf(buf, sizeof(buf), "%p", reinterpret_cast<void*>(bits));
+        } break;
+        default: {
+            buf[0] = '\0';
+        } break;
+        }
 
-// #ifdef HKDEBUG
-    debug_info.logsIssued++;
-// #endif
+        out += buf;
+    }
+}
+
+static void drain_ring(ThreadLog &ring, std::vector<Entry> &out)
+{
+    u64 head = ring.head.load(std::memory_order_relaxed);
+    const u64 tail = ring.tail.load(std::memory_order_acquire);
+
+    while (head < tail) {
+        const u64 left = ring_size - (head & ring_mask);
+        if (left < sizeof(Header)) {
+            head += left;
+            continue;
+        }
+
+        Header header;
+        std::memcpy(&header, ring.data + (head & ring_mask), sizeof(header));
+
+        if (header.site.caller) {
+            const u8 *args = ring.data + (head & ring_mask) + sizeof(Header);
+            const Site &site = header.site;
+
+            Entry entry;
+            entry.ticks = header.ticks;
+            entry.log.level = site.level;
+            entry.log.caller = format_caller(site.caller);
+            entry.log.file = site.file;
+            entry.log.line = std::to_string(site.line);
+            entry.log.time = format_time(header.ticks);
+            format_args(args, header.args, entry.log.args);
+
+            out.push_back(std::move(entry));
+        }
+
+        head += header.size;
+    }
+
+    ring.head.store(head, std::memory_order_release);
+}
+
+// Returns amount of logs handled
+static u64 drain()
+{
+    std::lock_guard<std::mutex> drain_lock(ctx.drain_mutex);
+
+    // Every record committed before this point is drained below
+    const u64 committed = ctx.committed.load(std::memory_order_acquire);
+
+    std::vector<ThreadLog*> rings;
+    {
+        std::lock_guard<std::mutex> lock(ctx.rings_mutex);
+
+        // Exited threads can't add anything, drop their empty rings
+        auto it = std::remove_if(ctx.rings.begin(), ctx.rings.end(),
+                                 [](const std::unique_ptr<ThreadLog> &ring) {
+            return ring->retired.load(std::memory_order_acquire) &&
+                   ring->head.load() == ring->tail.load();
+        });
+        ctx.rings.erase(it, ctx.rings.end());
+
+        for (auto &ring : ctx.rings) { rings.push_back(ring.get()); }
+    }
+
+    std::vector<Entry> entries;
+    for (ThreadLog *ring : rings) {
+        drain_ring(*ring, entries);
+    }
+
+    if (!entries.empty()) {
+        // Rings are ordered on their own, merge threads by time
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const Entry &a, const Entry &b) {
+            return a.ticks < b.ticks;
+        });
+
+        {
+            std::lock_guard<std::mutex> lock(ctx.handlers_mutex);
+            for (auto &entry : entries) {
+                for (auto &handler : ctx.handlers) {
+                    if (handler.sink == Sink::BACKGROUND) { handler.callback(entry.log); }
+                }
+            }
+        }
+
+        if (ctx.has_main_handlers.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(ctx.pending_mutex);
+            for (auto &entry : entries) {
+                ctx.pending.push_back(std::move(entry.log));
+            }
+        }
+    }
+
+    u64 processed = ctx.processed.load(std::memory_order_relaxed);
+    if (committed > processed) {
+        ctx.processed.store(committed, std::memory_order_release);
+    }
+
+    return entries.size();
+}
+
+static void sink_loop()
+{
+    is_sink_thread = true;
+
+    while (ctx.running.load()) {
+        {
+            std::unique_lock<std::mutex> lock(ctx.wake_mutex);
+            ctx.wake.wait_for(lock, sink_interval);
+        }
+
+        drain();
+        ctx.drained.notify_all();
+    }
+}
+
+void init()
+{
+    if (ctx.running.load()) { return; }
+
+    ctx.steady_start = std::chrono::steady_clock::now();
+    ctx.system_start = std::chrono::system_clock::now();
+    ctx.cached_second = -1;
+
+    {
+        std::lock_guard<std::mutex> lock(ctx.handlers_mutex);
+        ctx.handlers.clear();
+        ctx.has_main_handlers.store(false);
+    }
+
+    ctx.running.store(true);
+    ctx.sink = std::thread(sink_loop);
+
+    LOG_INFO("Logger initialized");
+}
+
+void deinit()
+{
+    LOG_INFO("Logger deinitialized");
+
+    if (ctx.running.exchange(false)) {
+        notify_sink();
+        ctx.sink.join();
+    }
+
+    // Whatever was logged while sink was stopping
+    drain();
+    dispatch();
+
+    std::lock_guard<std::mutex> lock(ctx.handlers_mutex);
+    ctx.handlers.clear();
+    ctx.has_main_handlers.store(false);
+}
+
+void flush()
+{
+    if (is_sink_thread) { return; }
+
+    if (!ctx.running.load()) {
+        drain();
+        return;
+    }
+
+    const u64 target = ctx.committed.load(std::memory_order_acquire);
+
+    std::unique_lock<std::mutex> lock(ctx.wake_mutex);
+    while (ctx.processed.load(std::memory_order_acquire) < target &&
+           ctx.running.load())
+    {
+        ctx.wake.notify_one();
+        ctx.drained.wait_for(lock, sink_interval);
+    }
+}
+
+u32 addMessageHandler(LoggerCallback callback, Sink sink)
+{
+    std::lock_guard<std::mutex> lock(ctx.handlers_mutex);
+
+    u32 handle = ctx.next_handle++;
+    ctx.handlers.push_back({ handle, sink, callback });
+
+    if (sink == Sink::MAIN_THREAD) { ctx.has_main_handlers.store(true); }
+
+    return handle;
+}
+
+void removeMessageHandler(u32 handle)
+{
+    std::lock_guard<std::mutex> lock(ctx.handlers_mutex);
+
+    b8 has_main = false;
+    for (u32 i = 0; i < ctx.handlers.size();) {
+        if (ctx.handlers[i].handle == handle) {
+            ctx.handlers.erase(i);
+            continue;
+        }
+
+        has_main |= ctx.handlers[i].sink == Sink::MAIN_THREAD;
+        ++i;
+    }
+
+    ctx.has_main_handlers.store(has_main);
 }
 
 void dispatch()
 {
-    Log log;
-    while (logs.pop(log)) {
-        for (auto &handle : handlers) {
-            handle(log);
+    hk::vector<Log> logs;
+    {
+        std::lock_guard<std::mutex> lock(ctx.pending_mutex);
+        if (ctx.pending.empty()) { return; }
+        std::swap(logs, ctx.pending);
+    }
+
+    // Copied, so handlers are free to add or remove handlers
+    hk::vector<LoggerCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(ctx.handlers_mutex);
+        for (auto &handler : ctx.handlers) {
+            if (handler.sink == Sink::MAIN_THREAD) {
+                callbacks.push_back(handler.callback);
+            }
+        }
+    }
+
+    for (auto &log : logs) {
+        for (auto &callback : callbacks) {
+            callback(log);
         }
     }
 }
 
 const DebugInfo& getDebugInfo()
 {
+    static DebugInfo debug_info;
+    debug_info.logsIssued = static_cast<u32>(ctx.committed.load(std::memory_order_relaxed));
+    debug_info.logsDropped = ctx.dropped.load(std::memory_order_relaxed);
     return debug_info;
 }
 
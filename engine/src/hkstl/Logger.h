@@ -2,8 +2,12 @@
 #define HK_LOGGER_H
 
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <cstring>
+#include <cstdint>
 #include <functional>
+#include <type_traits>
 
 #include "utility/hktypes.h"
 
@@ -20,27 +24,56 @@
     #define FUNCTION_SIGNATURE __func__
 #endif
 
-#define LOG(level, ...)                      \
-    hk::log::log(                            \
-    {                                        \
-        level,                               \
-        FUNCTION_SIGNATURE,                  \
-        std::strrchr("/" __FILE__, '/') + 1, \
-        STRINGIZE(__LINE__),                 \
-        hk::log::argsToString(__VA_ARGS__)   \
-    })
+// Levels above this one are compiled out with their arguments,
+// 0 fatal, 1 error, 2 warn, 3 info, 4 debug, 5 trace
+#ifndef HK_LOG_LEVEL
+    #ifdef HKDEBUG
+        #define HK_LOG_LEVEL 5
+    #else
+        #define HK_LOG_LEVEL 3
+    #endif
+#endif
+
+// Call site strings are static, they are stored as pointers
+#define LOG(level, ...)                     \
+    hk::log::write(                         \
+    {                                       \
+        level,                              \
+        FUNCTION_SIGNATURE,                 \
+        hk::log::file_name(__FILE__),       \
+        __LINE__                            \
+    }, __VA_ARGS__)
 
 #define LOG_FATAL(...) LOG(hk::log::Level::LVL_FATAL, __VA_ARGS__)
-#define LOG_ERROR(...) LOG(hk::log::Level::LVL_ERROR, __VA_ARGS__)
-#define LOG_WARN(...) LOG(hk::log::Level::LVL_WARN, __VA_ARGS__)
-#define LOG_INFO(...) LOG(hk::log::Level::LVL_INFO, __VA_ARGS__)
 
-#ifndef HKDEBUG
-    #define LOG_DEBUG(...)
-    #define LOG_TRACE(...)
+#if HK_LOG_LEVEL >= 1
+    #define LOG_ERROR(...) LOG(hk::log::Level::LVL_ERROR, __VA_ARGS__)
+#else
+    #define LOG_ERROR(...)
+#endif
+
+#if HK_LOG_LEVEL >= 2
+    #define LOG_WARN(...) LOG(hk::log::Level::LVL_WARN, __VA_ARGS__)
+#else
+    #define LOG_WARN(...)
+#endif
+
+#if HK_LOG_LEVEL >= 3
+    #define LOG_INFO(...) LOG(hk::log::Level::LVL_INFO, __VA_ARGS__)
 #else
+    #define LOG_INFO(...)
+#endif
+
+#if HK_LOG_LEVEL >= 4
     #define LOG_DEBUG(...) LOG(hk::log::Level::LVL_DEBUG, __VA_ARGS__)
+#else
+    #define LOG_DEBUG(...)
+#endif
+
+#if HK_LOG_LEVEL >= 5
     #define LOG_TRACE(...) LOG(hk::log::Level::LVL_TRACE, __VA_ARGS__)
+#else
+    #define LOG_TRACE(...)
 #endif
 
 namespace hk::log {
@@ -56,7 +89,7 @@ enum class Level {
     MAX_LVL
 };
 
-// Info left by log function
+// Formatted log sent to handlers
 struct Log {
     Level level;
     std::string caller;
@@ -66,24 +99,42 @@ struct Log {
     std::string args;
 };
 
-// Modified message sent to handlers
-struct MsgInfo {
+// Info left by LOG statement, strings must have static storage
+struct Site {
     Level level;
-    const std::string &callerName;
-    const std::string &filePath;
-    const std::string &lineNumber;
-    const std::string &args;
+    const char *caller;
+    const char *file;
+    u32 line;
 };
 
+constexpr const char* file_name(const char *path)
+{
+    const char *out = path;
+    for (const char *it = path; *it; ++it) {
+        if (*it == '/' || *it == '\\') { out = it + 1; }
+    }
+    return out;
+}
+
+/* Logs are recorded in binary form into per-thread rings and formatted
+ * by background sink thread. Handlers run either on sink thread,
+ * or on main thread inside dispatch() */
 HKAPI void init();
 HKAPI void deinit();
 
-HKAPI void log(const MsgInfo &info);
+enum class Sink {
+    MAIN_THREAD,
+    BACKGROUND, // Handler must be thread safe
+};
 
 using LoggerCallback = std::function<void(const hk::log::Log &log)>;
-HKAPI u32 addMessageHandler(LoggerCallback callback);
+HKAPI u32 addMessageHandler(LoggerCallback callback, Sink sink = Sink::MAIN_THREAD);
 HKAPI void removeMessageHandler(u32 handle);
 
+// Blocks until everything logged before the call reached handlers,
+// main thread handlers still wait for dispatch()
+HKAPI void flush();
+
 // ===== HIKAI INTERNAL USE =====
 void dispatch();
 
@@ -100,9 +151,146 @@ inline std::string argsToString(const Args& ...args)
     return res;
 }
 
+namespace detail {
+
+enum class Tag : u8 {
+    I64,
+    U64,
+    F64,
+    BOOL,
+    CHAR,
+    STR,
+    PTR,
+};
+
+// Longer strings are truncated
+constexpr u32 max_string = 16 * 1024;
+
+template<typename T>
+constexpr b8 is_char = std::is_same_v<T, char> ||
+                       std::is_same_v<T, signed char> ||
+                       std::is_same_v<T, unsigned char>;
+
+template<typename T>
+constexpr b8 is_string = std::is_same_v<T, const char*> ||
+                         std::is_same_v<T, char*> ||
+                         std::is_same_v<T, std::string> ||
+                         std::is_same_v<T, std::string_view>;
+
+// Enums go through operator<< since some of them have one
+template<typename T>
+constexpr b8 is_binary = std::is_arithmetic_v<T> || is_string<T> ||
+                         (std::is_pointer_v<T> && !std::is_function_v<std::remove_pointer_t<T>>);
+
+// Everything without binary form is formatted right away
+template<typename T>
+inline decltype(auto) prepare(const T &arg)
+{
+    if constexpr (is_binary<std::decay_t<T>>) {
+        return (arg);
+    } else {
+        std::ostringstream oss;
+        oss << arg;
+        return oss.str();
+    }
+}
+
+inline std::string_view view(const char *str)
+{
+    return str ? std::string_view(str) : std::string_view("(null)");
+}
+
+inline std::string_view view(std::string_view str)
+{
+    return str;
+}
+
+template<typename T>
+inline u32 arg_size(const T &arg)
+{
+    using D = std::decay_t<T>;
+
+    if constexpr (is_string<D>) {
+        u64 length = view(arg).size();
+        return 1 + sizeof(u32) + static_cast<u32>(length < max_string ? length : max_string);
+    } else {
+        return 1 + sizeof(u64);
+    }
+}
+
+template<typename T>
+inline u8* write_arg(u8 *out, const T &arg)
+{
+    using D = std::decay_t<T>;
+
+    Tag tag = Tag::U64;
+    u64 bits = 0;
+
+    if constexpr (is_string<D>) {
+        std::string_view str = view(arg);
+        u32 length = static_cast<u32>(str.size() < max_string ? str.size() : max_string);
+
+        *out++ = static_cast<u8>(Tag::STR);
+        std::memcpy(out, &length, sizeof(length));
+        std::memcpy(out + sizeof(length), str.data(), length);
+        return out + sizeof(length) + length;
+    } else if constexpr (std::is_same_v<D, bool>) {
+        tag = Tag::BOOL;
+        bits = arg;
+    } else if constexpr (is_char<D>) {
+        tag = Tag::CHAR;
+        bits = static_cast<u8>(arg);
+    } else if constexpr (std::is_floating_point_v<D>) {
+        tag = Tag::F64;
+        f64 value = arg;
+        std::memcpy(&bits, &value, sizeof(bits));
+    } else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>) {
+        tag = Tag::I64;
+        i64 value = arg;
+        std::memcpy(&bits, &value, sizeof(bits));
+    } else if constexpr (std::is_integral_v<D>) {
+        tag = Tag::U64;
+        bits = arg;
+    } else {
+        tag = Tag::PTR;
+        bits = static_cast<u64>(reinterpret_cast<uintptr_t>(arg));
+    }
+
+    *out++ = static_cast<u8>(tag);
+    std::memcpy(out, &bits, sizeof(bits));
+    return out + sizeof(bits);
+}
+
+// Returns space for arguments in calling thread ring,
+// nullptr if ring is full and log is dropped
+HKAPI u8* reserve(const Site &site, u32 size);
+HKAPI void commit(const Site &site, u32 size);
+
+template<typename... Args>
+inline void record(const Site &site, const Args& ...args)
+{
+    const u32 size = (0u + ... + arg_size(args));
+
+    u8 *out = reserve(site, size);
+    if (!out) { return; }
+
+    ((out = write_arg(out, args)), ...);
+
+    commit(site, size);
+}
+
+}
+
+template<typename... Args>
+inline void write(const Site &site, const Args& ...args)
+{
+    detail::record(site, detail::prepare(args)...);
+}
+
 // #ifdef HKDEBUG
 struct DebugInfo {
     u32 logsIssued = 0;
+    u32 logsDropped = 0;
 };
 
 HKAPI const DebugInfo& getDebugInfo();
@@ -0,0 +1,509 @@
+#include "hkbvh.h"
+
+#include "utility/hkassert.h"
+
+namespace hk {
+
+// Keeps flat and point boxes from reinserting on every move
+static constexpr f32 MIN_MARGIN = 1e-4f;
+
+static constexpr u32 BIN_COUNT = 16;
+
+static inline i32 higher(i32 a, i32 b) { return a > b ? a : b; }
+
+bvh::bvh(f32 margin) : margin_(margin) {}
+
+u32 bvh::insert(const hkm::aabb &box, u32 value)
+{
+    const u32 leaf = allocate();
+
+    Node &node = nodes_[leaf];
+    node.tight = box;
+    node.box = enlarge(box, margin_);
+    node.value = value;
+
+    insertLeaf(leaf);
+    ++size_;
+
+    return leaf;
+}
+
+void bvh::remove(u32 proxy)
+{
+    DEV_ASSERT(proxy < nodes_.size() && nodes_[proxy].height == 0, "bvh: Invalid proxy");
+
+    removeLeaf(proxy);
+    release(proxy);
+    --size_;
+}
+
+b8 bvh::move(u32 proxy, const hkm::aabb &box)
+{
+    DEV_ASSERT(proxy < nodes_.size() && nodes_[proxy].height == 0, "bvh: Invalid proxy");
+
+    Node &node = nodes_[proxy];
+    node.tight = box;
+
+    // Fat box that is still tight enough around new one stays
+    if (hkm::contains(node.box, box) &&
+        hkm::contains(enlarge(box, 4.f * margin_), node.box))
+    {
+        return false;
+    }
+
+    removeLeaf(proxy);
+    nodes_[proxy].box = enlarge(box, margin_);
+    insertLeaf(proxy);
+
+    return true;
+}
+
+void bvh::update(u32 proxy, const hkm::aabb &box)
+{
+    DEV_ASSERT(proxy < nodes_.size() && nodes_[proxy].height == 0, "bvh: Invalid proxy");
+
+    nodes_[proxy].tight = box;
+    nodes_[proxy].box = enlarge(box, margin_);
+}
+
+void bvh::refit()
+{
+    if (root_ == none) { return; }
+
+    // Breadth first order, parents always come before children
+    hk::vector<u32> order;
+    order.reserve(size_);
+    order.push_back(root_);
+
+    for (u32 i = 0; i < order.size(); ++i) {
+        const Node &node = nodes_[order[i]];
+        if (node.leaf()) { continue; }
+
+        order.push_back(node.left);
+        order.push_back(node.right);
+    }
+
+    for (u32 i = order.size(); i-- > 0;) {
+        Node &node = nodes_[order[i]];
+        if (node.leaf()) { continue; }
+
+        node.box = hkm::merge(nodes_[node.left].box, nodes_[node.right].box);
+    }
+}
+
+void bvh::rebuild()
+{
+    if (root_ == none) { return; }
+
+    // Leaf boxes copied out, so binning and partition walk memory in order
+    struct Ref {
+        hkm::aabb box;
+        hkm::vec3f center;
+        u32 leaf;
+    };
+
+    hk::vector<Ref> refs;
+    refs.reserve(size_);
+
+    // Leaves keep their indices, so proxies stay valid
+    free_ = none;
+    for (u32 i = nodes_.size(); i-- > 0;) {
+        if (nodes_[i].height == 0) {
+            const hkm::aabb &box = nodes_[i].box;
+            refs.push_back({ box, box.center(), i });
+        } else {
+            release(i);
+        }
+    }
+
+    struct Task {
+        u32 begin;
+        u32 end;
+        u32 parent;
+        b8 left;
+    };
+
+    hk::vector<Task> tasks;
+    hk::vector<u32> internals;
+    internals.reserve(refs.size());
+
+    tasks.push_back({ 0, refs.size(), none, false });
+
+    while (tasks.size()) {
+        const Task task = tasks.back();
+        tasks.pop_back();
+
+        u32 idx;
+
+        if (task.end - task.begin == 1) {
+            idx = refs[task.begin].leaf;
+        } else {
+            hkm::aabb bounds;
+            for (u32 i = task.begin; i < task.end; ++i) {
+                const hkm::vec3f &c = refs[i].center;
+                bounds = hkm::merge(bounds, hkm::aabb(c, c));
+            }
+
+            // Binned SAH over centroids, cost of split is count * area per side
+            f32 scale[3];
+            for (u32 axis = 0; axis < 3; ++axis) {
+                const f32 extent = bounds.max[axis] - bounds.min[axis];
+                scale[axis] = extent > 0.f ? BIN_COUNT / extent : 0.f;
+            }
+
+            const auto binOf = [&](const hkm::vec3f &center, u32 axis) {
+                const u32 bin = static_cast<u32>((center[axis] - bounds.min[axis]) * scale[axis]);
+                return bin < BIN_COUNT ? bin : BIN_COUNT - 1;
+            };
+
+            u32 counts[3][BIN_COUNT] = {};
+            hkm::aabb boxes[3][BIN_COUNT];
+
+            for (u32 i = task.begin; i < task.end; ++i) {
+                const Ref &ref = refs[i];
+
+                for (u32 axis = 0; axis < 3; ++axis) {
+                    const u32 bin = binOf(ref.center, axis);
+
+                    ++counts[axis][bin];
+                    boxes[axis][bin] = hkm::merge(boxes[axis][bin], ref.box);
+                }
+            }
+
+            u32 best_axis = 0;
+            u32 best_bin = BIN_COUNT;
+            f32 best_cost = FLT_MAX;
+
+            for (u32 axis = 0; axis < 3; ++axis) {
+                if (scale[axis] == 0.f) { continue; }
+
+                // Right side sweep first, then left one evaluates splits
+                f32 right_area[BIN_COUNT];
+                u32 right_count[BIN_COUNT];
+
+                hkm::aabb right;
+                u32 count = 0;
+                for (u32 bin = BIN_COUNT; bin-- > 1;) {
+                    right = hkm::merge(right, boxes[axis][bin]);
+                    count += counts[axis][bin];
+
+                    right_area[bin] = right.area();
+                    right_count[bin] = count;
+                }
+
+                hkm::aabb left;
+                count = 0;
+                for (u32 bin = 0; bin < BIN_COUNT - 1; ++bin) {
+                    left = hkm::merge(left, boxes[axis][bin]);
+                    count += counts[axis][bin];
+
+                    if (!count || !right_count[bin + 1]) { continue; }
+
+                    const f32 cost = count * left.area() + right_count[bin + 1] * right_area[bin + 1];
+                    if (cost < best_cost) {
+                        best_cost = cost;
+                        best_axis = axis;
+                        best_bin = bin;
+                    }
+                }
+            }
+
+            u32 mid = task.begin + (task.end - task.begin) / 2;
+
+            // All centroids in one spot split anywhere
+            if (best_bin != BIN_COUNT) {
+                u32 lo = task.begin;
+                u32 hi = task.end;
+                while (lo < hi) {
+                    if (binOf(refs[lo].center, best_axis) <= best_bin) {
+                        ++lo;
+                    } else {
+                        const Ref tmp = refs[lo];
+                        refs[lo] = refs[--hi];
+                        refs[hi] = tmp;
+                    }
+                }
+
+                if (lo != task.begin && lo != task.end) { mid = lo; }
+            }
+
+            idx = allocate();
+            internals.push_back(idx);
+
+            tasks.push_back({ mid, task.end, idx, false });
+            tasks.push_back({ task.begin, mid, idx, true });
+        }
+
+        nodes_[idx].parent = task.parent;
+
+        if (task.parent == none) {
+            root_ = idx;
+        } else if (task.left) {
+            nodes_[task.parent].left = idx;
+        } else {
+            nodes_[task.parent].right = idx;
+        }
+    }
+
+    // Internal nodes were made parents first
+    for (u32 i = internals.size(); i-- > 0;) {
+        Node &node = nodes_[internals[i]];
+        const Node &left = nodes_[node.left];
+        const Node &right = nodes_[node.right];
+
+        node.box = hkm::merge(left.box, right.box);
+        node.height = 1 + higher(left.height, right.height);
+    }
+}
+
+void bvh::clear()
+{
+    nodes_.clear();
+    root_ = none;
+    free_ = none;
+    size_ = 0;
+}
+
+u32 bvh::nearest(const hkm::vec3f &point, f32 max_distance) const
+{
+    f32 best = max_distance == FLT_MAX ? FLT_MAX : max_distance * max_distance;
+    u32 out = none;
+
+    walk(root_, [&](u32 idx) {
+        const Node &node = nodes_[idx];
+        if (hkm::distancesq(node.box, point) > best) { return false; }
+
+        if (node.leaf()) {
+            const f32 distance = hkm::distancesq(node.tight, point);
+            if (distance <= best) {
+                best = distance;
+                out = node.value;
+            }
+        }
+        return true;
+    });
+
+    return out;
+}
+
+f32 bvh::cost() const
+{
+    if (root_ == none) { return 0.f; }
+
+    const f32 root = nodes_[root_].box.area();
+    if (root <= 0.f) { return 0.f; }
+
+    f32 sum = 0.f;
+    for (const Node &node : nodes_) {
+        if (node.height > 0) { sum += node.box.area(); }
+    }
+
+    return sum / root;
+}
+
+/* ===== Nodes ===== */
+u32 bvh::allocate()
+{
+    u32 idx = free_;
+
+    if (idx == none) {
+        idx = nodes_.size();
+        nodes_.emplace_back();
+    } else {
+        free_ = nodes_[idx].parent;
+    }
+
+    Node &node = nodes_[idx];
+    node.box = {};
+    node.tight = {};
+    node.parent = none;
+    node.left = none;
+    node.right = none;
+    node.height = 0;
+    node.value = none;
+
+    return idx;
+}
+
+void bvh::release(u32 idx)
+{
+    nodes_[idx].parent = free_;
+    nodes_[idx].height = -1;
+    free_ = idx;
+}
+
+hkm::aabb bvh::enlarge(const hkm::aabb &box, f32 scale) const
+{
+    hkm::vec3f pad = (box.max - box.min) * scale;
+    for (u32 axis = 0; axis < 3; ++axis) {
+        if (pad[axis] < MIN_MARGIN) { pad[axis] = MIN_MARGIN; }
+    }
+
+    return hkm::aabb(box.min - pad, box.max + pad);
+}
+
+/* ===== Structure ===== */
+void bvh::insertLeaf(u32 leaf)
+{
+    if (root_ == none) {
+        root_ = leaf;
+        nodes_[leaf].parent = none;
+        return;
+    }
+
+    const hkm::aabb box = nodes_[leaf].box;
+
+    // Descend while pushing leaf further down is cheaper than pairing here
+    u32 idx = root_;
+    while (!nodes_[idx].leaf()) {
+        const Node &node = nodes_[idx];
+
+        const f32 area = node.box.area();
+        const f32 combined = hkm::merge(node.box, box).area();
+
+        // New parent here, or cost every node below pays for growing
+        const f32 cost = 2.f * combined;
+        const f32 inherited = 2.f * (combined - area);
+
+        const auto descend = [&](u32 child) {
+            const Node &c = nodes_[child];
+            const f32 merged = hkm::merge(c.box, box).area();
+            return c.leaf() ? merged + inherited : merged - c.box.area() + inherited;
+        };
+
+        const f32 left = descend(node.left);
+        const f32 right = descend(node.right);
+
+        if (cost < left && cost < right) { break; }
+
+        idx = left < right ? node.left : node.right;
+    }
+
+    const u32 sibling = idx;
+    const u32 old_parent = nodes_[sibling].parent;
+    const u32 parent = allocate();
+
+    Node &node = nodes_[parent];
+    node.parent = old_parent;
+    node.box = hkm::merge(box, nodes_[sibling].box);
+    node.height = nodes_[sibling].height + 1;
+    node.left = sibling;
+    node.right = leaf;
+
+    if (old_parent == none) {
+        root_ = parent;
+    } else if (nodes_[old_parent].left == sibling) {
+        nodes_[old_parent].left = parent;
+    } else {
+        nodes_[old_parent].right = parent;
+    }
+
+    nodes_[sibling].parent = parent;
+    nodes_[leaf].parent = parent;
+
+    for (idx = parent; idx != none; idx = nodes_[idx].parent) {
+        idx = balance(idx);
+
+        Node &current = nodes_[idx];
+        const Node &left = nodes_[current.left];
+        const Node &right = nodes_[current.right];
+
+        current.height = 1 + higher(left.height, right.height);
+        current.box = hkm::merge(left.box, right.box);
+    }
+}
+
+void bvh::removeLeaf(u32 leaf)
+{
+    if (leaf == root_) {
+        root_ = none;
+        return;
+    }
+
+    const u32 parent = nodes_[leaf].parent;
+    const u32 grand = nodes_[parent].parent;
+    const u32 sibling = nodes_[parent].left == leaf ? nodes_[parent].right : nodes_[parent].left;
+
+    release(parent);
+    nodes_[sibling].parent = grand;
+
+    if (grand == none) {
+        root_ = sibling;
+        return;
+    }
+
+    if (nodes_[grand].left == parent) {
+        nodes_[grand].left = sibling;
+    } else {
+        nodes_[grand].right = sibling;
+    }
+
+    for (u32 idx = grand; idx != none; idx = nodes_[idx].parent) {
+        idx = balance(idx);
+
+        Node &current = nodes_[idx];
+        const Node &left = nodes_[current.left];
+        const Node &right = nodes_[current.right];
+
+        current.height = 1 + higher(left.height, right.height);
+        current.box = hkm::merge(left.box, right.box);
+    }
+}
+
+// Rotates taller grandchild up when children heights differ by more than one,
+// returns node that took place of idx
+u32 bvh::balance(u32 idx)
+{
+    Node &a = nodes_[idx];
+    if (a.leaf() || a.height < 2) { return idx; }
+
+    const u32 ib = a.left;
+    const u32 ic = a.right;
+    Node &b = nodes_[ib];
+    Node &c = nodes_[ic];
+
+    const i32 diff = c.height - b.height;
+    if (diff >= -1 && diff <= 1) { return idx; }
+
+    // Child that goes up, its children and the one that stays
+    const u32 iup = diff > 0 ? ic : ib;
+    Node &up = diff > 0 ? c : b;
+    const Node &stay = diff > 0 ? b : c;
+
+    const u32 ifirst = up.left;
+    const u32 isecond = up.right;
+    Node &first = nodes_[ifirst];
+    Node &second = nodes_[isecond];
+
+    up.left = idx;
+    up.parent = a.parent;
+    a.parent = iup;
+
+    if (up.parent == none) {
+        root_ = iup;
+    } else if (nodes_[up.parent].left == idx) {
+        nodes_[up.parent].left = iup;
+    } else {
+        nodes_[up.parent].right = iup;
+    }
+
+    // Taller grandchild stays with up, other one replaces it under a
+    const u32 ikeep = first.height > second.height ? ifirst : isecond;
+    const u32 igive = first.height > second.height ? isecond : ifirst;
+    const Node &keep = nodes_[ikeep];
+    Node &give = nodes_[igive];
+
+    up.right = ikeep;
+    if (diff > 0) { a.right = igive; } else { a.left = igive; }
+    give.parent = idx;
+
+    a.box = hkm::merge(stay.box, give.box);
+    a.height = 1 + higher(stay.height, give.height);
+
+    up.box = hkm::merge(a.box, keep.box);
+    up.height = 1 + higher(a.height, keep.height);
+
+    return iup;
+}
+
+}
@@ -0,0 +1,263 @@
+#ifndef HK_BVH_H
+#define HK_BVH_H
+
+#include "hkcommon.h"
+#include "utility/hktypes.h"
+
+#include "containers/hkvector.h"
+
+#include "math/vec4f.h"
+#include "math/aabb.h"
+
+#include <cfloat>
+#include <cmath>
+
+namespace hk {
+
+/* Dynamic bounding volume hierarchy over boxes with user values.
+ * Leaves are inserted one by one at the cheapest place by SAH and
+ * kept balanced with rotations. Leaf boxes are enlarged by margin,
+ * so small moves don't change the tree at all.
+ * For bulk changes rebuild() builds binned SAH tree from scratch and
+ * refit() updates boxes without changing the structure.
+ * Proxy returned by insert() stays valid until removed, rebuild() too.
+ * Queries test user boxes at leaves and walk the tree without stack */
+class bvh {
+public:
+    static constexpr u32 none = static_cast<u32>(-1);
+
+    struct Node {
+        hkm::aabb box;   // Enlarged for leaves
+        hkm::aabb tight; // Leaves only, as given by user
+
+        u32 parent; // Next free node when unused
+        u32 left;   // none for leaves
+        u32 right;
+        i32 height; // 0 for leaves, -1 when unused
+
+        u32 value;
+
+        constexpr b8 leaf() const { return left == none; }
+    };
+
+public:
+    // Margin is part of box size leaves are enlarged by on each side
+    HKAPI explicit bvh(f32 margin = .1f);
+
+    HKAPI u32 insert(const hkm::aabb &box, u32 value);
+    HKAPI void remove(u32 proxy);
+
+    // Reinserts leaf only when box left its enlarged box,
+    // returns whether tree has changed
+    HKAPI b8 move(u32 proxy, const hkm::aabb &box);
+
+    // Sets leaf box without touching the tree, refit() before next query
+    HKAPI void update(u32 proxy, const hkm::aabb &box);
+    // Recomputes every internal box from leaves
+    HKAPI void refit();
+
+    // Top down binned SAH build over current leaves
+    HKAPI void rebuild();
+
+    HKAPI void clear();
+
+    /* ===== Queries ===== */
+
+    // func(u32 value) for leaves overlapping box
+    template<typename Func>
+    void query(const hkm::aabb &box, Func &&func) const;
+
+    // func(u32 value) for leaves overlapping sphere
+    template<typename Func>
+    void query(const hkm::vec3f &center, f32 radius, Func &&func) const;
+
+    /* func(u32 value) for leaves intersecting frustum given by planes
+     * from hkm::frustumPlanes(). Subtrees completely inside are reported
+     * without further tests */
+    template<typename Func>
+    void query(const hkm::vec4f planes[6], Func &&func) const;
+
+    /* f32 func(u32 value, f32 distance) for leaves hit by ray,
+     * distance is where ray enters leaf box in dir lengths.
+     * Returned value becomes new max_distance, so closest hit search
+     * returns exact hit distance and any hit search returns 0 */
+    template<typename Func>
+    void raycast(const hkm::vec3f &origin, const hkm::vec3f &dir,
+                 f32 max_distance, Func &&func) const;
+
+    // Value of leaf closest to point, none if none is within max_distance
+    HKAPI u32 nearest(const hkm::vec3f &point, f32 max_distance = FLT_MAX) const;
+
+    /* ===== Info ===== */
+
+    constexpr u32 size() const { return size_; }
+    constexpr u32 root() const { return root_; }
+    inline u32 height() const { return root_ == none ? 0 : nodes_[root_].height; }
+
+    inline const Node& node(u32 idx) const { return nodes_[idx]; }
+    inline const hkm::aabb& box(u32 proxy) const { return nodes_[proxy].tight; }
+    inline u32 value(u32 proxy) const { return nodes_[proxy].value; }
+
+    // Sum of internal node areas relative to root, lower is better
+    HKAPI f32 cost() const;
+
+private:
+    u32 allocate();
+    void release(u32 idx);
+
+    hkm::aabb enlarge(const hkm::aabb &box, f32 scale) const;
+
+    void insertLeaf(u32 leaf);
+    void removeLeaf(u32 leaf);
+    u32 balance(u32 idx);
+
+    // Depth first over subtree of start, enter(idx) returns whether to descend
+    template<typename Enter>
+    void walk(u32 start, Enter &&enter) const;
+
+private:
+    hk::vector<Node> nodes_;
+    u32 root_ = none;
+    u32 free_ = none;
+    u32 size_ = 0;
+
+    f32 margin_;
+};
+
+/* ===== Traversal ===== */
+template<typename Enter>
+void bvh::walk(u32 start, Enter &&enter) const
+{
+    if (start == none) { return; }
+
+    u32 idx = start;
+    while (true) {
+        if (enter(idx) && !nodes_[idx].leaf()) {
+            idx = nodes_[idx].left;
+            continue;
+        }
+
+        // Climb until there is an unvisited right sibling
+        while (true) {
+            if (idx == start) { return; }
+
+            const u32 parent = nodes_[idx].parent;
+            if (nodes_[parent].left == idx) {
+                idx = nodes_[parent].right;
+                break;
+            }
+
+            idx = parent;
+        }
+    }
+}
+
+template<typename Func>
+void bvh::query(const hkm::aabb &box, Func &&func) const
+{
+    walk(root_, [&](u32 idx) {
+        const Node &node = nodes_[idx];
+        if (!hkm::overlaps(node.box, box)) { return false; }
+
+        if (node.leaf() && hkm::overlaps(node.tight, box)) { func(node.value); }
+        return true;
+    });
+}
+
+template<typename Func>
+void bvh::query(const hkm::vec3f &center, f32 radius, Func &&func) const
+{
+    const f32 radiussq = radius * radius;
+
+    walk(root_, [&](u32 idx) {
+        const Node &node = nodes_[idx];
+        if (hkm::distancesq(node.box, center) > radiussq) { return false; }
+
+        if (node.leaf() && hkm::distancesq(node.tight, center) <= radiussq) {
+            func(node.value);
+        }
+        return true;
+    });
+}
+
+template<typename Func>
+void bvh::query(const hkm::vec4f planes[6], Func &&func) const
+{
+    enum Side { OUTSIDE, INSIDE, INTERSECTS };
+
+    const auto classify = [planes](const hkm::aabb &box) {
+        const hkm::vec3f c = box.center();
+        const hkm::vec3f e = box.extent();
+
+        Side side = INSIDE;
+        for (u32 p = 0; p < 6; ++p) {
+            const hkm::vec4f &n = planes[p];
+            const f32 d = n.x * c.x + n.y * c.y + n.z * c.z + n.w;
+            const f32 r = std::fabs(n.x) * e.x + std::fabs(n.y) * e.y + std::fabs(n.z) * e.z;
+
+            if (d + r < 0.f) { return OUTSIDE; }
+            if (d - r < 0.f) { side = INTERSECTS; }
+        }
+
+        return side;
+    };
+
+    walk(root_, [&](u32 idx) {
+        const Node &node = nodes_[idx];
+
+        switch (classify(node.box)) {
+        case OUTSIDE: return false;
+        case INSIDE: {
+            walk(idx, [&](u32 inner) {
+                if (nodes_[inner].leaf()) { func(nodes_[inner].value); }
+                return true;
+            });
+        } return false;
+        default: break;
+        }
+
+        if (node.leaf() && classify(node.tight) != OUTSIDE) { func(node.value); }
+        return true;
+    });
+}
+
+template<typename Func>
+void bvh::raycast(const hkm::vec3f &origin, const hkm::vec3f &dir,
+                  f32 max_distance, Func &&func) const
+{
+    // Infinities from zero components are handled by slab test
+    const hkm::vec3f inv(1.f / dir.x, 1.f / dir.y, 1.f / dir.z);
+
+    // Distance where ray enters box, FLT_MAX when it misses
+    const auto enter = [&](const hkm::aabb &box) {
+        f32 tmin = 0.f;
+        f32 tmax = max_distance;
+
+        for (u32 axis = 0; axis < 3; ++axis) {
+            f32 t0 = (box.min[axis] - origin[axis]) * inv[axis];
+            f32 t1 = (box.max[axis] - origin[axis]) * inv[axis];
+            if (t0 > t1) { const f32 t = t0; t0 = t1; t1 = t; }
+
+            // NaN from 0 * inf compares false and keeps bounds
+            if (t0 > tmin) { tmin = t0; }
+            if (t1 < tmax) { tmax = t1; }
+        }
+
+        return tmin <= tmax ? tmin : FLT_MAX;
+    };
+
+    walk(root_, [&](u32 idx) {
+        const Node &node = nodes_[idx];
+        if (enter(node.box) == FLT_MAX) { return false; }
+
+        if (node.leaf()) {
+            const f32 distance = enter(node.tight);
+            if (distance != FLT_MAX) { max_distance = func(node.value, distance); }
+        }
+        return true;
+    });
+}
+
+}
+
+#endif // HK_BVH_H
@@ -0,0 +1,424 @@
+#ifndef HK_FLAT_MAP_H
+#define HK_FLAT_MAP_H
+
+#include "utility/hktypes.h"
+#include "utility/hkassert.h"
+#include "utility/hkhash.h"
+
+#include "memory/hkallocator.h"
+
+namespace hk {
+
+// Compares stored key with any type it has operator== for
+struct equal_to {
+    template<typename A, typename B>
+    constexpr b8 operator()(const A &a, const B &b) const { return a == b; }
+};
+
+/* Open addressing hash map with Robin Hood probing.
+ * Keys and values live inline in one array, a word per slot keeps probe
+ * distance (0 is empty) and few hash bits. Erase shifts following entries
+ * back, so there are no tombstones and lookups stop at first entry closer
+ * to its home slot.
+ * Lookups are heterogeneous: anything Hash and Eq accept can be used as a key,
+ * hash can be passed in precomputed with hash_of().
+ * Inserting or erasing invalidates pointers and iterators */
+template<typename K, typename V, typename Hash = hasher<K>, typename Eq = equal_to>
+class flat_map {
+public:
+    struct Entry {
+        K key; // Don't modify through iterators
+        V value;
+    };
+
+private:
+    template<typename EntryType>
+    class Iterator {
+    public:
+        Iterator(EntryType *entries, const u32 *meta, u32 pos, u32 capacity)
+            : entries_(entries), meta_(meta), pos_(pos), capacity_(capacity)
+        {
+            skip();
+        }
+
+        EntryType& operator*() const { return entries_[pos_]; }
+        EntryType* operator->() const { return entries_ + pos_; }
+
+        Iterator& operator++() { ++pos_; skip(); return *this; }
+
+        b8 operator==(const Iterator &other) const { return pos_ == other.pos_; }
+        b8 operator!=(const Iterator &other) const { return pos_ != other.pos_; }
+
+    private:
+        void skip() { while (pos_ < capacity_ && !meta_[pos_]) { ++pos_; } }
+
+    private:
+        EntryType *entries_;
+        const u32 *meta_;
+        u32 pos_;
+        u32 capacity_;
+    };
+
+    static constexpr u32 min_capacity = 16;
+    static constexpr u32 dist_mask = 0xff;
+
+    // Table grows before probes get this long, even under max load
+    static constexpr u32 grow_dist = 128;
+
+public:
+    using iterator = Iterator<Entry>;
+    using const_iterator = Iterator<const Entry>;
+
+    flat_map() = default;
+    explicit flat_map(u32 capacity) { reserve(capacity); }
+    ~flat_map() { release(); }
+
+    flat_map(const flat_map &other) { *this = other; }
+    flat_map(flat_map &&other) noexcept { *this = hk::move(other); }
+
+    flat_map& operator=(const flat_map &other)
+    {
+        if (this == &other) { return *this; }
+
+        clear();
+        reserve(other.size_);
+        for (const Entry &entry : other) { try_emplace(entry.key, entry.value); }
+
+        return *this;
+    }
+
+    flat_map& operator=(flat_map &&other) noexcept
+    {
+        if (this == &other) { return *this; }
+
+        release();
+
+        entries_ = other.entries_;
+        meta_ = other.meta_;
+        capacity_ = other.capacity_;
+        size_ = other.size_;
+
+        other.entries_ = nullptr;
+        other.meta_ = nullptr;
+        other.capacity_ = 0;
+        other.size_ = 0;
+
+        return *this;
+    }
+
+    /* ===== Modifiers ===== */
+
+    /* Constructs value only when key is missing,
+     * Returns false and leaves value untouched when key exists */
+    template<typename Q, typename... Args>
+    inline b8 try_emplace(Q &&key, Args&& ...args)
+    {
+        b8 inserted;
+        place(hash_of(key), hk::forward<Q>(key), inserted, hk::forward<Args>(args)...);
+        return inserted;
+    }
+
+    inline b8 insert(const K &key, const V &value) { return try_emplace(key, value); }
+    inline b8 insert(K &&key, V &&value) { return try_emplace(hk::move(key), hk::move(value)); }
+
+    // Overwrites value when key exists
+    template<typename Q, typename T>
+    inline V& assign(Q &&key, T &&value)
+    {
+        b8 inserted;
+        V &out = place(hash_of(key), hk::forward<Q>(key), inserted, hk::forward<T>(value));
+        if (!inserted) { out = hk::forward<T>(value); }
+
+        return out;
+    }
+
+    // Default constructs missing values
+    template<typename Q>
+    inline V& operator[](Q &&key)
+    {
+        b8 inserted;
+        return place(hash_of(key), hk::forward<Q>(key), inserted);
+    }
+
+    // Returns false when key is missing
+    template<typename Q>
+    inline b8 erase(const Q &key)
+    {
+        u32 pos = locate(key, hash_of(key));
+        if (pos == capacity_) { return false; }
+
+        entries_[pos].~Entry();
+
+        // Backward shift, pulls following entries one slot closer to home
+        u32 next = (pos + 1) & mask();
+        while (dist(meta_[next]) > 1) {
+            new (entries_ + pos) Entry(hk::move(entries_[next]));
+            entries_[next].~Entry();
+            meta_[pos] = meta_[next] - 1;
+
+            pos = next;
+            next = (next + 1) & mask();
+        }
+
+        meta_[pos] = 0;
+        --size_;
+
+        return true;
+    }
+
+    // Keeps memory
+    inline void clear()
+    {
+        for (u32 i = 0; i < capacity_; ++i) {
+            if (!meta_[i]) { continue; }
+
+            entries_[i].~Entry();
+            meta_[i] = 0;
+        }
+
+        size_ = 0;
+    }
+
+    // Makes room for count entries without rehashing
+    inline void reserve(u32 count)
+    {
+        u32 capacity = min_capacity;
+        while (count > limit(capacity)) { capacity *= 2; }
+
+        if (capacity > capacity_) { rehash(capacity); }
+    }
+
+    /* ===== Lookup ===== */
+
+    // Same hash map uses internally, to look up with precomputed hashes
+    template<typename Q>
+    static inline u64 hash_of(const Q &key) { return Hash{}(key); }
+
+    // nullptr when key is missing
+    template<typename Q>
+    inline V* find(const Q &key, u64 hash)
+    {
+        u32 pos = locate(key, hash);
+        return pos == capacity_ ? nullptr : &entries_[pos].value;
+    }
+
+    template<typename Q>
+    inline const V* find(const Q &key, u64 hash) const
+    {
+        u32 pos = locate(key, hash);
+        return pos == capacity_ ? nullptr : &entries_[pos].value;
+    }
+
+    template<typename Q>
+    inline V* find(const Q &key) { return find(key, hash_of(key)); }
+
+    template<typename Q>
+    inline const V* find(const Q &key) const { return find(key, hash_of(key)); }
+
+    template<typename Q>
+    inline b8 contains(const Q &key) const { return locate(key, hash_of(key)) != capacity_; }
+
+    // Asserts when key is missing
+    template<typename Q>
+    inline V& at(const Q &key)
+    {
+        V *value = find(key);
+        ALWAYS_ASSERT(value, "hkflat_map: Key is missing");
+        return *value;
+    }
+
+    template<typename Q>
+    inline const V& at(const Q &key) const
+    {
+        const V *value = find(key);
+        ALWAYS_ASSERT(value, "hkflat_map: Key is missing");
+        return *value;
+    }
+
+    /* ===== Iterators =====
+     * Order is defined by hashes, not by insertion */
+
+    inline iterator begin() { return { entries_, meta_, 0, capacity_ }; }
+    inline iterator end() { return { entries_, meta_, capacity_, capacity_ }; }
+    inline const_iterator begin() const { return { entries_, meta_, 0, capacity_ }; }
+    inline const_iterator end() const { return { entries_, meta_, capacity_, capacity_ }; }
+
+    /* ===== Capacity ===== */
+
+    inline b8 empty() const { return !size_; }
+    inline u32 size() const { return size_; }
+    inline u32 capacity() const { return capacity_; }
+
+private:
+    inline u32 mask() const { return capacity_ - 1; }
+
+    // Max load of 7/8, Robin Hood keeps probes short even that full
+    static inline u32 limit(u32 capacity) { return capacity - capacity / 8; }
+
+    // High hash bits stored next to distance, most mismatches end without Eq
+    static inline u32 tag(u64 hash) { return static_cast<u32>(hash >> 32) & ~dist_mask; }
+    static inline u32 dist(u32 meta) { return meta & dist_mask; }
+
+    // Slot of key, capacity_ when missing
+    template<typename Q>
+    inline u32 locate(const Q &key, u64 hash) const
+    {
+        if (!size_) { return capacity_; }
+
+        u32 pos = static_cast<u32>(hash) & mask();
+        u32 expected = tag(hash) | 1;
+
+        // Entry closer to its home than we are to ours means key isn't here
+        while (dist(meta_[pos]) >= dist(expected)) {
+            if (meta_[pos] == expected && Eq{}(entries_[pos].key, key)) { return pos; }
+
+            pos = (pos + 1) & mask();
+            ++expected;
+        }
+
+        return capacity_;
+    }
+
+    template<typename Q, typename... Args>
+    inline V& place(u64 hash, Q &&key, b8 &inserted, Args&& ...args)
+    {
+        u32 pos = locate(key, hash);
+
+        inserted = pos == capacity_;
+        if (inserted) { pos = put(hash, hk::forward<Q>(key), hk::forward<Args>(args)...); }
+
+        return entries_[pos].value;
+    }
+
+    // Inserts key that is known to be missing, returns its slot
+    template<typename Q, typename... Args>
+    u32 put(u64 hash, Q &&key, Args&& ...args)
+    {
+        if (size_ + 1 > limit(capacity_)) {
+            rehash(capacity_ ? capacity_ * 2 : min_capacity);
+        }
+
+        u32 pos = static_cast<u32>(hash) & mask();
+        u32 meta = tag(hash) | 1;
+
+        while (dist(meta_[pos]) >= dist(meta)) {
+            pos = (pos + 1) & mask();
+            ++meta;
+        }
+
+        // Clustered keys, growing spreads them out again. Sparse table
+        // won't get better from growing, hash itself is bad then
+        if (dist(meta) >= grow_dist && size_ >= capacity_ / 4) {
+            rehash(capacity_ * 2);
+            return put(hash, hk::forward<Q>(key), hk::forward<Args>(args)...);
+        }
+
+        ALWAYS_ASSERT(dist(meta) < dist_mask, "hkflat_map: Probe is too long, check hash");
+
+        ++size_;
+
+        if (!meta_[pos]) {
+            new (entries_ + pos) Entry{ K(hk::forward<Q>(key)), V(hk::forward<Args>(args)...) };
+            meta_[pos] = meta;
+            return pos;
+        }
+
+        // Slot is taken by richer entry, it and ones after it move down the probe
+        Entry carry{ K(hk::forward<Q>(key)), V(hk::forward<Args>(args)...) };
+        const u32 home = pos;
+
+        while (meta_[pos]) {
+            if (dist(meta_[pos]) < dist(meta)) {
+                Entry tmp(hk::move(entries_[pos]));
+                entries_[pos] = hk::move(carry);
+                carry = hk::move(tmp);
+
+                u32 tmp_meta = meta_[pos];
+                meta_[pos] = meta;
+                meta = tmp_meta;
+            }
+
+            pos = (pos + 1) & mask();
+            ++meta;
+
+            ALWAYS_ASSERT(dist(meta) < dist_mask, "hkflat_map: Probe is too long, check hash");
+        }
+
+        new (entries_ + pos) Entry(hk::move(carry));
+        meta_[pos] = meta;
+
+        return home;
+    }
+
+    void rehash(u32 capacity)
+    {
+        DEV_ASSERT(mem::is_pow2(capacity), "hkflat_map: Capacity must be power of two");
+
+        Entry *entries = entries_;
+        u32 *meta = meta_;
+        u32 old_capacity = capacity_;
+
+        allocate(capacity);
+        size_ = 0;
+
+        for (u32 i = 0; i < old_capacity; ++i) {
+            if (!meta[i]) { continue; }
+
+            put(hash_of(entries[i].key), hk::move(entries[i].key), hk::move(entries[i].value));
+            entries[i].~Entry();
+        }
+
+        free(entries, old_capacity);
+    }
+
+    // Metadata is kept right after entries, in the same allocation
+    static inline u64 meta_offset(u32 capacity)
+    {
+        return mem::align_up(sizeof(Entry) * capacity, alignof(u32));
+    }
+
+    static inline u64 bytes(u32 capacity)
+    {
+        return meta_offset(capacity) + sizeof(u32) * capacity;
+    }
+
+    void allocate(u32 capacity)
+    {
+        constexpr u64 alignment = alignof(Entry) > alignof(u32) ? alignof(Entry) : alignof(u32);
+
+        void *memory = mem::heap().allocate(bytes(capacity), alignment);
+        ALWAYS_ASSERT(memory, "hkflat_map: Out of memory");
+
+        entries_ = static_cast<Entry*>(memory);
+        meta_ = reinterpret_cast<u32*>(static_cast<u8*>(memory) + meta_offset(capacity));
+        capacity_ = capacity;
+
+        for (u32 i = 0; i < capacity; ++i) { meta_[i] = 0; }
+    }
+
+    static inline void free(Entry *entries, u32 capacity)
+    {
+        if (entries) { mem::heap().deallocate(entries, bytes(capacity)); }
+    }
+
+    void release()
+    {
+        clear();
+        free(entries_, capacity_);
+
+        entries_ = nullptr;
+        meta_ = nullptr;
+        capacity_ = 0;
+    }
+
+private:
+    Entry *entries_ = nullptr;
+    u32 *meta_ = nullptr; // Tag in high bits, probe distance in low byte
+
+    u32 capacity_ = 0;
+    u32 size_ = 0;
+};
+
+}
+
+#endif // HK_FLAT_MAP_H
@@ -0,0 +1,134 @@
+#ifndef HK_MPMC_RING_H
+#define HK_MPMC_RING_H
+
+#include "utility/hktypes.h"
+
+#include <atomic>
+#include <utility>
+
+namespace hk {
+
+/* Bounded lock-free multi producer multi consumer queue
+ * Dmitry Vyukov's design: every cell carries sequence number telling
+ * whether it is ready for producer (seq == pos) or consumer (seq == pos + 1)
+ * N must be power of 2 */
+template<typename T, u32 N>
+class mpmc_ring {
+    static_assert(N >= 2 && !(N & (N - 1)), "mpmc_ring size must be power of 2");
+
+private:
+    static constexpr u64 mask = N - 1;
+
+    struct Cell {
+        std::atomic<u64> seq;
+        T data;
+    };
+
+    alignas(64) std::atomic<u64> tail_ { 0 }; // Producers
+    alignas(64) std::atomic<u64> head_ { 0 }; // Consumers
+    alignas(64) Cell cells_[N];
+
+public:
+    mpmc_ring()
+    {
+        for (u64 i = 0; i < N; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    mpmc_ring(const mpmc_ring&) = delete;
+    mpmc_ring& operator=(const mpmc_ring&) = delete;
+
+    // Fails when ring is full
+    template<typename U>
+    inline b8 push(U &&value)
+    {
+        u64 pos = tail_.load(std::memory_order_relaxed);
+        Cell *cell;
+
+        for (;;) {
+            cell = &cells_[pos & mask];
+            u64 seq = cell->seq.load(std::memory_order_acquire);
+            i64 diff = static_cast<i64>(seq) - static_cast<i64>(pos);
+
+            if (!diff) {
+                if (tail_.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed))
+                {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = std::forward<U>(value);
+        cell->seq.store(pos + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Drops oldest values until new one fits
+    template<typename U>
+    inline void push_overwrite(U &&value)
+    {
+        // Value is moved from only by successful push
+        T dropped;
+        while (!push(std::forward<U>(value))) {
+            pop(dropped);
+        }
+    }
+
+    // Fails when ring is empty
+    inline b8 pop(T &value)
+    {
+        u64 pos = head_.load(std::memory_order_relaxed);
+        Cell *cell;
+
+        for (;;) {
+            cell = &cells_[pos & mask];
+            u64 seq = cell->seq.load(std::memory_order_acquire);
+            i64 diff = static_cast<i64>(seq) - static_cast<i64>(pos + 1);
+
+            if (!diff) {
+                if (head_.compare_exchange_weak(pos, pos + 1,
+                                                std::memory_order_relaxed))
+                {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = std::move(cell->data);
+        cell->seq.store(pos + N, std::memory_order_release);
+
+        return true;
+    }
+
+    // Drops all values currently in ring, must not race with producers
+    inline void clear()
+    {
+        T value;
+        while (pop(value)) {}
+    }
+
+    // Approximate when other threads are active
+    inline u32 size() const
+    {
+        u64 tail = tail_.load(std::memory_order_acquire);
+        u64 head = head_.load(std::memory_order_acquire);
+        return tail > head ? static_cast<u32>(tail - head) : 0;
+    }
+
+    constexpr u32 capacity() const { return N; }
+};
+
+}
+
+#endif // HK_MPMC_RING_H
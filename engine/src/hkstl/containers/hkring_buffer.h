@@ -3,7 +3,7 @@
 
 #include "utility/hktypes.h"
 
-// TODO: either use atomic or mutex
+// INFO: Not thread safe, use mpmc_ring or spsc_ring across threads
 namespace hk {
 
 template<typename T, u32 N, b8 overwrite = false>
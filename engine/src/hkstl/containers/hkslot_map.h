@@ -0,0 +1,202 @@
+#ifndef HK_SLOT_MAP_H
+#define HK_SLOT_MAP_H
+
+#include "utility/hktypes.h"
+#include "utility/hkassert.h"
+#include "utility/hkhandle.h"
+
+#include "containers/hkvector.h"
+
+namespace hk {
+
+/* Dense storage addressed by generational handles.
+ * Values are packed at the front, erase moves the last value into the hole,
+ * so iteration touches live values only and their order is not stable.
+ * Handle stays valid until its value is erased, stale handles are rejected */
+template<typename T, typename Key = Handle<struct SlotTag>>
+class slot_map {
+private:
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    static constexpr u32 max_index = (1u << Key::index_bits) - 1;
+    static constexpr u32 gen_mask = (1u << Key::gen_bits) - 1;
+    static constexpr u32 none = static_cast<u32>(-1);
+
+    struct Slot {
+        u32 dense = none;   // Position in values_, none when free
+        u32 next = none;    // Next free slot
+        u32 gen = 1;
+    };
+
+public:
+    /* ===== Modifiers ===== */
+
+    template<typename... Args>
+    inline Key emplace(Args&& ...args)
+    {
+        u32 index = free_;
+
+        if (index != none) {
+            free_ = slots_[index].next;
+        } else {
+            index = slots_.size();
+            ALWAYS_ASSERT(index <= max_index, "hkslot_map: Out of handles");
+            slots_.push_back({});
+        }
+
+        Slot &slot = slots_[index];
+        slot.dense = values_.size();
+        slot.next = none;
+
+        values_.emplace_back(hk::forward<Args>(args)...);
+        indices_.push_back(index);
+
+        return key(index, slot.gen);
+    }
+
+    inline Key insert(const T &value) { return emplace(value); }
+    inline Key insert(T &&value) { return emplace(hk::move(value)); }
+
+    // Returns false for stale handles
+    inline b8 erase(Key handle)
+    {
+        if (!contains(handle)) { return false; }
+
+        Slot &slot = slots_[handle.index];
+        const u32 last = values_.size() - 1;
+
+        if (slot.dense != last) {
+            values_[slot.dense] = hk::move(values_[last]);
+            indices_[slot.dense] = indices_[last];
+            slots_[indices_[last]].dense = slot.dense;
+        }
+
+        values_.pop_back();
+        indices_.pop_back();
+
+        // Zero generation is skipped, zero handle always stays invalid
+        slot.gen = (slot.gen + 1) & gen_mask;
+        if (!slot.gen) { slot.gen = 1; }
+
+        slot.dense = none;
+        slot.next = free_;
+        free_ = handle.index;
+
+        return true;
+    }
+
+    // Invalidates every handle
+    inline void clear()
+    {
+        for (u32 i = 0; i < indices_.size(); ++i) {
+            Slot &slot = slots_[indices_[i]];
+
+            slot.gen = (slot.gen + 1) & gen_mask;
+            if (!slot.gen) { slot.gen = 1; }
+
+            slot.dense = none;
+            slot.next = free_;
+            free_ = indices_[i];
+        }
+
+        values_.clear();
+        indices_.clear();
+    }
+
+    inline void reserve(u32 capacity)
+    {
+        values_.reserve(capacity);
+        indices_.reserve(capacity);
+        slots_.reserve(capacity);
+    }
+
+    /* ===== Lookup ===== */
+
+    inline b8 contains(Key handle) const
+    {
+        if (handle.index >= slots_.size()) { return false; }
+
+        const Slot &slot = slots_[handle.index];
+        return slot.dense != none && key(handle.index, slot.gen).value == handle.value;
+    }
+
+    // nullptr for stale handles
+    inline T* get(Key handle)
+    {
+        return contains(handle) ? &values_[slots_[handle.index].dense] : nullptr;
+    }
+
+    inline const T* get(Key handle) const
+    {
+        return contains(handle) ? &values_[slots_[handle.index].dense] : nullptr;
+    }
+
+    // Asserts on stale handles
+    inline T& at(Key handle)
+    {
+        ALWAYS_ASSERT(contains(handle), "hkslot_map: Stale handle");
+        return values_[slots_[handle.index].dense];
+    }
+
+    inline const T& at(Key handle) const
+    {
+        ALWAYS_ASSERT(contains(handle), "hkslot_map: Stale handle");
+        return values_[slots_[handle.index].dense];
+    }
+
+    // Same as at()
+    inline T& operator[](Key handle) { return at(handle); }
+    inline const T& operator[](Key handle) const { return at(handle); }
+
+    /* ===== Dense access =====
+     * Position is in [0, size()), it changes when other values are erased */
+
+    inline T& value_at(u32 pos) { return values_.at(pos); }
+    inline const T& value_at(u32 pos) const { return values_.at(pos); }
+
+    inline Key key_at(u32 pos) const
+    {
+        const u32 index = indices_.at(pos);
+        return key(index, slots_[index].gen);
+    }
+
+    inline T* data() { return values_.data(); }
+    inline const T* data() const { return values_.data(); }
+
+    /* ===== Iterators ===== */
+
+    inline iterator begin() { return values_.begin(); }
+    inline iterator end() { return values_.end(); }
+    inline const_iterator begin() const { return values_.begin(); }
+    inline const_iterator end() const { return values_.end(); }
+
+    /* ===== Capacity ===== */
+
+    inline b8 empty() const { return values_.empty(); }
+    inline u32 size() const { return values_.size(); }
+
+    // Highest index ever handed out plus one, useful for sparse side tables
+    inline u32 slots() const { return slots_.size(); }
+
+private:
+    static inline Key key(u32 index, u32 gen)
+    {
+        Key out;
+        out.value = 0;
+        out.index = index;
+        out.gen = gen;
+        return out;
+    }
+
+private:
+    hk::vector<T> values_;
+    hk::vector<u32> indices_; // Slot of each value
+    hk::vector<Slot> slots_;
+
+    u32 free_ = none; // Head of free slot list
+};
+
+}
+
+#endif // HK_SLOT_MAP_H
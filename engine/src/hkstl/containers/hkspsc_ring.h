@@ -0,0 +1,82 @@
+#ifndef HK_SPSC_RING_H
+#define HK_SPSC_RING_H
+
+#include "utility/hktypes.h"
+
+#include <atomic>
+#include <utility>
+
+namespace hk {
+
+/* Bounded lock-free single producer single consumer queue
+ * Each side caches the other's index and reloads it only when
+ * ring looks full or empty, so cache lines bounce only then
+ * N must be power of 2 */
+template<typename T, u32 N>
+class spsc_ring {
+    static_assert(N >= 2 && !(N & (N - 1)), "spsc_ring size must be power of 2");
+
+private:
+    static constexpr u64 mask = N - 1;
+
+    alignas(64) std::atomic<u64> tail_ { 0 };
+    u64 head_cache_ = 0; // Producer's view of head
+
+    alignas(64) std::atomic<u64> head_ { 0 };
+    u64 tail_cache_ = 0; // Consumer's view of tail
+
+    alignas(64) T buffer_[N];
+
+public:
+    spsc_ring() = default;
+
+    spsc_ring(const spsc_ring&) = delete;
+    spsc_ring& operator=(const spsc_ring&) = delete;
+
+    // Producer only, fails when ring is full
+    template<typename U>
+    inline b8 push(U &&value)
+    {
+        const u64 tail = tail_.load(std::memory_order_relaxed);
+
+        if (tail - head_cache_ == N) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ == N) { return false; }
+        }
+
+        buffer_[tail & mask] = std::forward<U>(value);
+        tail_.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Consumer only, fails when ring is empty
+    inline b8 pop(T &value)
+    {
+        const u64 head = head_.load(std::memory_order_relaxed);
+
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) { return false; }
+        }
+
+        value = std::move(buffer_[head & mask]);
+        head_.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Approximate when other side is active
+    inline u32 size() const
+    {
+        u64 tail = tail_.load(std::memory_order_acquire);
+        u64 head = head_.load(std::memory_order_acquire);
+        return tail > head ? static_cast<u32>(tail - head) : 0;
+    }
+
+    constexpr u32 capacity() const { return N; }
+};
+
+}
+
+#endif // HK_SPSC_RING_H
@@ -6,9 +6,11 @@
 
 #include "math/utils.h"
 
-#include <initializer_list>
+#include "memory/hkallocator.h"
 
-// TODO: replace with custom allocators
+#include <initializer_list>
+#include <type_traits>
+#include <cstring>
 #include <memory>
 
 namespace hk {
@@ -45,6 +47,13 @@ public:
      * Same as vector(list.begin(), list.end()) */
     constexpr vector(std::initializer_list<T> list);
 
+    /* Constructs an empty vector that takes memory from allocator,
+     * allocator must outlive the vector. Copies of it use heap */
+    explicit constexpr vector(mem::Allocator &allocator);
+
+    // Constructs a vector with size default-inserted objects of T in allocator
+    constexpr vector(u32 size, mem::Allocator &allocator);
+
     /* ===== Destructors ===== */
 
     // *sad trumpet noises*
@@ -63,11 +72,24 @@ public:
         return *this;
     }
 
-    // Move assignment operator
+    /* Move assignment operator,
+     * Elements are moved one by one when allocators differ */
     constexpr vector<T>& operator=(vector<T> &&other)
     {
+        if (this == &other) { return *this; }
+
         clear();
-        if (buffer_) { free(buffer_); }
+
+        if (alloc_ != other.alloc_) {
+            reserve(other.size_);
+            for (u32 i = 0; i < other.size_; ++i) {
+                emplace_back(hk::move(other.buffer_[i]));
+            }
+            other.clear();
+            return *this;
+        }
+
+        release();
 
         size_ = other.size_;
         buffer_ = other.buffer_;
@@ -229,14 +251,27 @@ public:
      * May allocate memory, create/delete elements */
     constexpr void resize(u32 size, const T &value = T());
 
+    // nullptr when vector uses heap
+    constexpr mem::Allocator* allocator() const;
+
 private:
     template <typename... Args>
     constexpr iterator place(const_iterator pos, u32 count, Args&& ...args);
 
+    /* Moves count elements from src to dst, ranges may overlap.
+     * Non trivially copyable types (e.g. libstdc++ std::string with SSO)
+     * can't be moved around with memmove/realloc */
+    static constexpr void relocate(T *dst, T *src, u64 count);
+
+    // Frees buffer, elements must be destroyed before
+    constexpr void release();
+
 private:
     u32 size_ = 0;
     u32 capacity_ = 0;
     T *buffer_ = nullptr;
+
+    mem::Allocator *alloc_ = nullptr; // nullptr is heap
 };
 
 
@@ -246,7 +281,13 @@ private:
 HKVEC_CONSTRACTOR vector(u32 size)                  { resize(size); }
 HKVEC_CONSTRACTOR vector(u32 count, const T &value) { resize(count, value); }
 HKVEC_CONSTRACTOR vector(const vector<T> &other)    { *this = other; }
-HKVEC_CONSTRACTOR vector(vector<T> &&other)         { *this = hk::move(other); }
+HKVEC_CONSTRACTOR vector(vector<T> &&other)
+    : alloc_(other.alloc_)                          { *this = hk::move(other); }
+
+HKVEC_CONSTRACTOR vector(mem::Allocator &allocator)
+    : alloc_(&allocator)                            {}
+HKVEC_CONSTRACTOR vector(u32 size, mem::Allocator &allocator)
+    : alloc_(&allocator)                            { resize(size); }
 
 template <typename T>
 template<typename ItType, typename>
@@ -270,7 +311,7 @@ template <typename T>
 inline vector<T>::~vector()
 {
     clear();
-    if (buffer_) { free (buffer_); }
+    release();
 }
 
 /* ===== Operator Overloads ===== */
@@ -540,7 +581,7 @@ constexpr HKVEC_IT vector<T>::erase(HKVEC_CONST_IT first, HKVEC_CONST_IT last)
 
     // Move remaining elements leftward
     if (last < end()) {
-        std::memmove(first, last, static_cast<u32>(end() - first) * sizeof(T));
+        relocate(first, last, static_cast<u64>(end() - last));
     }
 
     size_ -= count;
@@ -585,10 +626,35 @@ constexpr void vector<T>::reserve(u32 capacity)
 {
     if (capacity <= capacity_) { return; }
 
-    void *tmp = std::realloc(buffer_, capacity * sizeof(T));
-    if (!tmp) { return; }
+    if (alloc_) {
+        // Linear allocators can extend their last allocation
+        if (buffer_ && alloc_->grow(buffer_, capacity_ * sizeof(T), capacity * sizeof(T))) {
+            capacity_ = capacity;
+            return;
+        }
+
+        T *tmp = static_cast<T*>(alloc_->allocate(capacity * sizeof(T), alignof(T)));
+        if (!tmp) { return; }
+
+        relocate(tmp, buffer_, size_);
+        release();
+
+        buffer_ = tmp;
+    } else if constexpr (std::is_trivially_copyable_v<T>) {
+        void *tmp = std::realloc(buffer_, capacity * sizeof(T));
+        if (!tmp) { return; }
+
+        buffer_ = static_cast<T*>(tmp);
+    } else {
+        T *tmp = static_cast<T*>(std::malloc(capacity * sizeof(T)));
+        if (!tmp) { return; }
+
+        relocate(tmp, buffer_, size_);
+        if (buffer_) { free(buffer_); }
+
+        buffer_ = tmp;
+    }
 
-    buffer_ = static_cast<T*>(tmp);
     capacity_ = capacity;
 }
 
@@ -605,6 +671,12 @@ constexpr void vector<T>::resize(u32 size, const T &value)
     }
 }
 
+template <typename T>
+constexpr mem::Allocator* vector<T>::allocator() const
+{
+    return alloc_;
+}
+
 template <typename T>
 template <typename... Args>
 constexpr
@@ -617,17 +689,20 @@ HKVEC_IT vector<T>::place(HKVEC_CONST_IT pos, u32 count, Args&& ...args)
 
     if (!count) { return begin(); }
 
+    // reserve may move the buffer, pos is not valid after it
+    u64 offset = static_cast<u64>(pos - begin());
+
     u32 new_size = size_ + count;
     if (new_size >= capacity_) {
         reserve(hkm::max(new_size, (capacity_ + 1) * 2));
     }
 
     // Shift elements to make room for new elem
-    iterator insert_pos = pos; // const, lmao
-    u64 shift_count = end() - pos;
+    iterator insert_pos = begin() + offset;
+    u64 shift_count = end() - insert_pos;
 
     // shift_count == 0, is a valid call
-    std::memmove(insert_pos + count, insert_pos, shift_count * sizeof(T));
+    relocate(insert_pos + count, insert_pos, shift_count);
 
     for (u32 i = 0; i < count; ++i) {
         new (insert_pos + i) T(hk::forward<Args>(args)...);
@@ -637,6 +712,41 @@ HKVEC_IT vector<T>::place(HKVEC_CONST_IT pos, u32 count, Args&& ...args)
     return insert_pos;
 }
 
+template <typename T>
+constexpr void vector<T>::relocate(T *dst, T *src, u64 count)
+{
+    if (!count || dst == src) { return; }
+
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        std::memmove(dst, src, count * sizeof(T));
+    } else if (dst < src) {
+        for (u64 i = 0; i < count; ++i) {
+            new (dst + i) T(hk::move(src[i]));
+            src[i].~T();
+        }
+    } else {
+        for (u64 i = count; i > 0; --i) {
+            new (dst + i - 1) T(hk::move(src[i - 1]));
+            src[i - 1].~T();
+        }
+    }
+}
+
+template <typename T>
+constexpr void vector<T>::release()
+{
+    if (!buffer_) { return; }
+
+    if (alloc_) {
+        alloc_->deallocate(buffer_, capacity_ * sizeof(T));
+    } else {
+        std::free(buffer_);
+    }
+
+    buffer_ = nullptr;
+    capacity_ = 0;
+}
+
 #undef HKVEC_IT
 #undef HKVEC_CONST_IT
 
@@ -4,12 +4,25 @@
 #include "Logger.h"
 #include "containers/hkvector.h"
 #include "containers/hkring_buffer.h"
+#include "containers/hkmpmc_ring.h"
+#include "containers/hkspsc_ring.h"
+#include "containers/hkslot_map.h"
+#include "containers/hkflat_map.h"
+#include "containers/hkbvh.h"
+#include "memory/hkallocator.h"
+#include "memory/hklinear.h"
+#include "memory/hkarena.h"
+#include "memory/hkpool.h"
+#include "memory/hkframe.h"
 #include "numerics/hkbit.h"
 #include "numerics/hkbitset.h"
 #include "numerics/hkbitflag.h"
 #include "numerics/hkrandom.h"
 #include "strings/hklocale.h"
+#include "strings/hkstring_id.h"
 #include "utility/hktypes.h"
 #include "utility/hkassert.h"
+#include "utility/hkhash.h"
+#include "utility/hkhandle.h"
 
 #endif // HK_STL_H
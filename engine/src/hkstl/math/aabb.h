@@ -0,0 +1,70 @@
+#ifndef HK_AABB_H
+#define HK_AABB_H
+
+#include "vec3f.h"
+
+#include <cfloat>
+
+namespace hkm {
+
+// Axis aligned box, default one is empty and merges into anything
+struct aabb {
+    vec3f min = vec3f(FLT_MAX);
+    vec3f max = vec3f(-FLT_MAX);
+
+    constexpr aabb() = default;
+    constexpr aabb(const vec3f &lo, const vec3f &hi) : min(lo), max(hi) {}
+
+    constexpr vec3f center() const { return (min + max) * .5f; }
+    constexpr vec3f extent() const { return (max - min) * .5f; }
+
+    // Half of surface area, SAH only compares them
+    constexpr f32 area() const
+    {
+        const vec3f d = max - min;
+        return d.x * d.y + d.y * d.z + d.z * d.x;
+    }
+};
+
+constexpr aabb merge(const aabb &a, const aabb &b)
+{
+    return aabb(vec3f(a.min.x < b.min.x ? a.min.x : b.min.x,
+                      a.min.y < b.min.y ? a.min.y : b.min.y,
+                      a.min.z < b.min.z ? a.min.z : b.min.z),
+                vec3f(a.max.x > b.max.x ? a.max.x : b.max.x,
+                      a.max.y > b.max.y ? a.max.y : b.max.y,
+                      a.max.z > b.max.z ? a.max.z : b.max.z));
+}
+
+constexpr b8 contains(const aabb &outer, const aabb &inner)
+{
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y &&
+           outer.min.z <= inner.min.z && outer.max.x >= inner.max.x &&
+           outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+constexpr b8 overlaps(const aabb &a, const aabb &b)
+{
+    return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+           a.min.y <= b.max.y && a.max.y >= b.min.y &&
+           a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+// Zero when point is inside
+constexpr f32 distancesq(const aabb &box, const vec3f &point)
+{
+    f32 dist = 0.f;
+    for (u32 axis = 0; axis < 3; ++axis) {
+        const f32 below = box.min[axis] - point[axis];
+        const f32 above = point[axis] - box.max[axis];
+
+        if (below > 0.f) { dist += below * below; }
+        if (above > 0.f) { dist += above * above; }
+    }
+
+    return dist;
+}
+
+}
+
+#endif // HK_AABB_H
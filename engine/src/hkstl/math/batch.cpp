@@ -0,0 +1,174 @@
+#include "batch.h"
+
+namespace hkm {
+
+template<typename T>
+static inline const T& at(const T *base, u32 stride, u32 idx)
+{
+    return *reinterpret_cast<const T*>(
+        reinterpret_cast<const u8*>(base) + static_cast<u64>(stride) * idx);
+}
+
+template<typename T>
+static inline T& at(T *base, u32 stride, u32 idx)
+{
+    return *reinterpret_cast<T*>(
+        reinterpret_cast<u8*>(base) + static_cast<u64>(stride) * idx);
+}
+
+void mul(const mat4f *A, const mat4f *B, mat4f *out, u32 count)
+{
+    const auto kernel = simd::kernels.mat4_mul;
+
+    for (u32 i = 0; i < count; ++i) {
+        kernel(A[i], B[i], out[i]);
+    }
+}
+
+void mul(const mat4f *A, const mat4f &B, mat4f *out, u32 count)
+{
+    const auto kernel = simd::kernels.mat4_mul;
+
+    // B may live inside out
+    const mat4f rhs = B;
+
+    for (u32 i = 0; i < count; ++i) {
+        kernel(A[i], rhs, out[i]);
+    }
+}
+
+void trs(const vec3f *pos, const quaternion *rotation, const vec3f *scale,
+         u32 stride, mat4f *out, u32 count)
+{
+    // Expanded S * R * T: rows of rotation matrix scaled, translation in row 3
+    for (u32 i = 0; i < count; ++i) {
+        const quaternion &q = at(rotation, stride, i);
+        const vec3f &s = at(scale, stride, i);
+        const vec3f &p = at(pos, stride, i);
+
+        const f32 x2 = q.x * q.x;
+        const f32 y2 = q.y * q.y;
+        const f32 z2 = q.z * q.z;
+        const f32 xy = q.x * q.y;
+        const f32 xz = q.x * q.z;
+        const f32 yz = q.y * q.z;
+        const f32 wx = q.w * q.x;
+        const f32 wy = q.w * q.y;
+        const f32 wz = q.w * q.z;
+
+        f32 (&m)[4][4] = out[i].n;
+
+        m[0][0] = s.x * (1.f - 2.f * (y2 + z2));
+        m[0][1] = s.x * (2.f * (xy - wz));
+        m[0][2] = s.x * (2.f * (xz + wy));
+        m[0][3] = 0.f;
+
+        m[1][0] = s.y * (2.f * (xy + wz));
+        m[1][1] = s.y * (1.f - 2.f * (x2 + z2));
+        m[1][2] = s.y * (2.f * (yz - wx));
+        m[1][3] = 0.f;
+
+        m[2][0] = s.z * (2.f * (xz - wy));
+        m[2][1] = s.z * (2.f * (yz + wx));
+        m[2][2] = s.z * (1.f - 2.f * (x2 + y2));
+        m[2][3] = 0.f;
+
+        m[3][0] = p.x;
+        m[3][1] = p.y;
+        m[3][2] = p.z;
+        m[3][3] = 1.f;
+    }
+}
+
+void transformNormals(const mat4f &M, const vec3f *in, vec3f *out, u32 count)
+{
+    const mat4f normal_matrix = transpose(inverse(M));
+
+    simd::kernels.transform_vectors(normal_matrix, in, out, count);
+
+    for (u32 i = 0; i < count; ++i) {
+        const f32 lengthsq = out[i].x * out[i].x +
+                             out[i].y * out[i].y +
+                             out[i].z * out[i].z;
+        const f32 inv = lengthsq > 0.f ? 1.f / sqrt(lengthsq) : 0.f;
+
+        out[i].x *= inv;
+        out[i].y *= inv;
+        out[i].z *= inv;
+    }
+}
+
+void transformAABBs(const mat4f &M,
+                    const vec3f *min, const vec3f *max,
+                    vec3f *out_min, vec3f *out_max, u32 count)
+{
+    for (u32 i = 0; i < count; ++i) {
+        const f32 lo[3] = { min[i].x, min[i].y, min[i].z };
+        const f32 hi[3] = { max[i].x, max[i].y, max[i].z };
+
+        f32 rmin[3] = { M(3, 0), M(3, 1), M(3, 2) };
+        f32 rmax[3] = { M(3, 0), M(3, 1), M(3, 2) };
+
+        for (u32 row = 0; row < 3; ++row) {
+            for (u32 col = 0; col < 3; ++col) {
+                const f32 a = M(row, col) * lo[row];
+                const f32 b = M(row, col) * hi[row];
+
+                rmin[col] += a < b ? a : b;
+                rmax[col] += a < b ? b : a;
+            }
+        }
+
+        out_min[i] = vec3f(rmin[0], rmin[1], rmin[2]);
+        out_max[i] = vec3f(rmax[0], rmax[1], rmax[2]);
+    }
+}
+
+void frustumPlanes(const mat4f &M, vec4f planes[6])
+{
+    // Row vectors, clip = v * M, so clip components are columns of M.
+    // Depth is in [0, w] either way around, so reversed depth works too
+    const vec4f x(M(0, 0), M(1, 0), M(2, 0), M(3, 0));
+    const vec4f y(M(0, 1), M(1, 1), M(2, 1), M(3, 1));
+    const vec4f z(M(0, 2), M(1, 2), M(2, 2), M(3, 2));
+    const vec4f w(M(0, 3), M(1, 3), M(2, 3), M(3, 3));
+
+    planes[0] = w + x;
+    planes[1] = w - x;
+    planes[2] = w + y;
+    planes[3] = w - y;
+    planes[4] = z;
+    planes[5] = w - z;
+}
+
+u32 cullAABBs(const vec4f planes[6], const AABBArrays &boxes, u32 count, u32 *visible)
+{
+    return simd::kernels.cull_aabbs(planes, boxes, count, visible);
+}
+
+void copy(const vec3f *src, u32 src_stride,
+          vec3f *dst, u32 dst_stride, u32 count, f32 scale)
+{
+    for (u32 i = 0; i < count; ++i) {
+        const vec3f &s = at(src, src_stride, i);
+        vec3f &d = at(dst, dst_stride, i);
+
+        d.x = s.x * scale;
+        d.y = s.y * scale;
+        d.z = s.z * scale;
+    }
+}
+
+void copy(const vec2f *src, u32 src_stride,
+          vec2f *dst, u32 dst_stride, u32 count)
+{
+    for (u32 i = 0; i < count; ++i) {
+        const vec2f &s = at(src, src_stride, i);
+        vec2f &d = at(dst, dst_stride, i);
+
+        d.x = s.x;
+        d.y = s.y;
+    }
+}
+
+}
@@ -0,0 +1,58 @@
+#ifndef HK_MATH_BATCH_H
+#define HK_MATH_BATCH_H
+
+#include "hkcommon.h"
+#include "utility/hktypes.h"
+
+#include "vec2f.h"
+#include "vec3f.h"
+#include "vec4f.h"
+#include "mat4f.h"
+#include "quaternion.h"
+
+/* Array versions of hot math operations.
+ * Strides are in bytes and let functions work directly on
+ * array of structs layouts like Transform or Vertex */
+namespace hkm {
+
+// Axis aligned boxes as arrays of components, center and half extent per axis
+struct AABBArrays {
+    const f32 *center[3];
+    const f32 *extent[3];
+};
+
+// out[i] = A[i] * B[i], local * parent gives child in parent space
+HKAPI void mul(const mat4f *A, const mat4f *B, mat4f *out, u32 count);
+// out[i] = A[i] * B
+HKAPI void mul(const mat4f *A, const mat4f &B, mat4f *out, u32 count);
+
+// Scale * Rotation * Translation per element, same as Transform::toMat4f
+HKAPI void trs(const vec3f *pos, const quaternion *rotation, const vec3f *scale,
+               u32 stride, mat4f *out, u32 count);
+
+// Uses inverse transpose of M and renormalizes, in and out may be the same
+HKAPI void transformNormals(const mat4f &M, const vec3f *in, vec3f *out, u32 count);
+
+// Arvo's method: resulting boxes are axis aligned and enclose transformed ones
+HKAPI void transformAABBs(const mat4f &M,
+                          const vec3f *min, const vec3f *max,
+                          vec3f *out_min, vec3f *out_max, u32 count);
+
+// Left, right, bottom, top, near and far planes of view projection,
+// normals point inside. Planes aren't normalized, only signs are used
+HKAPI void frustumPlanes(const mat4f &view_proj, vec4f planes[6]);
+
+// Writes indices of boxes intersecting frustum, returns their count.
+// Test is conservative, boxes near frustum corners may pass.
+// visible must fit count indices
+HKAPI u32 cullAABBs(const vec4f planes[6], const AABBArrays &boxes, u32 count, u32 *visible);
+
+// Strided copies between interleaved layouts, e.g. importer data into Vertex
+HKAPI void copy(const vec3f *src, u32 src_stride,
+                vec3f *dst, u32 dst_stride, u32 count, f32 scale = 1.f);
+HKAPI void copy(const vec2f *src, u32 src_stride,
+                vec2f *dst, u32 dst_stride, u32 count);
+
+}
+
+#endif // HK_MATH_BATCH_H
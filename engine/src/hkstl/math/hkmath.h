@@ -13,5 +13,8 @@
 #include "mat4f.h"
 
 #include "quaternion.h"
+#include "aabb.h"
+
+#include "batch.h"
 
 #endif // HK_MATH_H
@@ -4,6 +4,7 @@
 #include "vec3f.h"
 #include "vec4f.h"
 #include "mat3f.h"
+#include "simd.h"
 
 namespace hkm {
 
@@ -202,6 +203,17 @@ inline mat4f inverse(const mat4f &m)
     return im;
 }
 
+// Batched affine transforms, in and out may point to the same array
+inline void transformPoints(const mat4f &M, const vec3f *in, vec3f *out, u32 count)
+{
+    simd::kernels.transform_points(M, in, out, count);
+}
+
+inline void transformVecs(const mat4f &M, const vec3f *in, vec3f *out, u32 count)
+{
+    simd::kernels.transform_vectors(M, in, out, count);
+}
+
 }
 
 #endif // HK_MAT4F_H
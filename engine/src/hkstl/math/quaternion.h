@@ -163,7 +163,7 @@ constexpr quaternion operator /(const quaternion &q, f32 s)
     return quaternion(q.x * s, q.y * s, q.z * s, q.w * s);
 }
 
-constexpr quaternion normalize(const quaternion &q)
+inline quaternion normalize(const quaternion &q)
 {
     // if (q.w < 0) {
     //     return q / -q.length();
@@ -187,6 +187,36 @@ constexpr vec3f operator *(const quaternion &q, const vec3f &v)
     return v * q;
 }
 
+// Spherical interpolation along the shortest path, result is normalized
+inline quaternion slerp(const quaternion &q1, const quaternion &q2, f32 t)
+{
+    f32 cosom = q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+
+    // Take the shortest path
+    f32 sign = 1.f;
+    if (cosom < 0.f) {
+        cosom = -cosom;
+        sign = -1.f;
+    }
+
+    // Nearly parallel, fall back to nlerp to avoid division by ~0
+    f32 w1 = 1.f - t;
+    f32 w2 = t;
+    if (cosom <= .9995f) {
+        f32 omega = std::acos(cosom);
+        f32 sinom = 1.f / std::sin(omega);
+
+        w1 = std::sin((1.f - t) * omega) * sinom;
+        w2 = std::sin(t * omega) * sinom;
+    }
+    w2 *= sign;
+
+    return normalize(quaternion(q1.x * w1 + q2.x * w2,
+                                q1.y * w1 + q2.y * w2,
+                                q1.z * w1 + q2.z * w2,
+                                q1.w * w1 + q2.w * w2));
+}
+
 // Angle passed in radians
 inline quaternion fromAxisAngle(const vec3f &v, f32 angle)
 {
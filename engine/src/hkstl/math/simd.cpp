@@ -0,0 +1,475 @@
+#include "simd.h"
+
+#include "vec3f.h"
+#include "vec4f.h"
+#include "mat4f.h"
+#include "batch.h"
+
+#include "utils/spec.h"
+#include "hkstl/Logger.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+    #define HK_SIMD_X86
+    #include <immintrin.h>
+
+    #ifdef _MSC_VER
+        #include <intrin.h>
+        #define HK_TARGET_AVX2
+    #else
+        #define HK_TARGET_AVX2 __attribute__((target("avx2,fma")))
+    #endif
+#endif
+
+namespace hkm::simd {
+
+/* ===== Scalar ===== */
+namespace scalar {
+
+static void mat4_mul(const mat4f &A, const mat4f &B, mat4f &out)
+{
+    out = mat4f(
+        A(0, 0) * B(0, 0) + A(0, 1) * B(1, 0) + A(0, 2) * B(2, 0) + A(0, 3) * B(3, 0),
+        A(0, 0) * B(0, 1) + A(0, 1) * B(1, 1) + A(0, 2) * B(2, 1) + A(0, 3) * B(3, 1),
+        A(0, 0) * B(0, 2) + A(0, 1) * B(1, 2) + A(0, 2) * B(2, 2) + A(0, 3) * B(3, 2),
+        A(0, 0) * B(0, 3) + A(0, 1) * B(1, 3) + A(0, 2) * B(2, 3) + A(0, 3) * B(3, 3),
+        A(1, 0) * B(0, 0) + A(1, 1) * B(1, 0) + A(1, 2) * B(2, 0) + A(1, 3) * B(3, 0),
+        A(1, 0) * B(0, 1) + A(1, 1) * B(1, 1) + A(1, 2) * B(2, 1) + A(1, 3) * B(3, 1),
+        A(1, 0) * B(0, 2) + A(1, 1) * B(1, 2) + A(1, 2) * B(2, 2) + A(1, 3) * B(3, 2),
+        A(1, 0) * B(0, 3) + A(1, 1) * B(1, 3) + A(1, 2) * B(2, 3) + A(1, 3) * B(3, 3),
+        A(2, 0) * B(0, 0) + A(2, 1) * B(1, 0) + A(2, 2) * B(2, 0) + A(2, 3) * B(3, 0),
+        A(2, 0) * B(0, 1) + A(2, 1) * B(1, 1) + A(2, 2) * B(2, 1) + A(2, 3) * B(3, 1),
+        A(2, 0) * B(0, 2) + A(2, 1) * B(1, 2) + A(2, 2) * B(2, 2) + A(2, 3) * B(3, 2),
+        A(2, 0) * B(0, 3) + A(2, 1) * B(1, 3) + A(2, 2) * B(2, 3) + A(2, 3) * B(3, 3),
+        A(3, 0) * B(0, 0) + A(3, 1) * B(1, 0) + A(3, 2) * B(2, 0) + A(3, 3) * B(3, 0),
+        A(3, 0) * B(0, 1) + A(3, 1) * B(1, 1) + A(3, 2) * B(2, 1) + A(3, 3) * B(3, 1),
+        A(3, 0) * B(0, 2) + A(3, 1) * B(1, 2) + A(3, 2) * B(2, 2) + A(3, 3) * B(3, 2),
+        A(3, 0) * B(0, 3) + A(3, 1) * B(1, 3) + A(3, 2) * B(2, 3) + A(3, 3) * B(3, 3)
+    );
+}
+
+static void transform_points(const mat4f &M, const vec3f *in, vec3f *out, u32 count)
+{
+    for (u32 i = 0; i < count; ++i) {
+        const vec3f v = in[i];
+        out[i] = vec3f(M(0, 0) * v.x + M(1, 0) * v.y + M(2, 0) * v.z + M(3, 0),
+                       M(0, 1) * v.x + M(1, 1) * v.y + M(2, 1) * v.z + M(3, 1),
+                       M(0, 2) * v.x + M(1, 2) * v.y + M(2, 2) * v.z + M(3, 2));
+    }
+}
+
+static void transform_vectors(const mat4f &M, const vec3f *in, vec3f *out, u32 count)
+{
+    for (u32 i = 0; i < count; ++i) {
+        const vec3f v = in[i];
+        out[i] = vec3f(M(0, 0) * v.x + M(1, 0) * v.y + M(2, 0) * v.z,
+                       M(0, 1) * v.x + M(1, 1) * v.y + M(2, 1) * v.z,
+                       M(0, 2) * v.x + M(1, 2) * v.y + M(2, 2) * v.z);
+    }
+}
+
+// Also handles tails of wide kernels, indices are written starting from begin
+static u32 cull_range(const vec4f *planes, const AABBArrays &boxes,
+                      u32 begin, u32 end, u32 *visible)
+{
+    const f32 *cx = boxes.center[0];
+    const f32 *cy = boxes.center[1];
+    const f32 *cz = boxes.center[2];
+    const f32 *ex = boxes.extent[0];
+    const f32 *ey = boxes.extent[1];
+    const f32 *ez = boxes.extent[2];
+
+    u32 written = 0;
+    for (u32 i = begin; i < end; ++i) {
+        b8 inside = true;
+
+        // Box is outside when its corner furthest along normal is behind plane
+        for (u32 p = 0; p < 6; ++p) {
+            const vec4f &n = planes[p];
+            const f32 d = n.x * cx[i] + n.y * cy[i] + n.z * cz[i] + n.w +
+                          std::fabs(n.x) * ex[i] +
+                          std::fabs(n.y) * ey[i] +
+                          std::fabs(n.z) * ez[i];
+
+            inside = inside && d >= 0.f;
+        }
+
+        // Always written, only kept when inside
+        visible[written] = i;
+        written += inside;
+    }
+
+    return written;
+}
+
+static u32 cull_aabbs(const vec4f *planes, const AABBArrays &boxes, u32 count, u32 *visible)
+{
+    return cull_range(planes, boxes, 0, count, visible);
+}
+
+}
+
+#ifdef HK_SIMD_X86
+/* ===== SSE2 ===== */
+namespace sse2 {
+
+#define HK_SHUFFLE(v1, v2, x, y, z, w) \
+    _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(w, z, y, x))
+#define HK_SWIZZLE(v, x, y, z, w) HK_SHUFFLE(v, v, x, y, z, w)
+#define HK_SPLAT(v, i) HK_SWIZZLE(v, i, i, i, i)
+
+static inline void store3(vec3f &out, __m128 v)
+{
+    _mm_storel_pi(reinterpret_cast<__m64*>(&out.x), v);
+    _mm_store_ss(&out.z, _mm_movehl_ps(v, v));
+}
+
+// Row-vector convention: out.row[i] = sum A(i, k) * B.row[k]
+static inline __m128 row_mul(__m128 a, __m128 b0, __m128 b1, __m128 b2, __m128 b3)
+{
+    __m128 r = _mm_mul_ps(HK_SPLAT(a, 0), b0);
+    r = _mm_add_ps(r, _mm_mul_ps(HK_SPLAT(a, 1), b1));
+    r = _mm_add_ps(r, _mm_mul_ps(HK_SPLAT(a, 2), b2));
+    r = _mm_add_ps(r, _mm_mul_ps(HK_SPLAT(a, 3), b3));
+    return r;
+}
+
+static void mat4_mul(const mat4f &A, const mat4f &B, mat4f &out)
+{
+    const __m128 b0 = _mm_loadu_ps(B.n[0]);
+    const __m128 b1 = _mm_loadu_ps(B.n[1]);
+    const __m128 b2 = _mm_loadu_ps(B.n[2]);
+    const __m128 b3 = _mm_loadu_ps(B.n[3]);
+
+    // Load all of A first, out may alias A or B
+    const __m128 a0 = _mm_loadu_ps(A.n[0]);
+    const __m128 a1 = _mm_loadu_ps(A.n[1]);
+    const __m128 a2 = _mm_loadu_ps(A.n[2]);
+    const __m128 a3 = _mm_loadu_ps(A.n[3]);
+
+    _mm_storeu_ps(out.n[0], row_mul(a0, b0, b1, b2, b3));
+    _mm_storeu_ps(out.n[1], row_mul(a1, b0, b1, b2, b3));
+    _mm_storeu_ps(out.n[2], row_mul(a2, b0, b1, b2, b3));
+    _mm_storeu_ps(out.n[3], row_mul(a3, b0, b1, b2, b3));
+}
+
+static void transform_points(const mat4f &M, const vec3f *in, vec3f *out, u32 count)
+{
+    const __m128 r0 = _mm_loadu_ps(M.n[0]);
+    const __m128 r1 = _mm_loadu_ps(M.n[1]);
+    const __m128 r2 = _mm_loadu_ps(M.n[2]);
+    const __m128 r3 = _mm_loadu_ps(M.n[3]);
+
+    for (u32 i = 0; i < count; ++i) {
+        __m128 r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(in[i].x), r0), r3);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(in[i].y), r1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(in[i].z), r2));
+        store3(out[i], r);
+    }
+}
+
+static void transform_vectors(const mat4f &M, const vec3f *in, vec3f *out, u32 count)
+{
+    const __m128 r0 = _mm_loadu_ps(M.n[0]);
+    const __m128 r1 = _mm_loadu_ps(M.n[1]);
+    const __m128 r2 = _mm_loadu_ps(M.n[2]);
+
+    for (u32 i = 0; i < count; ++i) {
+        __m128 r = _mm_mul_ps(_mm_set1_ps(in[i].x), r0);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(in[i].y), r1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(in[i].z), r2));
+        store3(out[i], r);
+    }
+}
+
+// Four boxes per iteration, planes are splatted once
+static u32 cull_aabbs(const vec4f *planes, const AABBArrays &boxes, u32 count, u32 *visible)
+{
+    const __m128 sign = _mm_set1_ps(-0.f);
+
+    __m128 n[6][4];
+    __m128 a[6][3];
+    for (u32 p = 0; p < 6; ++p) {
+        const __m128 plane = _mm_loadu_ps(&planes[p].x);
+        const __m128 magnitude = _mm_andnot_ps(sign, plane);
+
+        for (u32 c = 0; c < 4; ++c) { n[p][c] = _mm_set1_ps(planes[p][c]); }
+        a[p][0] = HK_SPLAT(magnitude, 0);
+        a[p][1] = HK_SPLAT(magnitude, 1);
+        a[p][2] = HK_SPLAT(magnitude, 2);
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+
+    u32 written = 0;
+    u32 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 cx = _mm_loadu_ps(boxes.center[0] + i);
+        const __m128 cy = _mm_loadu_ps(boxes.center[1] + i);
+        const __m128 cz = _mm_loadu_ps(boxes.center[2] + i);
+        const __m128 ex = _mm_loadu_ps(boxes.extent[0] + i);
+        const __m128 ey = _mm_loadu_ps(boxes.extent[1] + i);
+        const __m128 ez = _mm_loadu_ps(boxes.extent[2] + i);
+
+        __m128 outside = zero;
+        for (u32 p = 0; p < 6; ++p) {
+            __m128 d = _mm_add_ps(_mm_mul_ps(cx, n[p][0]), n[p][3]);
+            d = _mm_add_ps(d, _mm_mul_ps(cy, n[p][1]));
+            d = _mm_add_ps(d, _mm_mul_ps(cz, n[p][2]));
+            d = _mm_add_ps(d, _mm_mul_ps(ex, a[p][0]));
+            d = _mm_add_ps(d, _mm_mul_ps(ey, a[p][1]));
+            d = _mm_add_ps(d, _mm_mul_ps(ez, a[p][2]));
+
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(d, zero));
+        }
+
+        // Branchless compaction, write position only moves for visible lanes
+        const u32 mask = ~_mm_movemask_ps(outside);
+        for (u32 lane = 0; lane < 4; ++lane) {
+            visible[written] = i + lane;
+            written += (mask >> lane) & 1;
+        }
+    }
+
+    if (i < count) {
+        written += scalar::cull_range(planes, boxes, i, count, visible + written);
+    }
+
+    return written;
+}
+
+}
+
+/* ===== AVX2 + FMA ===== */
+namespace avx2 {
+
+// Two rows of A per iteration, each 128-bit lane works on its own row
+HK_TARGET_AVX2 static void mat4_mul(const mat4f &A, const mat4f &B, mat4f &out)
+{
+    const __m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(B.n[0]));
+    const __m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(B.n[1]));
+    const __m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(B.n[2]));
+    const __m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(B.n[3]));
+
+    const __m256 a01 = _mm256_loadu_ps(A.n[0]);
+    const __m256 a23 = _mm256_loadu_ps(A.n[2]);
+
+    __m256 r01 = _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x00), b0);
+    r01 = _mm256_fmadd_ps(_mm256_shuffle_ps(a01, a01, 0x55), b1, r01);
+    r01 = _mm256_fmadd_ps(_mm256_shuffle_ps(a01, a01, 0xaa), b2, r01);
+    r01 = _mm256_fmadd_ps(_mm256_shuffle_ps(a01, a01, 0xff), b3, r01);
+
+    __m256 r23 = _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0x00), b0);
+    r23 = _mm256_fmadd_ps(_mm256_shuffle_ps(a23, a23, 0x55), b1, r23);
+    r23 = _mm256_fmadd_ps(_mm256_shuffle_ps(a23, a23, 0xaa), b2, r23);
+    r23 = _mm256_fmadd_ps(_mm256_shuffle_ps(a23, a23, 0xff), b3, r23);
+
+    _mm256_storeu_ps(out.n[0], r01);
+    _mm256_storeu_ps(out.n[2], r23);
+}
+
+HK_TARGET_AVX2 static inline __m256 splat2(f32 lo, f32 hi)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(lo)),
+                                _mm_set1_ps(hi), 1);
+}
+
+// Two points per iteration, one per 128-bit lane
+HK_TARGET_AVX2 static void transform_points(const mat4f &M, const vec3f *in, vec3f *out, u32 count)
+{
+    const __m256 r0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(M.n[0]));
+    const __m256 r1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(M.n[1]));
+    const __m256 r2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(M.n[2]));
+    const __m256 r3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(M.n[3]));
+
+    u32 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m256 r = _mm256_fmadd_ps(splat2(in[i].x, in[i + 1].x), r0, r3);
+        r = _mm256_fmadd_ps(splat2(in[i].y, in[i + 1].y), r1, r);
+        r = _mm256_fmadd_ps(splat2(in[i].z, in[i + 1].z), r2, r);
+
+        sse2::store3(out[i],     _mm256_castps256_ps128(r));
+        sse2::store3(out[i + 1], _mm256_extractf128_ps(r, 1));
+    }
+
+    if (i < count) {
+        sse2::transform_points(M, in + i, out + i, count - i);
+    }
+}
+
+HK_TARGET_AVX2 static void transform_vectors(const mat4f &M, const vec3f *in, vec3f *out, u32 count)
+{
+    const __m256 r0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(M.n[0]));
+    const __m256 r1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(M.n[1]));
+    const __m256 r2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(M.n[2]));
+
+    u32 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m256 r = _mm256_mul_ps(splat2(in[i].x, in[i + 1].x), r0);
+        r = _mm256_fmadd_ps(splat2(in[i].y, in[i + 1].y), r1, r);
+        r = _mm256_fmadd_ps(splat2(in[i].z, in[i + 1].z), r2, r);
+
+        sse2::store3(out[i],     _mm256_castps256_ps128(r));
+        sse2::store3(out[i + 1], _mm256_extractf128_ps(r, 1));
+    }
+
+    if (i < count) {
+        sse2::transform_vectors(M, in + i, out + i, count - i);
+    }
+}
+
+// Eight boxes per iteration
+HK_TARGET_AVX2 static u32 cull_aabbs(const vec4f *planes, const AABBArrays &boxes, u32 count, u32 *visible)
+{
+    __m256 n[6][4];
+    __m256 a[6][3];
+    for (u32 p = 0; p < 6; ++p) {
+        for (u32 c = 0; c < 4; ++c) { n[p][c] = _mm256_set1_ps(planes[p][c]); }
+        for (u32 c = 0; c < 3; ++c) { a[p][c] = _mm256_set1_ps(std::fabs(planes[p][c])); }
+    }
+
+    const __m256 zero = _mm256_setzero_ps();
+
+    u32 written = 0;
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 cx = _mm256_loadu_ps(boxes.center[0] + i);
+        const __m256 cy = _mm256_loadu_ps(boxes.center[1] + i);
+        const __m256 cz = _mm256_loadu_ps(boxes.center[2] + i);
+        const __m256 ex = _mm256_loadu_ps(boxes.extent[0] + i);
+        const __m256 ey = _mm256_loadu_ps(boxes.extent[1] + i);
+        const __m256 ez = _mm256_loadu_ps(boxes.extent[2] + i);
+
+        __m256 outside = zero;
+        for (u32 p = 0; p < 6; ++p) {
+            __m256 d = _mm256_fmadd_ps(cx, n[p][0], n[p][3]);
+            d = _mm256_fmadd_ps(cy, n[p][1], d);
+            d = _mm256_fmadd_ps(cz, n[p][2], d);
+            d = _mm256_fmadd_ps(ex, a[p][0], d);
+            d = _mm256_fmadd_ps(ey, a[p][1], d);
+            d = _mm256_fmadd_ps(ez, a[p][2], d);
+
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, zero, _CMP_LT_OQ));
+        }
+
+        const u32 mask = ~_mm256_movemask_ps(outside);
+        for (u32 lane = 0; lane < 8; ++lane) {
+            visible[written] = i + lane;
+            written += (mask >> lane) & 1;
+        }
+    }
+
+    if (i < count) {
+        written += scalar::cull_range(planes, boxes, i, count, visible + written);
+    }
+
+    return written;
+}
+
+}
+
+#undef HK_SHUFFLE
+#undef HK_SWIZZLE
+#undef HK_SPLAT
+
+// CPUID only reports hardware support, OS has to save YMM state as well
+static b8 os_saves_ymm()
+{
+    if (!hk::spec::cpu().feature.osxsave) { return false; }
+
+#ifdef _MSC_VER
+    u64 xcr0 = _xgetbv(0);
+#else
+    u32 eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    u64 xcr0 = (static_cast<u64>(edx) << 32) | eax;
+#endif
+
+    // XMM and YMM state
+    return (xcr0 & 0x6) == 0x6;
+}
+#endif // HK_SIMD_X86
+
+/* ===== Dispatch ===== */
+static constexpr Kernels scalar_kernels = {
+    scalar::mat4_mul,
+    scalar::transform_points,
+    scalar::transform_vectors,
+    scalar::cull_aabbs,
+};
+
+#ifdef HK_SIMD_X86
+static constexpr Kernels sse2_kernels = {
+    sse2::mat4_mul,
+    sse2::transform_points,
+    sse2::transform_vectors,
+    sse2::cull_aabbs,
+};
+
+// Kernels without 256-bit benefit stay on SSE2
+static constexpr Kernels avx2_kernels = {
+    avx2::mat4_mul,
+    avx2::transform_points,
+    avx2::transform_vectors,
+    avx2::cull_aabbs,
+};
+#endif
+
+Kernels kernels = scalar_kernels;
+static Level current = Level::SCALAR;
+
+b8 supported(Level level)
+{
+    const hk::spec::ProcessorSpec &cpu = hk::spec::cpu();
+
+    switch (level) {
+    case Level::SCALAR: return true;
+#ifdef HK_SIMD_X86
+    case Level::SSE2: return cpu.simd.sse2;
+    case Level::AVX2: return cpu.simd.avx2 && cpu.simd.fma3 && os_saves_ymm();
+#endif
+    default: return false;
+    }
+}
+
+b8 select(Level level)
+{
+    if (!supported(level)) { return false; }
+
+    switch (level) {
+    case Level::SCALAR: { kernels = scalar_kernels; } break;
+#ifdef HK_SIMD_X86
+    case Level::SSE2: { kernels = sse2_kernels; } break;
+    case Level::AVX2: { kernels = avx2_kernels; } break;
+#endif
+    default: return false;
+    }
+
+    current = level;
+    return true;
+}
+
+void init()
+{
+    for (u32 i = static_cast<u32>(Level::MAX_LEVELS); i-- > 0;) {
+        if (select(static_cast<Level>(i))) { break; }
+    }
+
+    LOG_INFO("Math kernels:", to_string(current));
+}
+
+Level level()
+{
+    return current;
+}
+
+const char* to_string(Level level)
+{
+    switch (level) {
+    case Level::SCALAR: return "Scalar";
+    case Level::SSE2:   return "SSE2";
+    case Level::AVX2:   return "AVX2";
+    default: return "Unknown";
+    }
+}
+
+}
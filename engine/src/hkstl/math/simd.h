@@ -0,0 +1,54 @@
+#ifndef HK_MATH_SIMD_H
+#define HK_MATH_SIMD_H
+
+#include "hkcommon.h"
+#include "utility/hktypes.h"
+
+namespace hkm {
+
+struct vec3f;
+struct vec4f;
+struct mat4f;
+struct AABBArrays;
+
+}
+
+/* Hot math kernels with scalar, SSE2 and AVX2 implementations.
+ * Table is filled with scalar kernels until init() picks the widest
+ * level supported by hk::spec::cpu() */
+namespace hkm::simd {
+
+enum class Level : u8 {
+    SCALAR = 0,
+    SSE2,
+    AVX2, // + FMA3
+
+    MAX_LEVELS
+};
+
+struct Kernels {
+    void (*mat4_mul)(const mat4f &A, const mat4f &B, mat4f &out);
+
+    // Affine transform, w is 1 for points and 0 for vectors
+    // in and out may be the same array
+    void (*transform_points)(const mat4f &M, const vec3f *in, vec3f *out, u32 count);
+    void (*transform_vectors)(const mat4f &M, const vec3f *in, vec3f *out, u32 count);
+
+    // Writes indices of boxes not outside any of 6 planes, returns their count
+    u32 (*cull_aabbs)(const vec4f *planes, const AABBArrays &boxes, u32 count, u32 *visible);
+};
+
+HKAPI extern Kernels kernels;
+
+HKAPI void init();
+
+// Fails when level isn't supported by CPU or by build
+HKAPI b8 select(Level level);
+HKAPI b8 supported(Level level);
+HKAPI Level level();
+
+HKAPI const char* to_string(Level level);
+
+}
+
+#endif // HK_MATH_SIMD_H
@@ -28,12 +28,7 @@ struct vec2f {
         return vec2f(-x, -y);
     }
 
-    constexpr vec2f& operator =(const vec2f &other)
-    {
-        this->x = other.x;
-        this->y = other.y;
-        return *this;
-    }
+    constexpr vec2f& operator =(const vec2f &other) = default;
 
     constexpr vec2f& operator +=(const vec2f &other)
     {
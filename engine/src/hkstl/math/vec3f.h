@@ -32,13 +32,7 @@ struct vec3f {
         return vec3f(-x, -y, -z);
     }
 
-    constexpr vec3f& operator =(const vec3f &other)
-    {
-        this->x = other.x;
-        this->y = other.y;
-        this->z = other.z;
-        return *this;
-    }
+    constexpr vec3f& operator =(const vec3f &other) = default;
 
     constexpr vec3f& operator +=(const vec3f &other)
     {
@@ -31,14 +31,7 @@ struct vec4f {
         return vec4f(-x, -y, -z, -w);
     }
 
-    constexpr vec4f& operator =(const vec4f &other)
-    {
-        this->x = other.x;
-        this->y = other.y;
-        this->z = other.z;
-        this->w = other.w;
-        return *this;
-    }
+    constexpr vec4f& operator =(const vec4f &other) = default;
 
     constexpr vec4f& operator +=(const vec4f &other)
     {
@@ -0,0 +1,90 @@
+#ifndef HK_ALLOCATOR_H
+#define HK_ALLOCATOR_H
+
+#include "utility/hktypes.h"
+#include "utility/hkassert.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+namespace hk::mem {
+
+constexpr u64 default_alignment = alignof(std::max_align_t);
+
+constexpr u64 align_up(u64 value, u64 alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+constexpr b8 is_pow2(u64 value)
+{
+    return value && !(value & (value - 1));
+}
+
+/* Interface containers allocate through. Allocators are not thread safe
+ * and are not owned by containers, they must outlive everything they hand
+ * memory to */
+class Allocator {
+public:
+    virtual ~Allocator() = default;
+
+    // nullptr when allocator is out of memory
+    virtual void* allocate(u64 size, u64 alignment = default_alignment) = 0;
+    virtual void deallocate(void *ptr, u64 size) = 0;
+
+    // Resizes allocation in place, false when it can't
+    virtual b8 grow(void *ptr, u64 size, u64 new_size)
+    {
+        (void)ptr; (void)size; (void)new_size;
+        return false;
+    }
+};
+
+// Plain malloc/free, alignment is limited to max_align_t
+class HeapAllocator final : public Allocator {
+public:
+    void* allocate(u64 size, u64 alignment = default_alignment) override
+    {
+        DEV_ASSERT(alignment <= default_alignment, "hkmem: Heap can't overalign");
+        (void)alignment;
+
+        return std::malloc(size);
+    }
+
+    void deallocate(void *ptr, u64 size) override
+    {
+        (void)size;
+        std::free(ptr);
+    }
+};
+
+inline HeapAllocator& heap()
+{
+    static HeapAllocator allocator;
+    return allocator;
+}
+
+// Allocates and constructs object, nullptr when allocator is full
+template<typename T, typename... Args>
+inline T* create(Allocator &allocator, Args&& ...args)
+{
+    void *ptr = allocator.allocate(sizeof(T), alignof(T));
+    if (!ptr) { return nullptr; }
+
+    return new (ptr) T(std::forward<Args>(args)...);
+}
+
+template<typename T>
+inline void destroy(Allocator &allocator, T *ptr)
+{
+    if (!ptr) { return; }
+
+    ptr->~T();
+    allocator.deallocate(ptr, sizeof(T));
+}
+
+}
+
+#endif // HK_ALLOCATOR_H
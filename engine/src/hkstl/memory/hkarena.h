@@ -0,0 +1,159 @@
+#ifndef HK_ARENA_H
+#define HK_ARENA_H
+
+#include "memory/hkallocator.h"
+
+namespace hk::mem {
+
+/* Growing bump allocator made of chained blocks.
+ * Blocks are kept after rewind and reused, memory goes back to backing
+ * allocator only on deinit. Markers make it usable as a scratch stack */
+class Arena final : public Allocator {
+private:
+    struct Block {
+        Block *next;
+        u64 size; // Usable bytes after header
+        u64 top;
+
+        u8* data() { return reinterpret_cast<u8*>(this + 1); }
+    };
+
+public:
+    struct Marker {
+        Block *block = nullptr;
+        u64 top = 0;
+    };
+
+    // Releases everything allocated inside of it on destruction
+    class Scope {
+    public:
+        explicit Scope(Arena &arena) : arena_(arena), marker_(arena.mark()) {}
+        ~Scope() { arena_.rewind(marker_); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Arena &arena_;
+        Marker marker_;
+    };
+
+public:
+    explicit Arena(u64 block_size = 64 * 1024, Allocator &backing = heap())
+        : backing_(&backing), block_size_(block_size) {}
+    ~Arena() { deinit(); }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void deinit()
+    {
+        for (Block *block = first_; block;) {
+            Block *next = block->next;
+            backing_->deallocate(block, sizeof(Block) + block->size);
+            block = next;
+        }
+
+        first_ = nullptr;
+        current_ = nullptr;
+        reserved_ = 0;
+    }
+
+    void* allocate(u64 size, u64 alignment = default_alignment) override
+    {
+        // Try current block and ones left after rewind
+        for (Block *block = current_; block; block = block->next) {
+            u64 start = align_up(reinterpret_cast<u64>(block->data()) + block->top, alignment) -
+                        reinterpret_cast<u64>(block->data());
+
+            if (start + size <= block->size) {
+                block->top = start + size;
+                current_ = block;
+                return block->data() + start;
+            }
+
+            // Skipped blocks stay empty until next rewind
+            if (block->next) { block->next->top = 0; }
+        }
+
+        u64 block_size = size + alignment > block_size_ ? size + alignment : block_size_;
+
+        void *memory = backing_->allocate(sizeof(Block) + block_size);
+        if (!memory) { return nullptr; }
+
+        Block *block = new (memory) Block{ nullptr, block_size, 0 };
+        reserved_ += block_size;
+
+        // Appended at the tail so block order matches allocation order
+        Block **tail = &first_;
+        while (*tail) { tail = &(*tail)->next; }
+        *tail = block;
+
+        current_ = block;
+
+        u64 start = align_up(reinterpret_cast<u64>(block->data()), alignment) -
+                    reinterpret_cast<u64>(block->data());
+        block->top = start + size;
+
+        return block->data() + start;
+    }
+
+    void deallocate(void *ptr, u64 size) override
+    {
+        if (!ptr || !current_) { return; }
+
+        if (static_cast<u8*>(ptr) + size == current_->data() + current_->top) {
+            current_->top -= size;
+        }
+    }
+
+    b8 grow(void *ptr, u64 size, u64 new_size) override
+    {
+        if (!ptr || !current_) { return false; }
+        if (static_cast<u8*>(ptr) + size != current_->data() + current_->top) { return false; }
+
+        u64 start = static_cast<u64>(static_cast<u8*>(ptr) - current_->data());
+        if (start + new_size > current_->size) { return false; }
+
+        current_->top = start + new_size;
+        return true;
+    }
+
+    Marker mark() const
+    {
+        return { current_, current_ ? current_->top : 0 };
+    }
+
+    void rewind(Marker marker)
+    {
+        if (!marker.block) {
+            reset();
+            return;
+        }
+
+        current_ = marker.block;
+        current_->top = marker.top;
+        if (current_->next) { current_->next->top = 0; }
+    }
+
+    void reset()
+    {
+        current_ = first_;
+        if (current_) { current_->top = 0; }
+    }
+
+    // Bytes taken from backing allocator
+    u64 reserved() const { return reserved_; }
+
+private:
+    Allocator *backing_;
+    u64 block_size_;
+
+    Block *first_ = nullptr;
+    Block *current_ = nullptr;
+    u64 reserved_ = 0;
+};
+
+}
+
+#endif // HK_ARENA_H
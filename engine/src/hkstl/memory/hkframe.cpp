@@ -0,0 +1,46 @@
+#include "hkframe.h"
+
+namespace hk::mem {
+
+static struct FrameContext {
+    Linear allocator;
+    FrameInfo info;
+} ctx;
+
+void init_frame(u64 size)
+{
+    ctx.allocator.init(size);
+    ctx.info = {};
+    ctx.info.capacity = ctx.allocator.capacity();
+}
+
+void deinit_frame()
+{
+    ctx.allocator.deinit();
+    ctx.info = {};
+}
+
+Linear& frame()
+{
+    return ctx.allocator;
+}
+
+void next_frame()
+{
+    ctx.info.used = ctx.allocator.used();
+    ctx.info.peak = ctx.allocator.peak();
+    ctx.info.overflow = ctx.allocator.overflow();
+
+    if (ctx.info.overflow) {
+        LOG_WARN("Frame allocator overflowed by", ctx.info.overflow, "bytes");
+    }
+
+    ctx.allocator.reset();
+}
+
+const FrameInfo& frame_info()
+{
+    return ctx.info;
+}
+
+}
@@ -0,0 +1,30 @@
+#ifndef HK_FRAME_H
+#define HK_FRAME_H
+
+#include "hkcommon.h"
+#include "memory/hklinear.h"
+
+/* Scratch memory that lives until the end of current frame.
+ * Main thread only, jobs must not hold on to it across frames */
+namespace hk::mem {
+
+struct FrameInfo {
+    u64 capacity = 0;
+    u64 used = 0;     // Previous frame
+    u64 peak = 0;
+    u64 overflow = 0; // Previous frame bytes that went to heap
+};
+
+HKAPI void init_frame(u64 size);
+HKAPI void deinit_frame();
+
+HKAPI Linear& frame();
+
+// Invalidates everything allocated from frame() so far
+HKAPI void next_frame();
+
+HKAPI const FrameInfo& frame_info();
+
+}
+
+#endif // HK_FRAME_H
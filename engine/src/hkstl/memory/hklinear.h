@@ -0,0 +1,138 @@
+#ifndef HK_LINEAR_H
+#define HK_LINEAR_H
+
+#include "memory/hkallocator.h"
+
+namespace hk::mem {
+
+/* Bump allocator over one fixed block.
+ * Only the last allocation can be freed or grown (stack order), everything
+ * else is released by rewind() or reset(). When block runs out requests
+ * spill to heap, so running out is slow, not fatal */
+class Linear final : public Allocator {
+public:
+    using Marker = u64;
+
+    Linear() = default;
+    ~Linear() { deinit(); }
+
+    Linear(const Linear&) = delete;
+    Linear& operator=(const Linear&) = delete;
+
+    void init(u64 size, Allocator &backing = heap())
+    {
+        deinit();
+
+        backing_ = &backing;
+        begin_ = static_cast<u8*>(backing.allocate(size));
+        size_ = begin_ ? size : 0;
+        top_ = 0;
+    }
+
+    // Uses external buffer, it is not freed by allocator
+    void init(void *buffer, u64 size)
+    {
+        deinit();
+
+        begin_ = static_cast<u8*>(buffer);
+        size_ = size;
+        top_ = 0;
+    }
+
+    void deinit()
+    {
+        if (backing_ && begin_) { backing_->deallocate(begin_, size_); }
+
+        backing_ = nullptr;
+        begin_ = nullptr;
+        size_ = 0;
+        top_ = 0;
+    }
+
+    void* allocate(u64 size, u64 alignment = default_alignment) override
+    {
+        u64 start = align_up(reinterpret_cast<u64>(begin_) + top_, alignment) -
+                    reinterpret_cast<u64>(begin_);
+
+        if (!begin_ || start + size > size_) {
+            overflow_ += size;
+            return heap().allocate(size, alignment);
+        }
+
+        top_ = start + size;
+        peak_ = top_ > peak_ ? top_ : peak_;
+
+        return begin_ + start;
+    }
+
+    void deallocate(void *ptr, u64 size) override
+    {
+        if (!ptr) { return; }
+
+        if (!owns(ptr)) {
+            heap().deallocate(ptr, size);
+            return;
+        }
+
+        // Last allocation goes back to the stack
+        if (static_cast<u8*>(ptr) + size == begin_ + top_) {
+            top_ -= size;
+        }
+    }
+
+    b8 grow(void *ptr, u64 size, u64 new_size) override
+    {
+        if (!owns(ptr) || static_cast<u8*>(ptr) + size != begin_ + top_) {
+            return false;
+        }
+
+        u64 start = static_cast<u64>(static_cast<u8*>(ptr) - begin_);
+        if (start + new_size > size_) { return false; }
+
+        top_ = start + new_size;
+        peak_ = top_ > peak_ ? top_ : peak_;
+
+        return true;
+    }
+
+    Marker mark() const { return top_; }
+
+    // Frees everything allocated after marker
+    void rewind(Marker marker)
+    {
+        DEV_ASSERT(marker <= top_, "hkmem: Invalid marker");
+        top_ = marker;
+    }
+
+    void reset()
+    {
+        top_ = 0;
+        overflow_ = 0;
+    }
+
+    b8 owns(const void *ptr) const
+    {
+        return ptr >= begin_ && ptr < begin_ + size_;
+    }
+
+    u64 capacity() const { return size_; }
+    u64 used() const { return top_; }
+    u64 peak() const { return peak_; }
+
+    // Bytes that didn't fit since last reset
+    u64 overflow() const { return overflow_; }
+
+private:
+    Allocator *backing_ = nullptr;
+
+    u8 *begin_ = nullptr;
+    u64 size_ = 0;
+    u64 top_ = 0;
+
+    u64 peak_ = 0;
+    u64 overflow_ = 0;
+};
+
+}
+
+#endif // HK_LINEAR_H
@@ -0,0 +1,137 @@
+#ifndef HK_POOL_H
+#define HK_POOL_H
+
+#include "memory/hkallocator.h"
+
+namespace hk::mem {
+
+/* Fixed size blocks with intrusive free list.
+ * Grows by pages of blocks_per_page, pages are never returned before
+ * deinit, so pointers stay valid for the whole lifetime of pool */
+class Pool final : public Allocator {
+private:
+    struct Node { Node *next; };
+    struct Page { Page *next; };
+
+public:
+    Pool() = default;
+    Pool(u64 block_size, u64 alignment, u32 blocks_per_page = 64, Allocator &backing = heap())
+    {
+        init(block_size, alignment, blocks_per_page, backing);
+    }
+    ~Pool() { deinit(); }
+
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
+    void init(u64 block_size, u64 alignment, u32 blocks_per_page = 64, Allocator &backing = heap())
+    {
+        DEV_ASSERT(is_pow2(alignment), "hkmem: Alignment must be power of two");
+        DEV_ASSERT(blocks_per_page, "hkmem: Empty pool pages");
+
+        deinit();
+
+        alignment_ = alignment > alignof(Node) ? alignment : alignof(Node);
+        block_size_ = align_up(block_size > sizeof(Node) ? block_size : sizeof(Node), alignment_);
+        blocks_per_page_ = blocks_per_page;
+        backing_ = &backing;
+    }
+
+    // Live blocks are released too, without destructors
+    void deinit()
+    {
+        for (Page *page = pages_; page;) {
+            Page *next = page->next;
+            backing_->deallocate(page, page_size());
+            page = next;
+        }
+
+        pages_ = nullptr;
+        free_ = nullptr;
+        used_ = 0;
+        reserved_ = 0;
+    }
+
+    template<typename T>
+    void init(u32 blocks_per_page = 64, Allocator &backing = heap())
+    {
+        init(sizeof(T), alignof(T), blocks_per_page, backing);
+    }
+
+    void* allocate(u64 size, u64 alignment = default_alignment) override
+    {
+        DEV_ASSERT(size <= block_size_, "hkmem: Allocation doesn't fit pool block");
+        (void)size; (void)alignment;
+
+        if (!free_ && !addPage()) { return nullptr; }
+
+        Node *node = free_;
+        free_ = node->next;
+        ++used_;
+
+        return node;
+    }
+
+    void deallocate(void *ptr, u64 size) override
+    {
+        (void)size;
+        if (!ptr) { return; }
+
+        DEV_ASSERT(used_, "hkmem: Pool double free");
+
+        Node *node = static_cast<Node*>(ptr);
+        node->next = free_;
+        free_ = node;
+        --used_;
+    }
+
+    u64 block_size() const { return block_size_; }
+    u32 used() const { return used_; }
+    u32 reserved() const { return reserved_; }
+
+private:
+    u64 header_size() const { return align_up(sizeof(Page), alignment_); }
+    u64 page_size() const { return header_size() + block_size_ * blocks_per_page_; }
+
+    b8 addPage()
+    {
+        DEV_ASSERT(backing_, "hkmem: Pool is not initialized");
+
+        // Page header is padded so blocks keep their alignment
+        void *memory = backing_->allocate(page_size(), alignment_);
+        if (!memory) { return false; }
+
+        Page *page = static_cast<Page*>(memory);
+        page->next = pages_;
+        pages_ = page;
+
+        u8 *blocks = static_cast<u8*>(memory) + header_size();
+
+        // Thread blocks in address order
+        for (u32 i = blocks_per_page_; i > 0; --i) {
+            Node *node = reinterpret_cast<Node*>(blocks + (i - 1) * block_size_);
+            node->next = free_;
+            free_ = node;
+        }
+
+        reserved_ += blocks_per_page_;
+        return true;
+    }
+
+private:
+    Allocator *backing_ = nullptr;
+
+    u64 block_size_ = 0;
+    u64 alignment_ = alignof(Node);
+    u32 blocks_per_page_ = 0;
+
+    Page *pages_ = nullptr;
+    Node *free_ = nullptr;
+
+    u32 used_ = 0;
+    u32 reserved_ = 0;
+};
+
+}
+
+#endif // HK_POOL_H
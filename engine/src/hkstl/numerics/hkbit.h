@@ -45,7 +45,11 @@ constexpr u32 popcount(T v)
 
     // TEST: do i really need to check specs for this?
     if (hk::spec::cpu().feature.popcnt) {
+#ifdef _MSC_VER
         return static_cast<u32>(__popcnt64(v));
+#else
+        return static_cast<u32>(__builtin_popcountll(v));
+#endif
     }
 
     // FIX: doesn't work for T = u64
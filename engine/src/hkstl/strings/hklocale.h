@@ -8,7 +8,7 @@
 
 namespace hk {
 
-// FIX: this is Windows only solution
+#ifdef HKWINDOWS
 
 inline std::string wstring_convert(const std::wstring &in)
 {
@@ -55,6 +55,66 @@ inline std::wstring string_convert(const std::string &in)
     return out;
 }
 
+#else
+
+// wchar_t is UTF-32 on POSIX systems
+inline std::string wstring_convert(const std::wstring &in)
+{
+    std::string out;
+    out.reserve(in.size());
+
+    for (wchar_t wc : in) {
+        u32 c = static_cast<u32>(wc);
+
+        if (c < 0x80) {
+            out += static_cast<char>(c);
+        } else if (c < 0x800) {
+            out += static_cast<char>(0xC0 | (c >> 6));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            out += static_cast<char>(0xE0 | (c >> 12));
+            out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (c >> 18));
+            out += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+
+    return out;
+}
+
+inline std::wstring string_convert(const std::string &in)
+{
+    std::wstring out;
+    out.reserve(in.size());
+
+    for (u32 i = 0; i < in.size();) {
+        u8 c = static_cast<u8>(in[i]);
+
+        u32 cp = 0;
+        u32 extra = 0;
+
+        if      (c < 0x80)           { cp = c;        extra = 0; }
+        else if ((c & 0xE0) == 0xC0) { cp = c & 0x1F; extra = 1; }
+        else if ((c & 0xF0) == 0xE0) { cp = c & 0x0F; extra = 2; }
+        else                         { cp = c & 0x07; extra = 3; }
+
+        ++i;
+        for (u32 j = 0; j < extra && i < in.size(); ++j, ++i) {
+            cp = (cp << 6) | (static_cast<u8>(in[i]) & 0x3F);
+        }
+
+        out += static_cast<wchar_t>(cp);
+    }
+
+    return out;
+}
+
+#endif // HKWINDOWS
+
 inline std::string normalise(const std::string &path)
 {
     // FIX: kinda works, but I don't like the way it's written
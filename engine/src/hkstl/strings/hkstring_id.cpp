@@ -0,0 +1,60 @@
+#include "hkstring_id.h"
+
+#include "Logger.h"
+#include "containers/hkflat_map.h"
+#include "memory/hkarena.h"
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+namespace hk {
+
+#ifdef HKDEBUG
+// Interned text never moves, names are few and live as long as the app
+static struct StringTable {
+    std::mutex mutex;
+    hk::flat_map<string_id, const char*> strings;
+    hk::mem::Arena text;
+} table;
+#endif
+
+string_id string_id::intern(std::string_view str)
+{
+    string_id id(str);
+
+#ifdef HKDEBUG
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    if (const char **interned = table.strings.find(id)) {
+        DEV_ASSERT(str == *interned, "string_id: Collision of", *interned, "and", std::string(str));
+        return id;
+    }
+
+    char *text = static_cast<char*>(table.text.allocate(str.size() + 1, 1));
+    std::memcpy(text, str.data(), str.size());
+    text[str.size()] = '\0';
+
+    table.strings.insert(id, text);
+#endif
+
+    return id;
+}
+
+std::string to_string(string_id id)
+{
+#ifdef HKDEBUG
+    {
+        std::lock_guard<std::mutex> lock(table.mutex);
+        if (const char **interned = table.strings.find(id)) { return *interned; }
+    }
+#endif
+
+    char buffer[19];
+    std::snprintf(buffer, sizeof(buffer), "0x%016llx",
+                  static_cast<unsigned long long>(id.value()));
+
+    return buffer;
+}
+
+}
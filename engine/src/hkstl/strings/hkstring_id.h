@@ -0,0 +1,67 @@
+#ifndef HK_STRING_ID_H
+#define HK_STRING_ID_H
+
+#include "hkcommon.h"
+#include "utility/hkhash.h"
+
+#include <string_view>
+
+namespace hk {
+
+/* 64-bit FNV-1a hash of a string, compared and hashed as integer.
+ * Literals hash at compile time. Text is kept only for ids made by intern()
+ * in debug builds, release builds can't turn id back into a string */
+class string_id {
+public:
+    constexpr string_id() = default;
+    constexpr string_id(const char *str) : hash_(hash(str)) {}
+    constexpr string_id(std::string_view str) : hash_(hash(str)) {}
+    string_id(const std::string &str) : hash_(hash(str)) {}
+
+    // Same as constructor, but remembers text for to_string() in debug
+    HKAPI static string_id intern(std::string_view str);
+
+    constexpr u64 value() const { return hash_; }
+    constexpr b8 valid() const { return hash_ != 0; }
+
+    constexpr b8 operator==(string_id other) const { return hash_ == other.hash_; }
+    constexpr b8 operator!=(string_id other) const { return hash_ != other.hash_; }
+    constexpr b8 operator<(string_id other) const { return hash_ < other.hash_; }
+
+    // Same result as hash_bytes(), but usable in constant expressions
+    static constexpr u64 hash(std::string_view str)
+    {
+        u64 hash = hash_seed;
+        for (char c : str) {
+            hash ^= static_cast<u8>(c);
+            hash *= hash_prime;
+        }
+
+        return hash;
+    }
+
+private:
+    u64 hash_ = 0;
+};
+
+// Interned text in debug builds, hash in hex otherwise
+HKAPI std::string to_string(string_id id);
+
+namespace literals {
+
+constexpr string_id operator""_id(const char *str, std::size_t size)
+{
+    return string_id(std::string_view(str, size));
+}
+
+}
+
+// FNV low bits only depend on low bits of input, mixed before table use
+template<>
+struct hasher<string_id> {
+    constexpr u64 operator()(string_id id) const { return hash_mix(id.value()); }
+};
+
+}
+
+#endif // HK_STRING_ID_H
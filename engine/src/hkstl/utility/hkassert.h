@@ -6,7 +6,12 @@
 
 #define STATIC_ASSERT static_assert
 
-#define HKBREAK __debugbreak()
+#ifdef _MSC_VER
+    #define HKBREAK __debugbreak()
+#else
+    #include <csignal>
+    #define HKBREAK raise(SIGTRAP)
+#endif
 
 #if _MSVC_TRADITIONAL
     #define LOG_FATAL_HELPER(message, ...) \
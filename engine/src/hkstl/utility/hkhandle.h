@@ -0,0 +1,28 @@
+#ifndef HK_HANDLE_H
+#define HK_HANDLE_H
+
+#include "hktypes.h"
+
+namespace hk {
+
+/* Index with generation, Tag keeps handles of different systems apart.
+ * Generation starts from 1, so zero value is never a live handle */
+#pragma warning(disable : 4201)
+template<typename Tag>
+struct Handle {
+    static constexpr u32 index_bits = 20;
+    static constexpr u32 gen_bits = 12;
+
+    union {
+        struct {
+            u32 index : 20; // 1'048'575 objects should be enough for everything
+            u32 gen   : 12;
+        };
+        u32 value = 0xdeadcell;
+    };
+};
+#pragma warning(default : 4201)
+
+}
+
+#endif // HK_HANDLE_H
@@ -0,0 +1,109 @@
+#ifndef HK_HASH_H
+#define HK_HASH_H
+
+#include "hktypes.h"
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace hk {
+
+// 64-bit FNV-1a, fine for table keys, not for anything adversarial
+constexpr u64 hash_seed = 0xcbf29ce484222325ull;
+constexpr u64 hash_prime = 0x100000001b3ull;
+
+// Chain calls by passing previous result as seed
+constexpr u64 hash_bytes(const void *data, u64 size, u64 seed = hash_seed)
+{
+    const u8 *bytes = static_cast<const u8*>(data);
+
+    u64 hash = seed;
+    for (u64 i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= hash_prime;
+    }
+
+    return hash;
+}
+
+// Only for types without padding or pointers
+template<typename T>
+constexpr u64 hash_value(const T &value, u64 seed = hash_seed)
+{
+    return hash_bytes(&value, sizeof(T), seed);
+}
+
+// Spreads bits of integer keys, power of two tables only look at low bits
+constexpr u64 hash_mix(u64 value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    value *= 0xc4ceb34fe1bc7b2dull;
+    value ^= value >> 33;
+
+    return value;
+}
+
+// Word at a time, for table lookups where FNV byte loop is too slow.
+// Not stable across platforms with different endianness, don't store it
+inline u64 hash_string(std::string_view value)
+{
+    const char *data = value.data();
+    u64 size = value.size();
+
+    u64 hash = hash_seed ^ (size * hash_prime);
+
+    for (; size >= 8; data += 8, size -= 8) {
+        u64 word;
+        std::memcpy(&word, data, 8);
+
+        hash = (hash ^ word) * 0x9e3779b97f4a7c15ull;
+        hash ^= hash >> 32;
+    }
+
+    u64 tail = 0;
+    if (size) { std::memcpy(&tail, data, size); }
+    hash = (hash ^ tail) * 0x9e3779b97f4a7c15ull;
+
+    return hash_mix(hash);
+}
+
+/* Default hash for containers, defined for integers, enums, pointers
+ * and strings. Strings hash as string_view, so std::string, string_view
+ * and literals of same text share hash and can look each other up */
+template<typename T, typename = void>
+struct hasher;
+
+template<typename T>
+struct hasher<T, std::enable_if_t<std::is_integral_v<T> || std::is_enum_v<T>>> {
+    constexpr u64 operator()(T value) const
+    {
+        return hash_mix(static_cast<u64>(value));
+    }
+};
+
+template<typename T>
+struct hasher<T*> {
+    u64 operator()(const T *value) const
+    {
+        return hash_mix(reinterpret_cast<u64>(value));
+    }
+};
+
+template<>
+struct hasher<std::string_view> {
+    u64 operator()(std::string_view value) const
+    {
+        return hash_string(value);
+    }
+};
+
+template<>
+struct hasher<std::string> : hasher<std::string_view> {};
+
+}
+
+#endif // HK_HASH_H
@@ -0,0 +1,341 @@
+#ifdef __linux__
+#include "platform/filesystem.h"
+
+#include "hkstl/strings/hklocale.h"
+#include "hkstl/utility/hkassert.h"
+
+#include <dirent.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <fstream>
+#include <string>
+
+namespace hk::filesystem {
+
+// Engine and user code still pass Windows style paths around
+static std::string to_posix(const std::string &path)
+{
+    std::string out = path;
+    for (auto &c : out) {
+        if (c == '\\') { c = '/'; }
+    }
+    return out;
+}
+
+b8 read_file(const std::string &path, hk::vector<u8> &out)
+{
+    std::ifstream file(to_posix(path),
+                       std::ios::binary | std::ios::in | std::ios::ate);
+    if (!file.is_open()) { return false; }
+
+    const u32 size = static_cast<u32>(file.tellg());
+    file.seekg(0, file.beg);
+    out.resize(size);
+    file.read((char*)(out.data()), size);
+    file.close();
+
+    return true;
+}
+
+b8 write_file(const std::string &path, const void *data, u64 size)
+{
+    std::ofstream file(to_posix(path),
+                       std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!file.is_open()) { return false; }
+
+    file.write(reinterpret_cast<const char*>(data), size);
+
+    return file.good();
+}
+
+b8 map_file(const std::string &path, MappedFile &out)
+{
+    out = {};
+
+    i32 fd = open(to_posix(path).c_str(), O_RDONLY);
+    if (fd < 0) { return false; }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !st.st_size) {
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // Mapping keeps its own reference to file
+    close(fd);
+
+    if (data == MAP_FAILED) { return false; }
+
+    out.data = static_cast<const u8*>(data);
+    out.size = static_cast<u64>(st.st_size);
+
+    return true;
+}
+
+void unmap_file(MappedFile &file)
+{
+    if (file.data) {
+        munmap(const_cast<u8*>(file.data), file.size);
+    }
+
+    file = {};
+}
+
+u64 last_write_time(const std::string &path)
+{
+    struct stat st;
+    if (stat(to_posix(path).c_str(), &st) != 0) { return 0; }
+
+    return static_cast<u64>(st.st_mtim.tv_sec) * 1000000000ull +
+           static_cast<u64>(st.st_mtim.tv_nsec);
+}
+
+b8 find_file(const std::string &root, const std::string &target,
+            std::string *out)
+{
+    std::string search_path = to_posix(root);
+
+    // Remove trailing '/'
+    while (search_path.size() > 1 && search_path.back() == '/') {
+        search_path.pop_back();
+    }
+
+    // FIX: ? a little quick fix, same as on Windows
+    if (search_path.find(target) != std::string::npos) {
+        if (out) { *out = root; }
+        return true;
+    }
+
+    DIR *dir = opendir(search_path.c_str());
+    if (!dir) { return false; }
+
+    b8 found = false;
+
+    dirent *entry;
+    while (!found && (entry = readdir(dir))) {
+        if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
+            continue;
+        }
+
+        std::string sub_path = search_path + '/' + entry->d_name;
+
+        if (!strcmp(entry->d_name, target.c_str())) {
+            if (out) { *out = sub_path; }
+            found = true;
+            break;
+        }
+
+        struct stat st;
+        if (stat(sub_path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+            found = find_file(sub_path, target, out);
+        }
+    }
+
+    closedir(dir);
+    return found;
+}
+
+b8 exists(const std::string &path)
+{
+    struct stat st;
+
+    if (stat(to_posix(path).c_str(), &st) != 0) {
+        if (errno == EACCES) {
+            LOG_WARN("Path exists but inaccessible");
+            return true;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+b8 create_directory(const std::string &path)
+{
+    if (mkdir(to_posix(path).c_str(), 0755) == 0) { return true; }
+
+    return errno == EEXIST;
+}
+
+hk::vector<std::string> split(const std::string &path)
+{
+    hk::vector<std::string> subpaths;
+    std::string subpath;
+
+    for (auto &c : path) {
+        if (c == '\\' || c == '/') {
+            if (!subpath.empty()) {
+                subpaths.push_back(subpath);
+                subpath.clear();
+            }
+        } else {
+            subpath += c;
+        }
+    }
+
+    if (!subpath.empty()) {
+        subpaths.push_back(subpath);
+    }
+
+    return subpaths;
+}
+
+std::string canonical(const std::string &path)
+{
+    std::string posix = to_posix(path);
+
+    char buffer[PATH_MAX];
+    if (realpath(posix.c_str(), buffer)) {
+        return std::string(buffer);
+    }
+
+    // Path doesn't exist, fall back to weakly canonical form
+    if (!posix.empty() && posix.front() != '/') {
+        char cwd[PATH_MAX];
+        ALWAYS_ASSERT(getcwd(cwd, PATH_MAX), "Failed to get current directory");
+        posix = std::string(cwd) + '/' + posix;
+    }
+
+    std::string out = hk::normalise(posix);
+    if (out.empty() || out.front() != '/') { out = '/' + out; }
+    while (out.size() > 1 && out[1] == '/') { out.erase(0, 1); }
+
+    return out;
+}
+
+std::string relative(const std::string &path, const std::string &base)
+{
+    hk::vector<std::string> from = split(canonical(base));
+    hk::vector<std::string> to = split(canonical(path));
+
+    u32 common = 0;
+    while (common < from.size() && common < to.size() &&
+           from[common] == to[common])
+    {
+        ++common;
+    }
+
+    std::string out;
+    for (u32 i = common; i < from.size(); ++i) {
+        out += "../";
+    }
+    for (u32 i = common; i < to.size(); ++i) {
+        out += to[i];
+        if (i + 1 < to.size()) { out += '/'; }
+    }
+
+    if (out.empty()) { out = "."; }
+
+    return out;
+}
+
+struct DirectoryIterator::Impl {
+    DIR *dir;
+    dirent *entry;
+
+    b8 valid;
+    std::string currentPath;
+
+    Impl(const std::string &path) :
+        dir(nullptr), entry(nullptr), valid(false)
+    {
+        currentPath = to_posix(path);
+        dir = opendir(currentPath.c_str());
+
+        valid = (dir != nullptr);
+
+        if (valid) { next(); }
+    }
+
+    ~Impl() {
+        if (dir) {
+            closedir(dir);
+        }
+    }
+
+    b8 next() {
+        if (!valid || !dir) {
+            return false;
+        }
+
+        do {
+            errno = 0;
+            entry = readdir(dir);
+        } while (entry && (!strcmp(entry->d_name, ".") ||
+                           !strcmp(entry->d_name, "..")));
+
+        if (!entry) {
+            if (errno) {
+                LOG_ERROR("Error enumerating directory:", strerror(errno));
+            }
+            valid = false;
+        }
+
+        return valid;
+    }
+
+    b8 isDirectory() const {
+        if (entry->d_type != DT_UNKNOWN) {
+            return entry->d_type == DT_DIR;
+        }
+
+        // Some filesystems don't fill d_type
+        struct stat st;
+        return stat(getPath().c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+    }
+
+    std::string getPath() const {
+        return currentPath + "/" + entry->d_name;
+    }
+
+    std::string getName() const {
+        return entry->d_name;
+    }
+};
+
+DirectoryIterator::DirectoryIterator(const std::string& path)
+{
+    impl = new Impl(path);
+
+    // Current entry is kept in iterator, so operator-> has nothing to allocate
+    if (impl->valid) { cur = Entry(impl->getPath(), impl->getName(), impl->isDirectory()); }
+}
+
+DirectoryIterator::~DirectoryIterator()
+{
+    delete impl;
+}
+
+b8 DirectoryIterator::operator !=(const DirectoryIterator&) const
+{
+    return impl->valid;
+}
+
+DirectoryIterator& DirectoryIterator::operator ++()
+{
+    if (impl->next()) { cur = Entry(impl->getPath(), impl->getName(), impl->isDirectory()); }
+    return *this;
+}
+
+const DirectoryIterator::Entry& DirectoryIterator::operator *()
+{
+    return cur;
+}
+
+const DirectoryIterator::Entry* DirectoryIterator::operator ->() const
+{
+    return &cur;
+}
+
+}
+
+#endif // __linux__
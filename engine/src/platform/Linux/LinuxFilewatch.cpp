@@ -0,0 +1,176 @@
+#ifdef __linux__
+#include "hkstl/Filewatch.h"
+
+#include "platform/platform.h"
+#include "platform/filesystem.h"
+#include "containers/hkvector.h"
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+
+#include <thread>
+#include <unordered_map>
+
+namespace hk::filewatch {
+
+static constexpr u32 buffer_size = 4096;
+static constexpr u32 notify_filter =
+    IN_CREATE      |
+    IN_DELETE      |
+    IN_MODIFY      |
+    IN_CLOSE_WRITE |
+    IN_MOVED_FROM  |
+    IN_MOVED_TO;
+
+class target {
+public:
+    void init(const std::string &path, onStateChange callback)
+    {
+        path_ = path;
+        callback_ = callback;
+
+        handle_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        ALWAYS_ASSERT(handle_ >= 0, "Failed to create inotify instance");
+
+        destroy_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        ALWAYS_ASSERT(destroy_ >= 0, "Failed to create destroy event");
+
+        // inotify is not recursive, unlike ReadDirectoryChangesW
+        addDirectory(path_, "");
+
+        watching_ = true;
+        watcher_ = std::thread([this](){ watch(); });
+    }
+
+    void deinit()
+    {
+        watching_ = false;
+
+        u64 signal = 1;
+        (void)!write(destroy_, &signal, sizeof(signal));
+        watcher_.join();
+
+        close(handle_);
+        close(destroy_);
+    }
+
+    void watch()
+    {
+        alignas(inotify_event) char buffer[buffer_size];
+
+        pollfd fds[] = {
+            { handle_,  POLLIN, 0 },
+            { destroy_, POLLIN, 0 },
+        };
+
+        while (watching_) {
+            if (poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) { continue; }
+                LOG_WARN("Failed to poll directory changes:", errno);
+                break;
+            }
+
+            if (fds[1].revents & POLLIN) { break; }
+            if (!(fds[0].revents & POLLIN)) { continue; }
+
+            i64 length = read(handle_, buffer, sizeof(buffer));
+            if (length <= 0) { continue; }
+
+            for (char *ptr = buffer; ptr < buffer + length;) {
+                inotify_event *event = reinterpret_cast<inotify_event*>(ptr);
+                ptr += sizeof(inotify_event) + event->len;
+
+                if (!event->len) { continue; }
+
+                std::string name = dirs_[event->wd] + event->name;
+
+                if ((event->mask & IN_ISDIR) && (event->mask & IN_CREATE)) {
+                    addDirectory(path_ + "/" + name, name);
+                }
+
+                State state = State::NONE;
+                if      (event->mask & IN_CREATE)      { state = State::ADDED; }
+                else if (event->mask & IN_DELETE)      { state = State::REMOVED; }
+                else if (event->mask & IN_CLOSE_WRITE) { state = State::MODIFIED; }
+                else if (event->mask & IN_MOVED_FROM)  { state = State::RENAMED_OLD; }
+                else if (event->mask & IN_MOVED_TO)    { state = State::RENAMED_NEW; }
+
+                // IN_MODIFY fires on every write, wait for IN_CLOSE_WRITE
+                if (state == State::NONE) { continue; }
+
+                callback_(name, state);
+            }
+        }
+    }
+
+private:
+    void addDirectory(const std::string &dir, const std::string &relative)
+    {
+        i32 wd = inotify_add_watch(handle_, dir.c_str(), notify_filter);
+        if (wd < 0) {
+            LOG_WARN("Failed to watch directory:", dir);
+            return;
+        }
+
+        dirs_[wd] = relative.empty() ? "" : relative + "/";
+
+        for (auto &entry : hk::filesystem::directory_iterator(dir)) {
+            if (!entry.isDirectory) { continue; }
+            addDirectory(entry.path, dirs_[wd] + entry.name);
+        }
+    }
+
+private:
+    std::string path_;
+    onStateChange callback_;
+    i32 handle_ = -1;
+    std::thread watcher_;
+
+    // Watch descriptor -> path relative to path_
+    std::unordered_map<i32, std::string> dirs_;
+
+    i32 destroy_ = -1;
+    b8 watching_;
+};
+
+static std::unordered_map<std::string, target*> targets;
+
+void init()
+{
+    targets.clear();
+}
+
+void deinit()
+{
+    for (auto &target : targets) {
+        target.second->deinit();
+        delete target.second;
+    }
+
+    targets.clear();
+}
+
+void watch(const std::string &path, onStateChange callback)
+{
+    if (!targets.size()) { init(); }
+
+    target *t = new target();
+    t->init(path, callback);
+    targets[path] = t;
+}
+
+void unwatch(const std::string &path)
+{
+    auto it = targets.find(path);
+    if (it == targets.end()) { return; }
+
+    it->second->deinit();
+    delete it->second;
+    targets.erase(it);
+}
+
+}
+
+#endif // __linux__
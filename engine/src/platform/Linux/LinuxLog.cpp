@@ -0,0 +1,154 @@
+#ifdef __linux__
+#include "LinuxLog.h"
+
+#include "utils/to_string.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+// terminal log
+static b8 is_terminal_attached = false;
+static b8 is_tty = false;
+static u32 hndl_terminal = 0;
+
+static constexpr u32 MaxFuncNameLength = 45;
+
+// file log
+static std::string log_file = "";
+static u32 hndl_file = 0;
+
+void logTerminal(const hk::log::Log &log);
+void logFile(const hk::log::Log &log);
+
+void attachTerminal()
+{
+    if (is_terminal_attached) { return; }
+
+    // Build farm nodes usually redirect output, skip colors there
+    is_tty = isatty(STDOUT_FILENO);
+    is_terminal_attached = true;
+
+    hndl_terminal = hk::log::addMessageHandler(logTerminal, hk::log::Sink::BACKGROUND);
+}
+
+void detachTerminal()
+{
+    if (!is_terminal_attached) { return; }
+
+    // Handler runs on logger thread, detach it before flushing stdout
+    hk::log::flush();
+    hk::log::removeMessageHandler(hndl_terminal);
+
+    is_terminal_attached = false;
+    fflush(stdout);
+}
+
+void setLogFile(const std::string &file)
+{
+    log_file = file;
+    if (log_file.empty()) { return; }
+
+    hndl_file = hk::log::addMessageHandler(logFile, hk::log::Sink::BACKGROUND);
+}
+
+void removeLogFile()
+{
+    hk::log::flush();
+    hk::log::removeMessageHandler(hndl_file);
+}
+
+void logTerminal(const hk::log::Log &log)
+{
+    /* Colored output, same layout as Windows console
+     * time [log_lvl]: caller message [opt]: args file line
+     * gray diff cyan white white red red */
+
+    if (!is_terminal_attached) { return; }
+
+    constexpr char const *lookup_color[] =
+    {
+        "0;41m",
+        "1;31m",
+        "1;33m",
+        "1;32m",
+        "1;34m",
+        "1;30m"
+    };
+
+    auto color = [](const char *code) { return is_tty ? code : ""; };
+
+    b8 is_error = log.level  < hk::log::Level::LVL_WARN;
+    b8 is_trace = log.level == hk::log::Level::LVL_TRACE;
+
+    std::string caller = log.caller;
+    if (caller.size() > MaxFuncNameLength) {
+        caller.erase(MaxFuncNameLength - 3, std::string::npos);
+        caller.append("...");
+    }
+
+    std::string level = std::string("\033[") +
+                        lookup_color[static_cast<u32>(log.level)];
+
+    std::ostringstream oss;
+    oss << std::left;
+    oss << color("\033[1;90m") << log.time << color("\033[0;10m") << ' ';
+
+    oss << color(level.c_str())
+        << std::setw(8) << to_string(log.level)
+        << color("\033[0;10m") << ' ';
+
+    oss << color("\033[1;36m")
+        << std::setw(MaxFuncNameLength) << caller
+        << color("\033[0;10m") << ' ';
+
+    if (is_trace) {
+        oss << color("\033[1;97m") << "---" << ' ' << color("\033[0;10m");
+    }
+
+    oss << color("\033[1;97m") << log.args << color("\033[0;10m");
+
+    if (is_error) {
+        oss << ' ' << color("\033[1;31m")
+            << log.file << ' ' << log.line
+            << color("\033[0;10m");
+    }
+
+    oss << '\n';
+
+    // Errors go to stderr so CI logs can separate them
+    FILE *out = is_error ? stderr : stdout;
+    fputs(oss.str().c_str(), out);
+}
+
+void logFile(const hk::log::Log &log)
+{
+    // No coloring
+    std::ostringstream oss;
+    oss << std::left;
+    oss << log.time << ' ';
+    oss << std::setw(8) << to_string(log.level) << ' ';
+    std::string caller = log.caller;
+    if (caller.size() > MaxFuncNameLength) {
+        caller.erase(MaxFuncNameLength - 3, std::string::npos);
+        caller.append("...");
+    }
+    oss << std::setw(MaxFuncNameLength) << caller << ' ';
+    oss << std::setw(30) << log.args << ' ';
+
+    b8 is_error = log.level  < hk::log::Level::LVL_WARN;
+    b8 is_trace = log.level == hk::log::Level::LVL_TRACE;
+    oss << std::setw(12) << (is_error ? log.file : "");
+    oss << std::setw(3)  << (is_trace ? log.line : "") << ' ';
+    oss << '\n';
+
+    std::ofstream file(log_file, std::ios::app);
+    if (file.is_open()) {
+        file << oss.rdbuf();
+        file.close();
+    }
+}
+
+#endif // __linux__
@@ -0,0 +1,12 @@
+#ifndef HK_LINUXLOG_H
+#define HK_LINUXLOG_H
+
+#include "hkcommon.h"
+#include "hkstl/Logger.h"
+
+HKAPI void attachTerminal();
+HKAPI void detachTerminal();
+HKAPI void setLogFile(const std::string &file);
+HKAPI void removeLogFile();
+
+#endif // HK_LINUXLOG_H
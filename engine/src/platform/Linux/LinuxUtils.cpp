@@ -0,0 +1,39 @@
+#ifdef __linux__
+#include "platform/utils.h"
+
+#include "platform/platform.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace hk::platform {
+
+b8 copyToClipboard(const std::string &target)
+{
+    // No display server to talk to in headless mode, try external tools
+    FILE *pipe = popen("xclip -selection clipboard 2>/dev/null", "w");
+    if (!pipe) { return false; }
+
+    fwrite(target.c_str(), 1, target.size(), pipe);
+
+    return pclose(pipe) == 0;
+}
+
+void addMessageBox(const std::string &name, const std::string &message)
+{
+    fprintf(stderr, "\n[%s]\n%s\n\n", name.c_str(), message.c_str());
+    fflush(stderr);
+}
+
+void addTaskDialog(const std::string &title,
+                   const std::string &header,
+                   const std::string &message)
+{
+    fprintf(stderr, "\n[%s] %s\n%s\n\n",
+            title.c_str(), header.c_str(), message.c_str());
+    fflush(stderr);
+}
+
+}
+
+#endif // __linux__
@@ -0,0 +1,28 @@
+#ifdef __linux__
+#include "Window.h"
+
+#include "hkstl/Logger.h"
+
+void Window::init(std::string title, u32 width, u32 height)
+{
+    title_ = title;
+    width_ = width;
+    height_ = height;
+
+    is_open_ = true;
+
+    LOG_WARN("No windowing backend on Linux, window", title_,
+             "will not be shown");
+}
+
+void Window::deinit()
+{
+    is_open_ = false;
+}
+
+b8 Window::ProcessMessages()
+{
+    return is_open_;
+}
+
+#endif // __linux__
@@ -0,0 +1,47 @@
+#ifndef HK_LINUXWINDOW_H
+#define HK_LINUXWINDOW_H
+
+#include "hkcommon.h"
+#include "utility/hktypes.h"
+
+#include <string>
+
+/* INFO: There is no windowing backend on Linux yet (no X11/Wayland),
+ * so this Window only tracks the requested size and never becomes visible.
+ * Applications are expected to run in headless mode, see AppDesc::headless */
+class Window {
+public:
+    Window() = default;
+    Window(const Window&) = delete;
+
+    ~Window() { deinit(); }
+
+    void init(std::string title, u32 width, u32 height);
+    void deinit();
+
+    b8 ProcessMessages();
+
+    /* Mouse settings */
+    HKAPI void hideCursor() {}
+    HKAPI void showCursor() {}
+
+    HKAPI void lockCursor() {}
+    HKAPI void unlockCursor() {}
+
+    HKAPI void enableRawMouseInput() {}
+    HKAPI void disableRawMouseInput() {}
+
+public:
+    u32 width() const { return width_; }
+    u32 height() const { return height_; }
+    b8  isVisible() const { return false; }
+
+private:
+    u32 width_ = 400;
+    u32 height_ = 400;
+    std::string title_ = "";
+
+    b8 is_open_ = false;
+};
+
+#endif // HK_LINUXWINDOW_H
@@ -0,0 +1,278 @@
+#ifdef __linux__
+#include "utils/spec.h"
+
+#include "platform/platform.h"
+
+#include <unistd.h>
+
+#include <fstream>
+#include <set>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <cpuid.h>
+    #define HK_HAS_CPUID
+#endif
+
+namespace hk::spec {
+
+static ProcessorSpec cpu_specs;
+static SystemSpec sys_specs;
+
+HKAPI const ProcessorSpec& cpu() { return cpu_specs; }
+HKAPI const SystemSpec& system() { return sys_specs; }
+
+void update_system_specs()
+{
+    sys_specs.type = SystemType::LINUX;
+
+    // TODO: query monitors once there is a windowing backend
+    sys_specs.monitors.clear();
+}
+
+static std::string read_line(const std::string &path)
+{
+    std::ifstream file(path);
+    std::string out;
+    std::getline(file, out);
+    return out;
+}
+
+// Values in /sys are like "32K" or "8192K"
+static u32 parse_size(const std::string &value)
+{
+    if (value.empty()) { return 0; }
+
+    u32 size = std::stoul(value);
+    switch (value.back()) {
+    case 'K': { size *= 1024; } break;
+    case 'M': { size *= 1024 * 1024; } break;
+    default: break;
+    }
+
+    return size;
+}
+
+static void update_cache_info()
+{
+    const std::string root = "/sys/devices/system/cpu/cpu0/cache/index";
+
+    for (u32 i = 0; ; ++i) {
+        std::string dir = root + std::to_string(i) + "/";
+
+        std::string level = read_line(dir + "level");
+        if (level.empty()) { break; }
+
+        std::string type = read_line(dir + "type");
+
+        ProcessorSpec::Cache::CacheInfo info = {};
+        info.size          = parse_size(read_line(dir + "size"));
+        info.line_size     = std::stoul("0" + read_line(dir + "coherency_line_size"));
+        info.sets          = std::stoul("0" + read_line(dir + "number_of_sets"));
+        info.associativity = std::stoul("0" + read_line(dir + "ways_of_associativity"));
+        info.partitions    = std::stoul("0" + read_line(dir + "physical_line_partition"));
+
+        // shared_cpu_list is like "0-1" or "0,8"
+        std::string shared = read_line(dir + "shared_cpu_list");
+        info.max_threads = shared.empty() ? 1 : 0;
+        for (u64 pos = 0; pos < shared.size();) {
+            u64 end = shared.find(',', pos);
+            if (end == std::string::npos) { end = shared.size(); }
+
+            std::string range = shared.substr(pos, end - pos);
+            u64 dash = range.find('-');
+            if (dash == std::string::npos) {
+                info.max_threads += 1;
+            } else {
+                info.max_threads += std::stoul(range.substr(dash + 1)) -
+                                    std::stoul(range.substr(0, dash)) + 1;
+            }
+
+            pos = end + 1;
+        }
+
+        // Number of instances of this cache in the package
+        info.count = info.max_threads ? cpu_specs.threads / info.max_threads : 0;
+
+        if (level == "1") {
+            if (type == "Data") {
+                cpu_specs.cache.L1.data = info;
+            } else {
+                cpu_specs.cache.L1.instr = info;
+            }
+        } else if (level == "2") {
+            cpu_specs.cache.L2 = info;
+        } else if (level == "3") {
+            cpu_specs.cache.L3 = info;
+        }
+    }
+}
+
+static void update_proc_info()
+{
+    std::ifstream file("/proc/cpuinfo");
+    if (!file.is_open()) {
+        LOG_WARN("Failed to open /proc/cpuinfo");
+        return;
+    }
+
+    // Pairs of (physical id, core id) define unique physical cores
+    std::set<std::pair<u32, u32>> cores;
+    std::set<u32> packages;
+
+    u32 physical_id = 0;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        u64 colon = line.find(':');
+        if (colon == std::string::npos) { continue; }
+
+        std::string key = line.substr(0, line.find_last_not_of(" \t", colon - 1) + 1);
+        std::string value = colon + 2 <= line.size() ? line.substr(colon + 2) : "";
+
+        if (key == "model name" && cpu_specs.brand.empty()) {
+            cpu_specs.brand = value;
+        } else if (key == "vendor_id" && cpu_specs.vendor.empty()) {
+            cpu_specs.vendor = value;
+        } else if (key == "physical id") {
+            physical_id = std::stoul(value);
+            packages.insert(physical_id);
+        } else if (key == "core id") {
+            cores.insert({ physical_id, static_cast<u32>(std::stoul(value)) });
+        }
+    }
+
+    cpu_specs.cores = cores.size() ? static_cast<u32>(cores.size())
+                                   : cpu_specs.threads;
+    cpu_specs.physical_packages = packages.size() ? static_cast<u32>(packages.size()) : 1;
+}
+
+#ifdef HK_HAS_CPUID
+static void update_cpuid_info()
+{
+    // https://en.wikipedia.org/wiki/CPUID
+    // Leaf layout is the same as in winspec.cpp
+
+    u32 eax, ebx, ecx, edx;
+
+    /* ====== EAX=0: Highest Function Parameter and Manufacturer ID ====== */
+
+    __cpuid(0, eax, ebx, ecx, edx);
+
+    std::string vendor;
+    vendor += std::string(reinterpret_cast<const char*>(&ebx), 4);
+    vendor += std::string(reinterpret_cast<const char*>(&edx), 4);
+    vendor += std::string(reinterpret_cast<const char*>(&ecx), 4);
+    cpu_specs.vendor = vendor;
+
+    /* ====== EAX=1: Processor Info and Feature Bits ====== */
+
+    __cpuid(1, eax, ebx, ecx, edx);
+
+    cpu_specs.version.stepping       = (eax >> 0)  & 0xf;
+    cpu_specs.version.model          = (eax >> 4)  & 0xf;
+    cpu_specs.version.family         = (eax >> 8)  & 0xf;
+    cpu_specs.version.processor_type = (eax >> 12) & 0x3;
+    u32 extended_model              = (eax >> 16) & 0xf;
+    u32 extended_family             = (eax >> 20) & 0xff;
+
+    if (cpu_specs.version.family == 6 || cpu_specs.version.family == 15) {
+        cpu_specs.version.model += (extended_model << 4);
+    }
+
+    if (cpu_specs.version.family == 15) {
+        cpu_specs.version.family += extended_family;
+    }
+
+    b8 cflush = edx >> 19 & 0x01;
+    cpu_specs.CLFLUSH_size = cflush ? ((ebx >> 8)  & 0xff) * 8 : 0;
+    cpu_specs.APIC_id      =          (ebx >> 24) & 0xff;
+
+    cpu_specs.simd.sse3          = ecx >> 0  & 0x01;
+    cpu_specs.feature.vmx        = ecx >> 5  & 0x01;
+    cpu_specs.simd.ssse3         = ecx >> 9  & 0x01;
+    cpu_specs.simd.fma3          = ecx >> 12 & 0x01;
+    cpu_specs.feature.pcid       = ecx >> 17 & 0x01;
+    cpu_specs.simd.sse4_1        = ecx >> 19 & 0x01;
+    cpu_specs.simd.sse4_2        = ecx >> 20 & 0x01;
+    cpu_specs.feature.popcnt     = ecx >> 23 & 0x01;
+    cpu_specs.feature.aes        = ecx >> 25 & 0x01;
+    cpu_specs.feature.osxsave    = ecx >> 27 & 0x01;
+    cpu_specs.simd.avx           = ecx >> 28 & 0x01;
+    cpu_specs.feature.hypervisor = ecx >> 31 & 0x01;
+
+    cpu_specs.feature.vme = edx >> 1  & 0x01;
+    cpu_specs.feature.pse = edx >> 3  & 0x01;
+    cpu_specs.feature.pae = edx >> 6  & 0x01;
+    cpu_specs.feature.mce = edx >> 7  & 0x01;
+    cpu_specs.feature.mca = edx >> 14 & 0x01;
+    cpu_specs.simd.mmx    = edx >> 23 & 0x01;
+    cpu_specs.simd.sse    = edx >> 25 & 0x01;
+    cpu_specs.simd.sse2   = edx >> 26 & 0x01;
+
+    /* ====== EAX=7, ECX=0/1: Extended Features ====== */
+
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+    cpu_specs.simd.avx2   = ebx >> 5  & 0x01;
+    cpu_specs.simd.avx512 = ebx >> 16 & 0x01;
+    cpu_specs.feature.sha = ebx >> 29 & 0x01;
+
+    __cpuid_count(7, 1, eax, ebx, ecx, edx);
+
+    cpu_specs.feature.sha512 = eax >> 0 & 0x01;
+
+    /* ===== EAX=8000'0001h: Extended Processor Info and Feature Bits ===== */
+
+    __cpuid(0x8000'0000, eax, ebx, ecx, edx);
+    u32 ext_max_leaf = eax;
+
+    if (ext_max_leaf >= 0x8000'0001) {
+        __cpuid(0x8000'0001, eax, ebx, ecx, edx);
+
+        cpu_specs.simd.sse4a  = ecx >> 6  & 0x01;
+        cpu_specs.feature.tce = ecx >> 17 & 0x01;
+        cpu_specs.feature.tbm = ecx >> 21 & 0x01;
+
+        cpu_specs.feature.lm  = edx >> 29 & 0x01;
+    }
+
+    /* ====== EAX=8000'0008h: Virtual and Physical Address Sizes ====== */
+
+    if (ext_max_leaf >= 0x8000'0008) {
+        __cpuid(0x8000'0008, eax, ebx, ecx, edx);
+
+        cpu_specs.physical_address = (eax >> 0) & 0xff;
+        cpu_specs.virtual_address  = (eax >> 8) & 0xff;
+
+        cpu_specs.physical_threads = ((ecx >> 0) & 0xff) + 1;
+    }
+}
+#endif // HK_HAS_CPUID
+
+void update_cpu_specs()
+{
+    cpu_specs.page_size = static_cast<u32>(sysconf(_SC_PAGESIZE));
+    cpu_specs.threads   = static_cast<u32>(sysconf(_SC_NPROCESSORS_ONLN));
+
+    // Count NUMA nodes exposed by the kernel
+    cpu_specs.numa_nodes = 0;
+    while (!read_line("/sys/devices/system/node/node" +
+                      std::to_string(cpu_specs.numa_nodes) +
+                      "/cpulist").empty())
+    {
+        cpu_specs.numa_nodes++;
+    }
+    if (!cpu_specs.numa_nodes) { cpu_specs.numa_nodes = 1; }
+
+#ifdef HK_HAS_CPUID
+    update_cpuid_info();
+#endif
+
+    update_proc_info();
+    update_cache_info();
+}
+
+}
+
+#endif // __linux__
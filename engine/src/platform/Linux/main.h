@@ -0,0 +1,44 @@
+#ifndef HK_LINUXMAIN_H
+#define HK_LINUXMAIN_H
+
+#include "hkstl/Logger.h"
+#include "core/Application.h"
+#include "platform/args.h"
+#include "platform/platform.h"
+#include "platform/Linux/LinuxLog.h"
+
+int main(int argc, char **argv)
+{
+    hk::log::init();
+
+    attachTerminal();
+#ifdef HKDEBUG
+    setLogFile("hikai_log.txt");
+#endif
+
+    LOG_INFO("Initializing Linux startup");
+
+    hk::platform::args::argc = argc;
+    hk::platform::args::argv = argv;
+
+    Application *app = create_app();
+
+    app->init();
+    app->run();
+    app->deinit();
+
+    delete app;
+
+#ifdef HKDEBUG
+    removeLogFile();
+#endif
+    // Flush everything logged during shutdown
+    hk::log::flush();
+    hk::log::dispatch();
+    detachTerminal();
+
+    hk::log::deinit();
+    return 0;
+}
+
+#endif // HK_LINUXMAIN_H
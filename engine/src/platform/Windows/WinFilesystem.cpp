@@ -1,3 +1,4 @@
+#ifdef _WIN32
 #include "platform/filesystem.h"
 
 #include "win.h"
@@ -26,6 +27,71 @@ b8 read_file(const std::string &path, hk::vector<u8> &out)
     return true;
 }
 
+b8 write_file(const std::string &path, const void *data, u64 size)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!file.is_open()) { return false; }
+
+    file.write(reinterpret_cast<const char*>(data), size);
+
+    return file.good();
+}
+
+b8 map_file(const std::string &path, MappedFile &out)
+{
+    out = {};
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) { return false; }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || !size.QuadPart) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+    // Mapping keeps its own reference to file
+    CloseHandle(file);
+
+    if (!mapping) { return false; }
+
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    out.data = static_cast<const u8*>(data);
+    out.size = static_cast<u64>(size.QuadPart);
+    out.handle = mapping;
+
+    return true;
+}
+
+void unmap_file(MappedFile &file)
+{
+    if (file.data) {
+        UnmapViewOfFile(file.data);
+        CloseHandle(file.handle);
+    }
+
+    file = {};
+}
+
+u64 last_write_time(const std::string &path)
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data)) {
+        return 0;
+    }
+
+    return (static_cast<u64>(data.ftLastWriteTime.dwHighDateTime) << 32) |
+           data.ftLastWriteTime.dwLowDateTime;
+}
+
 b8 find_file(const std::string &root, const std::string &target,
             std::string *out)
 {
@@ -97,6 +163,13 @@ b8 exists(const std::string &path)
     return true;
 }
 
+b8 create_directory(const std::string &path)
+{
+    if (CreateDirectoryA(path.c_str(), NULL)) { return true; }
+
+    return GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
 hk::vector<std::string> split(const std::string &path)
 {
     hk::vector<std::string> subpaths;
@@ -272,6 +345,9 @@ struct DirectoryIterator::Impl {
 DirectoryIterator::DirectoryIterator(const std::string& path)
 {
     impl = new Impl(path);
+
+    // Current entry is kept in iterator, so operator-> has nothing to allocate
+    if (impl->valid) { cur = Entry(impl->getPath(), impl->getName(), impl->isDirectory()); }
 }
 
 DirectoryIterator::~DirectoryIterator()
@@ -287,22 +363,20 @@ b8 DirectoryIterator::operator !=(const DirectoryIterator&) const
 
 DirectoryIterator& DirectoryIterator::operator ++()
 {
-    impl->next();
+    if (impl->next()) { cur = Entry(impl->getPath(), impl->getName(), impl->isDirectory()); }
     return *this;
 }
 
 const DirectoryIterator::Entry& DirectoryIterator::operator *()
 {
-    cur.path = impl->getPath();
-    cur.name = impl->getName();
-    cur.isDirectory = impl->isDirectory();
-
     return cur;
 }
 
 const DirectoryIterator::Entry* DirectoryIterator::operator ->() const
 {
-    return new Entry(impl->getPath(), impl->getName(), impl->isDirectory());
+    return &cur;
 }
 
 }
+
+#endif // _WIN32
@@ -1,4 +1,5 @@
-#include "filewatch.h"
+#ifdef _WIN32
+#include "hkstl/Filewatch.h"
 
 #include "platform/platform.h"
 #include "strings/hklocale.h"
@@ -163,3 +164,5 @@ void unwatch(const std::string &path)
 }
 
 }
+
+#endif // _WIN32
@@ -1,3 +1,4 @@
+#ifdef _WIN32
 #include "WinLog.h"
 
 #include "utils/to_string.h"
@@ -79,19 +80,21 @@ void allocWinConsole()
     GetConsoleScreenBufferInfo(hConsole, &csbi);
     setConsoleSize(maxBufferLineSize, csbi.srWindow.Bottom);
 
-    hndl_console = hk::log::addMessageHandler(logWinConsole);
+    hndl_console = hk::log::addMessageHandler(logWinConsole, hk::log::Sink::BACKGROUND);
 }
 
 void deallocWinConsole()
 {
     if (!hConsole) { return; }
 
+    // Handler runs on logger thread, detach it before closing console
+    hk::log::flush();
+    hk::log::removeMessageHandler(hndl_console);
+
     CloseHandle(hConsole);
     hConsole = 0;
 
     FreeConsole();
-
-    hk::log::removeMessageHandler(hndl_console);
 }
 
 void setLogFile(const std::string &file)
@@ -99,11 +102,12 @@ void setLogFile(const std::string &file)
     log_file = file;
     if (log_file.empty()) { return; }
 
-    hndl_file = hk::log::addMessageHandler(logWinFile);
+    hndl_file = hk::log::addMessageHandler(logWinFile, hk::log::Sink::BACKGROUND);
 }
 
 void removeLogFile()
 {
+    hk::log::flush();
     hk::log::removeMessageHandler(hndl_file);
 }
 
@@ -271,3 +275,5 @@ b8 setConsoleSize(i16 cols, i16 rows)
                         SWP_NOOWNERZORDER |
                         SWP_NOZORDER);
 }
+
+#endif // _WIN32
@@ -1,3 +1,4 @@
+#ifdef _WIN32
 #include "platform/utils.h"
 
 #include "platform/platform.h"
@@ -117,3 +118,5 @@ void addTaskDialog(const std::string &title,
 }
 
 }
+
+#endif // _WIN32
@@ -1,3 +1,4 @@
+#ifdef _WIN32
 #include "utils/spec.h"
 
 #include <intrin.h>
@@ -280,6 +281,7 @@ void update_cpu_specs()
     cpu_specs.simd.sse4_2        = cpuid.ecx >> 20 & 0x01;
     cpu_specs.feature.popcnt     = cpuid.ecx >> 23 & 0x01;
     cpu_specs.feature.aes        = cpuid.ecx >> 25 & 0x01;
+    cpu_specs.feature.osxsave    = cpuid.ecx >> 27 & 0x01;
     cpu_specs.simd.avx           = cpuid.ecx >> 28 & 0x01;
     cpu_specs.feature.hypervisor = cpuid.ecx >> 31 & 0x01;
 
@@ -483,3 +485,4 @@ void update_cpu_specs()
 
 }
 
+#endif // _WIN32
@@ -2,19 +2,43 @@
 #define HK_FILESYSTEM_H
 
 #include "hkcommon.h"
-#include "Windows/win.h"
+#include "platform.h"
 
 #include "hkstl/containers/hkvector.h"
 
+#ifdef HKWINDOWS
+    #define HKPATH_SEPARATOR "\\"
+#else
+    #define HKPATH_SEPARATOR "/"
+#endif
+
 namespace hk::filesystem {
 
 HKAPI b8 read_file(const std::string &path, hk::vector<u8>& out);
+HKAPI b8 write_file(const std::string &path, const void *data, u64 size);
+
+// Read only view of whole file, stays valid until unmap_file
+struct MappedFile {
+    const u8 *data = nullptr;
+    u64 size = 0;
+
+    void *handle = nullptr; // Platform specific
+};
+
+HKAPI b8 map_file(const std::string &path, MappedFile &out);
+HKAPI void unmap_file(MappedFile &file);
+
+// Opaque timestamp, only good for comparison. 0 if file doesn't exist
+HKAPI u64 last_write_time(const std::string &path);
 
 HKAPI b8 find_file(const std::string &root, const std::string &target,
                   std::string *out = nullptr);
 
 HKAPI b8 exists(const std::string &path);
 
+// Creates single directory, true if it already exists
+HKAPI b8 create_directory(const std::string &path);
+
 // Converts path to weakly canonical absolute path
 HKAPI std::string canonical(const std::string &path);
 
@@ -63,7 +87,7 @@ private:
 
 public:
     directory_iterator(const std::string& path) :
-        startPath(path), endPath(path + "\\" + "*")
+        startPath(path), endPath(path + HKPATH_SEPARATOR + "*")
     {}
 
     DirectoryIterator begin() const {
@@ -4,6 +4,8 @@
 // Platform detection
 #if defined(_WIN32)
     #define HKWINDOWS
+#elif defined(__linux__)
+    #define HKLINUX
 #else
     #error "Unsupported platform"
 #endif
@@ -17,6 +19,11 @@
     // This, alongside platform::args, is a complitly garbage way to do this
     // but at least it works so I let it be as it is till better days
     #define PLATFORM_MAIN "platform/Windows/main.h"
+#elif defined(HKLINUX)
+    #include "platform/Linux/Window.h"
+    #include "platform/Linux/LinuxLog.h"
+
+    #define PLATFORM_MAIN "platform/Linux/main.h"
 #endif // Platform dependent includes
 
 #endif // HK_PLATFORM_H
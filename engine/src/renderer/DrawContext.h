@@ -36,6 +36,10 @@ struct RenderObject {
 
     void create(const hk::Mesh &mesh, const std::string &name)
     {
+        // Recreated on mesh change, old buffers may still be in use
+        if (bkr::is_valid(vertex)) { bkr::destroy_buffer(vertex); }
+        if (bkr::is_valid(index))  { bkr::destroy_buffer(index); }
+
         BufferDesc vertex_desc = {};
         vertex_desc.type = BufferType::VERTEX_BUFFER;
         vertex_desc.access = MemoryType::GPU_LOCAL;
@@ -62,13 +66,16 @@ struct RenderObject {
 };
 
 struct RenderLight {
-    Light *light;
+    Light light;
     Transform transform;
 };
 
 struct DrawContext {
     hk::vector<RenderObject> objects;
     hk::vector<RenderLight> lights;
+
+    // Indices into objects that passed culling this frame
+    hk::vector<u32> visible;
 };
 
 }
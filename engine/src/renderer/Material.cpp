@@ -6,45 +6,42 @@
 
 namespace hk {
 
-void hk::RenderMaterial::build(VkRenderPass renderpass, u32 pushConstSize,
+void hk::RenderMaterial::build(VkRenderPass renderpass,
                          VkDescriptorSetLayout sceneDescriptorLayout,
                          VkDescriptorSetLayout passDescriptorLayout,
                          hk::vector<VkFormat> formats, VkFormat depthFormat,
                          const std::string &name)
 {
-    // TODO: Make this dynamic
-    hk::DescriptorLayout::Builder l_builder;
-    l_builder.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT);
-    l_builder.addBinding(1, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,  VK_SHADER_STAGE_FRAGMENT_BIT);
-    l_builder.addBinding(2, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,  VK_SHADER_STAGE_FRAGMENT_BIT);
-    l_builder.addBinding(3, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,  VK_SHADER_STAGE_FRAGMENT_BIT);
-    l_builder.addBinding(4, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,  VK_SHADER_STAGE_FRAGMENT_BIT);
-    l_builder.addBinding(5, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,  VK_SHADER_STAGE_FRAGMENT_BIT);
-    l_builder.addBinding(6, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,  VK_SHADER_STAGE_FRAGMENT_BIT);
-    layout.init(l_builder.build());
+    // Rebuilding, old objects are released once frames in flight are done
+    if (bkr::is_valid(buf)) {
+        bkr::destroy_buffer(buf);
+        pipeline.deinit();
+        layout.deinit();
+    }
 
-    PipelineBuilder builder;
+    const hk::ShaderAsset &vs = hk::assets()->getShader(material->vertex_shader);
+    const hk::ShaderAsset &ps = hk::assets()->getShader(material->pixel_shader);
 
-    builder.setShader(material->vertex_shader);
-    builder.setShader(material->pixel_shader);
+    // Material owns set 2, only bindings shaders declare are in it
+    hk::DescriptorLayout::Builder l_builder;
+    l_builder.addReflection(vs.reflection, material_set);
+    l_builder.addReflection(ps.reflection, material_set);
 
-    hk::vector<Format> vert_layout = {
-        // position
-        hk::Format::R32G32B32_SFLOAT,
+    const hk::vector<VkDescriptorSetLayoutBinding> bindings = l_builder.build();
+    layout.init(bindings);
 
-        // normal
-        hk::Format::R32G32B32_SFLOAT,
+    used_bindings = 0;
+    for (const auto &binding : bindings) {
+        if (binding.binding < 32) { used_bindings |= 1u << binding.binding; }
+    }
 
-        // texture coordinates
-        hk::Format::R32G32_SFLOAT,
+    PipelineBuilder builder;
 
-        // tangent
-        hk::Format::R32G32B32_SFLOAT,
+    builder.setShader(material->vertex_shader);
+    builder.setShader(material->pixel_shader);
 
-        // hk::Format::SIGNED | hk::Format::FLOAT |
-        // hk::Format::VEC3 | hk::Format::B32,
-    };
-    builder.setVertexLayout(sizeof(Vertex), vert_layout);
+    // Vertex shader inputs must match hk::Vertex layout
+    builder.setVertexLayout(sizeof(Vertex));
 
     builder.setInputTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
     builder.setRasterizer(VK_POLYGON_MODE_FILL,
@@ -63,8 +60,6 @@ void hk::RenderMaterial::build(VkRenderPass renderpass, u32 pushConstSize,
     };
     builder.setColors(colors);
 
-    builder.setPushConstants({{VK_SHADER_STAGE_ALL_GRAPHICS, 0, pushConstSize }});
-
     hk::vector<VkDescriptorSetLayout> layouts = {
         sceneDescriptorLayout,
         passDescriptorLayout,
@@ -105,12 +100,17 @@ MaterialInstance RenderMaterial::write(DescriptorAllocator &allocator, VkSampler
     writer.clear();
 
     bkr::update_buffer(buf, &material->constants);
-    writer.writeBuffer(0, bkr::handle(buf),
-                       sizeof(Material::constants), 0,
-                       VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    if (used_bindings & 1u) {
+        writer.writeBuffer(0, bkr::handle(buf),
+                           sizeof(Material::constants), 0,
+                           VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    }
 
     hk::ImageHandle map;
     for (u32 i = 0; i < Material::MAX_TEXTURE_TYPE; ++i) {
+        // Stripped by compiler if shader never samples it
+        if (!(used_bindings & (1u << (i + 1)))) { continue; }
+
         u32 handle = material->map_handles[i];
 
         map = hk::assets()->getTexture(handle).image;
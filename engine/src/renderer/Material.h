@@ -62,7 +62,11 @@ struct RenderMaterial {
     hk::BufferHandle buf;
     Material *material;
 
-    void build(VkRenderPass renderpass, u32 pushConstSize,
+    // Set index in material shaders, bit per binding present in layout
+    static constexpr u32 material_set = 2;
+    u32 used_bindings = 0;
+
+    void build(VkRenderPass renderpass,
                VkDescriptorSetLayout sceneDescriptorLayout,
                VkDescriptorSetLayout passDescriptorLayout,
                hk::vector<VkFormat> formats, VkFormat depthFormat,
@@ -1,7 +1,10 @@
 #include "Renderer.h"
 
 #include "platform/platform.h"
+#include "platform/filesystem.h"
 #include "resources/AssetManager.h"
+#include "core/profiler.h"
+#include "renderer/gpu_profiler.h"
 
 #include "renderer/ui/debug_draw.h"
 
@@ -21,6 +24,8 @@ void Renderer::init(const Window *window)
 
     hk::bkr::init();
 
+    hk::pipeline_cache::init("pipeline.cache");
+
     device_ = hk::vkc::device();
     physical_ = hk::vkc::adapter();
 
@@ -32,6 +37,8 @@ void Renderer::init(const Window *window)
 
     createFrameResources();
 
+    hk::gpu_profiler::init(max_frames_);
+
     createBindlessDescriptor();
 
     createSamplers();
@@ -103,6 +110,12 @@ void Renderer::deinit()
 
     swapchain_.deinit();
 
+    hk::gpu_profiler::deinit();
+
+    hk::pipeline_cache::deinit();
+
+    hk::dxc::deinit();
+
     hk::bkr::deinit();
 
     hk::vkc::deinit();
@@ -110,11 +123,22 @@ void Renderer::deinit()
 
 void Renderer::draw(hk::DrawContext &ctx)
 {
+    HK_PROFILE_FUNCTION();
+
     VkResult err;
 
     FrameData frame = frames_[current_frame_];
 
-    vkWaitForFences(device_, 1, &frame.in_flight_fence, VK_TRUE, UINT64_MAX);
+    {
+        HK_PROFILE_SCOPE("Renderer::waitForFrame");
+        vkWaitForFences(device_, 1, &frame.in_flight_fence, VK_TRUE, UINT64_MAX);
+    }
+
+    // Frame that used this slot is done, release what it held on to
+    hk::bkr::begin_frame(max_frames_);
+
+    // Submitted ahead of frame, so this frame already sees uploaded data
+    hk::bkr::flush_uploads();
 
     u32 image_idx = 0;
     err = swapchain_.acquireNextImage(frame.acquire_semaphore, image_idx);
@@ -140,6 +164,9 @@ void Renderer::draw(hk::DrawContext &ctx)
     err = vkBeginCommandBuffer(frame.cmd, &beginInfo);
     ALWAYS_ASSERT(!err, "Failed to begin Command Buffer");
 
+    // Reads timings of the frame that used this slot before
+    hk::gpu_profiler::begin_frame(frame.cmd, current_frame_);
+
     VkViewport viewport = {};
     viewport.x = 0.0f;
     viewport.y = 0.0f;
@@ -163,11 +190,13 @@ void Renderer::draw(hk::DrawContext &ctx)
                             offscreen_.geometry_pipeline_.layout(), 0, 1,
                             &bindless_.set, 0, nullptr);
 
+    hk::gpu_profiler::begin(frame.cmd, "Geometry");
     offscreen_.begin(frame.cmd, image_idx);
         offscreen_.geometry_pipeline_.bind(frame.cmd, bind_point_graphics);
 
         // Geometry Pass
-        for (auto &object : ctx.objects) {
+        for (u32 idx : ctx.visible) {
+            hk::RenderObject &object = ctx.objects.at(idx);
             hk::MaterialInstance &mat = object.material;
 
             mat.pipeline->bind(frame.cmd, bind_point_graphics);
@@ -179,7 +208,7 @@ void Renderer::draw(hk::DrawContext &ctx)
                 instance_data.model_to_world = object.instances.at(mesh_idx);
 
                 vkCmdPushConstants(frame.cmd, mat.pipeline->layout(),
-                                   VK_SHADER_STAGE_ALL_GRAPHICS, 0,
+                                   mat.pipeline->push_stages(), 0,
                                    sizeof(instance_data), &instance_data);
 
                 vkCmdDrawIndexed(frame.cmd, hk::bkr::desc(object.index).size,
@@ -188,9 +217,13 @@ void Renderer::draw(hk::DrawContext &ctx)
 
         }
 
+        hk::gpu_profiler::end(frame.cmd);
+
         // Light pass
         vkCmdNextSubpass(frame.cmd, VK_SUBPASS_CONTENTS_INLINE);
 
+        hk::gpu_profiler::begin(frame.cmd, "Lighting");
+
         offscreen_.pipeline_.bind(frame.cmd, bind_point_graphics);
 
         vkCmdDraw(frame.cmd, 3, 1, 0, 0);
@@ -203,9 +236,12 @@ void Renderer::draw(hk::DrawContext &ctx)
         // vkCmdDraw(frame.cmd, 4, 1, 0, 0);
 
         // Debug Draw
+        hk::gpu_profiler::begin(frame.cmd, "Debug Draw");
         hk::dd::draw(frame.cmd);
+        hk::gpu_profiler::end(frame.cmd);
 
     offscreen_.end(frame.cmd);
+    hk::gpu_profiler::end(frame.cmd);
 
     // VkResult f = vkGetFenceStatus(hk::context()->device(), frame.in_flight_fence);
     // LOG_DEBUG("Current Index: ", imageIndex,
@@ -239,9 +275,11 @@ void Renderer::draw(hk::DrawContext &ctx)
     //                      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
     //                      0, 0, NULL, 0, NULL, 1, &bar);
 
+    hk::gpu_profiler::begin(frame.cmd, "Post Process");
     post_process_.render(offscreen_.color_,
                          frame.cmd, image_idx,
                          &frame.descriptor_alloc);
+    hk::gpu_profiler::end(frame.cmd);
 
     // hk::imman().transition_image_layout(post_process_.color_, );
 
@@ -262,13 +300,17 @@ void Renderer::draw(hk::DrawContext &ctx)
                          0, 0, NULL, 0, NULL, 1, &bar);
 
     if (use_ui_) {
+        HK_GPU_SCOPE(frame.cmd, "UI");
         ui_.render(frame.cmd, image_idx);
     } else {
+        HK_GPU_SCOPE(frame.cmd, "Present");
         present_.render(post_process_.color_,
                         frame.cmd, image_idx,
                         &frame.descriptor_alloc);
     }
 
+    hk::gpu_profiler::end_frame(frame.cmd);
+
     err = vkEndCommandBuffer(frame.cmd);
     ALWAYS_ASSERT(!err, "Failed to end Command Buffer");
 
@@ -480,6 +522,27 @@ void Renderer::loadShaders()
     desc.debug = false;
 #endif
 
+    // Passes and debug draw use the same settings, so cache misses of
+    // every shader in folder are compiled at once, loads below are hits
+    hk::vector<hk::dxc::ShaderDesc> descs;
+    for (auto &entry : hk::filesystem::directory_iterator(path)) {
+        if (entry.isDirectory) { continue; }
+
+        if (entry.name.find(".vert.hlsl") != std::string::npos) {
+            desc.type = ShaderType::Vertex;
+        } else if (entry.name.find(".frag.hlsl") != std::string::npos) {
+            desc.type = ShaderType::Pixel;
+        } else {
+            continue;
+        }
+
+        desc.path = path + entry.name;
+        descs.push_back(desc);
+    }
+    hk::dxc::precompile(descs);
+
+    desc.type = ShaderType::Vertex;
+
     desc.path = path + "Default.vert.hlsl";
     hndlDefaultVS = hk::assets()->load(desc.path, &desc);
     hk::assets()->attachCallback(hndlDefaultVS, [this](){
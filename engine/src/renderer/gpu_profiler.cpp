@@ -0,0 +1,218 @@
+#include "gpu_profiler.h"
+
+#include "renderer/vkwrappers/vkcontext.h"
+#include "renderer/vkwrappers/vkdebug.h"
+
+#include "hkstl/Logger.h"
+
+namespace hk::gpu_profiler {
+
+// First two queries of every slot bracket whole frame
+static constexpr u32 queries_per_slot = 128;
+static constexpr u32 frame_queries = 2;
+static constexpr u32 skipped = ~0u;
+
+struct Slot {
+    struct Pending {
+        const char *name;
+        u32 depth;
+        u32 begin; // Query indices inside slot
+        u32 end;
+    };
+
+    u64 frame = 0;
+    b8 recorded = false;
+
+    u32 queries = 0;
+    hk::vector<Pending> regions;
+    hk::vector<u32> open; // Indices into regions, skipped when pool was full
+};
+
+static struct GpuProfilerContext {
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueryPool pool = VK_NULL_HANDLE;
+
+    f64 period = 0.0; // ns per tick
+    u64 mask = 0;     // Only timestampValidBits are meaningful
+
+    hk::vector<Slot> slots;
+    u32 current = skipped;
+    u64 frame = 0;
+
+    hk::vector<u64> readback;
+    Results results;
+} ctx;
+
+void init(u32 frames_in_flight)
+{
+    ctx.device = hk::vkc::device();
+
+    const auto &adapter = hk::vkc::adapter_info();
+    const u32 valid_bits =
+        hk::vkc::device_info().graphics_family.properties.timestampValidBits;
+
+    if (!valid_bits || adapter.properties.limits.timestampPeriod <= 0.f) {
+        LOG_WARN("Graphics queue doesn't support timestamps, GPU profiler disabled");
+        return;
+    }
+
+    ctx.period = adapter.properties.limits.timestampPeriod;
+    ctx.mask = valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+
+    VkQueryPoolCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    info.queryCount = queries_per_slot * frames_in_flight;
+
+    VkResult err = vkCreateQueryPool(ctx.device, &info, nullptr, &ctx.pool);
+    if (err) {
+        LOG_ERROR("Failed to create timestamp Query Pool, GPU profiler disabled");
+        ctx.pool = VK_NULL_HANDLE;
+        return;
+    }
+    hk::debug::setName(ctx.pool, "Query Pool - GPU Profiler");
+
+    ctx.slots.resize(frames_in_flight);
+    ctx.readback.resize(queries_per_slot);
+    ctx.current = skipped;
+    ctx.frame = 0;
+    ctx.results = {};
+}
+
+void deinit()
+{
+    if (ctx.pool) {
+        vkDestroyQueryPool(ctx.device, ctx.pool, nullptr);
+    }
+
+    ctx.pool = VK_NULL_HANDLE;
+    ctx.slots = hk::vector<Slot>();
+    ctx.current = skipped;
+}
+
+b8 supported()
+{
+    return ctx.pool != VK_NULL_HANDLE;
+}
+
+static f32 to_ms(u64 begin, u64 end)
+{
+    u64 ticks = (end - begin) & ctx.mask;
+    return static_cast<f32>(ticks * ctx.period / 1e6);
+}
+
+static void resolve(u32 idx)
+{
+    Slot &slot = ctx.slots[idx];
+
+    // No wait flag, slot fence was already waited on, so results are either
+    // there or frame was never submitted
+    VkResult err = vkGetQueryPoolResults(ctx.device, ctx.pool,
+                                         idx * queries_per_slot, slot.queries,
+                                         slot.queries * sizeof(u64),
+                                         ctx.readback.data(), sizeof(u64),
+                                         VK_QUERY_RESULT_64_BIT);
+    if (err != VK_SUCCESS) { return; }
+
+    const u64 *time = ctx.readback.data();
+
+    ctx.results.frame = slot.frame;
+    ctx.results.ms = to_ms(time[0], time[1]);
+    ctx.results.regions.clear();
+
+    for (auto &pending : slot.regions) {
+        Region region;
+        region.name = pending.name;
+        region.depth = pending.depth;
+        region.begin = to_ms(time[0], time[pending.begin]);
+        region.ms = to_ms(time[pending.begin], time[pending.end]);
+        ctx.results.regions.push_back(region);
+    }
+}
+
+static void write(VkCommandBuffer cmd, VkPipelineStageFlagBits stage, u32 query)
+{
+    vkCmdWriteTimestamp(cmd, stage, ctx.pool, ctx.current * queries_per_slot + query);
+}
+
+void begin_frame(VkCommandBuffer cmd, u32 slot)
+{
+    if (!supported()) { return; }
+
+    Slot &s = ctx.slots[slot];
+
+    if (s.recorded) {
+        resolve(slot);
+        s.recorded = false;
+    }
+
+    vkCmdResetQueryPool(cmd, ctx.pool, slot * queries_per_slot, queries_per_slot);
+
+    s.frame = ctx.frame++;
+    s.queries = frame_queries;
+    s.regions.clear();
+    s.open.clear();
+
+    ctx.current = slot;
+    write(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+}
+
+void end_frame(VkCommandBuffer cmd)
+{
+    if (!supported() || ctx.current == skipped) { return; }
+
+    Slot &s = ctx.slots[ctx.current];
+
+    // Close whatever was left open, so every written query has a pair
+    while (!s.open.empty()) { end(cmd); }
+
+    write(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+
+    s.recorded = true;
+    ctx.current = skipped;
+}
+
+void begin(VkCommandBuffer cmd, const char *name)
+{
+    if (!supported() || ctx.current == skipped) { return; }
+
+    Slot &s = ctx.slots[ctx.current];
+
+    if (s.queries + 2 > queries_per_slot) {
+        s.open.push_back(skipped);
+        return;
+    }
+
+    Slot::Pending pending;
+    pending.name = name;
+    pending.depth = s.open.size();
+    pending.begin = s.queries++;
+    pending.end = s.queries++;
+
+    s.open.push_back(s.regions.size());
+    s.regions.push_back(pending);
+
+    write(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pending.begin);
+}
+
+void end(VkCommandBuffer cmd)
+{
+    if (!supported() || ctx.current == skipped) { return; }
+
+    Slot &s = ctx.slots[ctx.current];
+    if (s.open.empty()) { return; }
+
+    u32 region = s.open.back();
+    s.open.pop_back();
+
+    if (region == skipped) { return; }
+
+    write(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, s.regions[region].end);
+}
+
+const Results& results()
+{
+    return ctx.results;
+}
+
+}
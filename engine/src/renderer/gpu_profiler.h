@@ -0,0 +1,66 @@
+#ifndef HK_GPU_PROFILER_H
+#define HK_GPU_PROFILER_H
+
+#include "hkcommon.h"
+#include "core/profiler.h"
+#include "hkstl/containers/hkvector.h"
+
+#include "vendor/vulkan/vulkan.h"
+
+/* Timestamp query profiler for the graphics queue.
+ * Every frame in flight owns a slice of one query pool. Slice is read
+ * right after its fence was waited on, so results never stall the CPU
+ * and always describe the frame that previously used the same slot */
+namespace hk::gpu_profiler {
+
+struct Region {
+    const char *name = nullptr; // Must outlive profiler, literals only
+    u32 depth = 0;
+    f32 begin = 0.f; // ms since frame start
+    f32 ms = 0.f;
+};
+
+struct Results {
+    u64 frame = 0; // Renderer frame the timings came from
+    f32 ms = 0.f;  // Whole command buffer
+
+    hk::vector<Region> regions; // In recording order
+};
+
+void init(u32 frames_in_flight);
+void deinit();
+
+// false when graphics queue doesn't support timestamps,
+// all other calls are no-ops then
+HKAPI b8 supported();
+
+// Reads back slot results and resets its queries,
+// must be called outside of render pass
+void begin_frame(VkCommandBuffer cmd, u32 slot);
+void end_frame(VkCommandBuffer cmd);
+
+// Regions can nest, excess regions are silently skipped
+HKAPI void begin(VkCommandBuffer cmd, const char *name);
+HKAPI void end(VkCommandBuffer cmd);
+
+// Latest frame whose results were available
+HKAPI const Results& results();
+
+class Scope {
+public:
+    Scope(VkCommandBuffer cmd, const char *name) : cmd_(cmd) { begin(cmd_, name); }
+    ~Scope() { end(cmd_); }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    VkCommandBuffer cmd_;
+};
+
+}
+
+#define HK_GPU_SCOPE(cmd, name) \
+    hk::gpu_profiler::Scope HK_PROFILE_CONCAT(hk_gpu_scope_, __COUNTER__)(cmd, name)
+
+#endif // HK_GPU_PROFILER_H
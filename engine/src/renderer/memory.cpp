@@ -0,0 +1,641 @@
+#include "memory.h"
+
+#include "renderer/vkwrappers/vkcontext.h"
+#include "renderer/vkwrappers/vkdebug.h"
+
+#include <string>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace hk::bkr {
+
+/* ===== Bit helpers ===== */
+static u32 msb(u64 value)
+{
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanReverse64(&idx, value);
+    return static_cast<u32>(idx);
+#else
+    return 63 - static_cast<u32>(__builtin_clzll(value));
+#endif
+}
+
+static u32 lsb(u64 value)
+{
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward64(&idx, value);
+    return static_cast<u32>(idx);
+#else
+    return static_cast<u32>(__builtin_ctzll(value));
+#endif
+}
+
+constexpr u64 align_up(u64 value, u64 alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/* ===== TLSF ===== */
+void TLSF::init(u64 size)
+{
+    nodes_.clear();
+    free_nodes_.clear();
+
+    for (u32 fl = 0; fl < fl_count; ++fl) {
+        for (u32 sl = 0; sl < sl_count; ++sl) {
+            heads_[fl][sl] = invalid;
+        }
+        sl_bitmap_[fl] = 0;
+    }
+    fl_bitmap_ = 0;
+
+    size_ = size & ~((1ull << granularity_log2) - 1);
+    used_ = 0;
+    allocations_ = 0;
+    free_ranges_ = 0;
+
+    if (!size_) { return; }
+
+    u32 node = create_node();
+    nodes_[node].offset = 0;
+    nodes_[node].size = size_;
+    insert_free(node);
+}
+
+void TLSF::mapping(u64 units, u32 &fl, u32 &sl) const
+{
+    fl = msb(units);
+
+    if (fl >= sl_log2) {
+        sl = static_cast<u32>(units >> (fl - sl_log2)) ^ sl_count;
+    } else {
+        sl = static_cast<u32>(units << (sl_log2 - fl)) ^ sl_count;
+    }
+}
+
+b8 TLSF::find_free(u64 units, u32 &fl, u32 &sl) const
+{
+    // Round up to next list, so any range in it is big enough
+    const u32 log2 = msb(units);
+    if (log2 >= sl_log2) {
+        units += (1ull << (log2 - sl_log2)) - 1;
+    }
+
+    mapping(units, fl, sl);
+    if (fl >= fl_count) { return false; }
+
+    u32 sl_map = sl_bitmap_[fl] & (~0u << sl);
+    if (!sl_map) {
+        const u64 fl_map = fl + 1 < 64 ? fl_bitmap_ & (~0ull << (fl + 1)) : 0;
+        if (!fl_map) { return false; }
+
+        fl = lsb(fl_map);
+        sl_map = sl_bitmap_[fl];
+    }
+
+    sl = lsb(sl_map);
+
+    return true;
+}
+
+void TLSF::insert_free(u32 idx)
+{
+    Node &node = nodes_[idx];
+
+    u32 fl, sl;
+    mapping(node.size >> granularity_log2, fl, sl);
+
+    node.is_free = true;
+    node.prev_free = invalid;
+    node.next_free = heads_[fl][sl];
+
+    if (node.next_free != invalid) {
+        nodes_[node.next_free].prev_free = idx;
+    }
+
+    heads_[fl][sl] = idx;
+    sl_bitmap_[fl] |= 1u << sl;
+    fl_bitmap_ |= 1ull << fl;
+
+    ++free_ranges_;
+}
+
+void TLSF::remove_free(u32 idx)
+{
+    Node &node = nodes_[idx];
+
+    u32 fl, sl;
+    mapping(node.size >> granularity_log2, fl, sl);
+
+    if (node.prev_free != invalid) {
+        nodes_[node.prev_free].next_free = node.next_free;
+    } else {
+        heads_[fl][sl] = node.next_free;
+    }
+
+    if (node.next_free != invalid) {
+        nodes_[node.next_free].prev_free = node.prev_free;
+    }
+
+    if (heads_[fl][sl] == invalid) {
+        sl_bitmap_[fl] &= ~(1u << sl);
+        if (!sl_bitmap_[fl]) { fl_bitmap_ &= ~(1ull << fl); }
+    }
+
+    node.is_free = false;
+    node.prev_free = node.next_free = invalid;
+
+    --free_ranges_;
+}
+
+u32 TLSF::create_node()
+{
+    u32 idx;
+
+    if (free_nodes_.size()) {
+        idx = free_nodes_.back();
+        free_nodes_.pop_back();
+    } else {
+        idx = nodes_.size();
+        nodes_.push_back({});
+    }
+
+    nodes_[idx] = {};
+    nodes_[idx].is_used = true;
+
+    return idx;
+}
+
+void TLSF::destroy_node(u32 idx)
+{
+    nodes_[idx].is_used = false;
+    free_nodes_.push_back(idx);
+}
+
+u32 TLSF::allocate(u64 size, u64 alignment, u64 &offset)
+{
+    constexpr u64 granularity = 1ull << granularity_log2;
+
+    if (!size) { size = 1; }
+    size = align_up(size, granularity);
+
+    // Every range starts at granularity, bigger alignment needs padding
+    const u64 padding = alignment > granularity ? alignment - granularity : 0;
+
+    u32 fl, sl;
+    if (!find_free((size + padding) >> granularity_log2, fl, sl)) {
+        return invalid;
+    }
+
+    const u32 idx = heads_[fl][sl];
+    remove_free(idx);
+
+    const u64 aligned = alignment > granularity ?
+        align_up(nodes_[idx].offset, alignment) : nodes_[idx].offset;
+
+    // Leading padding goes back as free range, previous range is never free
+    if (aligned != nodes_[idx].offset) {
+        const u32 lead = create_node();
+        Node &node = nodes_[idx];
+
+        nodes_[lead].offset = node.offset;
+        nodes_[lead].size = aligned - node.offset;
+        nodes_[lead].prev_phys = node.prev_phys;
+        nodes_[lead].next_phys = idx;
+
+        if (node.prev_phys != invalid) { nodes_[node.prev_phys].next_phys = lead; }
+        node.prev_phys = lead;
+
+        node.size -= aligned - node.offset;
+        node.offset = aligned;
+
+        insert_free(lead);
+    }
+
+    // Same for the tail
+    if (nodes_[idx].size - size >= granularity) {
+        const u32 tail = create_node();
+        Node &node = nodes_[idx];
+
+        nodes_[tail].offset = node.offset + size;
+        nodes_[tail].size = node.size - size;
+        nodes_[tail].prev_phys = idx;
+        nodes_[tail].next_phys = node.next_phys;
+
+        if (node.next_phys != invalid) { nodes_[node.next_phys].prev_phys = tail; }
+        node.next_phys = tail;
+
+        node.size = size;
+
+        insert_free(tail);
+    }
+
+    used_ += nodes_[idx].size;
+    ++allocations_;
+
+    offset = nodes_[idx].offset;
+
+    return idx;
+}
+
+void TLSF::free(u32 idx)
+{
+    DEV_ASSERT(idx < nodes_.size() && nodes_[idx].is_used && !nodes_[idx].is_free,
+               "Invalid TLSF node");
+
+    used_ -= nodes_[idx].size;
+    --allocations_;
+
+    // Merge with free neighbours
+    const u32 prev = nodes_[idx].prev_phys;
+    if (prev != invalid && nodes_[prev].is_free) {
+        remove_free(prev);
+
+        nodes_[prev].size += nodes_[idx].size;
+        nodes_[prev].next_phys = nodes_[idx].next_phys;
+        if (nodes_[idx].next_phys != invalid) {
+            nodes_[nodes_[idx].next_phys].prev_phys = prev;
+        }
+
+        destroy_node(idx);
+        idx = prev;
+    }
+
+    const u32 next = nodes_[idx].next_phys;
+    if (next != invalid && nodes_[next].is_free) {
+        remove_free(next);
+
+        nodes_[idx].size += nodes_[next].size;
+        nodes_[idx].next_phys = nodes_[next].next_phys;
+        if (nodes_[next].next_phys != invalid) {
+            nodes_[nodes_[next].next_phys].prev_phys = idx;
+        }
+
+        destroy_node(next);
+    }
+
+    insert_free(idx);
+}
+
+u64 TLSF::largest_free() const
+{
+    if (!fl_bitmap_) { return 0; }
+
+    const u32 fl = msb(fl_bitmap_);
+
+    u64 largest = 0;
+    for (u32 sl = 0; sl < sl_count; ++sl) {
+        for (u32 idx = heads_[fl][sl]; idx != invalid; idx = nodes_[idx].next_free) {
+            if (nodes_[idx].size > largest) { largest = nodes_[idx].size; }
+        }
+    }
+
+    return largest;
+}
+
+/* ===== Device memory ===== */
+struct Block {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    u8 *mapped = nullptr;
+    TLSF tlsf;
+};
+
+// One per memory type and resource tiling
+struct Pool {
+    hk::vector<Block*> blocks; // Freed blocks leave nullptr, so indices stay valid
+    u64 block_size = 0;
+
+    u32 dedicated = 0;
+    u64 dedicated_size = 0;
+};
+
+static struct MemoryContext {
+    VkDevice device = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties properties;
+    b8 has_budget = false;
+
+    Pool pools[VK_MAX_MEMORY_TYPES * 2];
+
+    // Everything allocated from Vulkan, per heap
+    u64 heap_usage[VK_MAX_MEMORY_HEAPS];
+
+    struct CachedType {
+        u32 bits;
+        VkMemoryPropertyFlags properties;
+        u32 index;
+    };
+    hk::vector<CachedType> type_cache;
+} ctx;
+
+static constexpr u64 max_block_size = 128ull * 1024 * 1024;
+
+void init_memory(b8 has_budget_ext)
+{
+    ctx.device = hk::vkc::device();
+    ctx.properties = hk::vkc::adapter_info().memory_properties;
+    ctx.has_budget = has_budget_ext;
+
+    for (u32 i = 0; i < VK_MAX_MEMORY_HEAPS; ++i) {
+        ctx.heap_usage[i] = 0;
+    }
+
+    for (u32 type = 0; type < ctx.properties.memoryTypeCount; ++type) {
+        const u32 heap = ctx.properties.memoryTypes[type].heapIndex;
+        const u64 heap_size = ctx.properties.memoryHeaps[heap].size;
+
+        // Small heaps, like 256MB BAR, would be eaten by a single block
+        u64 block_size = max_block_size;
+        while (block_size > heap_size / 8 && block_size > 1024 * 1024) {
+            block_size >>= 1;
+        }
+
+        ctx.pools[type * 2 + 0] = {};
+        ctx.pools[type * 2 + 1] = {};
+        ctx.pools[type * 2 + 0].block_size = block_size;
+        ctx.pools[type * 2 + 1].block_size = block_size;
+    }
+
+    ctx.type_cache.clear();
+}
+
+static void release_block(u32 type, Block *block)
+{
+    const u32 heap = ctx.properties.memoryTypes[type].heapIndex;
+
+    if (block->mapped) { vkUnmapMemory(ctx.device, block->memory); }
+    vkFreeMemory(ctx.device, block->memory, nullptr);
+
+    ctx.heap_usage[heap] -= block->tlsf.size();
+
+    delete block;
+}
+
+void deinit_memory()
+{
+    for (u32 p = 0; p < ctx.properties.memoryTypeCount * 2; ++p) {
+        Pool &pool = ctx.pools[p];
+
+        for (Block *block : pool.blocks) {
+            if (!block) { continue; }
+
+            if (block->tlsf.allocations()) {
+                LOG_WARN("Device memory block still has", block->tlsf.allocations(),
+                         "allocation(s)");
+            }
+
+            release_block(p / 2, block);
+        }
+
+        pool.blocks.clear();
+    }
+}
+
+static u32 find_type(u32 bits, VkMemoryPropertyFlags properties)
+{
+    for (const auto &cached : ctx.type_cache) {
+        if (cached.bits == bits && cached.properties == properties) {
+            return cached.index;
+        }
+    }
+
+    u32 index = 0;
+    for (; index < ctx.properties.memoryTypeCount; ++index) {
+        if ((bits & (1 << index)) &&
+            (ctx.properties.memoryTypes[index].propertyFlags & properties) == properties)
+        {
+            break;
+        }
+    }
+
+    ALWAYS_ASSERT(index < ctx.properties.memoryTypeCount,
+                  "Failed to find suitable Vulkan memory type");
+
+    ctx.type_cache.push_back({ bits, properties, index });
+
+    return index;
+}
+
+static b8 is_host_visible(u32 type)
+{
+    return ctx.properties.memoryTypes[type].propertyFlags &
+           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+}
+
+static VkDeviceMemory allocate_device_memory(u32 type, u64 size, u8 **mapped)
+{
+    const u32 heap = ctx.properties.memoryTypes[type].heapIndex;
+
+    const MemoryStats::Heap budget = memory_stats().heaps[heap];
+    if (budget.usage + size > budget.budget) {
+        LOG_WARN("Device memory heap", heap, "is over budget:",
+                 budget.usage + size, "/", budget.budget);
+    }
+
+    VkMemoryAllocateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    info.allocationSize = size;
+    info.memoryTypeIndex = type;
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkResult err = vkAllocateMemory(ctx.device, &info, nullptr, &memory);
+    ALWAYS_ASSERT(!err, "Failed to allocate Vulkan Device Memory");
+
+    ctx.heap_usage[heap] += size;
+
+    *mapped = nullptr;
+    if (is_host_visible(type)) {
+        err = vkMapMemory(ctx.device, memory, 0, VK_WHOLE_SIZE, 0,
+                          reinterpret_cast<void**>(mapped));
+        ALWAYS_ASSERT(!err, "Failed to map Vulkan Device Memory");
+    }
+
+    return memory;
+}
+
+Allocation allocate_memory(const VkMemoryRequirements &requirements,
+                           VkMemoryPropertyFlags properties,
+                           b8 linear, b8 dedicated)
+{
+    const u32 type = find_type(requirements.memoryTypeBits, properties);
+    const u32 pool_idx = type * 2 + (linear ? 0 : 1);
+    Pool &pool = ctx.pools[pool_idx];
+
+    Allocation out;
+    out.pool = pool_idx;
+
+    // Big resources get their own memory, they would only fragment blocks
+    if (dedicated || requirements.size > pool.block_size / 2) {
+        out.memory = allocate_device_memory(type, requirements.size, &out.mapped);
+        out.offset = 0;
+        out.size = requirements.size;
+
+        ++pool.dedicated;
+        pool.dedicated_size += requirements.size;
+
+        return out;
+    }
+
+    u32 free_slot = TLSF::invalid;
+
+    for (u32 i = 0; i < pool.blocks.size(); ++i) {
+        Block *block = pool.blocks[i];
+        if (!block) { free_slot = i; continue; }
+
+        u64 offset;
+        u32 node = block->tlsf.allocate(requirements.size, requirements.alignment, offset);
+        if (node == TLSF::invalid) { continue; }
+
+        out.memory = block->memory;
+        out.offset = offset;
+        out.size = requirements.size;
+        out.mapped = block->mapped ? block->mapped + offset : nullptr;
+        out.block = i;
+        out.node = node;
+
+        return out;
+    }
+
+    // No room, create new block
+    Block *block = new Block();
+    block->memory = allocate_device_memory(type, pool.block_size, &block->mapped);
+    block->tlsf.init(pool.block_size);
+
+    hk::debug::setName(block->memory, "Memory Block - Type " + std::to_string(type) +
+                                      (linear ? " Linear" : " Optimal"));
+
+    if (free_slot == TLSF::invalid) {
+        free_slot = pool.blocks.size();
+        pool.blocks.push_back(block);
+    } else {
+        pool.blocks[free_slot] = block;
+    }
+
+    u64 offset;
+    u32 node = block->tlsf.allocate(requirements.size, requirements.alignment, offset);
+    ALWAYS_ASSERT(node != TLSF::invalid, "Failed to sub-allocate Vulkan Device Memory");
+
+    out.memory = block->memory;
+    out.offset = offset;
+    out.size = requirements.size;
+    out.mapped = block->mapped ? block->mapped + offset : nullptr;
+    out.block = free_slot;
+    out.node = node;
+
+    return out;
+}
+
+void free_memory(Allocation &allocation)
+{
+    if (!allocation.memory) { return; }
+
+    Pool &pool = ctx.pools[allocation.pool];
+    const u32 type = allocation.pool / 2;
+
+    if (allocation.block == TLSF::invalid) {
+        const u32 heap = ctx.properties.memoryTypes[type].heapIndex;
+
+        if (allocation.mapped) { vkUnmapMemory(ctx.device, allocation.memory); }
+        vkFreeMemory(ctx.device, allocation.memory, nullptr);
+
+        ctx.heap_usage[heap] -= allocation.size;
+
+        --pool.dedicated;
+        pool.dedicated_size -= allocation.size;
+
+        allocation = {};
+        return;
+    }
+
+    Block *block = pool.blocks[allocation.block];
+    block->tlsf.free(allocation.node);
+
+    // Keep one empty block around, so alloc/free pairs don't hit Vulkan
+    if (!block->tlsf.allocations()) {
+        u32 empty = 0;
+        for (Block *other : pool.blocks) {
+            if (other && !other->tlsf.allocations()) { ++empty; }
+        }
+
+        if (empty > 1) {
+            release_block(type, block);
+            pool.blocks[allocation.block] = nullptr;
+        }
+    }
+
+    allocation = {};
+}
+
+MemoryStats memory_stats()
+{
+    MemoryStats stats;
+
+    const u32 heap_count = ctx.properties.memoryHeapCount;
+    stats.heaps.resize(heap_count);
+
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {};
+    budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+    if (ctx.has_budget) {
+        VkPhysicalDeviceMemoryProperties2 properties = {};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        properties.pNext = &budget;
+        vkGetPhysicalDeviceMemoryProperties2(hk::vkc::adapter(), &properties);
+    }
+
+    for (u32 i = 0; i < heap_count; ++i) {
+        MemoryStats::Heap &heap = stats.heaps[i];
+        const VkMemoryHeap &src = ctx.properties.memoryHeaps[i];
+
+        heap.size = src.size;
+        heap.device_local = src.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+
+        if (ctx.has_budget) {
+            heap.budget = budget.heapBudget[i];
+            heap.usage = budget.heapUsage[i];
+        } else {
+            // Common rule of thumb, leave some room for other processes
+            heap.budget = src.size / 10 * 8;
+            heap.usage = ctx.heap_usage[i];
+        }
+    }
+
+    stats.types.resize(ctx.properties.memoryTypeCount);
+    for (u32 t = 0; t < ctx.properties.memoryTypeCount; ++t) {
+        MemoryStats::Type &type = stats.types[t];
+
+        type.heap = ctx.properties.memoryTypes[t].heapIndex;
+        type.flags = ctx.properties.memoryTypes[t].propertyFlags;
+
+        for (u32 p = t * 2; p < t * 2 + 2; ++p) {
+            const Pool &pool = ctx.pools[p];
+
+            type.dedicated += pool.dedicated;
+            type.allocations += pool.dedicated;
+            type.reserved += pool.dedicated_size;
+            type.used += pool.dedicated_size;
+
+            for (const Block *block : pool.blocks) {
+                if (!block) { continue; }
+
+                const TLSF &tlsf = block->tlsf;
+
+                ++type.blocks;
+                type.allocations += tlsf.allocations();
+                type.reserved += tlsf.size();
+                type.used += tlsf.used();
+                type.free_ranges += tlsf.free_ranges();
+
+                const u64 largest = tlsf.largest_free();
+                if (largest > type.largest_free) { type.largest_free = largest; }
+            }
+        }
+    }
+
+    return stats;
+}
+
+}
@@ -0,0 +1,125 @@
+#ifndef HK_MEMORY_H
+#define HK_MEMORY_H
+
+#include "hkcommon.h"
+#include "hkstl/containers/hkvector.h"
+
+#include "vendor/vulkan/vulkan.h"
+
+namespace hk::bkr {
+
+/* Two level segregated fit allocator over abstract range [0, size)
+ * Doesn't touch memory itself, so it can manage device memory blocks
+ * O(1) allocation and free, neighbouring free ranges are merged */
+class TLSF {
+public:
+    static constexpr u32 invalid = ~0u;
+
+    HKAPI void init(u64 size);
+
+    // Returns node to free later or invalid, offset is aligned
+    HKAPI u32 allocate(u64 size, u64 alignment, u64 &offset);
+    HKAPI void free(u32 node);
+
+    constexpr u64 size() const { return size_; }
+    constexpr u64 used() const { return used_; }
+    constexpr u32 allocations() const { return allocations_; }
+    constexpr u32 free_ranges() const { return free_ranges_; }
+
+    HKAPI u64 largest_free() const;
+
+private:
+    static constexpr u32 granularity_log2 = 8; // 256 bytes
+    static constexpr u32 sl_log2 = 4;
+    static constexpr u32 sl_count = 1 << sl_log2;
+    static constexpr u32 fl_count = 40;
+
+    struct Node {
+        u64 offset = 0;
+        u64 size = 0;
+
+        u32 prev_phys = invalid;
+        u32 next_phys = invalid;
+        u32 prev_free = invalid;
+        u32 next_free = invalid;
+
+        b8 is_free = false;
+        b8 is_used = false; // Node slot is alive
+    };
+
+    void mapping(u64 units, u32 &fl, u32 &sl) const;
+    b8 find_free(u64 units, u32 &fl, u32 &sl) const;
+
+    void insert_free(u32 node);
+    void remove_free(u32 node);
+
+    u32 create_node();
+    void destroy_node(u32 node);
+
+private:
+    hk::vector<Node> nodes_;
+    hk::vector<u32> free_nodes_;
+
+    u32 heads_[fl_count][sl_count];
+    u64 fl_bitmap_ = 0;
+    u32 sl_bitmap_[fl_count];
+
+    u64 size_ = 0;
+    u64 used_ = 0;
+    u32 allocations_ = 0;
+    u32 free_ranges_ = 0;
+};
+
+struct Allocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    u64 offset = 0;
+    u64 size = 0;
+
+    u8 *mapped = nullptr; // Host visible memory is mapped persistently
+
+    u32 pool = 0;
+    u32 block = TLSF::invalid; // invalid for dedicated allocations
+    u32 node = TLSF::invalid;
+};
+
+struct MemoryStats {
+    struct Heap {
+        u64 size = 0;
+        u64 budget = 0; // Estimated when VK_EXT_memory_budget is missing
+        u64 usage = 0;
+        b8 device_local = false;
+    };
+
+    struct Type {
+        u32 heap = 0;
+        VkMemoryPropertyFlags flags = 0;
+
+        u32 blocks = 0;
+        u32 allocations = 0;
+        u32 dedicated = 0;
+
+        u64 reserved = 0; // Allocated from Vulkan
+        u64 used = 0;     // Handed out to resources
+        u64 largest_free = 0;
+        u32 free_ranges = 0;
+    };
+
+    hk::vector<Heap> heaps;
+    hk::vector<Type> types;
+};
+
+void init_memory(b8 has_budget_ext);
+void deinit_memory();
+
+// Linear resources (buffers) and optimal images never share blocks,
+// so bufferImageGranularity doesn't need to be respected
+Allocation allocate_memory(const VkMemoryRequirements &requirements,
+                           VkMemoryPropertyFlags properties,
+                           b8 linear, b8 dedicated = false);
+void free_memory(Allocation &allocation);
+
+HKAPI MemoryStats memory_stats();
+
+}
+
+#endif // HK_MEMORY_H
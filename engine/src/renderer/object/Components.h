@@ -0,0 +1,38 @@
+#ifndef HK_COMPONENTS_H
+#define HK_COMPONENTS_H
+
+#include "hkcommon.h"
+
+#include "Light.h"
+#include "Camera.h"
+
+/* Components SceneGraph attaches to node entities.
+ * Light and Camera are stored as they are, by value */
+namespace hk {
+
+struct SceneNode;
+
+// Links entity back to its place in SceneGraph
+struct Hierarchy {
+    SceneNode *node = nullptr;
+};
+
+struct MeshRenderer {
+    u32 mesh = 0;     // MeshAsset handle
+    u32 material = 0; // MaterialAsset handle
+};
+
+// Local space box of attached mesh
+struct Bounds {
+    hkm::vec3f min;
+    hkm::vec3f max;
+};
+
+// Tags, kept until draw context picks up the change
+struct MeshChanged {};
+struct MaterialChanged {};
+struct LightChanged {};
+
+}
+
+#endif // HK_COMPONENTS_H
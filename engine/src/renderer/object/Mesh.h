@@ -9,6 +9,10 @@ namespace hk {
 struct Mesh {
     hk::vector<Vertex> vertices;
     hk::vector<u32> indices;
+
+    // Local space bounds, used for culling
+    hkm::vec3f min;
+    hkm::vec3f max;
 };
 
 }
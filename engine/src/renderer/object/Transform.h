@@ -80,4 +80,10 @@ inline Transform operator *(const Transform &a, const Transform &b)
 {
     return Transform(a.toMat4f() * b.toMat4f());
 }
+
+inline void toMat4f(const Transform *in, hkm::mat4f *out, u32 count)
+{
+    hkm::trs(&in->pos, &in->rotation, &in->scale, sizeof(Transform), out, count);
+}
+
 #endif // HK_TRANSFORM_H
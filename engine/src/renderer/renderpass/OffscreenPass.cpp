@@ -308,6 +308,8 @@ void OffscreenPass::createRenderPass()
     err = vkCreateRenderPass(device_, &info, nullptr, &render_pass_);
     ALWAYS_ASSERT(!err, "Failed to create Vulkan Render Pass");
     hk::debug::setName(render_pass_, "Deferred RenderPass");
+
+    hk::pipeline_cache::describe_pass(render_pass_, info);
 }
 
 void OffscreenPass::loadShaders()
@@ -221,6 +221,8 @@ void PostProcessPass::createRenderPass()
     err = vkCreateRenderPass(device_, &info, nullptr, &render_pass_);
     ALWAYS_ASSERT(!err, "Failed to create Vulkan Render Pass");
     hk::debug::setName(render_pass_, "Post Process RenderPass");
+
+    hk::pipeline_cache::describe_pass(render_pass_, info);
 }
 
 void PostProcessPass::createPipeline()
@@ -130,6 +130,8 @@ void UIPass::createRenderPass()
     err = vkCreateRenderPass(device_, &info, nullptr, &render_pass_);
     ALWAYS_ASSERT(!err, "Failed to create Vulkan Render Pass");
     hk::debug::setName(render_pass_, "UI RenderPass");
+
+    hk::pipeline_cache::describe_pass(render_pass_, info);
 }
 
 }
@@ -3,30 +3,22 @@
 
 #include "hkstl/utility/hktypes.h"
 #include "hkstl/strings/hkstring.h"
+#include "hkstl/strings/hkstring_id.h"
+#include "hkstl/utility/hkhandle.h"
+
+#include <string>
 
 // FIX: temp for VkImageLayout
 #include "vendor/vulkan/vulkan.h"
 
 namespace hk {
 
-#pragma warning(disable : 4201)
-template<typename Tag>
-struct Handle {
-    union {
-        struct {
-            u32 index : 20; // 1'048'575 objects should be enough for everything
-            u32 gen   : 12;
-        };
-        u32 value = 0xdeadcell;
-    };
-};
-#pragma warning(default : 4201)
-
 using BufferHandle = Handle<struct BufferTag>;
 using ImageHandle = Handle<struct ImageTag>;
 
 struct ResourceMetadata {
-    hk::string name;
+    std::string name; // For display, id is hash only in release
+    hk::string_id id;
     struct Handle<struct ResourceTag> handle;
 };
 
@@ -2,7 +2,9 @@
 
 #include "hkvulkan.h"
 
-#include "resource_pool.h"
+#include "memory.h"
+
+#include "hkstl/containers/hkslot_map.h"
 
 #include <deque>
 
@@ -10,13 +12,25 @@ namespace hk::bkr {
 
 struct InternalBuffer {
     VkBuffer handle = VK_NULL_HANDLE;
-    VkDeviceMemory memory = VK_NULL_HANDLE;
+    Allocation memory;
 };
 
 struct InternalImage {
     VkImage handle = VK_NULL_HANDLE;
     VkImageView view = VK_NULL_HANDLE;
-    VkDeviceMemory memory = VK_NULL_HANDLE;
+    Allocation memory;
+};
+
+struct Buffer {
+    InternalBuffer data;
+    BufferDesc desc;
+    ResourceMetadata meta;
+};
+
+struct Image {
+    InternalImage data;
+    ImageDesc desc;
+    ResourceMetadata meta;
 };
 
 struct VulkanImageDesc {
@@ -26,32 +40,53 @@ struct VulkanImageDesc {
     VkImageUsageFlags usage;
     VkImageAspectFlags aspect_mask;
     VkMemoryPropertyFlags properties;
+    b8 dedicated;
 };
 
-static struct Resources {
-    template <typename T>
-    struct Slot {
-        T data;
-        u32 gen = 0;
-        b8 is_valid = false;
+/* Persistently mapped upload ring, shared by all GPU local writes
+ * Positions only grow, physical offset is position % capacity.
+ * Every flushed batch remembers where ring head was, once its fence
+ * is signaled, everything before that point can be reused */
+struct StagingRing {
+    static constexpr u64 capacity = 64 * 1024 * 1024;
+    static constexpr u32 max_batches = 3;
+
+    struct Batch {
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+        u64 end = 0;
+        b8 submitted = false;
     };
 
-    // TODO: change to more suitable structure, maybe colony, maybe pool
-    hk::vector<Slot<InternalBuffer>> buffer_pool;
-    hk::vector<Slot<InternalImage>> image_pool;
+    InternalBuffer buffer;
+    u8 *mapped = nullptr;
+    u64 alignment = 16;
 
-    // TODO: change to hk::stack
-    std::deque<u32> free_buffers;
-    std::deque<u32> free_images;
+    u64 head = 0;
+    u64 tail = 0;
 
-    hk::vector<ResourceMetadata> buffer_metas;
-    hk::vector<ResourceMetadata> image_metas;
+    Batch batches[max_batches];
+    u32 current = 0; // Batch being recorded
+    u32 oldest = 0;  // Oldest submitted batch
+    b8 recording = false;
+};
 
-    hk::vector<BufferDesc> buffer_descs;
-    hk::vector<ImageDesc> image_descs;
+// Anything destroyed while frames in flight may still use it
+struct Garbage {
+    u64 frame = 0;
 
-    u32 buffer_count;
-    u32 image_count;
+    InternalBuffer buffer;
+    InternalImage image;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+    VkDescriptorSetLayout set_layout = VK_NULL_HANDLE;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+};
+
+static struct Resources {
+    // References into pools are invalidated by create and destroy
+    hk::slot_map<Buffer, BufferHandle> buffers;
+    hk::slot_map<Image, ImageHandle> images;
 
     // std::deque<Handle> deletion_queue;
 
@@ -64,57 +99,52 @@ static struct Resources {
 
     // Descriptors?
 
+    StagingRing staging;
+
+    // Ordered by frame, destroyed once that frame is finished
+    std::deque<Garbage> garbage;
+    u64 frame = 0;
+    i64 finished_frame = -1;
+
     VkDevice device = VK_NULL_HANDLE;
 } ctx;
 
+static void init_staging();
+static void deinit_staging();
+
+static void collect_garbage(b8 all);
+
+static void record_transition(VkCommandBuffer cmd, const ImageHandle &handle,
+                              VkImageLayout target);
+
 void init()
 {
     ctx.device = hk::vkc::device();
 
     constexpr u32 initial_size = 2048;
-    ctx.buffer_pool.resize(initial_size);
-    ctx.buffer_metas.resize(initial_size);
-    ctx.buffer_descs.resize(initial_size);
-    ctx.image_pool.resize(initial_size);
-    ctx.image_metas.resize(initial_size);
-    ctx.image_descs.resize(initial_size);
-
-    ctx.free_buffers.resize(initial_size);
-    for (u32 i = initial_size - 1; i > 0; --i) {
-        ctx.free_buffers.push_back(i);
-    }
-    ctx.free_buffers.push_back(0);
+    ctx.buffers.reserve(initial_size);
+    ctx.images.reserve(initial_size);
 
-    ctx.free_images.resize(initial_size);
-    for (u32 i = initial_size - 1; i > 0; --i) {
-        ctx.free_images.push_back(i);
+    b8 has_budget = false;
+    for (auto &ext : hk::vkc::adapter_info().exts) {
+        if (!strcmp(ext.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+            has_budget = true;
+        }
     }
-    ctx.free_images.push_back(0);
+    init_memory(has_budget);
 
-    ctx.buffer_count = 0;
-    ctx.image_count = 0;
+    init_staging();
 }
 
 void deinit()
 {
     // TODO: Destroy all resources
-}
 
-u32 find_memory_idx(VkMemoryRequirements requirements, VkMemoryPropertyFlags properties)
-{
-    auto mem_properties = hk::vkc::adapter_info().memory_properties;
+    deinit_staging();
 
-    u32 mem_index = 0;
-    for (; mem_index < mem_properties.memoryTypeCount; ++mem_index) {
-        if ((requirements.memoryTypeBits & (1 << mem_index)) &&
-            (mem_properties.memoryTypes[mem_index].propertyFlags &
-            properties) == properties)
-        {
-            break;
-        }
-    }
+    collect_garbage(true);
 
-    return mem_index;
+    deinit_memory();
 }
 
 InternalBuffer allocate_buffer(const BufferDesc &desc)
@@ -143,28 +173,99 @@ InternalBuffer allocate_buffer(const BufferDesc &desc)
 
     VkMemoryPropertyFlags properties = to_vulkan(desc.access);
 
-    VkMemoryAllocateInfo alloc_info = {};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = mem_requirements.size;
-    alloc_info.memoryTypeIndex = find_memory_idx(mem_requirements, properties);
+    buffer.memory = allocate_memory(mem_requirements, properties, true);
 
-    err = vkAllocateMemory(ctx.device, &alloc_info, nullptr, &buffer.memory);
-    ALWAYS_ASSERT(!err, "Failed to allocate Vulkan Buffer Memory");
-
-    vkBindBufferMemory(ctx.device, buffer.handle, buffer.memory, 0);
+    err = vkBindBufferMemory(ctx.device, buffer.handle,
+                             buffer.memory.memory, buffer.memory.offset);
+    ALWAYS_ASSERT(!err, "Failed to bind Vulkan Buffer Memory");
 
     return buffer;
 }
 
-void deallocate_buffer(InternalBuffer &buffer)
+void deallocate_buffer(InternalBuffer &buffer);
+void deallocate_image(InternalImage &image);
+
+/* ===== Deferred destruction ===== */
+static void retire(Garbage &garbage)
 {
-    // TODO: change to 'b8 in_use'
-    if (ctx.device) { vkDeviceWaitIdle(ctx.device); }
+    // Uploads recorded now are submitted right before next frame,
+    // so next frame is the last one that may use this
+    garbage.frame = ctx.frame + 1;
+    ctx.garbage.push_back(garbage);
+}
 
-    // buffer should be valide at this point, no need for checks
+static void collect_garbage(b8 all)
+{
+    if (all && ctx.garbage.size()) { vkDeviceWaitIdle(ctx.device); }
 
-    vkDestroyBuffer(ctx.device, buffer.handle, nullptr);
-    vkFreeMemory(ctx.device, buffer.memory, nullptr);
+    while (ctx.garbage.size()) {
+        Garbage &garbage = ctx.garbage.front();
+
+        if (!all && static_cast<i64>(garbage.frame) > ctx.finished_frame) { break; }
+
+        if (garbage.buffer.handle) { deallocate_buffer(garbage.buffer); }
+        if (garbage.image.handle)  { deallocate_image(garbage.image); }
+
+        if (garbage.pipeline) {
+            vkDestroyPipeline(ctx.device, garbage.pipeline, nullptr);
+        }
+        if (garbage.pipeline_layout) {
+            vkDestroyPipelineLayout(ctx.device, garbage.pipeline_layout, nullptr);
+        }
+        if (garbage.set_layout) {
+            vkDestroyDescriptorSetLayout(ctx.device, garbage.set_layout, nullptr);
+        }
+        if (garbage.pool) {
+            vkDestroyDescriptorPool(ctx.device, garbage.pool, nullptr);
+        }
+
+        ctx.garbage.pop_front();
+    }
+}
+
+void begin_frame(u32 frames_in_flight)
+{
+    // Fence of this frame slot is signaled, so is every frame before it
+    ++ctx.frame;
+    ctx.finished_frame = static_cast<i64>(ctx.frame) - frames_in_flight;
+
+    collect_garbage(false);
+}
+
+void destroy_deferred(VkPipeline pipeline)
+{
+    if (!pipeline) { return; }
+
+    Garbage garbage;
+    garbage.pipeline = pipeline;
+    retire(garbage);
+}
+
+void destroy_deferred(VkPipelineLayout layout)
+{
+    if (!layout) { return; }
+
+    Garbage garbage;
+    garbage.pipeline_layout = layout;
+    retire(garbage);
+}
+
+void destroy_deferred(VkDescriptorSetLayout layout)
+{
+    if (!layout) { return; }
+
+    Garbage garbage;
+    garbage.set_layout = layout;
+    retire(garbage);
+}
+
+void destroy_deferred(VkDescriptorPool pool)
+{
+    if (!pool) { return; }
+
+    Garbage garbage;
+    garbage.pool = pool;
+    retire(garbage);
 }
 
 // TODO: Move to utils
@@ -174,6 +275,225 @@ constexpr u64 align_size(u64 size, u64 alignment)
     return (alignment == 0) ? size : (size + alignment - 1) & ~(alignment - 1);
 }
 
+/* ===== Staging ===== */
+static void init_staging()
+{
+    VkResult err;
+
+    StagingRing &ring = ctx.staging;
+
+    BufferDesc desc = {
+        BufferType::NONE,
+        MemoryType::CPU_UPLOAD,
+        StagingRing::capacity, 1
+    };
+
+    ring.buffer = allocate_buffer(desc);
+    ring.mapped = ring.buffer.memory.mapped;
+    ALWAYS_ASSERT(ring.mapped, "Staging Ring memory is not mapped");
+
+    // Image copies need offsets aligned to texel size as well
+    auto limits = hk::vkc::adapter_info().properties.limits;
+    if (limits.optimalBufferCopyOffsetAlignment > ring.alignment) {
+        ring.alignment = limits.optimalBufferCopyOffsetAlignment;
+    }
+
+    VkFenceCreateInfo fence_info = {};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    for (auto &batch : ring.batches) {
+        batch.cmd = hk::vkc::graphics().createCommandBuffer();
+        hk::debug::setName(batch.cmd, "Upload Command Buffer");
+
+        err = vkCreateFence(ctx.device, &fence_info, nullptr, &batch.fence);
+        ALWAYS_ASSERT(!err, "Failed to create Vulkan Fence");
+    }
+
+    ring.head = ring.tail = 0;
+    ring.current = ring.oldest = 0;
+    ring.recording = false;
+
+    hk::debug::setName(ring.buffer.handle, "Buffer - Staging Ring");
+}
+
+static void deinit_staging()
+{
+    StagingRing &ring = ctx.staging;
+    if (!ring.mapped) { return; }
+
+    flush_uploads();
+    vkDeviceWaitIdle(ctx.device);
+
+    for (auto &batch : ring.batches) {
+        vkDestroyFence(ctx.device, batch.fence, nullptr);
+        hk::vkc::graphics().freeCommandBuffer(batch.cmd);
+        batch = {};
+    }
+
+    vkDestroyBuffer(ctx.device, ring.buffer.handle, nullptr);
+    free_memory(ring.buffer.memory);
+
+    ring.mapped = nullptr;
+}
+
+// Releases ring space of finished batches, optionally blocks on oldest one
+static void reclaim_staging(b8 wait)
+{
+    StagingRing &ring = ctx.staging;
+
+    while (ring.batches[ring.oldest].submitted) {
+        StagingRing::Batch &batch = ring.batches[ring.oldest];
+
+        if (wait) {
+            vkWaitForFences(ctx.device, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+            wait = false;
+        } else if (vkGetFenceStatus(ctx.device, batch.fence) != VK_SUCCESS) {
+            break;
+        }
+
+        ring.tail = batch.end;
+        batch.submitted = false;
+        ring.oldest = (ring.oldest + 1) % StagingRing::max_batches;
+    }
+}
+
+// Command buffer of current batch, begins it on first use
+static VkCommandBuffer upload_cmd()
+{
+    StagingRing &ring = ctx.staging;
+    StagingRing::Batch &batch = ring.batches[ring.current];
+
+    if (ring.recording) { return batch.cmd; }
+
+    // Batch is reused only after GPU is done with it
+    while (batch.submitted) { reclaim_staging(true); }
+
+    VkCommandBufferBeginInfo begin_info = {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    VkResult err = vkBeginCommandBuffer(batch.cmd, &begin_info);
+    ALWAYS_ASSERT(!err, "Failed to begin upload Command Buffer");
+
+    // Destination may still be read by previously submitted frames
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(batch.cmd,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    ring.recording = true;
+
+    return batch.cmd;
+}
+
+// Returns false if size doesn't fit into ring at all
+static b8 allocate_staging(u64 size, u64 &offset)
+{
+    StagingRing &ring = ctx.staging;
+
+    if (size > StagingRing::capacity) { return false; }
+
+    for (;;) {
+        reclaim_staging(false);
+
+        // Nothing in use, start over from the beginning
+        if (ring.head == ring.tail) {
+            ring.head = ring.tail = align_size(ring.head, StagingRing::capacity);
+        }
+
+        u64 pos = align_size(ring.head, ring.alignment);
+        u64 physical = pos % StagingRing::capacity;
+
+        // Allocation never wraps, skip the rest of the ring instead
+        if (physical + size > StagingRing::capacity) {
+            pos += StagingRing::capacity - physical;
+            physical = 0;
+        }
+
+        if (pos + size - ring.tail <= StagingRing::capacity) {
+            ring.head = pos + size;
+            offset = physical;
+            return true;
+        }
+
+        // Ring is full, wait until GPU consumes something
+        flush_uploads();
+        reclaim_staging(true);
+    }
+}
+
+void flush_uploads()
+{
+    StagingRing &ring = ctx.staging;
+    if (!ring.recording) { return; }
+
+    StagingRing::Batch &batch = ring.batches[ring.current];
+
+    // Make copies visible to everything submitted after
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+    vkCmdPipelineBarrier(batch.cmd,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    VkResult err = vkEndCommandBuffer(batch.cmd);
+    ALWAYS_ASSERT(!err, "Failed to end upload Command Buffer");
+
+    vkResetFences(ctx.device, 1, &batch.fence);
+
+    err = hk::vkc::graphics().submit(batch.cmd, batch.fence);
+    ALWAYS_ASSERT(!err, "Failed to submit upload Command Buffer");
+
+    batch.end = ring.head;
+    batch.submitted = true;
+
+    ring.recording = false;
+    ring.current = (ring.current + 1) % StagingRing::max_batches;
+}
+
+void deallocate_buffer(InternalBuffer &buffer);
+
+// Fallback for data bigger than whole ring, blocks until copy is done
+template<typename Record>
+static void upload_dedicated(u64 size, const void *data, const Record &record)
+{
+    flush_uploads();
+
+    BufferDesc desc = {
+        BufferType::NONE,
+        MemoryType::CPU_UPLOAD,
+        static_cast<u32>(size), 1
+    };
+
+    InternalBuffer staging = allocate_buffer(desc);
+
+    std::memcpy(staging.memory.mapped, data, size);
+
+    hk::vkc::submitImmCmd([&](VkCommandBuffer cmd) {
+        record(cmd, staging.handle);
+    });
+
+    deallocate_buffer(staging);
+}
+
+// Immediate, only for buffers GPU is known to be done with
+void deallocate_buffer(InternalBuffer &buffer)
+{
+    // buffer should be valide at this point, no need for checks
+
+    vkDestroyBuffer(ctx.device, buffer.handle, nullptr);
+    free_memory(buffer.memory);
+}
+
 BufferHandle create_buffer(const BufferDesc &desc, const std::string &name)
 {
     auto limits = hk::vkc::adapter_info().properties.limits;
@@ -192,106 +512,85 @@ BufferHandle create_buffer(const BufferDesc &desc, const std::string &name)
 
     InternalBuffer buffer = allocate_buffer(buffer_desc);
 
-    u32 idx = ctx.free_buffers.back();
-    ctx.free_buffers.pop_back();
-
-    auto &slot = ctx.buffer_pool.at(idx);
-    slot.data = buffer;
-    slot.is_valid = true;
+    BufferHandle handle = ctx.buffers.insert({ buffer, buffer_desc, {} });
 
-    BufferHandle handle = { idx, slot.gen };
-
-    ResourceMetadata meta;
+    ResourceMetadata &meta = ctx.buffers.at(handle).meta;
     meta.name = name;
+    meta.id = hk::string_id::intern(name);
     meta.handle.value = handle.value;
 
-    ctx.buffer_metas.at(idx) = meta;
-    ctx.buffer_descs.at(idx) = buffer_desc;
-
-    ++ctx.buffer_count;
-
     hk::debug::setName(buffer.handle, "Buffer - "        + name);
-    hk::debug::setName(buffer.memory, "Buffer Memory - " + name);
 
     return handle;
 }
 
 void destroy_buffer(const BufferHandle &handle)
 {
-    // TODO: delete desc, meta, mark index free, add checks, etc
-
-    auto &slot = ctx.buffer_pool.at(handle.index);
-    ALWAYS_ASSERT(handle.gen == slot.gen);
-    ALWAYS_ASSERT(slot.is_valid);
+    Buffer &slot = ctx.buffers.at(handle);
 
-    // TODO: push to dealloc queue
-    deallocate_buffer(slot.data);
+    Garbage garbage;
+    garbage.buffer = slot.data;
+    retire(garbage);
 
-    ++slot.gen;
-    slot.is_valid = false;
-
-    ctx.free_buffers.push_back(handle.index);
+    ctx.buffers.erase(handle);
+}
 
-    --ctx.buffer_count;
+b8 is_valid(const BufferHandle &handle)
+{
+    return ctx.buffers.contains(handle);
 }
 
 void resize_buffer(const BufferHandle &handle, u32 size)
 {
-    BufferDesc &desc = ctx.buffer_descs.at(handle.index);
+    Buffer &slot = ctx.buffers.at(handle);
+
+    BufferDesc &desc = slot.desc;
     desc.size = size;
 
-    auto &slot = ctx.buffer_pool.at(handle.index);
-    ALWAYS_ASSERT(handle.gen == slot.gen);
-    ALWAYS_ASSERT(slot.is_valid);
+    // Old buffer may still be read by frames in flight
+    Garbage garbage;
+    garbage.buffer = slot.data;
+    retire(garbage);
 
-    deallocate_buffer(slot.data);
     InternalBuffer buffer = allocate_buffer(desc);
     slot.data = buffer;
 }
 
 void update_buffer(const BufferHandle &handle, const void *data)
 {
-    auto &slot = ctx.buffer_pool.at(handle.index);
-    ALWAYS_ASSERT(handle.gen == slot.gen);
-    ALWAYS_ASSERT(slot.is_valid);
+    Buffer &slot = ctx.buffers.at(handle);
 
-    BufferDesc &desc = ctx.buffer_descs.at(handle.index);
+    BufferDesc &desc = slot.desc;
 
     u32 memsize = desc.size * desc.stride;
 
     if (desc.access == MemoryType::CPU_UPLOAD) {
-        void *mapped = nullptr;
-
-        vkMapMemory(ctx.device, slot.data.memory, 0, memsize, 0, &mapped);
-        std::memcpy(mapped, data, memsize);
-        vkUnmapMemory(ctx.device, slot.data.memory);
-
+        std::memcpy(slot.data.memory.mapped, data, memsize);
         return;
     }
 
-    BufferDesc staging_desk = {
-        BufferType::NONE,
-        MemoryType::CPU_UPLOAD,
-        desc.size,
-        desc.stride
-    };
-
-    BufferHandle staging = create_buffer(staging_desk);
-    update_buffer(staging, data);
+    u64 offset = 0;
+    if (!allocate_staging(memsize, offset)) {
+        upload_dedicated(memsize, data, [&](VkCommandBuffer cmd, VkBuffer staging) {
+            VkBufferCopy region = {};
+            region.size = memsize;
+            vkCmdCopyBuffer(cmd, staging, slot.data.handle, 1, &region);
+        });
+        return;
+    }
 
-    hk::vkc::submitImmCmd([&](VkCommandBuffer cmd) {
-        VkBufferCopy copyRegion = {};
-        copyRegion.size = memsize;
-        vkCmdCopyBuffer(cmd, ctx.buffer_pool.at(staging.index).data.handle, slot.data.handle, 1, &copyRegion);
-    });
+    std::memcpy(ctx.staging.mapped + offset, data, memsize);
 
-    destroy_buffer(staging);
+    VkBufferCopy region = {};
+    region.srcOffset = offset;
+    region.size = memsize;
+    vkCmdCopyBuffer(upload_cmd(), ctx.staging.buffer.handle, slot.data.handle, 1, &region);
 }
 
 void bind_buffer(const BufferHandle &handle, VkCommandBuffer cmd)
 {
-    auto &slot = ctx.buffer_pool.at(handle.index);
-    BufferDesc &desc = ctx.buffer_descs.at(handle.index);
+    Buffer &slot = ctx.buffers.at(handle);
+    BufferDesc &desc = slot.desc;
 
     switch(desc.type) {
     case BufferType::VERTEX_BUFFER: {
@@ -307,24 +606,23 @@ void bind_buffer(const BufferHandle &handle, VkCommandBuffer cmd)
     }
 }
 
-// TODO: add checks
 const BufferDesc& desc(const BufferHandle &handle)
 {
-    return ctx.buffer_descs.at(handle.index);
+    return ctx.buffers.at(handle).desc;
 }
 const ResourceMetadata& meta(const BufferHandle &handle)
 {
-    return ctx.buffer_metas.at(handle.index);
+    return ctx.buffers.at(handle).meta;
 }
 
 VkBuffer handle(BufferHandle handle)
 {
-    return ctx.buffer_pool.at(handle.index).data.handle;
+    return ctx.buffers.at(handle).data.handle;
 }
 
-HKAPI const hk::vector<ResourceMetadata>& metadata() { return ctx.buffer_metas; }
-HKAPI const hk::vector<BufferDesc>& descriptors() { return ctx.buffer_descs; }
-HKAPI const u32 size() { return ctx.buffer_count; };
+HKAPI const ResourceMetadata& metadata(u32 i) { return ctx.buffers.value_at(i).meta; }
+HKAPI const BufferDesc& descriptor(u32 i) { return ctx.buffers.value_at(i).desc; }
+HKAPI const u32 size() { return ctx.buffers.size(); };
 
 /* ===== Images ===== */
 constexpr VkImageAspectFlags aspect_mask(const ImageDesc &desc)
@@ -448,6 +746,10 @@ constexpr VulkanImageDesc vulkan_desc(const ImageDesc &desc)
     vkdesc.tiling = VK_IMAGE_TILING_OPTIMAL;
     vkdesc.properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
+    // Attachments are big and recreated on resize, keep them out of blocks
+    vkdesc.dedicated = desc.type == ImageType::RENDER_TARGET ||
+                       desc.type == ImageType::DEPTH_BUFFER;
+
     // FIX: temp
     vkdesc.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
     vkdesc.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
@@ -482,19 +784,13 @@ InternalImage allocate_image(const VulkanImageDesc &desc)
     VkMemoryRequirements mem_requirements;
     vkGetImageMemoryRequirements(ctx.device, image.handle, &mem_requirements);
 
-    auto mem_properties = hk::vkc::adapter_info().memory_properties;
-
-    VkMemoryPropertyFlags properties = desc.properties;
+    image.memory = allocate_memory(mem_requirements, desc.properties,
+                                   desc.tiling == VK_IMAGE_TILING_LINEAR,
+                                   desc.dedicated);
 
-    VkMemoryAllocateInfo alloc_info = {};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = mem_requirements.size;
-    alloc_info.memoryTypeIndex = find_memory_idx(mem_requirements, properties);
-
-    err = vkAllocateMemory(ctx.device, &alloc_info, nullptr, &image.memory);
-    ALWAYS_ASSERT(!err, "Failed to allocate memory for Vulkan Image");
-
-    vkBindImageMemory(ctx.device, image.handle, image.memory, 0);
+    err = vkBindImageMemory(ctx.device, image.handle,
+                            image.memory.memory, image.memory.offset);
+    ALWAYS_ASSERT(!err, "Failed to bind memory for Vulkan Image");
 
     VkImageViewCreateInfo view_info = {};
     view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -520,16 +816,14 @@ InternalImage allocate_image(const VulkanImageDesc &desc)
     return image;
 }
 
+// Immediate, only for images GPU is known to be done with
 void deallocate_image(InternalImage &image)
 {
-    // TODO: change to 'b8 in_use'
-    if (ctx.device) { vkDeviceWaitIdle(ctx.device); }
-
     // image should be valide at this point, no need for checks
 
     vkDestroyImageView(ctx.device, image.view, nullptr);
     vkDestroyImage(ctx.device, image.handle, nullptr);
-    vkFreeMemory(ctx.device, image.memory, nullptr);
+    free_memory(image.memory);
 }
 
 ImageHandle create_image(const ImageDesc &desc, const std::string &name)
@@ -546,24 +840,13 @@ ImageHandle create_image(const ImageDesc &desc, const std::string &name)
 
     InternalImage image = allocate_image(vulkan_desc(image_desc));
 
-    u32 idx = ctx.free_images.back();
-    ctx.free_images.pop_back();
-
-    auto &slot = ctx.image_pool.at(idx);
-    slot.data = image;
-    slot.is_valid = true;
+    ImageHandle handle = ctx.images.insert({ image, image_desc, {} });
 
-    ImageHandle handle = { idx, slot.gen };
-
-    ResourceMetadata meta;
+    ResourceMetadata &meta = ctx.images.at(handle).meta;
     meta.name = name;
+    meta.id = hk::string_id::intern(name);
     meta.handle.value = handle.value;
 
-    ctx.image_metas.at(idx) = meta;
-    ctx.image_descs.at(idx) = image_desc;
-
-    ++ctx.image_count;
-
     VkImageLayout layout;
     switch (desc.type) {
     case ImageType::TEXTURE:
@@ -575,59 +858,37 @@ ImageHandle create_image(const ImageDesc &desc, const std::string &name)
     default: { break; }
     }
 
-    transition_image_layout(handle, layout);
+    // Goes with the rest of uploads, so creating many textures doesn't stall
+    record_transition(upload_cmd(), handle, layout);
 
     hk::debug::setName(image.handle, "Image - "        + name);
     hk::debug::setName(image.view,   "Image View - "   + name);
-    hk::debug::setName(image.memory, "Image Memory - " + name);
+    if (image.memory.block == TLSF::invalid) {
+        hk::debug::setName(image.memory.memory, "Image Memory - " + name);
+    }
 
     return handle;
 }
 
 void destroy_image(const ImageHandle &handle)
 {
-    // TODO: delete desc, meta, mark index free, add checks, etc
-
-    auto &slot = ctx.image_pool.at(handle.index);
-    ALWAYS_ASSERT(handle.gen == slot.gen);
-    ALWAYS_ASSERT(slot.is_valid);
-
-    // TODO: don't dealloc on a spot, mark for deletion and
-    // clear after sure it's not used anymore
-    deallocate_image(slot.data);
+    Image &slot = ctx.images.at(handle);
 
-    ++slot.gen;
-    slot.is_valid = false;
+    Garbage garbage;
+    garbage.image = slot.data;
+    retire(garbage);
 
-    ctx.free_images.push_back(handle.index);
-
-    --ctx.image_count;
+    ctx.images.erase(handle);
 }
 
 void write_image(const ImageHandle &handle, const void *pixels)
 {
-    auto &slot = ctx.image_pool.at(handle.index);
-    ALWAYS_ASSERT(handle.gen == slot.gen);
-    ALWAYS_ASSERT(slot.is_valid);
+    Image &slot = ctx.images.at(handle);
 
-    ImageDesc &desc = ctx.image_descs.at(handle.index);
+    ImageDesc &desc = slot.desc;
 
     u32 size = desc.width * desc.height * 4; // Assuming 4 bytes per pixel
 
-    BufferDesc staging_desc = {
-        BufferType::NONE,
-        MemoryType::CPU_UPLOAD,
-        size, 1
-    };
-
-    BufferHandle staging_buf = bkr::create_buffer(staging_desc);
-
-    bkr::update_buffer(staging_buf, pixels);
-
-    VkImageLayout old_layout = desc.layout_history.back();
-
-    transition_image_layout(handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
     // Copy from buffer to image
     VkBufferImageCopy region = {};
     region.bufferOffset = 0;
@@ -642,36 +903,46 @@ void write_image(const ImageHandle &handle, const void *pixels)
     region.imageOffset = { 0, 0, 0 };
     region.imageExtent = { desc.width, desc.height, 1 };
 
-    hk::vkc::submitImmCmd([&](VkCommandBuffer cmd) {
+    VkImageLayout old_layout = desc.layout_history.back();
+
+    auto record = [&](VkCommandBuffer cmd, VkBuffer staging) {
+        record_transition(cmd, handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
         vkCmdCopyBufferToImage(
             cmd,
-            bkr::handle(staging_buf),
+            staging,
             slot.data.handle,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
             1, &region);
-    });
 
-    transition_image_layout(handle, old_layout);
+        record_transition(cmd, handle, old_layout);
+    };
+
+    u64 offset = 0;
+    if (!allocate_staging(size, offset)) {
+        upload_dedicated(size, pixels, record);
+        return;
+    }
+
+    std::memcpy(ctx.staging.mapped + offset, pixels, size);
+    region.bufferOffset = offset;
 
-    bkr::destroy_buffer(staging_buf);
+    record(upload_cmd(), ctx.staging.buffer.handle);
 }
 
 void copy_image(const ImageHandle &src, const ImageHandle &dst)
 {
-    auto &src_slot = ctx.image_pool.at(src.index);
-    ALWAYS_ASSERT(src.gen == src_slot.gen);
-    ALWAYS_ASSERT(src_slot.is_valid);
+    Image &src_slot = ctx.images.at(src);
+    Image &dst_slot = ctx.images.at(dst);
 
-    auto &dst_slot = ctx.image_pool.at(dst.index);
-    ALWAYS_ASSERT(dst.gen == dst_slot.gen);
-    ALWAYS_ASSERT(dst_slot.is_valid);
-
-    ImageDesc &src_desc = ctx.image_descs.at(src.index);
-    ImageDesc &dst_desc = ctx.image_descs.at(dst.index);
+    ImageDesc &src_desc = src_slot.desc;
+    ImageDesc &dst_desc = dst_slot.desc;
 
     ALWAYS_ASSERT(src_desc.width == dst_desc.width);
     ALWAYS_ASSERT(src_desc.height == dst_desc.height);
 
+    flush_uploads();
+
     VkImageLayout src_old_layout = src_desc.layout_history.back();
     transition_image_layout(src, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
 
@@ -704,20 +975,15 @@ void copy_image(const ImageHandle &src, const ImageHandle &dst)
     transition_image_layout(dst, dst_old_layout);
 }
 
-void transition_image_layout(const ImageHandle &handle, VkImageLayout target)
+// Records barrier and updates tracked layout right away
+static void record_transition(VkCommandBuffer cmd, const ImageHandle &handle,
+                              VkImageLayout target)
 {
-    auto &slot = ctx.image_pool.at(handle.index);
-    ALWAYS_ASSERT(handle.gen == slot.gen);
-    ALWAYS_ASSERT(slot.is_valid);
-
-    ALWAYS_ASSERT(target != VK_IMAGE_LAYOUT_UNDEFINED,
-                  "Can't transition to undefined layout");
+    Image &slot = ctx.images.at(handle);
 
-    ImageDesc &desc = ctx.image_descs.at(handle.index);
+    ImageDesc &desc = slot.desc;
     VkImageLayout layout = desc.layout_history.back();
 
-    if (layout == target) { return; }
-
     VkImageMemoryBarrier barrier = {};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.oldLayout = layout;
@@ -740,53 +1006,68 @@ void transition_image_layout(const ImageHandle &handle, VkImageLayout target)
     VkPipelineStageFlags src_stage = pipeline_stage(layout, true);
     VkPipelineStageFlags dst_stage = pipeline_stage(target, false);
 
-    hk::vkc::submitImmCmd([&](VkCommandBuffer cmd) {
-        vkCmdPipelineBarrier(
-            cmd,
-            src_stage, dst_stage,
-            0,
-            0, nullptr,
-            0, nullptr,
-            1, &barrier
-        );
-    });
+    vkCmdPipelineBarrier(
+        cmd,
+        src_stage, dst_stage,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &barrier
+    );
 
     desc.layout_history.push_back(target);
 }
 
+void transition_image_layout(const ImageHandle &handle, VkImageLayout target)
+{
+    Image &slot = ctx.images.at(handle);
+
+    ALWAYS_ASSERT(target != VK_IMAGE_LAYOUT_UNDEFINED,
+                  "Can't transition to undefined layout");
+
+    if (slot.desc.layout_history.back() == target) { return; }
+
+    // Pending uploads were recorded against current layout
+    flush_uploads();
+
+    hk::vkc::submitImmCmd([&](VkCommandBuffer cmd) {
+        record_transition(cmd, handle, target);
+    });
+}
+
 const ImageDesc& desc(ImageHandle handle)
 {
-    return ctx.image_descs.at(handle.index);
+    return ctx.images.at(handle).desc;
 }
 
 const ResourceMetadata& meta(ImageHandle handle)
 {
-    return ctx.image_metas.at(handle.index);
+    return ctx.images.at(handle).meta;
 }
 
 VkImage image(ImageHandle handle)
 {
-    return ctx.image_pool.at(handle.index).data.handle;
+    return ctx.images.at(handle).data.handle;
 }
 
 VkImageView view(ImageHandle handle)
 {
-    return ctx.image_pool.at(handle.index).data.view;
+    return ctx.images.at(handle).data.view;
 }
 
-const hk::vector<ResourceMetadata>& image_metadata()
+const ResourceMetadata& image_metadata(u32 i)
 {
-    return ctx.image_metas;
+    return ctx.images.value_at(i).meta;
 }
 
-const hk::vector<ImageDesc>& image_descriptors()
+const ImageDesc& image_descriptor(u32 i)
 {
-    return ctx.image_descs;
+    return ctx.images.value_at(i).desc;
 }
 
 const u32 image_size()
 {
-    return ctx.image_count;
+    return ctx.images.size();
 }
 
 // returns handle
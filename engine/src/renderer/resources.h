@@ -15,9 +15,25 @@ namespace hk::bkr {
 void init();
 void deinit();
 
+// Uploads to GPU local resources are recorded into one command buffer
+// and submitted here, Renderer calls it once per frame before drawing
+void flush_uploads();
+
+// Called by Renderer right after waiting on frame fence,
+// destroys everything finished frames were the last to use
+void begin_frame(u32 frames_in_flight);
+
+/* ===== Deferred destruction ===== */
+// Destroyed once every frame that might still use them is finished
+void destroy_deferred(VkPipeline pipeline);
+void destroy_deferred(VkPipelineLayout layout);
+void destroy_deferred(VkDescriptorSetLayout layout);
+void destroy_deferred(VkDescriptorPool pool);
+
 /* ===== Buffers ===== */
 BufferHandle create_buffer(const BufferDesc &desc, const hk::string &name = "");
 void destroy_buffer(const BufferHandle &handle);
+b8 is_valid(const BufferHandle &handle);
 
 void resize_buffer(const BufferHandle &handle, u32 size);
 void update_buffer(const BufferHandle &handle, const void *data);
@@ -28,8 +44,10 @@ const ResourceMetadata& meta(const BufferHandle &handle);
 
 // FIX: temp
 VkBuffer handle(BufferHandle handle);
-HKAPI const hk::vector<ResourceMetadata>& metadata();
-HKAPI const hk::vector<BufferDesc>& descriptors();
+
+// Live buffers, i is in [0, size()), order changes on destroy
+HKAPI const ResourceMetadata& metadata(u32 i);
+HKAPI const BufferDesc& descriptor(u32 i);
 HKAPI const u32 size();
 
 /* ===== Images ===== */
@@ -46,8 +64,10 @@ const ResourceMetadata& meta(ImageHandle handle);
 // FIX: temp
 VkImage image(ImageHandle handle);
 VkImageView view(ImageHandle handle);
-HKAPI const hk::vector<ResourceMetadata>& image_metadata();
-HKAPI const hk::vector<ImageDesc>& image_descriptors();
+
+// Live images, i is in [0, image_size()), order changes on destroy
+HKAPI const ResourceMetadata& image_metadata(u32 i);
+HKAPI const ImageDesc& image_descriptor(u32 i);
 HKAPI const u32 image_size();
 
 /* ===== Shaders ===== */
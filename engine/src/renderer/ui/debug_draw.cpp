@@ -14,15 +14,20 @@ struct DebugShape {
     ShapeDesc info;
 
     b8 point_array = false;
+    // Range in DebugContext points
     // PERF: change to vertecies + indices if memory will become a problem
-    hk::vector<hkm::vec3f> points = {};
+    u32 first = 0;
+    u32 count = 0;
 
     // FIX: temp
     VkDescriptorSet descriptor_set;
 };
 
 static struct DebugContext {
+    // Both are cleared after draw and keep their capacity,
+    // so steady frames don't touch the heap
     hk::vector<DebugShape> shapes = {};
+    hk::vector<hkm::vec3f> points = {}; // Points of all shapes
 
     BufferHandle buf; // contains points from all shapes
 
@@ -137,6 +142,7 @@ void deinit()
 {
     bkr::destroy_buffer(ctx.buf);
     ctx.shapes.clear();
+    ctx.points.clear();
 
     ctx.line_pipeline.deinit();
     ctx.point_pipeline.deinit();
@@ -150,77 +156,55 @@ void draw(VkCommandBuffer cmd)
     hk::imgui::debug::push(ctx.point_pipeline);
     hk::imgui::debug::push(ctx.line_pipeline);
 
-    hk::vector<DebugShape> point_shapes = {};
-    hk::vector<DebugShape> line_shapes = {};
-
-    // Sort
     for (auto &shape : ctx.shapes) {
         if (shape.point_array) {
-            point_shapes.push_back(shape);
+            shape.info.thickness = ctx.large_points ?
+                hkm::clamp(shape.info.thickness,
+                           ctx.point_range.x,
+                           ctx.point_range.y) : 1.f;
         } else {
-            line_shapes.push_back(shape);
-        }
-    }
-
-    // Update buffer
-    hk::vector<hkm::vec3f> points;
-
-    for (auto &shape : point_shapes) {
-        for (u32 i = 0; i < shape.points.size(); ++i) {
-            points.push_back(shape.points[i]);
+            shape.info.thickness = ctx.wide_lines ?
+                hkm::clamp(shape.info.thickness,
+                           ctx.line_range.x,
+                           ctx.line_range.y) : 1.f;
         }
-
-        shape.info.thickness = ctx.large_points ?
-            hkm::clamp(shape.info.thickness,
-                       ctx.point_range.x,
-                       ctx.point_range.y) : 1.f;
-    }
-
-    for (auto &shape : line_shapes) {
-        for (u32 i = 0; i < shape.points.size(); ++i) {
-            points.push_back(shape.points[i]);
-        }
-
-        shape.info.thickness = ctx.wide_lines ?
-            hkm::clamp(shape.info.thickness,
-                       ctx.line_range.x,
-                       ctx.line_range.y) : 1.f;
     }
 
     // Resize buffer if needed
-    if (bkr::desc(ctx.buf).size <= points.size()) {
-        bkr::resize_buffer(ctx.buf, points.size());
+    if (bkr::desc(ctx.buf).size <= ctx.points.size()) {
+        bkr::resize_buffer(ctx.buf, ctx.points.size());
     }
 
-    bkr::update_buffer(ctx.buf, points.data());
+    bkr::update_buffer(ctx.buf, ctx.points.data());
 
-    // Draw
-    u32 offset = 0;
+    // Draw, shapes use their own ranges of the buffer, no sorting needed
     bkr::bind_buffer(ctx.buf, cmd);
 
     // Draw point shapes
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, ctx.point_pipeline.handle());
 
-    for (auto &shape : point_shapes) {
+    for (auto &shape : ctx.shapes) {
+        if (!shape.point_array) { continue; }
+
         vkCmdPushConstants(cmd, ctx.point_pipeline.layout(),
                            VK_SHADER_STAGE_ALL_GRAPHICS, 0,
                            sizeof(ShapeDesc), &shape.info);
 
-        vkCmdDraw(cmd, shape.points.size(), 1, offset, 0);
-        offset += shape.points.size();
+        vkCmdDraw(cmd, shape.count, 1, shape.first, 0);
     }
 
     // Draw line shapes
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, ctx.line_pipeline.handle());
 
-    for (auto &shape : line_shapes) {
+    for (auto &shape : ctx.shapes) {
+        if (shape.point_array) { continue; }
+
         vkCmdPushConstants(cmd, ctx.line_pipeline.layout(),
                            VK_SHADER_STAGE_ALL_GRAPHICS, 0,
                            sizeof(ShapeDesc), &shape.info);
 
         vkCmdSetLineWidth(cmd, shape.info.thickness);
-        vkCmdDraw(cmd, shape.points.size(), 1, offset, 0);
-        offset += shape.points.size();
+        vkCmdDraw(cmd, shape.count, 1, shape.first, 0);
     }
 
     // FIX: remove
@@ -243,21 +227,33 @@ void draw(VkCommandBuffer cmd)
     // });
 
     ctx.shapes.clear();
+    ctx.points.clear();
 }
 
 /* ===== Internal Shapes ===== */
-constexpr void point(DebugShape &out, const hkm::vec3f &pos)
+// Shape points are appended to context, shapes must be built one at a time
+inline DebugShape shape(const ShapeDesc &desc)
+{
+    DebugShape out;
+    out.info = desc;
+    out.first = ctx.points.size();
+    return out;
+}
+
+inline void point(DebugShape &out, const hkm::vec3f &pos)
 {
     out.point_array = true;
-    out.points.push_back(pos);
+    ctx.points.push_back(pos);
+    ++out.count;
 }
 
-constexpr void line(DebugShape &out,
-                    const hkm::vec3f &from, const hkm::vec3f &to)
+inline void line(DebugShape &out,
+                 const hkm::vec3f &from, const hkm::vec3f &to)
 {
     out.point_array = false;
-    out.points.push_back(from);
-    out.points.push_back(to);
+    ctx.points.push_back(from);
+    ctx.points.push_back(to);
+    out.count += 2;
 }
 
 inline void rect(DebugShape &out,
@@ -384,12 +380,20 @@ inline void sphere(DebugShape &out, const hkm::vec3f &center, f32 radius)
 /* ===== User Shapes ===== */
 void point(const ShapeDesc &desc, const hkm::vec3f &pos)
 {
-    ctx.shapes.push_back({ desc, true, { pos } });
+    DebugShape point = shape(desc);
+
+    hk::dd::point(point, pos);
+
+    ctx.shapes.push_back(point);
 }
 
 void line(const ShapeDesc &desc, const hkm::vec3f &from, const hkm::vec3f &to)
 {
-    ctx.shapes.push_back({ desc, false, { from, to }});
+    DebugShape line = shape(desc);
+
+    hk::dd::line(line, from, to);
+
+    ctx.shapes.push_back(line);
 }
 
 void rect(const ShapeDesc &desc,
@@ -397,8 +401,7 @@ void rect(const ShapeDesc &desc,
           const hkm::vec3f &p3, const hkm::vec3f &p4,
           const hkm::vec3f &normal)
 {
-    DebugShape rect;
-    rect.info = desc;
+    DebugShape rect = shape(desc);
 
     hk::dd::rect(rect, p1, p2, p3, p4, normal);
 
@@ -409,8 +412,7 @@ void circle(const ShapeDesc &desc,
             const hkm::vec3f &center, f32 radius,
             const hkm::vec3f &normal)
 {
-    DebugShape circle;
-    circle.info = desc;
+    DebugShape circle = shape(desc);
 
     hk::dd::circle(circle, center, radius, normal, 50);
 
@@ -419,8 +421,7 @@ void circle(const ShapeDesc &desc,
 
 void sphere(const ShapeDesc &desc, const hkm::vec3f &center, f32 radius)
 {
-    DebugShape sphere;
-    sphere.info = desc;
+    DebugShape sphere = shape(desc);
 
     hk::dd::sphere(sphere, center, radius);
 
@@ -429,8 +430,7 @@ void sphere(const ShapeDesc &desc, const hkm::vec3f &center, f32 radius)
 
 void view_frustum(const ShapeDesc &desc, const hkm::mat4f view_proj_inv)
 {
-    DebugShape frustum;
-    frustum.info = desc;
+    DebugShape frustum = shape(desc);
 
     hkm::vec3f planes[8] = {
         // near
@@ -467,8 +467,7 @@ void conical_frustum(const ShapeDesc &desc,
                      const hkm::vec3f &apex, f32 apex_radius,
                      const hkm::vec3f &base, f32 base_radius)
 {
-    DebugShape frustum;
-    frustum.info = desc;
+    DebugShape frustum = shape(desc);
 
     hkm::vec3f dir = normalize(base - apex);
 
@@ -489,7 +488,10 @@ void conical_frustum(const ShapeDesc &desc,
         // fan
         // line(frustum, frustum.points.at(i), frustum.points.at(i + n));
 
-        line(frustum, frustum.points.at(i), frustum.points.at(i + n * 2));
+        // Copied, push into points may reallocate them
+        hkm::vec3f from = ctx.points.at(frustum.first + i);
+        hkm::vec3f to = ctx.points.at(frustum.first + i + n * 2);
+        line(frustum, from, to);
     }
 
     ctx.shapes.push_back(frustum);
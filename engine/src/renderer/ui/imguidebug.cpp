@@ -10,7 +10,7 @@ void push(const hk::Pipeline &pipeline)
         if (ImGui::Begin("Pipeline Info")) {
             const hk::Pipeline::Info &info = pipeline.info_;
 
-            if (ImGui::TreeNode(info.name.c_str())) {
+            if (ImGui::TreeNode(hk::to_string(info.name).c_str())) {
                 if (ImGui::TreeNode("Layout Info")) {
                     ImGui::Text("Descriptor Sets: %i", info.desc_layouts.size());
 
@@ -39,9 +39,9 @@ void push(const hk::Pipeline &pipeline)
                         "Compute"
                     };
                     for (auto &stage : info.shaders) {
-                        if (!ImGui::TreeNode(stages[stage.first])) { continue; }
+                        if (!ImGui::TreeNode(stages[stage.key])) { continue; }
 
-                        const auto &shader = hk::assets()->getShader(stage.second);
+                        const auto &shader = hk::assets()->getShader(stage.value);
 
                         ImGui::Text("Name: %s", shader.name.c_str());
                         ImGui::Text("Entry Point: %s", shader.desc.entry.c_str());
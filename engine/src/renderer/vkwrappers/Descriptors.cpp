@@ -1,5 +1,11 @@
 #include "Descriptors.h"
 
+#include "renderer/resources.h"
+
+#include "hkstl/utility/hkhash.h"
+
+#include <algorithm>
+
 namespace hk {
 
 DescriptorLayout::Builder& DescriptorLayout::Builder::addBinding(
@@ -8,7 +14,7 @@ DescriptorLayout::Builder& DescriptorLayout::Builder::addBinding(
     VkShaderStageFlags stages,
     VkSampler *immutable_samplers)
 {
-    ALWAYS_ASSERT(!bindings_.count(binding),
+    ALWAYS_ASSERT(!bindings_.contains(binding),
                   "Descriptor binding:", binding, "is already in use");
 
     VkDescriptorSetLayoutBinding layout = {};
@@ -23,22 +29,107 @@ DescriptorLayout::Builder& DescriptorLayout::Builder::addBinding(
     return *this;
 }
 
+DescriptorLayout::Builder& DescriptorLayout::Builder::addReflection(
+    const hk::dxc::ShaderReflection &reflection, u32 set)
+{
+    for (const auto &binding : reflection.bindings) {
+        if (binding.set != set) { continue; }
+
+        if (!binding.count) {
+            LOG_WARN("Runtime sized binding:", binding.binding,
+                     "must be added explicitly");
+            continue;
+        }
+
+        VkDescriptorSetLayoutBinding *layout = bindings_.find(binding.binding);
+        if (!layout) {
+            addBinding(binding.binding, binding.count,
+                       binding.type, reflection.stage);
+            continue;
+        }
+
+        ALWAYS_ASSERT(layout->descriptorType == binding.type &&
+                      layout->descriptorCount == binding.count,
+                      "Shader stages disagree on binding:", binding.binding);
+
+        layout->stageFlags |= reflection.stage;
+    }
+
+    return *this;
+}
+
 hk::vector<VkDescriptorSetLayoutBinding> DescriptorLayout::Builder::build()
 {
     hk::vector<VkDescriptorSetLayoutBinding> bindings;
     for (auto &binding : bindings_) {
-        bindings.push_back(binding.second);
+        bindings.push_back(binding.value);
     }
 
     return bindings;
 }
 
+struct SharedLayout {
+    VkDescriptorSetLayout handle = VK_NULL_HANDLE;
+    StateKey key;
+    u32 refs = 0;
+};
+static hk::flat_map<u64, SharedLayout> shared_layouts;
+
+static StateKey make_layout_key(hk::vector<VkDescriptorSetLayoutBinding> bindings,
+                                VkDescriptorSetLayoutCreateFlags flags)
+{
+    // Builder output order isn't defined
+    std::sort(bindings.begin(), bindings.end(),
+              [](const auto &a, const auto &b) { return a.binding < b.binding; });
+
+    StateKey key;
+    append_key(key, flags);
+    for (const auto &binding : bindings) {
+        append_key(key, binding.binding);
+        append_key(key, binding.descriptorType);
+        append_key(key, binding.descriptorCount);
+        append_key(key, binding.stageFlags);
+
+        const u32 immutable = binding.pImmutableSamplers ? 1 : 0;
+        append_key(key, immutable);
+        if (immutable) {
+            append_key(key, binding.pImmutableSamplers,
+                       sizeof(VkSampler) * binding.descriptorCount);
+        }
+    }
+
+    return key;
+}
+
+const StateKey* layout_key(VkDescriptorSetLayout layout)
+{
+    for (const auto &shared : shared_layouts) {
+        if (shared.value.handle == layout) { return &shared.value.key; }
+    }
+
+    return nullptr;
+}
+
 void DescriptorLayout::init(
     const hk::vector<VkDescriptorSetLayoutBinding> &bindings,
     VkDescriptorSetLayoutCreateFlags flags)
 {
     VkResult err;
 
+    StateKey key = make_layout_key(bindings, flags);
+    hash_ = hk::hash_bytes(key.data(), key.size());
+
+    if (SharedLayout *shared = shared_layouts.find(hash_)) {
+        if (shared->key == key) {
+            ++shared->refs;
+            handle_ = shared->handle;
+            return;
+        }
+
+        // Hash collision, different layout gets its own handle
+        hash_ = 0;
+    }
+
     VkDescriptorSetLayoutCreateInfo info = {};
     info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
     info.pBindings = bindings.size() ? bindings.data() : nullptr;
@@ -48,15 +139,32 @@ void DescriptorLayout::init(
     VkDevice device = hk::vkc::device();
     err = vkCreateDescriptorSetLayout(device, &info, nullptr, &handle_);
     ALWAYS_ASSERT(!err, "Failed to create Vulkan Descriptor Set Layout");
+
+    if (!hash_) { return; }
+
+    SharedLayout shared;
+    shared.handle = handle_;
+    shared.key = hk::move(key);
+    shared.refs = 1;
+    shared_layouts.insert(hash_, hk::move(shared));
 }
 
 void DescriptorLayout::deinit()
 {
-    if (handle_) {
-        VkDevice device = hk::vkc::device();
-        vkDestroyDescriptorSetLayout(device, handle_, nullptr);
-        handle_ = VK_NULL_HANDLE;
+    if (!handle_) { return; }
+
+    if (hash_) {
+        SharedLayout *shared = shared_layouts.find(hash_);
+        if (shared && !--shared->refs) {
+            hk::bkr::destroy_deferred(handle_);
+            shared_layouts.erase(hash_);
+        }
+    } else {
+        hk::bkr::destroy_deferred(handle_);
     }
+
+    handle_ = VK_NULL_HANDLE;
+    hash_ = 0;
 }
 
 void DescriptorAllocator::init(
@@ -79,14 +187,14 @@ void DescriptorAllocator::init(
 
 void DescriptorAllocator::deinit()
 {
-    VkDevice device = hk::vkc::device();
+    // Sets from these pools may still be bound by frames in flight
     for (auto pool : readyPools) {
-        vkDestroyDescriptorPool(device, pool, nullptr);
+        hk::bkr::destroy_deferred(pool);
     }
     readyPools.clear();
 
     for (auto pool : fullPools) {
-        vkDestroyDescriptorPool(device, pool, nullptr);
+        hk::bkr::destroy_deferred(pool);
     }
     fullPools.clear();
 }
@@ -5,14 +5,36 @@
 
 #include "renderer/vkwrappers/vkcontext.h"
 
+#include "resources/loaders/ShaderReflection.h"
+
 #include "hkstl/containers/hkvector.h"
+#include "hkstl/containers/hkflat_map.h"
+
+#include <cstring>
 
 // TODO: replace
 #include <deque>
-#include <unordered_map>
 
 namespace hk {
 
+// Creation state as raw bytes, objects built from equal keys are shared
+using StateKey = hk::vector<u8>;
+
+inline void append_key(StateKey &key, const void *data, u64 size)
+{
+    if (!size) { return; }
+
+    const u32 at = key.size();
+    key.resize(at + static_cast<u32>(size));
+    std::memcpy(key.data() + at, data, size);
+}
+
+template<typename T>
+inline void append_key(StateKey &key, const T &value)
+{
+    append_key(key, &value, sizeof(T));
+}
+
 class DescriptorLayout {
 public:
     class Builder {
@@ -22,10 +44,15 @@ public:
                             VkShaderStageFlags stages,
                             VkSampler *immutable_samplers = VK_NULL_HANDLE);
 
+        // Adds bindings of set shader declares, shared bindings
+        // are merged, so call it once per pipeline stage
+        Builder& addReflection(const hk::dxc::ShaderReflection &reflection,
+                               u32 set);
+
         hk::vector<VkDescriptorSetLayoutBinding> build();
 
     private:
-        std::unordered_map<u32, VkDescriptorSetLayoutBinding> bindings_ = {};
+        hk::flat_map<u32, VkDescriptorSetLayoutBinding> bindings_;
     };
 
 public:
@@ -46,8 +73,15 @@ public:
 
 private:
     VkDescriptorSetLayout handle_ = VK_NULL_HANDLE;
+
+    // Identical layouts are shared, so pipelines using them can be too,
+    // 0 when layout isn't shared
+    u64 hash_ = 0;
 };
 
+// Content key of layout made by DescriptorLayout, nullptr for others
+const StateKey* layout_key(VkDescriptorSetLayout layout);
+
 
 class DescriptorAllocator {
 public:
@@ -2,12 +2,17 @@
 
 #include "renderer/vkwrappers/vkcontext.h"
 #include "renderer/vkwrappers/vkdebug.h"
+#include "renderer/resources.h"
 
 #include "resources/AssetManager.h"
 
+#include "platform/filesystem.h"
+
 #include "hkstl/math/hkmath.h"
 #include "hkstl/numerics/hkbitflag.h"
+#include "hkstl/utility/hkhash.h"
 
+#include <cstring>
 #include <utility>
 
 namespace hk {
@@ -15,6 +20,143 @@ namespace hk {
 hk::vector<VkVertexInputAttributeDescription>
 createVertexLayout(const VertexLayout &formats, u32 binding = 0);
 
+/* ============================= Pipeline Cache ============================= */
+static struct PipelineCacheContext {
+    struct Entry {
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        StateKey key; // Compared on hit, hash alone may collide
+        u32 refs = 0;
+    };
+
+    hk::flat_map<u64, Entry> pipelines;
+
+    // Live render pass -> its compatibility description
+    hk::flat_map<u64, StateKey> passes;
+
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    std::string path;
+} cache_ctx;
+
+// Blob from another driver or device is not an error, just useless
+static b8 valid_cache_blob(const hk::vector<u8> &blob)
+{
+    if (blob.size() < sizeof(VkPipelineCacheHeaderVersionOne)) { return false; }
+
+    VkPipelineCacheHeaderVersionOne header;
+    std::memcpy(&header, blob.data(), sizeof(header));
+
+    const VkPhysicalDeviceProperties &properties =
+        hk::vkc::adapter_info().properties;
+
+    return header.headerSize >= sizeof(header) &&
+           header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           header.vendorID == properties.vendorID &&
+           header.deviceID == properties.deviceID &&
+           !std::memcmp(header.pipelineCacheUUID,
+                        properties.pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+namespace pipeline_cache {
+
+void init(const std::string &path)
+{
+    VkResult err;
+
+    cache_ctx.path = path;
+
+    hk::vector<u8> blob;
+    if (hk::filesystem::exists(path) && hk::filesystem::read_file(path, blob)) {
+        if (!valid_cache_blob(blob)) {
+            LOG_INFO("Pipeline cache is from another device, discarding");
+            blob.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    info.initialDataSize = blob.size();
+    info.pInitialData = blob.size() ? blob.data() : nullptr;
+
+    err = vkCreatePipelineCache(hk::vkc::device(), &info, nullptr, &cache_ctx.cache);
+    ALWAYS_ASSERT(!err, "Failed to create Vulkan Pipeline Cache");
+
+    hk::debug::setName(cache_ctx.cache, "Pipeline Cache");
+}
+
+void deinit()
+{
+    VkDevice device = hk::vkc::device();
+
+    if (cache_ctx.pipelines.size()) {
+        LOG_WARN("Pipelines alive on cache deinit:", cache_ctx.pipelines.size());
+    }
+
+    for (auto &entry : cache_ctx.pipelines) {
+        hk::bkr::destroy_deferred(entry.value.pipeline);
+        hk::bkr::destroy_deferred(entry.value.layout);
+    }
+    cache_ctx.pipelines.clear();
+    cache_ctx.passes.clear();
+
+    if (!cache_ctx.cache) { return; }
+
+    size_t size = 0;
+    vkGetPipelineCacheData(device, cache_ctx.cache, &size, nullptr);
+
+    hk::vector<u8> blob(size);
+    if (size && vkGetPipelineCacheData(device, cache_ctx.cache,
+                                       &size, blob.data()) == VK_SUCCESS)
+    {
+        if (!hk::filesystem::write_file(cache_ctx.path, blob.data(), size)) {
+            LOG_WARN("Failed to save pipeline cache:", cache_ctx.path);
+        }
+    }
+
+    vkDestroyPipelineCache(device, cache_ctx.cache, nullptr);
+    cache_ctx.cache = VK_NULL_HANDLE;
+}
+
+u32 size()
+{
+    return cache_ctx.pipelines.size();
+}
+
+void describe_pass(VkRenderPass pass, const VkRenderPassCreateInfo &info)
+{
+    // Only what render pass compatibility depends on
+    StateKey key;
+    append_key(key, info.attachmentCount);
+    for (u32 i = 0; i < info.attachmentCount; ++i) {
+        append_key(key, info.pAttachments[i].format);
+        append_key(key, info.pAttachments[i].samples);
+    }
+
+    auto append_refs = [&key](const VkAttachmentReference *refs, u32 count) {
+        append_key(key, count);
+        for (u32 i = 0; refs && i < count; ++i) {
+            append_key(key, refs[i].attachment);
+        }
+    };
+
+    append_key(key, info.subpassCount);
+    for (u32 i = 0; i < info.subpassCount; ++i) {
+        const VkSubpassDescription &subpass = info.pSubpasses[i];
+
+        append_key(key, subpass.pipelineBindPoint);
+        append_refs(subpass.pInputAttachments, subpass.inputAttachmentCount);
+        append_refs(subpass.pColorAttachments, subpass.colorAttachmentCount);
+        append_refs(subpass.pResolveAttachments,
+                    subpass.pResolveAttachments ? subpass.colorAttachmentCount : 0);
+        append_refs(subpass.pDepthStencilAttachment,
+                    subpass.pDepthStencilAttachment ? 1 : 0);
+    }
+
+    cache_ctx.passes[reinterpret_cast<u64>(pass)] = hk::move(key);
+}
+
+}
+
 /* ================================ Pipeline ================================ */
 void Pipeline::init(VkPipeline pipeline, VkPipelineLayout layout)
 {
@@ -24,10 +166,24 @@ void Pipeline::init(VkPipeline pipeline, VkPipelineLayout layout)
 
 void Pipeline::deinit()
 {
-    VkDevice device = hk::vkc::device();
+    if (hash_) {
+        // Missing entry means cache was already torn down
+        PipelineCacheContext::Entry *entry = cache_ctx.pipelines.find(hash_);
+        if (entry && !--entry->refs) {
+            // Frames in flight may still be bound to it
+            hk::bkr::destroy_deferred(entry->pipeline);
+            hk::bkr::destroy_deferred(entry->layout);
+
+            cache_ctx.pipelines.erase(hash_);
+        }
+    } else {
+        hk::bkr::destroy_deferred(handle_);
+        hk::bkr::destroy_deferred(layout_);
+    }
 
-    vkDestroyPipeline(device, handle_, nullptr);
-    vkDestroyPipelineLayout(device, layout_, nullptr);
+    handle_ = VK_NULL_HANDLE;
+    layout_ = VK_NULL_HANDLE;
+    hash_ = 0;
 }
 
 void Pipeline::bind(VkCommandBuffer cmd, VkPipelineBindPoint bind_point)
@@ -35,10 +191,20 @@ void Pipeline::bind(VkCommandBuffer cmd, VkPipelineBindPoint bind_point)
     vkCmdBindPipeline(cmd, bind_point, handle_);
 }
 
+VkShaderStageFlags Pipeline::push_stages() const
+{
+    VkShaderStageFlags stages = 0;
+    for (const auto &range : info_.push_ranges) {
+        stages |= range.stageFlags;
+    }
+
+    return stages;
+}
+
 /* ============================ Pipeline Builder ============================ */
 void PipelineBuilder::setName(const std::string &name)
 {
-    out_.info_.name = name;
+    out_.info_.name = hk::string_id::intern(name);
 }
 
 void PipelineBuilder::setDescriptors(
@@ -90,16 +256,39 @@ void PipelineBuilder::setShader(u32 hndl_shader)
     stage_info.pName = shader.desc.entry.c_str();
 
     u32 type = static_cast<u32>(shader.desc.type);
-    if (out_.info_.shaders.count(type)) {
+    if (out_.info_.shaders.contains(type)) {
         LOG_WARN("Can't overwrite shaders in pipeline");
         return;
     }
 
     shader_stages_.push_back(stage_info);
+    reflections_.push_back(&shader.reflection);
+    shader_hashes_.push_back(
+        hk::hash_bytes(shader.code.data(), sizeof(u32) * shader.code.size()));
 
     out_.info_.shaders[type] = hndl_shader;
 }
 
+void PipelineBuilder::setVertexLayout(u32 stride)
+{
+    const hk::dxc::ShaderReflection *vertex = nullptr;
+    for (const auto *reflection : reflections_) {
+        if (reflection->stage == VK_SHADER_STAGE_VERTEX_BIT) { vertex = reflection; }
+    }
+    ALWAYS_ASSERT(vertex, "Vertex layout is reflected from vertex shader, "
+                  "but it's not set");
+
+    hk::VertexLayout layout;
+    for (const auto &input : vertex->inputs) {
+        // hk::createVertexLayout assigns locations by index
+        ALWAYS_ASSERT(input.location == layout.size(),
+                      "Vertex inputs must have consecutive locations");
+        layout.push_back(input.format);
+    }
+
+    setVertexLayout(stride, layout);
+}
+
 void PipelineBuilder::setVertexLayout(
     u32 stride, const hk::VertexLayout &layout)
 {
@@ -279,10 +468,143 @@ void PipelineBuilder::setDynamicStates(const hk::vector<VkDynamicState> &states)
     dynamic_state_.pDynamicStates = dynamic_states_.data();
 }
 
+StateKey PipelineBuilder::key(VkRenderPass pass, u32 subpass) const
+{
+    StateKey key;
+
+    auto mix = [&key](const void *data, u64 size) {
+        append_key(key, size);
+        append_key(key, data, size);
+    };
+    auto mix_value = [&key](u64 value) {
+        append_key(key, value);
+    };
+
+    /* ===== Render Pass ===== */
+    // Dynamic rendering has no pass, its formats are mixed in below
+    if (const StateKey *desc = cache_ctx.passes.find(reinterpret_cast<u64>(pass))) {
+        mix(desc->data(), desc->size());
+    } else {
+        if (pass) { LOG_WARN("Render pass isn't described to pipeline cache"); }
+        mix(&pass, sizeof(pass));
+    }
+    mix_value(subpass);
+
+    /* ===== Pipeline Layout ===== */
+    mix_value(desc_layouts_.size());
+    for (VkDescriptorSetLayout layout : desc_layouts_) {
+        // Layouts made elsewhere live as long as renderer, handle is enough
+        if (const StateKey *desc = layout_key(layout)) {
+            mix(desc->data(), desc->size());
+        } else {
+            mix(&layout, sizeof(layout));
+        }
+    }
+    mix(push_ranges_.data(), sizeof(VkPushConstantRange) * push_ranges_.size());
+
+    /* ===== Shaders ===== */
+    // Reloaded shader has different code, so it is a new pipeline
+    for (u32 i = 0; i < shader_stages_.size(); ++i) {
+        const VkPipelineShaderStageCreateInfo &stage = shader_stages_[i];
+
+        mix_value(stage.stage);
+        mix_value(shader_hashes_[i]);
+        mix(stage.pName, std::strlen(stage.pName));
+    }
+
+    /* ===== Fixed Function ===== */
+    mix_value(vertex_input_.vertexBindingDescriptionCount);
+    mix(&vertex_binding_, sizeof(vertex_binding_));
+    mix(attribute_descs_.data(),
+        sizeof(VkVertexInputAttributeDescription) * attribute_descs_.size());
+
+    mix_value(input_assembly_.topology);
+    mix_value(input_assembly_.primitiveRestartEnable);
+    mix_value(tessellation_.patchControlPoints);
+
+    mix_value(viewport_.viewportCount);
+    mix_value(viewport_.scissorCount);
+    mix(viewports_.data(), sizeof(VkViewport) * viewports_.size());
+    mix(scissors_.data(), sizeof(VkRect2D) * scissors_.size());
+
+    mix_value(rasterizer_.depthClampEnable);
+    mix_value(rasterizer_.rasterizerDiscardEnable);
+    mix_value(rasterizer_.polygonMode);
+    mix_value(rasterizer_.cullMode);
+    mix_value(rasterizer_.frontFace);
+    mix_value(rasterizer_.depthBiasEnable);
+    mix(&rasterizer_.lineWidth, sizeof(f32));
+
+    mix_value(multisampling_.rasterizationSamples);
+    mix_value(multisampling_.sampleShadingEnable);
+    mix_value(multisampling_.alphaToCoverageEnable);
+    mix_value(multisampling_.alphaToOneEnable);
+
+    mix_value(depth_stencil_.depthTestEnable);
+    mix_value(depth_stencil_.depthWriteEnable);
+    mix_value(depth_stencil_.depthCompareOp);
+    mix_value(depth_stencil_.depthBoundsTestEnable);
+    mix_value(depth_stencil_.stencilTestEnable);
+    mix(&depth_stencil_.minDepthBounds, sizeof(f32));
+    mix(&depth_stencil_.maxDepthBounds, sizeof(f32));
+
+    mix_value(color_blending_.logicOpEnable);
+    mix_value(color_blending_.logicOp);
+    mix(blend_states_.data(),
+        sizeof(VkPipelineColorBlendAttachmentState) * blend_states_.size());
+
+    mix(dynamic_states_.data(), sizeof(VkDynamicState) * dynamic_states_.size());
+
+    /* ===== Dynamic Rendering ===== */
+    mix(colors_.data(), sizeof(VkFormat) * colors_.size());
+    mix_value(rendering_info_.depthAttachmentFormat);
+    mix_value(rendering_info_.stencilAttachmentFormat);
+
+    return key;
+}
+
 hk::Pipeline PipelineBuilder::build(VkRenderPass pass, u32 subpass)
 {
     VkResult err;
 
+    // Not set explicitly, take one range covering every shader's block
+    if (push_ranges_.empty()) {
+        VkPushConstantRange range = {};
+        for (const auto *reflection : reflections_) {
+            if (!reflection->push_size) { continue; }
+
+            range.stageFlags |= reflection->stage;
+            range.size = hkm::max(range.size, reflection->push_size);
+        }
+
+        if (range.size) { setPushConstants({ range }); }
+    }
+
+    out_.info_.push_ranges = push_ranges_;
+    out_.info_.desc_layouts = desc_layouts_;
+    out_.info_.viewports = viewports_;
+    out_.info_.dynamic_states = dynamic_states_;
+
+    StateKey state = key(pass, subpass);
+
+    // 0 is reserved for uncached pipelines
+    out_.hash_ = hk::hash_bytes(state.data(), state.size());
+    out_.hash_ = out_.hash_ ? out_.hash_ : 1;
+
+    if (PipelineCacheContext::Entry *cached = cache_ctx.pipelines.find(out_.hash_)) {
+        if (cached->key == state) {
+            ++cached->refs;
+
+            out_.handle_ = cached->pipeline;
+            out_.layout_ = cached->layout;
+
+            return out_;
+        }
+
+        // Hash collision, different pipeline is created uncached
+        out_.hash_ = 0;
+    }
+
     err = vkCreatePipelineLayout(device, &layout_info_, nullptr, &out_.layout_);
     ALWAYS_ASSERT(!err, "Failed to create Vulkan Pipeline Layout");
 
@@ -309,16 +631,22 @@ hk::Pipeline PipelineBuilder::build(VkRenderPass pass, u32 subpass)
     info.renderPass = pass;
     info.subpass = subpass;
 
-    err = vkCreateGraphicsPipelines(device, out_.cache_, 1,
+    err = vkCreateGraphicsPipelines(device, cache_ctx.cache, 1,
                                     &info, nullptr, &out_.handle_);
     ALWAYS_ASSERT(!err, "Failed to create Vulkan Graphics Pipeline");
 
-    hk::debug::setName(out_.handle_, "Pipeline - " + out_.info_.name);
-    hk::debug::setName(out_.layout_, "Pipeline Layout - " + out_.info_.name);
-    out_.info_.push_ranges = push_ranges_;
-    out_.info_.desc_layouts = desc_layouts_;
-    out_.info_.viewports = viewports_;
-    out_.info_.dynamic_states = dynamic_states_;
+    const std::string name = hk::to_string(out_.info_.name);
+    hk::debug::setName(out_.handle_, "Pipeline - " + name);
+    hk::debug::setName(out_.layout_, "Pipeline Layout - " + name);
+
+    if (!out_.hash_) { return out_; }
+
+    PipelineCacheContext::Entry entry;
+    entry.pipeline = out_.handle_;
+    entry.layout = out_.layout_;
+    entry.key = hk::move(state);
+    entry.refs = 1;
+    cache_ctx.pipelines[out_.hash_] = hk::move(entry);
 
     return out_;
 }
@@ -333,6 +661,8 @@ void PipelineBuilder::clear()
 
     /* ===== Pipeline States ===== */
     shader_stages_.clear();
+    reflections_.clear();
+    shader_hashes_.clear();
     vertex_input_ =
         { VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
     input_assembly_ =
@@ -4,11 +4,18 @@
 #include "vendor/vulkan/vulkan.h"
 
 #include "renderer/resources.h"
+#include "renderer/vkwrappers/Descriptors.h"
+
+#include "resources/loaders/ShaderReflection.h"
 
 #include "hkstl/containers/hkvector.h"
+#include "hkstl/containers/hkflat_map.h"
+#include "hkstl/strings/hkstring_id.h"
 
 namespace hk {
 
+using hk::literals::operator""_id;
+
 using VertexLayout = hk::vector<hk::Format>;
 
 enum class BlendState {
@@ -24,6 +31,9 @@ public:
 
     void bind(VkCommandBuffer cmd, VkPipelineBindPoint bind_point);
 
+    // Stages to pass to vkCmdPushConstants
+    VkShaderStageFlags push_stages() const;
+
 public:
     constexpr VkPipeline handle() const
     {
@@ -41,20 +51,21 @@ private:
     VkPipeline handle_ = VK_NULL_HANDLE;
     VkPipelineLayout layout_ = VK_NULL_HANDLE;
 
-    VkPipelineCache cache_ = VK_NULL_HANDLE;
+    // Key in pipeline cache, identical pipelines are shared
+    u64 hash_ = 0;
 
     friend class PipelineBuilder;
 
 public:
     struct Info {
-        std::string name = "Unknown";
+        hk::string_id name = "Unknown"_id;
 
         /* ===== Pipeline Layout Info ===== */
         hk::vector<VkDescriptorSetLayout> desc_layouts;
         hk::vector<VkPushConstantRange> push_ranges;
 
         /* ===== Pipeline Info ===== */
-        std::unordered_map<u32, u32> shaders; // ShaderType, handle
+        hk::flat_map<u32, u32> shaders; // ShaderType, handle
         hk::VertexLayout vertex_layout;
         VkPrimitiveTopology topology;
         hk::vector<VkViewport> viewports;
@@ -65,6 +76,23 @@ public:
     } info_;
 };
 
+/* ===== Pipeline Cache ===== */
+// Pipelines built from identical state are created once and shared,
+// driver cache blob is kept on disk between runs
+namespace pipeline_cache {
+
+void init(const std::string &path);
+void deinit();
+
+// Number of unique pipelines alive
+u32 size();
+
+// Pipelines are keyed by pass compatibility instead of its handle,
+// call right after creating render pass
+void describe_pass(VkRenderPass pass, const VkRenderPassCreateInfo &info);
+
+}
+
 class PipelineBuilder {
 public:
     PipelineBuilder() { clear(); }
@@ -81,6 +109,8 @@ public:
     /* ===== Pipeline Info ===== */
     void setShader(u32 hndl_shader);
     void setVertexLayout(u32 stride, const hk::VertexLayout &layout);
+    // Attributes are taken from vertex shader inputs, set shader first
+    void setVertexLayout(u32 stride);
     void setInputTopology(VkPrimitiveTopology topology);
     void setTessellation(u32 points_per_patch);
     void setViewports(const hk::vector<VkViewport> &viewports,
@@ -93,6 +123,11 @@ public:
     void setColors(const hk::vector<std::pair<VkFormat, BlendState>> &atts);
     void setDynamicStates(const hk::vector<VkDynamicState> &states);
 
+private:
+    // Covers every state that ends up in pipeline creation,
+    // built from contents, so reused handles never alias
+    StateKey key(VkRenderPass pass, u32 subpass) const;
+
 private:
     /* ===== Pipeline Layout ===== */
     VkPipelineLayoutCreateInfo layout_info_;
@@ -102,6 +137,8 @@ private:
 
     /* ===== Pipeline States ===== */
     hk::vector<VkPipelineShaderStageCreateInfo> shader_stages_;
+    hk::vector<const hk::dxc::ShaderReflection*> reflections_;
+    hk::vector<u64> shader_hashes_; // SPIR-V per stage
     VkPipelineVertexInputStateCreateInfo   vertex_input_;
     VkPipelineInputAssemblyStateCreateInfo input_assembly_;
     VkPipelineTessellationStateCreateInfo  tessellation_;
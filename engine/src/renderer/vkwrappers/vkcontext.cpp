@@ -1,7 +1,10 @@
 #include "vkcontext.h"
 
 #include "platform/platform.h"
+
+#ifdef HKWINDOWS
 #include "vulkan/vulkan_win32.h"
+#endif
 
 #include "vkdebug.h"
 
@@ -337,6 +340,13 @@ void create_device()
         VK_KHR_SWAPCHAIN_EXTENSION_NAME,
     };
 
+    // Optional, lets memory allocator track real budget
+    for (auto &ext : adapter_info(ctx.info_.adapter_index).exts) {
+        if (!strcmp(ext.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+            extensionsLogic.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        }
+    }
+
     VkDeviceCreateInfo device_info = {};
     device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     device_info.pQueueCreateInfos = queueCreateInfos.data();
@@ -2,8 +2,11 @@
 #define HK_ASSET_H
 
 #include "hkstl/containers/hkvector.h"
+#include "hkstl/utility/hkhandle.h"
+#include "hkstl/strings/hkstring_id.h"
 
 #include "loaders/ShaderLoader.h"
+#include "loaders/ShaderReflection.h"
 
 #include "renderer/hkvulkan.h"
 
@@ -14,14 +17,14 @@
 
 namespace hk {
 
+using AssetHandle = Handle<struct AssetTag>;
+
 struct Asset {
-    // 26 bits for index + 6 unique bits
-    // OR
-    // 20 bits for index + 6 bits for type + 6 unique bits
-    u32 handle = 0xdeadcell;
+    u32 handle = 0xdeadcell; // AssetHandle value, 0 is never a valid asset
 
     std::string name = "Undefined";
     std::string path = "Void";
+    hk::string_id id; // Of path, key in AssetManager
 
     enum class Type : u32 {
         NONE = 0,
@@ -35,18 +38,27 @@ struct Asset {
         MAX_ASSET_TYPE,
     } type;
 
+    // Async loads stay PENDING until main thread finishes them
+    enum class State : u8 {
+        READY = 0,
+        PENDING,
+        FAILED,
+    } state = State::READY;
+
     virtual ~Asset() {};
 };
 
-// TODO: rename
-constexpr u32 getIndex(u32 handle)
+inline AssetHandle toAssetHandle(u32 handle)
 {
-    return handle & ((1 << 26) - 1);
+    AssetHandle out;
+    out.value = handle;
+    return out;
 }
 
-constexpr u32 getUnique(u32 handle)
+// TODO: rename
+inline u32 getIndex(u32 handle)
 {
-    return (handle & ~((1 << 26) - 1)) >> 26;
+    return toAssetHandle(handle).index;
 }
 
 struct ShaderAsset : public Asset {
@@ -54,6 +66,8 @@ struct ShaderAsset : public Asset {
     hk::vector<u32> code;
     VkShaderModule module;
 
+    hk::dxc::ShaderReflection reflection;
+
     ~ShaderAsset() { deinit(); }
 
     void createShaderModule()
@@ -66,6 +80,8 @@ struct ShaderAsset : public Asset {
         info.codeSize = code.size() * sizeof(u32);
         info.pCode = code.data();
 
+        reflection = hk::dxc::reflect(code);
+
         err = vkCreateShaderModule(device, &info, nullptr, &module);
         ALWAYS_ASSERT(!err, "Failed to create Vulkan Shader Module");
 
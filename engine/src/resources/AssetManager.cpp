@@ -10,10 +10,52 @@
 #include "hkstl/Filewatch.h"
 #include "utils/to_string.h"
 
+#include "core/jobs.h"
+#include "core/profiler.h"
+
 #include <algorithm>
 
 namespace hk {
 
+// Async loads finished per frame, keeps GPU uploads from spiking
+static constexpr u32 max_finished_per_frame = 16;
+
+struct LoadRequest {
+    u32 handle;
+    Asset::Type type;
+    std::string path;
+
+    hk::dxc::ShaderDesc shader_desc;
+
+    // Written by worker
+    loader::ImageInfo image;
+    hk::vector<u32> code;
+    loader::ModelData *model = nullptr;
+
+    // Zero once worker is done
+    jobs::Counter counter;
+};
+
+static void load_job(void *data)
+{
+    HK_PROFILE_FUNCTION();
+
+    LoadRequest &request = *reinterpret_cast<LoadRequest*>(data);
+
+    switch (request.type) {
+    case Asset::Type::TEXTURE: {
+        request.image = hk::loader::load_image(request.path);
+    } break;
+    case Asset::Type::SHADER: {
+        request.code = hk::dxc::loadShader(request.shader_desc);
+    } break;
+    case Asset::Type::MODEL: {
+        request.model = hk::loader::importModel(request.path);
+    } break;
+    default: break;
+    }
+}
+
 AssetManager *assets()
 {
     static AssetManager *singletone = nullptr;
@@ -28,6 +70,11 @@ void AssetManager::init(const std::string &folder)
 {
     folder_ = folder;
 
+    textures_.init<TextureAsset>();
+    shaders_.init<ShaderAsset>();
+    models_.init<ModelAsset>();
+    requests_.init<LoadRequest>(16);
+
     hk::filewatch::watch(folder_,
         [this](const std::string &path, const hk::filewatch::State state)
         {
@@ -40,28 +87,41 @@ void AssetManager::init(const std::string &folder)
 
             LOG_INFO("Asset changed:", folder_ + path, to_string(state));
 
-            reload(paths_[folder_ + path]);
-
-            for (auto &callback : callbacks_.at(paths_[folder_ + path])) {
-                if (callback) { callback(); }
-            }
+            queueChange(folder_ + path);
         }
     );
 }
 
 void AssetManager::deinit()
 {
+    // Workers may still write into requests
+    for (auto *request : in_flight_) {
+        discardLoad(request);
+    }
+    in_flight_.clear();
+
     folder_ = "assets\\";
-    index_ = 0;
 
     for (auto &asset : assets_) {
         switch(asset->type) {
         case Asset::Type::TEXTURE: {
-            TextureAsset *texture = reinterpret_cast<TextureAsset*>(asset);
-            hk::bkr::destroy_image(texture->image);
+            TextureAsset *texture = static_cast<TextureAsset*>(asset);
+
+            // Pending and failed textures borrow fallback image
+            if (asset->state == Asset::State::READY) {
+                hk::bkr::destroy_image(texture->image);
+            }
+
+            hk::mem::destroy(textures_, texture);
         } break;
         case Asset::Type::SHADER: {
-            reinterpret_cast<ShaderAsset*>(asset)->deinit();
+            ShaderAsset *shader = static_cast<ShaderAsset*>(asset);
+            shader->deinit();
+
+            hk::mem::destroy(shaders_, shader);
+        } break;
+        case Asset::Type::MODEL: {
+            hk::mem::destroy(models_, static_cast<ModelAsset*>(asset));
         } break;
 
         default: break;
@@ -70,6 +130,9 @@ void AssetManager::deinit()
 
     assets_.clear();
     callbacks_.clear();
+
+    hndl_fallback_color = 0;
+    hndl_fallback_noncolor = 0;
 }
 
 u32 AssetManager::create(Asset::Type type, void *data)
@@ -96,9 +159,9 @@ u32 AssetManager::create(Asset::Type type, void *data)
     return handle;
 }
 
-u32 AssetManager::load(const std::string &path, void *data)
+b8 AssetManager::resolve(const std::string &path, std::string &out, Asset::Type &type)
 {
-    std::string out;
+    type = Asset::Type::NONE;
 
     if (hk::filesystem::find_file(folder_, path, &out)) {
         // Path inside folder_
@@ -117,7 +180,8 @@ u32 AssetManager::load(const std::string &path, void *data)
             } else {
                 LOG_WARN("File doesn't exists:", path);
                 ALWAYS_ASSERT(0, "File doesn't exists:", path); // TODO: add fallback
-                return 0;
+                out.clear();
+                return false;
             }
         } else {
             out = path;
@@ -141,22 +205,12 @@ u32 AssetManager::load(const std::string &path, void *data)
 
                     LOG_INFO("Asset changed:", file_path + path, to_string(state));
 
-                    reload(paths_[file_path + path]);
-
-                    for (auto &callback : callbacks_.at(paths_[file_path + path])) {
-                        if (callback) { callback(); }
-                    }
+                    queueChange(file_path + path);
                 }
             );
         }
     }
 
-    if (paths_.find(out) != paths_.end()) {
-        return paths_[out];
-    }
-
-    Asset::Type type = Asset::Type::NONE;
-
     u64 dotPos = path.find_last_of('.');
     std::string ext = path.substr(dotPos);
     std::transform(ext.begin(), ext.end(), ext.begin(),
@@ -181,14 +235,68 @@ u32 AssetManager::load(const std::string &path, void *data)
         type = Asset::Type::MODEL;
     } else {
         LOG_ERROR("Unknown file extension:", ext);
-        return 0xdeadcell;
+        return false;
     }
 
-    return load(out, type, data);
+    return true;
+}
+
+u32 AssetManager::find(string_id path) const
+{
+    const u32 *handle = paths_.find(path);
+    return handle && assets_.contains(toAssetHandle(*handle)) ? *handle : 0;
+}
+
+u32 AssetManager::load(const std::string &path, void *data)
+{
+    const string_id id(path);
+
+    // Path was requested before, skips file search
+    u32 handle = find(id);
+    if (!handle) {
+        std::string out;
+        Asset::Type type;
+
+        // Empty out means file was not found
+        if (!resolve(path, out, type)) { return out.empty() ? 0 : 0xdeadcell; }
+
+        handle = find(out);
+        if (!handle) {
+            handle = load(out, type, data);
+            paths_.assign(id, handle);
+            return handle;
+        }
+
+        paths_.assign(id, handle);
+    }
+
+    wait(handle);
+    return handle;
+}
+
+u32 AssetManager::loadAsync(const std::string &path, void *data)
+{
+    const string_id id(path);
+
+    u32 handle = find(id);
+    if (handle) { return handle; }
+
+    std::string out;
+    Asset::Type type;
+
+    if (!resolve(path, out, type)) { return out.empty() ? 0 : 0xdeadcell; }
+
+    handle = find(out);
+    if (!handle) { handle = startLoad(out, type, data); }
+
+    paths_.assign(id, handle);
+    return handle;
 }
 
 u32 AssetManager::load(const std::string &path, Asset::Type type, void *data)
 {
+    HK_PROFILE_FUNCTION();
+
     u32 handle = 0;
 
     switch (type) {
@@ -205,7 +313,7 @@ u32 AssetManager::load(const std::string &path, Asset::Type type, void *data)
         LOG_ERROR("Unknown asset type:", path);
     }
 
-    paths_[path] = handle;
+    paths_.assign(string_id(path), handle);
     // LOG_INFO("path:", path);
 
     hk::event::EventContext context;
@@ -216,10 +324,227 @@ u32 AssetManager::load(const std::string &path, Asset::Type type, void *data)
     return handle;
 }
 
+u32 AssetManager::startLoad(const std::string &path, Asset::Type type, void *data)
+{
+    Asset *asset = nullptr;
+    LoadRequest *request = hk::mem::create<LoadRequest>(requests_);
+
+    switch (type) {
+    case Asset::Type::TEXTURE: {
+        createFallbackTextures();
+
+        TextureAsset *texture = hk::mem::create<TextureAsset>(textures_);
+        texture->image = getTexture(hndl_fallback_color).image;
+        asset = texture;
+    } break;
+    case Asset::Type::SHADER: {
+        ShaderAsset *shader = hk::mem::create<ShaderAsset>(shaders_);
+        shader->desc = *reinterpret_cast<hk::dxc::ShaderDesc*>(data);
+        shader->module = VK_NULL_HANDLE;
+        request->shader_desc = shader->desc;
+        asset = shader;
+    } break;
+    case Asset::Type::MODEL: {
+        ModelAsset *model = hk::mem::create<ModelAsset>(models_);
+        model->hndlRootMesh = 0;
+        asset = model;
+    } break;
+    default: {
+        // Nothing to decode, created in place
+        hk::mem::destroy(requests_, request);
+        return load(path, type, data);
+    }
+    }
+
+    asset->handle = assets_.insert(asset).value;
+
+    asset->name = path.substr(path.find_last_of("/\\") + 1);
+    asset->path = path;
+    asset->id = path;
+    asset->type = type;
+    asset->state = Asset::State::PENDING;
+
+    paths_.assign(asset->id, asset->handle);
+
+    request->handle = asset->handle;
+    request->type = type;
+    request->path = path;
+
+    in_flight_.push_back(request);
+    jobs::submit({ load_job, request, &request->counter });
+
+    return asset->handle;
+}
+
+void AssetManager::finishLoad(LoadRequest *request)
+{
+    Asset *asset = get(request->handle);
+    asset->state = Asset::State::READY;
+
+    switch (request->type) {
+    case Asset::Type::TEXTURE: {
+        TextureAsset *texture = reinterpret_cast<TextureAsset*>(asset);
+        loader::ImageInfo &info = request->image;
+
+        if (!info.pixels) {
+            asset->state = Asset::State::FAILED;
+            break;
+        }
+
+        ImageDesc desc = {};
+        desc.type = ImageType::TEXTURE,
+        desc.format = hk::Format::R8G8B8A8_SRGB;
+        desc.width = info.width;
+        desc.height = info.height;
+        desc.channels = info.channels;
+
+        texture->image = hk::bkr::create_image(desc, asset->name);
+        hk::bkr::write_image(texture->image, info.pixels);
+
+        hk::loader::unload_image(info);
+    } break;
+    case Asset::Type::SHADER: {
+        ShaderAsset *shader = reinterpret_cast<ShaderAsset*>(asset);
+
+        if (request->code.size() <= 0) {
+            LOG_WARN("Shader code is empty");
+            asset->state = Asset::State::FAILED;
+            break;
+        }
+
+        shader->code = hk::move(request->code);
+        shader->createShaderModule();
+    } break;
+    case Asset::Type::MODEL: {
+        ModelAsset *model = reinterpret_cast<ModelAsset*>(asset);
+
+        if (!request->model) {
+            asset->state = Asset::State::FAILED;
+            break;
+        }
+
+        model->hndlRootMesh = hk::loader::createModel(request->model);
+    } break;
+    default: break;
+    }
+
+    hk::mem::destroy(requests_, request);
+
+    if (asset->state != Asset::State::READY) { return; }
+
+    hk::event::EventContext context;
+    context.u32[0] = asset->handle;
+    context.u32[1] = static_cast<u32>(asset->type);
+    hk::event::fire(hk::event::EVENT_ASSET_LOADED, context);
+
+    const u32 idx = getIndex(asset->handle);
+    if (idx < callbacks_.size()) {
+        for (auto &callback : callbacks_.at(idx)) {
+            if (callback) { callback(); }
+        }
+    }
+}
+
+void AssetManager::discardLoad(LoadRequest *request)
+{
+    jobs::wait(&request->counter);
+
+    hk::loader::unload_image(request->image);
+    if (request->model) { hk::loader::destroyModel(request->model); }
+
+    hk::mem::destroy(requests_, request);
+}
+
+void AssetManager::update()
+{
+    HK_PROFILE_FUNCTION();
+
+    u32 budget = max_finished_per_frame;
+
+    for (u32 i = 0; i < in_flight_.size() && budget;) {
+        LoadRequest *request = in_flight_[i];
+
+        if (request->counter.value.load(std::memory_order_acquire)) {
+            ++i;
+            continue;
+        }
+
+        // Finishing model may start new loads
+        in_flight_.erase(i);
+        finishLoad(request);
+
+        --budget;
+    }
+
+    // Watchers only queue paths, assets are touched on main thread
+    hk::vector<std::string> changed;
+    {
+        std::lock_guard<std::mutex> lock(changed_mutex_);
+        changed = hk::move(changed_);
+        changed_.clear();
+    }
+
+    for (const auto &path : changed) {
+        const u32 handle = find(path);
+        if (!handle) { continue; }
+
+        reload(handle);
+
+        const u32 idx = getIndex(handle);
+        if (idx >= callbacks_.size()) { continue; }
+
+        for (auto &callback : callbacks_.at(idx)) {
+            if (callback) { callback(); }
+        }
+    }
+}
+
+void AssetManager::queueChange(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(changed_mutex_);
+
+    // Editors often write file more than once per save
+    for (const auto &queued : changed_) {
+        if (queued == path) { return; }
+    }
+    changed_.push_back(path);
+}
+
+b8 AssetManager::ready(u32 handle) const
+{
+    return get(handle)->state != Asset::State::PENDING;
+}
+
+void AssetManager::wait(u32 handle)
+{
+    if (ready(handle)) { return; }
+
+    for (u32 i = 0; i < in_flight_.size(); ++i) {
+        LoadRequest *request = in_flight_[i];
+        if (request->handle != handle) { continue; }
+
+        jobs::wait(&request->counter);
+
+        in_flight_.erase(i);
+        finishLoad(request);
+        return;
+    }
+}
+
 void AssetManager::reload(u32 handle)
 {
     Asset *asset = get(handle);
 
+    // Load still in flight would overwrite reloaded data once finished
+    for (u32 i = 0; i < in_flight_.size(); ++i) {
+        LoadRequest *request = in_flight_[i];
+        if (request->handle != handle) { continue; }
+
+        in_flight_.erase(i);
+        discardLoad(request);
+        break;
+    }
+
     switch(asset->type) {
     case Asset::Type::SHADER: {
         ShaderAsset *shader = reinterpret_cast<ShaderAsset*>(asset);
@@ -229,13 +554,22 @@ void AssetManager::reload(u32 handle)
             return;
         }
         shader->createShaderModule();
+
+        asset->state = Asset::State::READY;
     } break;
     case Asset::Type::TEXTURE: {
         TextureAsset *texture = reinterpret_cast<TextureAsset*>(asset);
-        // not create -> reload
-        hk::bkr::destroy_image(texture->image);
 
         loader::ImageInfo info = hk::loader::load_image(texture->path);
+        if (!info.pixels) {
+            LOG_WARN("Texture was not reloaded");
+            return;
+        }
+
+        // Pending and failed textures borrow fallback image
+        if (asset->state == Asset::State::READY) {
+            hk::bkr::destroy_image(texture->image);
+        }
 
         ImageDesc desc = {};
         desc.type = ImageType::TEXTURE,
@@ -246,6 +580,10 @@ void AssetManager::reload(u32 handle)
 
         texture->image = hk::bkr::create_image(desc, asset->name);
         hk::bkr::write_image(texture->image, info.pixels);
+
+        hk::loader::unload_image(info);
+
+        asset->state = Asset::State::READY;
     } break;
     case Asset::Type::MATERIAL: {
         // TODO: do
@@ -262,21 +600,23 @@ void AssetManager::reload(u32 handle)
 
 void AssetManager::attachCallback(u32 handle, std::function<void()> callback)
 {
-    if (callbacks_.size() <= index_) {
-        callbacks_.resize(index_ + 1);
+    // Indexed by slot, sized on demand
+    const u32 idx = getIndex(handle);
+    if (callbacks_.size() <= idx) {
+        callbacks_.resize(idx + 1);
     }
 
-    callbacks_.at(getIndex(handle)).push_back(callback);
+    callbacks_.at(idx).push_back(callback);
 }
 
 u32 AssetManager::loadTexture(const std::string &path)
 {
-    TextureAsset *asset = new TextureAsset();
-    assets_.push_back(asset);
-    asset->handle = index_++;
+    TextureAsset *asset = hk::mem::create<TextureAsset>(textures_);
+    asset->handle = assets_.insert(asset).value;
 
     asset->name = path.substr(path.find_last_of("/\\") + 1);
     asset->path = path;
+    asset->id = path;
     asset->type = Asset::Type::TEXTURE;
 
     loader::ImageInfo info = hk::loader::load_image(path);
@@ -291,6 +631,8 @@ u32 AssetManager::loadTexture(const std::string &path)
     asset->image = hk::bkr::create_image(desc, asset->name);
     hk::bkr::write_image(asset->image, info.pixels);
 
+    hk::loader::unload_image(info);
+
     return asset->handle;
 }
 
@@ -305,12 +647,12 @@ u32 AssetManager::loadShader(const std::string &path, void *data)
         return 0;
     }
 
-    ShaderAsset *asset = new ShaderAsset();
-    assets_.push_back(asset);
-    asset->handle = index_++;
+    ShaderAsset *asset = hk::mem::create<ShaderAsset>(shaders_);
+    asset->handle = assets_.insert(asset).value;
 
     asset->name = path.substr(path.find_last_of("/\\") + 1);
     asset->path = path;
+    asset->id = path;
     asset->type = Asset::Type::SHADER;
     asset->desc = desc;
     asset->code = code;
@@ -321,12 +663,12 @@ u32 AssetManager::loadShader(const std::string &path, void *data)
 
 u32 AssetManager::loadModel(const std::string &path)
 {
-    ModelAsset *asset = new ModelAsset();
-    assets_.push_back(asset);
-    asset->handle = index_++;
+    ModelAsset *asset = hk::mem::create<ModelAsset>(models_);
+    asset->handle = assets_.insert(asset).value;
 
     asset->name = path.substr(path.find_last_of("/\\") + 1);
     asset->path = path;
+    asset->id = path;
     asset->type = Asset::Type::MODEL;
 
     asset->hndlRootMesh = hk::loader::loadModel(path);
@@ -337,8 +679,7 @@ u32 AssetManager::loadModel(const std::string &path)
 u32 AssetManager::createMaterial(void *data)
 {
     MaterialAsset *asset = reinterpret_cast<MaterialAsset*>(data);
-    assets_.push_back(asset);
-    asset->handle = index_++;
+    asset->handle = assets_.insert(asset).value;
 
     asset->type = Asset::Type::MATERIAL;
 
@@ -353,6 +694,19 @@ u32 AssetManager::createMaterial(void *data)
         asset->data.map_handles[i] = hndl_fallback_noncolor;
     }
 
+    // Pending textures are drawn as fallback until they are uploaded
+    const u32 hndl_material = asset->handle;
+    for (u32 i = 0; i < Material::MAX_TEXTURE_TYPE; ++i) {
+        const u32 map = asset->data.map_handles[i];
+        if (!assets_.contains(toAssetHandle(map)) || ready(map)) { continue; }
+
+        attachCallback(map, [hndl_material](){
+            hk::event::EventContext context;
+            context.u32[0] = hndl_material;
+            hk::event::fire(event::EVENT_MATERIAL_MODIFIED, context);
+        });
+    }
+
     const std::string path = "..\\engine\\assets\\shaders\\";
     asset->data.vertex_shader = hk::assets()->load(path + "Default.vert.hlsl");
     asset->data.pixel_shader = hk::assets()->load(path + "Deferred.frag.hlsl");
@@ -374,8 +728,7 @@ u32 AssetManager::createMaterial(void *data)
 u32 AssetManager::createMesh(void *data)
 {
     MeshAsset *asset = reinterpret_cast<MeshAsset*>(data);
-    assets_.push_back(asset);
-    asset->handle = index_++;
+    asset->handle = assets_.insert(asset).value;
     asset->type = Asset::Type::MESH;
 
     for (auto &mesh : asset->children) {
@@ -392,9 +745,8 @@ void AssetManager::createFallbackTextures()
     // Create fallback textures for color map and non-color maps
     hndl_fallback_color = load("PNG\\Purple\\texture_08.png");
 
-    TextureAsset *asset = new TextureAsset();
-    assets_.push_back(asset);
-    asset->handle = index_++;
+    TextureAsset *asset = hk::mem::create<TextureAsset>(textures_);
+    asset->handle = assets_.insert(asset).value;
 
     asset->name = "Fallback Transparent Texture";
     asset->type = Asset::Type::TEXTURE;
@@ -405,13 +757,8 @@ void AssetManager::createFallbackTextures()
         1, 1, 4
     }, asset->name);
 
-    u8 *data = new u8[4];
-    data[0] = 0;
-    data[1] = 0;
-    data[2] = 0;
-    data[3] = 0;
+    u8 data[4] = { 0, 0, 0, 0 };
     hk::bkr::write_image(image, data);
-    delete[] data;
 
     asset->image = image;
 
@@ -5,10 +5,17 @@
 
 #include "hkcommon.h"
 
+#include "hkstl/containers/hkslot_map.h"
+#include "hkstl/containers/hkflat_map.h"
+#include "hkstl/memory/hkpool.h"
+
 #include <functional>
+#include <mutex>
 
 namespace hk {
 
+struct LoadRequest;
+
 class AssetManager {
 public:
     void init(const std::string &folder);
@@ -20,35 +27,50 @@ public:
     HKAPI u32 load(const std::string &path, Asset::Type type, void *data = nullptr);
     HKAPI void unload(u32 handle);
 
+    // Handle of asset loaded from path, 0 when there is none.
+    // Path can be either the one load was called with or resolved one
+    HKAPI u32 find(string_id path) const;
+
+    /* Returns PENDING asset right away, decoding runs on job workers.
+     * Pending textures show fallback texture, EVENT_ASSET_LOADED
+     * and attached callbacks fire once asset is ready */
+    HKAPI u32 loadAsync(const std::string &path, void *data = nullptr);
+    HKAPI b8 ready(u32 handle) const;
+    // Blocks until asset is ready, helping workers meanwhile
+    HKAPI void wait(u32 handle);
+
+    // Finishes completed async loads, GPU uploads happen here
+    void update();
+
     void reload(u32 handle);
 
     HKAPI void attachCallback(u32 handle, std::function<void()> callback);
 
-    inline std::string getAssetName(u32 handle)
+    inline const std::string& getAssetName(u32 handle) const
     {
-        return assets_.at(getIndex(handle))->name;
+        return assets_.at(toAssetHandle(handle))->name;
     }
 
-    inline std::string getAssetPath(u32 handle)
+    inline const std::string& getAssetPath(u32 handle) const
     {
-        return assets_.at(getIndex(handle))->path;
+        return assets_.at(toAssetHandle(handle))->path;
     }
 
     // TODO: probably don't want to get access to user to Assets
     Asset* get(u32 handle) const
     {
-        return assets_.at(getIndex(handle));
+        return assets_.at(toAssetHandle(handle));
     }
 
     // template<typename Type>
     // auto get(u32 handle) const
     // {
-    //     switch(assets_.at(getIndex(handle))->type) {
+    //     switch(assets_.at(toAssetHandle(handle))->type) {
     //         case Asset::Type::TEXTURE: {
-    //             return *static_cast<hk::TextureAsset*>(assets_.at(getIndex(handle)));
+    //             return *static_cast<hk::TextureAsset*>(assets_.at(toAssetHandle(handle)));
     //         } break;
     //         case Asset::Type::SHADER: {
-    //             return *static_cast<hk::ShaderAsset*>(assets_.at(getIndex(handle)));
+    //             return *static_cast<hk::ShaderAsset*>(assets_.at(toAssetHandle(handle)));
     //         } break;
     //     }
     // }
@@ -56,36 +78,46 @@ public:
     // FIX: temp
     hk::ShaderAsset& getShader(u32 handle) const
     {
-        return *static_cast<hk::ShaderAsset*>(assets_.at(getIndex(handle)));
+        return *static_cast<hk::ShaderAsset*>(assets_.at(toAssetHandle(handle)));
     }
 
     hk::TextureAsset& getTexture(u32 handle) const
     {
-        return *static_cast<hk::TextureAsset*>(assets_.at(getIndex(handle)));
+        return *static_cast<hk::TextureAsset*>(assets_.at(toAssetHandle(handle)));
     }
 
     hk::MaterialAsset& getMaterial(u32 handle) const
     {
-        return *static_cast<hk::MaterialAsset*>(assets_.at(getIndex(handle)));
+        return *static_cast<hk::MaterialAsset*>(assets_.at(toAssetHandle(handle)));
     }
 
     hk::ModelAsset& getModel(u32 handle) const
     {
-        return *static_cast<hk::ModelAsset*>(assets_.at(getIndex(handle)));
+        return *static_cast<hk::ModelAsset*>(assets_.at(toAssetHandle(handle)));
     }
 
     hk::MeshAsset& getMesh(u32 handle) const
     {
-        return *static_cast<hk::MeshAsset*>(assets_.at(getIndex(handle)));
+        return *static_cast<hk::MeshAsset*>(assets_.at(toAssetHandle(handle)));
     }
 
 public:
     inline std::string folder() const { return folder_; }
 
     // FIX: temp
-    const hk::vector<Asset*> assets() const { return assets_; }
+    // Live assets, in no particular order
+    const hk::slot_map<Asset*, AssetHandle>& assets() const { return assets_; }
 
 private:
+    b8 resolve(const std::string &path, std::string &out, Asset::Type &type);
+    u32 startLoad(const std::string &path, Asset::Type type, void *data);
+    void finishLoad(LoadRequest *request);
+    // Waits for worker and drops its result, asset is left as is
+    void discardLoad(LoadRequest *request);
+
+    // Called from watcher threads, drained by update()
+    void queueChange(const std::string &path);
+
     u32 loadTexture(const std::string &path);
     u32 loadShader(const std::string &path, void *data);
     u32 loadModel(const std::string &path); // FIX: temp?
@@ -100,16 +132,28 @@ private:
 
     hk::vector<std::string> watched_;
 
-    u32 index_ = 0;
-    // TODO: replace with a memory pool
-    hk::vector<Asset*> assets_;
+    // Stale handles assert instead of reading reused slots
+    hk::slot_map<Asset*, AssetHandle> assets_;
+
+    // Storage for assets created by manager,
+    // material and mesh assets are owned by whoever created them
+    hk::mem::Pool textures_;
+    hk::mem::Pool shaders_;
+    hk::mem::Pool models_;
+    hk::mem::Pool requests_;
 
     // TODO: change vector of callbacks to linked list
     hk::vector<std::vector<std::function<void()>>> callbacks_;
 
-    // PERF: rethink usage of unordered_map. why even use handles,
-    // if forced to use map nonetheless
-    std::unordered_map<std::string, u32> paths_;
+    // Requested and resolved paths -> handle, repeated loads skip file search
+    hk::flat_map<string_id, u32> paths_;
+
+    // Owned by main thread, workers only write into requests
+    hk::vector<LoadRequest*> in_flight_;
+
+    // Changed files reported by watchers, reloaded in update()
+    std::mutex changed_mutex_;
+    hk::vector<std::string> changed_;
 
     u32 hndl_fallback_color;
     u32 hndl_fallback_noncolor;
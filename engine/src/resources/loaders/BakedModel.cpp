@@ -0,0 +1,326 @@
+#include "BakedModel.h"
+
+#include "platform/filesystem.h"
+
+#include <cstring>
+#include <type_traits>
+
+namespace hk::loader {
+
+/* File layout, every section is aligned to 16 bytes:
+ * Header | MeshEntry[] | MaterialEntry[] | NodeEntry[] | u32 node meshes[]
+ * | strings | vertices and indices of every mesh
+ * All offsets are from file start */
+static constexpr u32 magic = 0x4853454D; // "MESH"
+static constexpr u32 version = 2;
+static constexpr u64 alignment = 16;
+
+// Vertex arrays are written and read back with memcpy
+static_assert(std::is_trivially_copyable_v<Vertex>, "Vertex must be trivially copyable");
+
+struct StringRef {
+    u32 offset;
+    u32 size;
+};
+
+struct Header {
+    u32 magic;
+    u32 version;
+    u64 source_time;
+
+    u32 mesh_count;
+    u32 material_count;
+    u32 node_count;
+    u32 node_mesh_count;
+
+    u64 meshes_offset;
+    u64 materials_offset;
+    u64 nodes_offset;
+    u64 node_meshes_offset;
+    u64 strings_offset;
+    u64 strings_size;
+};
+
+struct MeshEntry {
+    u64 vertex_offset;
+    u64 index_offset;
+    u32 vertex_count;
+    u32 index_count;
+    u32 material;
+    u32 pad;
+
+    hkm::vec3f min;
+    hkm::vec3f max;
+};
+
+struct MaterialEntry {
+    decltype(Material::constants) constants;
+    u32 twosided;
+    StringRef name;
+    StringRef maps[Material::MAX_TEXTURE_TYPE];
+};
+
+struct NodeEntry {
+    hkm::mat4f transform;
+    i32 parent;
+    u32 first_mesh;
+    u32 mesh_count;
+    StringRef name;
+};
+
+static u64 align(u64 offset)
+{
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+std::string bakedPath(const std::string &source)
+{
+    return source + ".hkmesh";
+}
+
+static StringRef addString(hk::vector<u8> &strings, const std::string &str)
+{
+    StringRef ref = { strings.size(), static_cast<u32>(str.size()) };
+
+    for (char c : str) {
+        strings.push_back(static_cast<u8>(c));
+    }
+
+    return ref;
+}
+
+b8 bakeModel(const ModelData &model, const std::string &path)
+{
+    const u64 source_time = filesystem::last_write_time(model.path);
+    if (!source_time) { return false; }
+
+    Header header = {};
+    header.magic = magic;
+    header.version = version;
+    header.source_time = source_time;
+    header.mesh_count = model.meshes.size();
+    header.material_count = model.materials.size();
+    header.node_count = model.nodes.size();
+
+    hk::vector<u8> strings;
+    hk::vector<u32> node_meshes;
+
+    hk::vector<MaterialEntry> materials(header.material_count);
+    for (u32 i = 0; i < header.material_count; ++i) {
+        const ModelData::MaterialData &src = model.materials[i];
+        MaterialEntry &dst = materials[i];
+
+        dst.constants = src.constants;
+        dst.twosided = src.twosided;
+        dst.name = addString(strings, src.name);
+
+        for (u32 m = 0; m < Material::MAX_TEXTURE_TYPE; ++m) {
+            dst.maps[m] = addString(strings, src.maps[m]);
+        }
+    }
+
+    hk::vector<NodeEntry> nodes(header.node_count);
+    for (u32 i = 0; i < header.node_count; ++i) {
+        const ModelData::Node &src = model.nodes[i];
+        NodeEntry &dst = nodes[i];
+
+        dst.transform = src.transform;
+        dst.parent = src.parent;
+        dst.first_mesh = node_meshes.size();
+        dst.mesh_count = src.meshes.size();
+        dst.name = addString(strings, src.name);
+
+        for (u32 mesh : src.meshes) {
+            node_meshes.push_back(mesh);
+        }
+    }
+    header.node_mesh_count = node_meshes.size();
+
+    // Lay out sections
+    u64 offset = align(sizeof(Header));
+
+    header.meshes_offset = offset;
+    offset = align(offset + sizeof(MeshEntry) * header.mesh_count);
+
+    header.materials_offset = offset;
+    offset = align(offset + sizeof(MaterialEntry) * header.material_count);
+
+    header.nodes_offset = offset;
+    offset = align(offset + sizeof(NodeEntry) * header.node_count);
+
+    header.node_meshes_offset = offset;
+    offset = align(offset + sizeof(u32) * header.node_mesh_count);
+
+    header.strings_offset = offset;
+    header.strings_size = strings.size();
+    offset = align(offset + strings.size());
+
+    hk::vector<MeshEntry> meshes(header.mesh_count);
+    for (u32 i = 0; i < header.mesh_count; ++i) {
+        const Mesh &src = model.meshes[i];
+        MeshEntry &dst = meshes[i];
+
+        dst.vertex_count = src.vertices.size();
+        dst.index_count = src.indices.size();
+        dst.material = model.mesh_materials[i];
+        dst.pad = 0;
+
+        dst.min = src.min;
+        dst.max = src.max;
+
+        dst.vertex_offset = offset;
+        offset = align(offset + sizeof(Vertex) * dst.vertex_count);
+
+        dst.index_offset = offset;
+        offset = align(offset + sizeof(u32) * dst.index_count);
+    }
+
+    // Write everything into one blob
+    hk::vector<u8> blob(offset, 0);
+    u8 *data = blob.data();
+
+    auto write = [data](u64 at, const void *src, u64 size) {
+        if (size) { std::memcpy(data + at, src, size); }
+    };
+
+    write(0, &header, sizeof(Header));
+    write(header.meshes_offset, meshes.data(), sizeof(MeshEntry) * meshes.size());
+    write(header.materials_offset, materials.data(), sizeof(MaterialEntry) * materials.size());
+    write(header.nodes_offset, nodes.data(), sizeof(NodeEntry) * nodes.size());
+    write(header.node_meshes_offset, node_meshes.data(), sizeof(u32) * node_meshes.size());
+    write(header.strings_offset, strings.data(), strings.size());
+
+    for (u32 i = 0; i < header.mesh_count; ++i) {
+        const Mesh &src = model.meshes[i];
+        write(meshes[i].vertex_offset, src.vertices.data(), sizeof(Vertex) * src.vertices.size());
+        write(meshes[i].index_offset, src.indices.data(), sizeof(u32) * src.indices.size());
+    }
+
+    return filesystem::write_file(path, blob.data(), blob.size());
+}
+
+static b8 inside(const filesystem::MappedFile &file, u64 offset, u64 size)
+{
+    return offset <= file.size && size <= file.size - offset;
+}
+
+ModelData* loadBakedModel(const std::string &path, const std::string &source)
+{
+    const u64 source_time = filesystem::last_write_time(source);
+    if (!source_time || filesystem::last_write_time(path) == 0) { return nullptr; }
+
+    filesystem::MappedFile file;
+    if (!filesystem::map_file(path, file)) { return nullptr; }
+
+    Header header;
+    if (file.size < sizeof(Header)) {
+        filesystem::unmap_file(file);
+        return nullptr;
+    }
+    std::memcpy(&header, file.data, sizeof(Header));
+
+    if (header.magic != magic || header.version != version ||
+        header.source_time != source_time)
+    {
+        filesystem::unmap_file(file);
+        return nullptr;
+    }
+
+    const b8 valid =
+        inside(file, header.meshes_offset, sizeof(MeshEntry) * u64(header.mesh_count)) &&
+        inside(file, header.materials_offset, sizeof(MaterialEntry) * u64(header.material_count)) &&
+        inside(file, header.nodes_offset, sizeof(NodeEntry) * u64(header.node_count)) &&
+        inside(file, header.node_meshes_offset, sizeof(u32) * u64(header.node_mesh_count)) &&
+        inside(file, header.strings_offset, header.strings_size);
+
+    if (!valid) {
+        LOG_WARN("Baked model is corrupted:", path);
+        filesystem::unmap_file(file);
+        return nullptr;
+    }
+
+    // Sections are aligned, so entries are read in place
+    const u8 *base = file.data;
+    const MeshEntry *meshes = reinterpret_cast<const MeshEntry*>(base + header.meshes_offset);
+    const MaterialEntry *materials = reinterpret_cast<const MaterialEntry*>(base + header.materials_offset);
+    const NodeEntry *nodes = reinterpret_cast<const NodeEntry*>(base + header.nodes_offset);
+    const u32 *node_meshes = reinterpret_cast<const u32*>(base + header.node_meshes_offset);
+    const char *strings = reinterpret_cast<const char*>(base + header.strings_offset);
+
+    auto string = [&](const StringRef &ref) {
+        if (u64(ref.offset) + ref.size > header.strings_size) { return std::string(); }
+        return std::string(strings + ref.offset, ref.size);
+    };
+
+    ModelData *model = new ModelData();
+    model->path = source;
+
+    model->meshes.resize(header.mesh_count);
+    model->mesh_materials.resize(header.mesh_count);
+
+    for (u32 i = 0; i < header.mesh_count; ++i) {
+        const MeshEntry &src = meshes[i];
+        Mesh &dst = model->meshes[i];
+
+        if (!inside(file, src.vertex_offset, sizeof(Vertex) * u64(src.vertex_count)) ||
+            !inside(file, src.index_offset, sizeof(u32) * u64(src.index_count)) ||
+            src.material >= header.material_count)
+        {
+            LOG_WARN("Baked model is corrupted:", path);
+            delete model;
+            filesystem::unmap_file(file);
+            return nullptr;
+        }
+
+        model->mesh_materials[i] = src.material;
+
+        dst.min = src.min;
+        dst.max = src.max;
+
+        // PERF: Mesh owns its arrays, so this is one bulk copy per stream
+        dst.vertices.resize(src.vertex_count);
+        dst.indices.resize(src.index_count);
+        std::memcpy(dst.vertices.data(), base + src.vertex_offset, sizeof(Vertex) * src.vertex_count);
+        std::memcpy(dst.indices.data(), base + src.index_offset, sizeof(u32) * src.index_count);
+    }
+
+    model->materials.resize(header.material_count);
+    for (u32 i = 0; i < header.material_count; ++i) {
+        const MaterialEntry &src = materials[i];
+        ModelData::MaterialData &dst = model->materials[i];
+
+        dst.name = string(src.name);
+        dst.constants = src.constants;
+        dst.twosided = src.twosided;
+
+        for (u32 m = 0; m < Material::MAX_TEXTURE_TYPE; ++m) {
+            dst.maps[m] = string(src.maps[m]);
+        }
+    }
+
+    model->nodes.resize(header.node_count);
+    for (u32 i = 0; i < header.node_count; ++i) {
+        const NodeEntry &src = nodes[i];
+        ModelData::Node &dst = model->nodes[i];
+
+        dst.name = string(src.name);
+        dst.transform = src.transform;
+
+        // Parent must precede child, otherwise owners lookup breaks
+        dst.parent = src.parent < static_cast<i32>(i) ? src.parent : -1;
+
+        if (u64(src.first_mesh) + src.mesh_count > header.node_mesh_count) { continue; }
+
+        dst.meshes.reserve(src.mesh_count);
+        for (u32 m = 0; m < src.mesh_count; ++m) {
+            const u32 mesh = node_meshes[src.first_mesh + m];
+            if (mesh < header.mesh_count) { dst.meshes.push_back(mesh); }
+        }
+    }
+
+    filesystem::unmap_file(file);
+
+    return model;
+}
+
+}
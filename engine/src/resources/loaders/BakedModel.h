@@ -0,0 +1,20 @@
+#ifndef HK_BAKED_MODEL_H
+#define HK_BAKED_MODEL_H
+
+#include "ModelLoader.h"
+
+namespace hk::loader {
+
+/* Engine native model file, written next to source model.
+ * Holds everything importer produced, so repeated loads skip Assimp
+ * and read vertex and index arrays as is from mapped file */
+HKAPI std::string bakedPath(const std::string &source);
+
+HKAPI b8 bakeModel(const ModelData &model, const std::string &path);
+
+// Returns nullptr when file is missing, corrupted or older than source
+HKAPI ModelData* loadBakedModel(const std::string &path, const std::string &source);
+
+}
+
+#endif // HK_BAKED_MODEL_H
@@ -45,10 +45,14 @@ ImageInfo load_image(const hk::string &path)
     };
 
     return out;
-
-    // TODO: make unload_image or just call free on pixels later yourself
-    stbi_image_free(pixels);
 }
 
+void unload_image(ImageInfo &info)
+{
+    if (!info.pixels) { return; }
+
+    stbi_image_free(info.pixels);
+    info.pixels = nullptr;
 }
 
+}
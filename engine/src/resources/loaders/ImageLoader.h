@@ -15,6 +15,7 @@ struct ImageInfo {
 };
 
 ImageInfo load_image(const hk::string &path);
+void unload_image(ImageInfo &info);
 
 }
 
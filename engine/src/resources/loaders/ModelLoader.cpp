@@ -1,4 +1,5 @@
 #include "ModelLoader.h"
+#include "BakedModel.h"
 
 #include "resources/AssetManager.h"
 
@@ -8,117 +9,64 @@
 
 #include "hkstl/containers/hkvector.h"
 
-// TODO: replace with Hikai implementation
-#include <unordered_map>
-#include <functional>
-
 namespace hk::loader {
 
-u32 loadMaterial(const aiMaterial* material, const std::string &path)
-{
-    hk::MaterialAsset *asset = new MaterialAsset();
-
-    // path without filename
-    const std::string path_ = path.substr(0, path.find_last_of("/\\") + 1);
+// Later entries override earlier ones, PBR maps win over legacy ones
+static constexpr struct {
+    aiTextureType source;
+    Material::TextureType target;
+} texture_types[] = {
+    { aiTextureType_DIFFUSE,           Material::BASECOLOR },
+    { aiTextureType_EMISSIVE,          Material::EMISSIVE },
+    { aiTextureType_NORMALS,           Material::NORMAL },
+    { aiTextureType_SHININESS,         Material::ROUGHNESS },
+    { aiTextureType_LIGHTMAP,          Material::AMBIENT_OCCLUSION },
 
+    // PBR Materials
+    { aiTextureType_BASE_COLOR,        Material::BASECOLOR },
+    { aiTextureType_NORMAL_CAMERA,     Material::NORMAL },
+    { aiTextureType_EMISSION_COLOR,    Material::EMISSIVE },
+    { aiTextureType_METALNESS,         Material::METALNESS },
+    { aiTextureType_DIFFUSE_ROUGHNESS, Material::ROUGHNESS },
+    { aiTextureType_AMBIENT_OCCLUSION, Material::AMBIENT_OCCLUSION },
+};
+
+static void importMaterial(const aiMaterial *material, ModelData::MaterialData &out)
+{
     aiString name;
     material->Get(AI_MATKEY_NAME, name);
-    asset->name = name.C_Str();
-    asset->path = path;
-
-    hk::Material &mat = asset->data;
+    out.name = name.C_Str();
 
     // Get constants
-    material->Get(AI_MATKEY_COLOR_DIFFUSE,  mat.constants.color);
-    material->Get(AI_MATKEY_COLOR_SPECULAR, mat.constants.specular);
-    material->Get(AI_MATKEY_COLOR_AMBIENT,  mat.constants.ambient);
-    // material->Get(AI_MATKEY_COLOR_EMISSIVE, mat.constants.emissive);
-    // material->Get(AI_MATKEY_COLOR_TRANSPARENT, mat.constants.emissive);
-    // material->Get(AI_MATKEY_COLOR_REFLECTIVE,  mat.constants.emissive);
+    material->Get(AI_MATKEY_COLOR_DIFFUSE,  out.constants.color);
+    material->Get(AI_MATKEY_COLOR_SPECULAR, out.constants.specular);
+    material->Get(AI_MATKEY_COLOR_AMBIENT,  out.constants.ambient);
+    // material->Get(AI_MATKEY_COLOR_EMISSIVE, out.constants.emissive);
+    // material->Get(AI_MATKEY_COLOR_TRANSPARENT, out.constants.emissive);
+    // material->Get(AI_MATKEY_COLOR_REFLECTIVE,  out.constants.emissive);
 
-    material->Get(AI_MATKEY_TWOSIDED,       mat.twosided);
-    // material->Get(AI_MATKEY_BLEND_FUNC,       mat.constants.twosided);
+    material->Get(AI_MATKEY_TWOSIDED,       out.twosided);
+    // material->Get(AI_MATKEY_BLEND_FUNC,       out.constants.twosided);
 
-    material->Get(AI_MATKEY_OPACITY,        mat.constants.opacity);
+    material->Get(AI_MATKEY_OPACITY,        out.constants.opacity);
 
-    // material->Get(AI_MATKEY_SHININESS,    mat.constants.shininess);
-    // material->Get(AI_MATKEY_REFLECTIVITY, mat.constants.reflectivity);
-    material->Get(AI_MATKEY_METALLIC_FACTOR,  mat.constants.metalness);
-    material->Get(AI_MATKEY_ROUGHNESS_FACTOR, mat.constants.roughness);
+    // material->Get(AI_MATKEY_SHININESS,    out.constants.shininess);
+    // material->Get(AI_MATKEY_REFLECTIVITY, out.constants.reflectivity);
+    material->Get(AI_MATKEY_METALLIC_FACTOR,  out.constants.metalness);
+    material->Get(AI_MATKEY_ROUGHNESS_FACTOR, out.constants.roughness);
 
-    // Load textures
+    // Texture paths
     aiString asspath;
-    for (u32 i = 0; i < material->GetTextureCount(aiTextureType_DIFFUSE); ++i) {
-        if (material->GetTexture(aiTextureType_DIFFUSE, i, &asspath) == AI_SUCCESS) {
-            mat.map_handles[Material::BASECOLOR] = hk::assets()->load(path_ + asspath.C_Str());
-        }
-    }
-
-    for (u32 i = 0; i < material->GetTextureCount(aiTextureType_EMISSIVE); ++i) {
-        if (material->GetTexture(aiTextureType_EMISSIVE, i, &asspath) == AI_SUCCESS) {
-            mat.map_handles[Material::EMISSIVE] = hk::assets()->load(path_ + asspath.C_Str());
-        }
-    }
-
-    for (u32 i = 0; i < material->GetTextureCount(aiTextureType_NORMALS); ++i) {
-        if (material->GetTexture(aiTextureType_NORMALS, i, &asspath) == AI_SUCCESS) {
-            mat.map_handles[Material::NORMAL] = hk::assets()->load(path_ + asspath.C_Str());
-        }
-    }
-
-    for (u32 i = 0; i < material->GetTextureCount(aiTextureType_SHININESS); ++i) {
-        if (material->GetTexture(aiTextureType_SHININESS, i, &asspath) == AI_SUCCESS) {
-            mat.map_handles[Material::ROUGHNESS] = hk::assets()->load(path_ + asspath.C_Str());
-        }
-    }
-
-    for (u32 i = 0; i < material->GetTextureCount(aiTextureType_LIGHTMAP); ++i) {
-        if (material->GetTexture(aiTextureType_LIGHTMAP, i, &asspath) == AI_SUCCESS) {
-            mat.map_handles[Material::AMBIENT_OCCLUSION] = hk::assets()->load(path_ + asspath.C_Str());
-        }
-    }
-
-    // PBR Materials
-    for (u32 i = 0; i < material->GetTextureCount(aiTextureType_BASE_COLOR); ++i) {
-        if (material->GetTexture(aiTextureType_BASE_COLOR, i, &asspath) == AI_SUCCESS) {
-            mat.map_handles[Material::BASECOLOR] = hk::assets()->load(path_ + asspath.C_Str());
-        }
-    }
-
-    for (u32 i = 0; i < material->GetTextureCount(aiTextureType_NORMAL_CAMERA); ++i) {
-        if (material->GetTexture(aiTextureType_NORMAL_CAMERA, i, &asspath) == AI_SUCCESS) {
-            mat.map_handles[Material::NORMAL] = hk::assets()->load(path_ + asspath.C_Str());
-        }
-    }
-
-    for (u32 i = 0; i < material->GetTextureCount(aiTextureType_EMISSION_COLOR); ++i) {
-        if (material->GetTexture(aiTextureType_EMISSION_COLOR, i, &asspath) == AI_SUCCESS) {
-            mat.map_handles[Material::EMISSIVE] = hk::assets()->load(path_ + asspath.C_Str());
-        }
-    }
-
-    for (u32 i = 0; i < material->GetTextureCount(aiTextureType_METALNESS); ++i) {
-        if (material->GetTexture(aiTextureType_METALNESS, i, &asspath) == AI_SUCCESS) {
-            mat.map_handles[Material::METALNESS] = hk::assets()->load(path_ + asspath.C_Str());
-        }
-    }
-
-    for (u32 i = 0; i < material->GetTextureCount(aiTextureType_DIFFUSE_ROUGHNESS); ++i) {
-        if (material->GetTexture(aiTextureType_DIFFUSE_ROUGHNESS, i, &asspath) == AI_SUCCESS) {
-            mat.map_handles[Material::ROUGHNESS] = hk::assets()->load(path_ + asspath.C_Str());
-        }
-    }
-
-    for (u32 i = 0; i < material->GetTextureCount(aiTextureType_AMBIENT_OCCLUSION); ++i) {
-        if (material->GetTexture(aiTextureType_AMBIENT_OCCLUSION, i, &asspath) == AI_SUCCESS) {
-            mat.map_handles[Material::AMBIENT_OCCLUSION] = hk::assets()->load(path_ + asspath.C_Str());
+    for (const auto &type : texture_types) {
+        for (u32 i = 0; i < material->GetTextureCount(type.source); ++i) {
+            if (material->GetTexture(type.source, i, &asspath) == AI_SUCCESS) {
+                out.maps[type.target] = asspath.C_Str();
+            }
         }
     }
-
-    return hk::assets()->create(hk::Asset::Type::MATERIAL, asset);
 }
 
-u32 loadModel(const std::string &path)
+static ModelData* importAssimp(const std::string &path)
 {
     Assimp::Importer importer;
 
@@ -129,38 +77,57 @@ u32 loadModel(const std::string &path)
                 aiProcess_CalcTangentSpace;
 
     const aiScene *assimpScene = importer.ReadFile(path, flags);
-    ALWAYS_ASSERT(assimpScene, "Failed to load model:", path);
+    if (!assimpScene) {
+        LOG_ERROR("Failed to load model:", path);
+        return nullptr;
+    }
+
+    ModelData *model = new ModelData();
+    model->path = path;
 
     const u32 numMeshes = assimpScene->mNumMeshes;
     const u32 numMaterials = assimpScene->mNumMaterials;
 
-    hk::vector<Mesh> meshes;
-    hk::vector<u32> materials;
-
-    meshes.resize(numMeshes);
-    materials.reserve(numMaterials);
-
+    model->materials.resize(numMaterials);
     for (u32 i = 0; i < numMaterials; ++i) {
-        const aiMaterial* material = assimpScene->mMaterials[i];
-        u32 hndlMaterial = loadMaterial(material, path);
-        materials.push_back(hndlMaterial);
+        importMaterial(assimpScene->mMaterials[i], model->materials[i]);
     }
 
+    hk::vector<Mesh> &meshes = model->meshes;
+    meshes.resize(numMeshes);
+    model->mesh_materials.resize(numMeshes);
+
     for (u32 i = 0; i < numMeshes; ++i) {
         const aiMesh* srcMesh = assimpScene->mMeshes[i];
         Mesh &dstMesh = meshes[i];
 
-        dstMesh.vertices.resize(srcMesh->mNumVertices);
+        model->mesh_materials[i] = srcMesh->mMaterialIndex;
 
-        for (u32 v = 0; v < srcMesh->mNumVertices; ++v) {
-            Vertex &vertex = dstMesh.vertices[v];
+        // aiProcess_GenBoundingBoxes, same space as vertices
+        const aiAABB &aabb = srcMesh->mAABB;
+        dstMesh.min = hkm::vec3f(aabb.mMin.x, aabb.mMin.y, aabb.mMin.z);
+        dstMesh.max = hkm::vec3f(aabb.mMax.x, aabb.mMax.y, aabb.mMax.z);
 
-            vertex.pos       = reinterpret_cast<hkm::vec3f&>(srcMesh->mVertices[v]);
-            vertex.tc        = reinterpret_cast<hkm::vec2f&>(srcMesh->mTextureCoords[0][v]);
-            vertex.normal    = reinterpret_cast<hkm::vec3f&>(srcMesh->mNormals[v]);
-            vertex.tangent   = reinterpret_cast<hkm::vec3f&>(srcMesh->mTangents[v]);
-            vertex.bitangent = reinterpret_cast<hkm::vec3f&>(srcMesh->mBitangents[v]) * -1.f; // Flip V
-        }
+        dstMesh.vertices.resize(srcMesh->mNumVertices);
+
+        // Copy attribute streams straight into interleaved vertices
+        const u32 count = srcMesh->mNumVertices;
+        Vertex *dst = dstMesh.vertices.data();
+        constexpr u32 stride = sizeof(Vertex);
+        constexpr u32 src_stride = sizeof(aiVector3D);
+
+        hkm::copy(reinterpret_cast<const hkm::vec3f*>(srcMesh->mVertices), src_stride,
+                  &dst->pos, stride, count);
+        hkm::copy(reinterpret_cast<const hkm::vec2f*>(srcMesh->mTextureCoords[0]), src_stride,
+                  &dst->tc, stride, count);
+        hkm::copy(reinterpret_cast<const hkm::vec3f*>(srcMesh->mNormals), src_stride,
+                  &dst->normal, stride, count);
+        hkm::copy(reinterpret_cast<const hkm::vec3f*>(srcMesh->mTangents), src_stride,
+                  &dst->tangent, stride, count);
+        hkm::copy(reinterpret_cast<const hkm::vec3f*>(srcMesh->mBitangents), src_stride,
+                  &dst->bitangent, stride, count, -1.f); // Flip V
+
+        dstMesh.indices.reserve(srcMesh->mNumFaces * 3);
 
         for (u32 f = 0; f < srcMesh->mNumFaces; ++f) {
             const aiFace& face = srcMesh->mFaces[f];
@@ -171,52 +138,137 @@ u32 loadModel(const std::string &path)
         }
     }
 
-    // Recursively load mesh instances and material
-    std::function<void(aiNode*, MeshAsset *parent)> loadInstances;
-    loadInstances = [&](aiNode* node, MeshAsset *parent = nullptr)
-    {
-        MeshAsset *currentMesh;
+    // Flatten hierarchy, parents always precede children
+    hk::vector<std::pair<const aiNode*, i32>> stack;
+    stack.push_back({ assimpScene->mRootNode, -1 });
 
-        // Skip nodes without mesh
-        // TEST: this might result in skipping transforms, should test this
-        if (node->mNumMeshes > 0) {
-            currentMesh = new MeshAsset();
-            currentMesh->name = node->mName.C_Str();
-
-            if (parent) {
-                parent->children.push_back(currentMesh);
-            }
+    while (stack.size()) {
+        auto [node, parent] = stack.back();
+        stack.pop_back();
 
-            const hkm::mat4f nodeToParent = reinterpret_cast<const hkm::mat4f&>(node->mTransformation.Transpose());
-            const hkm::mat4f parentToNode = inverse(nodeToParent);
+        const i32 idx = static_cast<i32>(model->nodes.size());
+        model->nodes.emplace_back();
+        ModelData::Node &dst = model->nodes.back();
 
-            // The same node may contain multiple meshes in its space, referring to them by indices
-            for (u32 i = 0; i < node->mNumMeshes; i++) {
-                u32 meshIndex = node->mMeshes[i];
+        dst.name = node->mName.C_Str();
+        dst.parent = parent;
 
-                // Load Instances
-                currentMesh->mesh = meshes[meshIndex];
-                currentMesh->instances.push_back(nodeToParent);
-                currentMesh->instancesInv.push_back(parentToNode);
+        aiMatrix4x4 transform = node->mTransformation;
+        dst.transform = reinterpret_cast<const hkm::mat4f&>(transform.Transpose());
 
-                // Load Materials
-                const aiMesh* mesh = assimpScene->mMeshes[meshIndex];
-                currentMesh->hndlTextures.push_back(materials[mesh->mMaterialIndex]);
-            }
-        } else {
-            currentMesh = parent;
+        for (u32 i = 0; i < node->mNumMeshes; ++i) {
+            dst.meshes.push_back(node->mMeshes[i]);
         }
 
-        for (u32 i = 0; i < node->mNumChildren; i++) {
-            loadInstances(node->mChildren[i], currentMesh);
+        // Reversed, so children are visited in original order
+        for (u32 i = node->mNumChildren; i-- > 0;) {
+            stack.push_back({ node->mChildren[i], idx });
         }
-    };
+    }
+
+    return model;
+}
+
+ModelData* importModel(const std::string &path)
+{
+    const std::string baked = bakedPath(path);
+
+    ModelData *model = loadBakedModel(baked, path);
+    if (model) { return model; }
+
+    model = importAssimp(path);
+    if (!model) { return nullptr; }
+
+    if (!bakeModel(*model, baked)) {
+        LOG_WARN("Failed to bake model:", baked);
+    }
+
+    return model;
+}
+
+static u32 createMaterial(const ModelData::MaterialData &src, const std::string &path)
+{
+    hk::MaterialAsset *asset = new MaterialAsset();
+
+    // path without filename
+    const std::string path_ = path.substr(0, path.find_last_of("/\\") + 1);
+
+    asset->name = src.name;
+    asset->path = path;
+
+    hk::Material &mat = asset->data;
+    mat.constants = src.constants;
+    mat.twosided = src.twosided;
+
+    for (u32 i = 0; i < Material::MAX_TEXTURE_TYPE; ++i) {
+        if (src.maps[i].empty()) { continue; }
+        mat.map_handles[i] = hk::assets()->loadAsync(path_ + src.maps[i]);
+    }
+
+    return hk::assets()->create(hk::Asset::Type::MATERIAL, asset);
+}
+
+u32 createModel(ModelData *model)
+{
+    hk::vector<u32> materials;
+    materials.reserve(model->materials.size());
+
+    for (auto &material : model->materials) {
+        materials.push_back(createMaterial(material, model->path));
+    }
 
     MeshAsset *root = new MeshAsset();
     root->name = "Meshes";
-    loadInstances(assimpScene->mRootNode, root);
+
+    // Nodes without meshes are skipped, their children go to closest parent
+    // TEST: this might result in skipping transforms, should test this
+    hk::vector<MeshAsset*> owners(model->nodes.size());
+
+    for (u32 n = 0; n < model->nodes.size(); ++n) {
+        const ModelData::Node &node = model->nodes[n];
+        MeshAsset *parent = node.parent < 0 ? root : owners[node.parent];
+
+        if (!node.meshes.size()) {
+            owners[n] = parent;
+            continue;
+        }
+
+        MeshAsset *currentMesh = new MeshAsset();
+        currentMesh->name = node.name;
+        parent->children.push_back(currentMesh);
+        owners[n] = currentMesh;
+
+        const hkm::mat4f &nodeToParent = node.transform;
+        const hkm::mat4f parentToNode = inverse(nodeToParent);
+
+        // The same node may contain multiple meshes in its space, referring to them by indices
+        for (u32 meshIndex : node.meshes) {
+            // Load Instances
+            currentMesh->mesh = model->meshes[meshIndex];
+            currentMesh->instances.push_back(nodeToParent);
+            currentMesh->instancesInv.push_back(parentToNode);
+
+            // Load Materials
+            currentMesh->hndlTextures.push_back(materials[model->mesh_materials[meshIndex]]);
+        }
+    }
+
+    delete model;
 
     return hk::assets()->create(Asset::Type::MESH, root);
 }
 
+void destroyModel(ModelData *model)
+{
+    delete model;
+}
+
+u32 loadModel(const std::string &path)
+{
+    ModelData *model = importModel(path);
+    ALWAYS_ASSERT(model, "Failed to load model:", path);
+
+    return createModel(model);
+}
+
 }
@@ -3,11 +3,49 @@
 
 #include "hkcommon.h"
 #include "hkstl/utility/hktypes.h"
+#include "hkstl/containers/hkvector.h"
+
+#include "renderer/object/Mesh.h"
+#include "renderer/Material.h"
 
 #include <string>
 
 namespace hk::loader {
 
+/* Engine side copy of imported model, filled either by Assimp
+ * or straight from baked file, so it doesn't depend on importer */
+struct ModelData {
+    struct MaterialData {
+        std::string name;
+        decltype(Material::constants) constants;
+        b8 twosided = false;
+
+        // Relative to model folder, empty when map is not used
+        std::string maps[Material::MAX_TEXTURE_TYPE];
+    };
+
+    struct Node {
+        std::string name;
+        i32 parent = -1; // Parents always precede children
+        hkm::mat4f transform; // Node to parent
+        hk::vector<u32> meshes;
+    };
+
+    std::string path;
+
+    hk::vector<Mesh> meshes;
+    hk::vector<u32> mesh_materials; // Material index per mesh
+    hk::vector<MaterialData> materials;
+    hk::vector<Node> nodes;
+};
+
+// Import is CPU only and can run on any thread,
+// while creation registers assets and must run on main thread
+// Prefers baked file next to source, bakes it when missing or stale
+ModelData* importModel(const std::string &path);
+u32 createModel(ModelData *model); // Takes ownership
+void destroyModel(ModelData *model);
+
 u32 loadModel(const std::string &path);
 
 }
@@ -24,15 +24,29 @@
 
 #include "platform/filesystem.h"
 
+#include "core/jobs.h"
+
 #include "hkstl/strings/hklocale.h"
+#include "hkstl/utility/hkhash.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace hk::dxc {
 
-static CComPtr<IDxcUtils> dxcUtils;
-static CComPtr<IDxcCompiler3> dxcCompiler;
-static b8 initialized = false;
+// Bump when output changes for reasons hashed inputs don't cover
+static constexpr u64 cache_version = 2;
+static constexpr u32 spirv_magic = 0x07230203;
+static const std::string cache_folder = "shader_cache";
+static const std::string include_folder = "..\\engine\\assets\\shaders\\includes"; // TODO: make conf.
 
 struct IncludeHandler : public IDxcIncludeHandler {
+    CComPtr<IDxcUtils> *utils = nullptr;
+
     HRESULT STDMETHODCALLTYPE LoadSource(
         _In_z_ LPCWSTR pFilename,
         _COM_Outptr_result_maybenull_ IDxcBlob** ppIncludeSource) override
@@ -40,7 +54,7 @@ struct IncludeHandler : public IDxcIncludeHandler {
         HRESULT hr;
         CComPtr<IDxcBlobEncoding> pEncoding;
 
-        hr = dxcUtils->LoadFile(pFilename, nullptr, pEncoding.GetAddressOf());
+        hr = (*utils)->LoadFile(pFilename, nullptr, pEncoding.GetAddressOf());
         if (SUCCEEDED(hr)) {
             *ppIncludeSource = pEncoding.Detach();
         }
@@ -60,59 +74,104 @@ struct IncludeHandler : public IDxcIncludeHandler {
     ULONG STDMETHODCALLTYPE Release(void) override { return 0; }
 };
 
-static struct IncludeHandler dxcIncludeHandler;
+// DXC instances are not thread safe, every compile borrows its own
+struct Compiler {
+    CComPtr<IDxcUtils> utils;
+    CComPtr<IDxcCompiler3> compiler;
+    IncludeHandler handler;
+};
+
+static struct ShaderCacheContext {
+    std::mutex mutex;
 
-void init()
+    hk::vector<Compiler*> idle;
+    std::unordered_map<u64, hk::vector<u32>> code;
+
+    b8 folder_ready = false;
+} ctx;
+
+static Compiler* create_compiler()
 {
     HRESULT err;
 
-    err = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&dxcUtils));
+    Compiler *compiler = new Compiler();
+
+    err = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&compiler->utils));
     ALWAYS_ASSERT(SUCCEEDED(err), "Failed to create IDxcUtils");
 
-    err = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&dxcCompiler));
+    err = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&compiler->compiler));
     ALWAYS_ASSERT(SUCCEEDED(err), "Failed to create IDxcCompiler3");
 
-    initialized = true;
+    // ComPtr overloads operator&
+    compiler->handler.utils = std::addressof(compiler->utils);
+
+    return compiler;
 }
 
-void deinit()
+static Compiler* acquire_compiler()
 {
-    dxcCompiler->Release();
-    dxcCompiler = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(ctx.mutex);
+
+        if (ctx.idle.size()) {
+            Compiler *compiler = ctx.idle.back();
+            ctx.idle.pop_back();
+            return compiler;
+        }
+    }
 
-    dxcUtils->Release();
-    dxcUtils = nullptr;
+    return create_compiler();
 }
 
-hk::vector<u32> loadShader(const ShaderDesc &desc)
+static void release_compiler(Compiler *compiler)
 {
-    if(!initialized) { init(); }
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+    ctx.idle.push_back(compiler);
+}
 
-    hk::vector<u8> shader;
-    if (!hk::filesystem::read_file(desc.path, shader)) {
-        LOG_ERROR("Failed to read from file:", desc.path);
+void init()
+{
+    release_compiler(create_compiler());
+}
+
+void deinit()
+{
+    std::lock_guard<std::mutex> lock(ctx.mutex);
+
+    for (Compiler *compiler : ctx.idle) {
+        delete compiler;
     }
+    ctx.idle.clear();
 
-    HRESULT err;
+    ctx.code.clear();
+}
 
-    CComPtr<IDxcBlobEncoding> source;
-    err = dxcUtils->CreateBlob(shader.data(), shader.size(), CP_UTF8, &source);
-    ALWAYS_ASSERT(SUCCEEDED(err), "Failed to create IDxcBlobEncoding");
+/* ===== Arguments ===== */
+// Storage for strings args point into
+struct Arguments {
+    std::wstring filename;
+    std::wstring entry;
+    std::wstring target;
+    std::wstring include;
+    hk::vector<std::wstring> defines;
 
     hk::vector<LPCWSTR> args;
+};
+
+static void build_arguments(const ShaderDesc &desc, Arguments &out)
+{
     // Name of the shader file to be displayed e.g. in an error message
-    std::wstring filename =
+    out.filename =
         hk::string_convert(desc.path.substr(desc.path.find_last_of("/\\") + 1));
-    u64 ext_idx = filename.rfind('.');
-    args.push_back(filename.substr(ext_idx, 4).c_str());
+    out.args.push_back(out.filename.c_str());
 
     // TODO: can use ext to map for file types automaticaly
     // but will work only with correct file types (vert, frag, etc)
 
-    std::wstring wmain(desc.entry.begin(), desc.entry.end());
+    out.entry = std::wstring(desc.entry.begin(), desc.entry.end());
     // -E for the entry point (eg. 'main')
-    args.push_back(L"-E");
-    args.push_back((LPCWSTR)wmain.c_str());
+    out.args.push_back(L"-E");
+    out.args.push_back(out.entry.c_str());
 
     constexpr wchar_t const *types[] = {
         L"none",
@@ -135,47 +194,187 @@ hk::vector<u32> loadShader(const ShaderDesc &desc)
         L"6_7",
     };
 
-    std::wstring target(types[static_cast<u8>(desc.type)]);
-    target += models[static_cast<u8>(desc.model)];
+    out.target = types[static_cast<u8>(desc.type)];
+    out.target += models[static_cast<u8>(desc.model)];
 
     // -T for the target profile (eg. 'ps_6_6')
-    args.push_back(L"-T");
-    args.push_back((LPCWSTR)target.c_str());
+    out.args.push_back(L"-T");
+    out.args.push_back(out.target.c_str());
 
     switch (desc.ir) {
     case ShaderIR::DXIL: {
-        args.push_back(L"-Wno-ignored-attributes");
+        out.args.push_back(L"-Wno-ignored-attributes");
     } break;
     case ShaderIR::SPIRV: {
-        args.push_back(L"-spirv");
-        args.push_back(L"-fspv-target-env=vulkan1.3"); // TODO: take from instance
-        args.push_back(L"-fvk-use-dx-layout");
+        out.args.push_back(L"-spirv");
+        out.args.push_back(L"-fspv-target-env=vulkan1.3"); // TODO: take from instance
+        out.args.push_back(L"-fvk-use-dx-layout");
     } break;
     }
 
     if (desc.debug) {
         // Disable optimizations
-        args.push_back(L"-Od");
+        out.args.push_back(L"-Od");
 
         // Enable debug information
-        args.push_back(L"-Zi");
+        out.args.push_back(L"-Zi");
 
         // Embed PDB in shader container (must be used with /Zi)
-        args.push_back(L"-Qembed_debug");
+        out.args.push_back(L"-Qembed_debug");
 
         // args.push_back(L"-fspv-debug=vulkan-with-source");
     } else {
-        args.push_back(L"-O3");
+        out.args.push_back(L"-O3");
     }
 
+    // Reserve first, args point into these strings
+    out.defines.reserve(desc.defines.size());
+    for (const auto &define : desc.defines) {
+        out.defines.push_back(hk::string_convert(define));
+    }
+    for (const auto &define : out.defines) {
+        out.args.push_back(L"-D");
+        out.args.push_back(define.c_str());
+    }
 
-    args.push_back(L"-I");
-    args.push_back(L"..\\engine\\assets\\shaders\\includes"); // TODO: make conf.
-
-    IncludeHandler handler;
+    out.include = hk::string_convert(include_folder);
+    out.args.push_back(L"-I");
+    out.args.push_back(out.include.c_str());
 
     // Pack matrices in Column-major order
     // args.push_back(L"-Zpc");
+}
+
+/* ===== Cache Key ===== */
+static std::string directory(const std::string &path)
+{
+    const u64 slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+}
+
+// Hashes file and everything it includes, same way DXC resolves them:
+// next to including file first, then include folder
+static u64 hash_file(const std::string &path, u64 seed,
+                     std::unordered_set<std::string> &visited)
+{
+    if (!visited.insert(path).second) { return seed; }
+
+    hk::vector<u8> source;
+    if (!hk::filesystem::read_file(path, source)) {
+        return hk::hash_bytes(path.data(), path.size(), seed);
+    }
+
+    u64 hash = hk::hash_bytes(source.data(), source.size(), seed);
+
+    const std::string text(source.begin(), source.end());
+    for (u64 pos = text.find("#include"); pos != std::string::npos;
+         pos = text.find("#include", pos + 1))
+    {
+        const u64 open = text.find_first_of("\"<", pos);
+        const u64 line = text.find('\n', pos);
+        if (open == std::string::npos || open > line) { continue; }
+
+        const u64 close = text.find_first_of("\">", open + 1);
+        if (close == std::string::npos || close > line) { continue; }
+
+        const std::string name = text.substr(open + 1, close - open - 1);
+
+        std::string include = directory(path) + name;
+        if (!hk::filesystem::exists(include)) {
+            include = include_folder + HKPATH_SEPARATOR + name;
+        }
+
+        hash = hash_file(include, hash, visited);
+    }
+
+    return hash;
+}
+
+static u64 cache_key(const ShaderDesc &desc, const Arguments &arguments)
+{
+    u64 hash = hk::hash_value(cache_version);
+
+    for (const auto *arg : arguments.args) {
+        const std::wstring str(arg);
+        hash = hk::hash_bytes(str.data(), str.size() * sizeof(wchar_t), hash);
+    }
+
+    std::unordered_set<std::string> visited;
+    return hash_file(desc.path, hash, visited);
+}
+
+static std::string cache_path(u64 key)
+{
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", key);
+
+    return cache_folder + HKPATH_SEPARATOR + name + ".spv";
+}
+
+// Written in front of code, file name alone doesn't prove what's inside
+struct CacheHeader {
+    u64 key;
+};
+
+// File may be truncated, left from another key or not code at all
+static b8 read_cache(const std::string &path, u64 key, ShaderIR ir,
+                     hk::vector<u32> &out)
+{
+    hk::vector<u8> blob;
+    if (!hk::filesystem::read_file(path, blob)) { return false; }
+
+    const u64 size = blob.size() > sizeof(CacheHeader) ?
+                     blob.size() - sizeof(CacheHeader) : 0;
+
+    CacheHeader header = {};
+    if (size) { std::memcpy(&header, blob.data(), sizeof(CacheHeader)); }
+
+    b8 valid = size && !(size % sizeof(u32)) && header.key == key;
+    if (valid) {
+        out.resize(static_cast<u32>(size / sizeof(u32)));
+        std::memcpy(out.data(), blob.data() + sizeof(CacheHeader), size);
+
+        valid = ir != ShaderIR::SPIRV || out[0] == spirv_magic;
+    }
+
+    if (!valid) {
+        LOG_WARN("Shader cache is invalid, recompiling:", path);
+        out.clear();
+    }
+
+    return valid;
+}
+
+static b8 write_cache(const std::string &path, u64 key, const hk::vector<u32> &code)
+{
+    const u64 size = code.size() * sizeof(u32);
+
+    hk::vector<u8> blob(static_cast<u32>(sizeof(CacheHeader) + size));
+
+    CacheHeader header = {};
+    header.key = key;
+    std::memcpy(blob.data(), &header, sizeof(CacheHeader));
+    std::memcpy(blob.data() + sizeof(CacheHeader), code.data(), size);
+
+    return hk::filesystem::write_file(path, blob.data(), blob.size());
+}
+
+/* ===== Compilation ===== */
+static hk::vector<u32> compile(const ShaderDesc &desc, Arguments &arguments)
+{
+    hk::vector<u8> shader;
+    if (!hk::filesystem::read_file(desc.path, shader)) {
+        LOG_ERROR("Failed to read from file:", desc.path);
+        return hk::vector<u32>();
+    }
+
+    Compiler *compiler = acquire_compiler();
+
+    HRESULT err;
+
+    CComPtr<IDxcBlobEncoding> source;
+    err = compiler->utils->CreateBlob(shader.data(), shader.size(), CP_UTF8, &source);
+    ALWAYS_ASSERT(SUCCEEDED(err), "Failed to create IDxcBlobEncoding");
 
     DxcBuffer sourceBuffer;
     sourceBuffer.Ptr = source->GetBufferPointer();
@@ -183,8 +382,10 @@ hk::vector<u32> loadShader(const ShaderDesc &desc)
     sourceBuffer.Encoding = 0;
 
     CComPtr<IDxcResult> result;
-    err = dxcCompiler->Compile(&sourceBuffer, args.data(), (u32)args.size(),
-                               &handler, IID_PPV_ARGS(&result));
+    err = compiler->compiler->Compile(&sourceBuffer,
+                                      arguments.args.data(),
+                                      (u32)arguments.args.size(),
+                                      &compiler->handler, IID_PPV_ARGS(&result));
     ALWAYS_ASSERT(SUCCEEDED(err), "Failed to compile shader");
 
     CComPtr<IDxcBlobUtf8> errors;
@@ -206,7 +407,60 @@ hk::vector<u32> loadShader(const ShaderDesc &desc)
         spirvBuffer[i] = spvByte;
     }
 
+    release_compiler(compiler);
+
     return spirvBuffer;
 }
 
+hk::vector<u32> loadShader(const ShaderDesc &desc)
+{
+    Arguments arguments;
+    build_arguments(desc, arguments);
+
+    const u64 key = cache_key(desc, arguments);
+    const std::string path = cache_path(key);
+
+    {
+        std::lock_guard<std::mutex> lock(ctx.mutex);
+
+        auto cached = ctx.code.find(key);
+        if (cached != ctx.code.end()) { return cached->second; }
+    }
+
+    hk::vector<u32> code;
+    if (read_cache(path, key, desc.ir, code)) {
+        std::lock_guard<std::mutex> lock(ctx.mutex);
+        ctx.code[key] = code;
+
+        return code;
+    }
+
+    code = compile(desc, arguments);
+
+    // Failed compilation is never cached, so fixed shader gets recompiled
+    if (code.size()) {
+        std::lock_guard<std::mutex> lock(ctx.mutex);
+
+        if (!ctx.folder_ready) {
+            ctx.folder_ready = hk::filesystem::create_directory(cache_folder);
+        }
+        if (!ctx.folder_ready || !write_cache(path, key, code)) {
+            LOG_WARN("Failed to write shader cache:", path);
+        }
+
+        ctx.code[key] = code;
+    }
+
+    return code;
+}
+
+void precompile(const hk::vector<ShaderDesc> &descs)
+{
+    hk::jobs::parallel_for(0, descs.size(), 1, [&descs](u32 begin, u32 end) {
+        for (u32 i = begin; i < end; ++i) {
+            loadShader(descs[i]);
+        }
+    });
+}
+
 }
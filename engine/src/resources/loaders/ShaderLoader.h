@@ -39,7 +39,6 @@ enum class ShaderIR {
 namespace hk::dxc {
 
 // TODO: things that should be passed from outside code
-// defines
 // include directories
 struct ShaderDesc {
     std::string path;
@@ -51,13 +50,23 @@ struct ShaderDesc {
     // Intermediate Representation
     ShaderIR ir = ShaderIR::SPIRV;
     b8 debug = false;
+
+    // NAME or NAME=VALUE
+    hk::vector<std::string> defines;
 };
 
 void init();
 void deinit();
 
+/* Compiled code is cached in memory and on disk, keyed by hash of source,
+ * every included file, entry, target and compiler arguments.
+ * DXC is only created on cache miss. Thread safe */
 hk::vector<u32> loadShader(const ShaderDesc &desc);
 
+// Compiles cache misses in parallel on job workers, so following
+// loadShader calls for the same descs are cache hits
+void precompile(const hk::vector<ShaderDesc> &descs);
+
 }
 
 #endif // HK_SHADER_LOADER_H
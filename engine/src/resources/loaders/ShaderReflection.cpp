@@ -0,0 +1,445 @@
+#include "ShaderReflection.h"
+
+#include "hkstl/utility/hkassert.h"
+
+#include <algorithm>
+
+namespace hk::dxc {
+
+/* ===== SPIR-V ===== */
+// Subset of spirv.h that reflection needs
+namespace spv {
+
+constexpr u32 magic = 0x07230203;
+constexpr u32 header_size = 5;
+
+enum Op : u16 {
+    OpEntryPoint      = 15,
+    OpTypeInt         = 21,
+    OpTypeFloat       = 22,
+    OpTypeVector      = 23,
+    OpTypeMatrix      = 24,
+    OpTypeImage       = 25,
+    OpTypeSampler     = 26,
+    OpTypeSampledImage = 27,
+    OpTypeArray       = 28,
+    OpTypeRuntimeArray = 29,
+    OpTypeStruct      = 30,
+    OpTypePointer     = 32,
+    OpConstant        = 43,
+    OpVariable        = 59,
+    OpDecorate        = 71,
+    OpMemberDecorate  = 72,
+    OpTypeAccelerationStructureKHR = 5341,
+};
+
+enum Decoration : u32 {
+    Block         = 2,
+    BufferBlock   = 3,
+    ArrayStride   = 6,
+    MatrixStride  = 7,
+    BuiltIn       = 11,
+    Location      = 30,
+    Binding       = 33,
+    DescriptorSet = 34,
+    Offset        = 35,
+};
+
+enum StorageClass : u32 {
+    UniformConstant = 0,
+    Input           = 1,
+    Uniform         = 2,
+    PushConstant    = 9,
+    StorageBuffer   = 12,
+};
+
+enum ExecutionModel : u32 {
+    Vertex                 = 0,
+    TessellationControl    = 1,
+    TessellationEvaluation = 2,
+    Geometry               = 3,
+    Fragment               = 4,
+    GLCompute              = 5,
+};
+
+enum Dim : u32 {
+    DimBuffer      = 5,
+    DimSubpassData = 6,
+};
+
+}
+
+static constexpr u32 none = ~0u;
+
+// Everything reflection cares about, indexed by SPIR-V result id
+struct Id {
+    u16 opcode = 0;
+
+    u32 type = none;    // Component, element, pointee or result type
+    u32 storage = none; // Pointers and variables
+
+    u32 width = 0;      // Int, Float
+    u32 sign = 0;       // Int
+    u32 count = 0;      // Vector components, matrix columns, array length id
+    u32 dim = 0;        // Image
+    u32 sampled = 0;    // Image, 2 is storage
+    u32 value = 0;      // Constant, low word is enough for lengths
+
+    u32 set = none;
+    u32 binding = none;
+    u32 location = none;
+    u32 array_stride = 0;
+    b8 builtin = false;
+    b8 block = false;
+    b8 buffer_block = false;
+
+    hk::vector<u32> members;
+    hk::vector<u32> offsets;
+    hk::vector<u32> matrix_strides;
+};
+
+static VkShaderStageFlagBits to_stage(u32 model)
+{
+    switch (model) {
+    case spv::Vertex:                 return VK_SHADER_STAGE_VERTEX_BIT;
+    case spv::TessellationControl:    return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+    case spv::TessellationEvaluation: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+    case spv::Geometry:               return VK_SHADER_STAGE_GEOMETRY_BIT;
+    case spv::Fragment:               return VK_SHADER_STAGE_FRAGMENT_BIT;
+    case spv::GLCompute:              return VK_SHADER_STAGE_COMPUTE_BIT;
+    default:                          return VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM;
+    }
+}
+
+static u32 type_size(const hk::vector<Id> &ids, u32 type, u32 matrix_stride = 0)
+{
+    if (type >= ids.size()) { return 0; }
+    const Id &id = ids[type];
+
+    switch (id.opcode) {
+    case spv::OpTypeInt:
+    case spv::OpTypeFloat: {
+        return id.width / 8;
+    }
+    case spv::OpTypeVector: {
+        return id.count * type_size(ids, id.type);
+    }
+    case spv::OpTypeMatrix: {
+        const u32 column = matrix_stride ? matrix_stride : type_size(ids, id.type);
+        return id.count * column;
+    }
+    case spv::OpTypeArray: {
+        const u32 stride = id.array_stride ? id.array_stride
+                                           : type_size(ids, id.type, matrix_stride);
+        return id.count < ids.size() ? ids[id.count].value * stride : 0;
+    }
+    case spv::OpTypeStruct: {
+        u32 size = 0;
+        for (u32 i = 0; i < id.members.size(); ++i) {
+            const u32 offset = i < id.offsets.size() ? id.offsets[i] : 0;
+            const u32 stride = i < id.matrix_strides.size() ? id.matrix_strides[i] : 0;
+            size = std::max(size, offset + type_size(ids, id.members[i], stride));
+        }
+        return size;
+    }
+    default:
+        return 0;
+    }
+}
+
+static hk::Format to_format(const hk::vector<Id> &ids, u32 type)
+{
+    const Id &id = ids[type];
+
+    const b8 vector = id.opcode == spv::OpTypeVector;
+    if (vector && (id.type >= ids.size() || !id.count || id.count > 4)) {
+        return hk::Format::UNDEFINED;
+    }
+
+    const u32 components = vector ? id.count : 1;
+    const Id &scalar = vector ? ids[id.type] : id;
+
+    if (scalar.width != 32) { return hk::Format::UNDEFINED; }
+
+    if (scalar.opcode == spv::OpTypeFloat) {
+        constexpr hk::Format formats[] = {
+            hk::Format::R32_SFLOAT,
+            hk::Format::R32G32_SFLOAT,
+            hk::Format::R32G32B32_SFLOAT,
+            hk::Format::R32G32B32A32_SFLOAT,
+        };
+        return formats[components - 1];
+    }
+
+    if (scalar.opcode == spv::OpTypeInt && scalar.sign) {
+        constexpr hk::Format formats[] = {
+            hk::Format::R32_SINT,
+            hk::Format::R32G32_SINT,
+            hk::Format::R32G32B32_SINT,
+            hk::Format::R32G32B32A32_SINT,
+        };
+        return formats[components - 1];
+    }
+
+    if (scalar.opcode == spv::OpTypeInt) {
+        constexpr hk::Format formats[] = {
+            hk::Format::R32_UINT,
+            hk::Format::R32G32_UINT,
+            hk::Format::R32G32B32_UINT,
+            hk::Format::R32G32B32A32_UINT,
+        };
+        return formats[components - 1];
+    }
+
+    return hk::Format::UNDEFINED;
+}
+
+static VkDescriptorType to_descriptor(const Id &type, u32 storage)
+{
+    switch (storage) {
+    case spv::UniformConstant: {
+        switch (type.opcode) {
+        case spv::OpTypeSampler:      return VK_DESCRIPTOR_TYPE_SAMPLER;
+        case spv::OpTypeSampledImage: return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        case spv::OpTypeAccelerationStructureKHR:
+            return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+        case spv::OpTypeImage: {
+            if (type.dim == spv::DimSubpassData) {
+                return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            }
+            if (type.dim == spv::DimBuffer) {
+                return type.sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER
+                                         : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            }
+            return type.sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+                                     : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        }
+        default: break;
+        }
+    } break;
+    case spv::Uniform: {
+        if (type.block)        { return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER; }
+        if (type.buffer_block) { return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER; }
+    } break;
+    case spv::StorageBuffer: {
+        return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    }
+    default: break;
+    }
+
+    return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+}
+
+ShaderReflection reflect(const hk::vector<u32> &code)
+{
+    ShaderReflection out;
+
+    if (code.size() < spv::header_size || code[0] != spv::magic) {
+        LOG_WARN("Can't reflect shader, code is not SPIR-V");
+        return out;
+    }
+
+    const u32 bound = code[3];
+    hk::vector<Id> ids(bound);
+    hk::vector<u32> variables;
+
+    u32 model = none;
+
+    /* ===== Collect ids ===== */
+    for (u32 pos = spv::header_size; pos < code.size();) {
+        const u16 opcode = code[pos] & 0xffff;
+        const u32 words = code[pos] >> 16;
+
+        if (!words || pos + words > code.size()) {
+            LOG_WARN("Can't reflect shader, SPIR-V is truncated");
+            return ShaderReflection();
+        }
+
+        const u32 *op = &code[pos];
+        pos += words;
+
+        // Operand is a result id, check it's in bounds
+        auto at = [&](u32 word) -> Id* {
+            return word < words && op[word] < bound ? &ids[op[word]] : nullptr;
+        };
+
+        switch (opcode) {
+        case spv::OpEntryPoint: {
+            // First entry point wins, DXC emits only one
+            if (model == none) { model = op[1]; }
+        } break;
+        case spv::OpTypeInt: {
+            if (Id *id = at(1)) {
+                id->opcode = opcode;
+                id->width = op[2];
+                id->sign = op[3];
+            }
+        } break;
+        case spv::OpTypeFloat: {
+            if (Id *id = at(1)) {
+                id->opcode = opcode;
+                id->width = op[2];
+            }
+        } break;
+        case spv::OpTypeVector:
+        case spv::OpTypeMatrix:
+        case spv::OpTypeArray: {
+            if (Id *id = at(1)) {
+                id->opcode = opcode;
+                id->type = op[2];
+                id->count = op[3];
+            }
+        } break;
+        case spv::OpTypeImage: {
+            if (Id *id = at(1)) {
+                id->opcode = opcode;
+                id->type = op[2];
+                id->dim = op[3];
+                id->sampled = op[7];
+            }
+        } break;
+        case spv::OpTypeSampler:
+        case spv::OpTypeAccelerationStructureKHR: {
+            if (Id *id = at(1)) { id->opcode = opcode; }
+        } break;
+        case spv::OpTypeSampledImage:
+        case spv::OpTypeRuntimeArray: {
+            if (Id *id = at(1)) {
+                id->opcode = opcode;
+                id->type = op[2];
+            }
+        } break;
+        case spv::OpTypeStruct: {
+            if (Id *id = at(1)) {
+                id->opcode = opcode;
+                for (u32 i = 2; i < words; ++i) {
+                    id->members.push_back(op[i]);
+                }
+            }
+        } break;
+        case spv::OpTypePointer: {
+            if (Id *id = at(1)) {
+                id->opcode = opcode;
+                id->storage = op[2];
+                id->type = op[3];
+            }
+        } break;
+        case spv::OpConstant: {
+            if (Id *id = at(2)) {
+                id->opcode = opcode;
+                id->type = op[1];
+                id->value = op[3];
+            }
+        } break;
+        case spv::OpVariable: {
+            if (Id *id = at(2)) {
+                id->opcode = opcode;
+                id->type = op[1];
+                id->storage = op[3];
+                variables.push_back(op[2]);
+            }
+        } break;
+        case spv::OpDecorate: {
+            Id *id = at(1);
+            if (!id || words < 3) { break; }
+
+            const u32 value = words > 3 ? op[3] : 0;
+            switch (op[2]) {
+            case spv::Block:         { id->block = true; } break;
+            case spv::BufferBlock:   { id->buffer_block = true; } break;
+            case spv::ArrayStride:   { id->array_stride = value; } break;
+            case spv::BuiltIn:       { id->builtin = true; } break;
+            case spv::Location:      { id->location = value; } break;
+            case spv::Binding:       { id->binding = value; } break;
+            case spv::DescriptorSet: { id->set = value; } break;
+            default: break;
+            }
+        } break;
+        case spv::OpMemberDecorate: {
+            Id *id = at(1);
+            if (!id || words < 5) { break; }
+
+            const u32 member = op[2];
+            if (op[3] == spv::Offset) {
+                if (id->offsets.size() <= member) { id->offsets.resize(member + 1, 0); }
+                id->offsets[member] = op[4];
+            } else if (op[3] == spv::MatrixStride) {
+                if (id->matrix_strides.size() <= member) { id->matrix_strides.resize(member + 1, 0); }
+                id->matrix_strides[member] = op[4];
+            }
+        } break;
+        default: break;
+        }
+    }
+
+    out.stage = to_stage(model);
+
+    /* ===== Resolve variables ===== */
+    for (u32 variable : variables) {
+        const Id &var = ids[variable];
+        if (var.type >= bound) { continue; }
+
+        // Variables are always pointers
+        u32 type = ids[var.type].type;
+        if (type >= bound) { continue; }
+
+        switch (var.storage) {
+        case spv::UniformConstant:
+        case spv::Uniform:
+        case spv::StorageBuffer: {
+            if (var.set == none || var.binding == none) { break; }
+
+            ShaderReflection::Binding binding;
+            binding.set = var.set;
+            binding.binding = var.binding;
+
+            if (ids[type].opcode == spv::OpTypeArray) {
+                const u32 length = ids[type].count;
+                binding.count = length < bound ? ids[length].value : 1;
+                type = ids[type].type;
+            } else if (ids[type].opcode == spv::OpTypeRuntimeArray) {
+                binding.count = 0;
+                type = ids[type].type;
+            }
+            if (type >= bound) { break; }
+
+            binding.type = to_descriptor(ids[type], var.storage);
+            if (binding.type == VK_DESCRIPTOR_TYPE_MAX_ENUM) {
+                LOG_WARN("Unknown descriptor type at binding:", binding.binding,
+                         "set:", binding.set);
+                break;
+            }
+
+            out.bindings.push_back(binding);
+        } break;
+        case spv::PushConstant: {
+            out.push_size = std::max(out.push_size, type_size(ids, type));
+        } break;
+        case spv::Input: {
+            if (model != spv::Vertex || var.builtin || var.location == none) { break; }
+
+            ShaderReflection::Input input;
+            input.location = var.location;
+            input.format = to_format(ids, type);
+
+            if (input.format == hk::Format::UNDEFINED) {
+                LOG_WARN("Unsupported vertex input format at location:", input.location);
+            }
+
+            out.inputs.push_back(input);
+        } break;
+        default: break;
+        }
+    }
+
+    std::sort(out.bindings.begin(), out.bindings.end(),
+              [](const auto &a, const auto &b) {
+                  return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+              });
+    std::sort(out.inputs.begin(), out.inputs.end(),
+              [](const auto &a, const auto &b) { return a.location < b.location; });
+
+    return out;
+}
+
+}
@@ -0,0 +1,41 @@
+#ifndef HK_SHADER_REFLECTION_H
+#define HK_SHADER_REFLECTION_H
+
+#include "hkcommon.h"
+#include "hkstl/containers/hkvector.h"
+
+#include "renderer/resource_types.h"
+
+#include "vendor/vulkan/vulkan.h"
+
+namespace hk::dxc {
+
+// What pipeline and descriptor layouts need to know about a shader
+struct ShaderReflection {
+    struct Binding {
+        u32 set = 0;
+        u32 binding = 0;
+        VkDescriptorType type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+        u32 count = 1; // 0 for runtime sized arrays
+    };
+
+    struct Input {
+        u32 location = 0;
+        hk::Format format = hk::Format::UNDEFINED;
+    };
+
+    VkShaderStageFlagBits stage = VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM;
+
+    hk::vector<Binding> bindings; // Sorted by set, then binding
+    hk::vector<Input> inputs;     // Vertex stage only, sorted by location
+
+    u32 push_size = 0; // 0 if shader has no push constants
+};
+
+// Only resources shader actually declares end up here, so layouts built
+// from it are minimal. Returns empty reflection for invalid SPIR-V
+HKAPI ShaderReflection reflect(const hk::vector<u32> &code);
+
+}
+
+#endif // HK_SHADER_REFLECTION_H
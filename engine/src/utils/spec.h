@@ -87,6 +87,7 @@ struct ProcessorSpec {
             u8 pcid       : 1; // Process context identifiers (CR4 bit 17)
             u8 popcnt     : 1; // POPCNT instruction
             u8 aes        : 1; // AES instruction set
+            u8 osxsave    : 1; // OS saves extended (AVX) registers
             u8 hypervisor : 1;
 
             u8 sha        : 1;
@@ -31,6 +31,9 @@ echo:
 type results.txt
 echo:
 
+type benchmarks.txt
+echo:
+
 echo "Cleanup..."
 if exist *.obj DEL /F *.obj
 if exist tests.exe DEL /F tests.exe
@@ -0,0 +1,30 @@
+#!/usr/bin/env bash
+set -e
+cd "$(dirname "$0")"
+
+echo "==========================="
+echo "       Hikai Test"
+echo "==========================="
+
+cp engine/bin/libhikai.so tests/
+
+cd tests
+
+echo "Compiling tests..."
+${CXX:-g++} entry.cpp UnitTest.cpp Tests.cpp \
+    -std=c++17 -g -Wall -Wextra -o tests \
+    -I../engine/src -I../engine/src/vendor -I../engine/src/hkstl \
+    -L. -lhikai -Wl,-rpath,\$ORIGIN -lpthread
+
+echo "Running tests..."
+./tests
+
+echo
+cat results.txt
+echo
+
+cat benchmarks.txt
+echo
+
+echo "Cleanup..."
+rm -f tests libhikai.so
@@ -2,6 +2,14 @@
 
 #include "UnitTest.h"
 
+#include "renderer/memory.h"
+#include "resources/loaders/ShaderReflection.h"
+#include "resources/loaders/BakedModel.h"
+
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
 void Tests::init()
 {
     containersTests();
@@ -9,9 +17,17 @@ void Tests::init()
     mathTests();
     numericsTests();
     stringsTests();
+    loggerTests();
+    resourcesTests();
+    jobsTests();
+    eventsTests();
+    profilerTests();
+    ecsTests();
 
     RUN_ALL_TESTS();
 
+    benchmarks();
+
     hk::event::fire(hk::event::EVENT_APP_SHUTDOWN, {});
 }
 
@@ -64,6 +80,14 @@ hkm::quaternion roundQuat(const hkm::quaternion &quat, u32 precision) {
     return out;
 }
 
+// Element-wise compare of float arrays with relative tolerance
+b8 closeEnough(const f32 *x, const f32 *y, u32 count) {
+    for(u32 i = 0; i < count; ++i) {
+        if (fabs(x[i] - y[i]) > 1.0e-4f * fmax(1.f, fabs(x[i]))) { return false; }
+    }
+    return true;
+}
+
 void Tests::containersTests()
 {
     struct Mock {
@@ -73,6 +97,9 @@ void Tests::containersTests()
 
     static hk::vector<Mock> hkvec(4, {80085, 11.f});
     static hk::ring_buffer<Mock, 10> hkring;
+    static hk::mpmc_ring<u32, 1024> mpmc;
+    static hk::mpmc_ring<std::string, 4> mpmc_overwrite;
+    static hk::spsc_ring<u32, 256> spsc;
 
     DEFINE_TEST("Containers", "Vector default value constructor",
     {
@@ -122,6 +149,23 @@ void Tests::containersTests()
         EXPECT_EQ(hkvec.at(0).id, (u32)2);
     });
 
+    DEFINE_TEST("Containers", "Vector non trivial elements",
+    {
+        // Strings with small buffer optimization must survive reallocation
+        hk::vector<std::string> strings;
+        for (u32 i = 0; i < 100; ++i) {
+            strings.push_back(std::to_string(i));
+        }
+
+        strings.erase(strings.begin());
+        strings.insert(strings.begin(), std::string("first"));
+
+        EXPECT_EQ(strings.size(), (u32)100);
+        EXPECT_EQ(strings[0], std::string("first"));
+        EXPECT_EQ(strings[1], std::string("1"));
+        EXPECT_EQ(strings[99], std::string("99"));
+    });
+
     DEFINE_TEST("Containers", "Ring Buffer operations",
     {
         for(u32 i = 0; hkring.push({i, 0}) && i < 15; ++i) {}
@@ -141,6 +185,467 @@ void Tests::containersTests()
         EXPECT_EQ(hkring.size(), (u32)0);
     });
 
+    DEFINE_TEST("Containers", "MPMC ring multiple producers",
+    {
+        constexpr u32 producers = 4;
+        constexpr u32 consumers = 2;
+        constexpr u32 per_producer = 100000;
+
+        static u8 seen[producers * per_producer];
+        std::atomic<u32> received { 0 };
+
+        std::vector<std::thread> threads;
+        for (u32 p = 0; p < producers; ++p) {
+            threads.emplace_back([&, p]() {
+                for (u32 i = 0; i < per_producer; ++i) {
+                    while (!mpmc.push(p * per_producer + i)) { std::this_thread::yield(); }
+                }
+            });
+        }
+        for (u32 c = 0; c < consumers; ++c) {
+            threads.emplace_back([&]() {
+                u32 value;
+                while (received.load() < producers * per_producer) {
+                    if (mpmc.pop(value)) {
+                        ++seen[value];
+                        received.fetch_add(1);
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads) { thread.join(); }
+
+        b8 once = true;
+        for (u32 i = 0; i < producers * per_producer; ++i) { once = once && seen[i] == 1; }
+
+        EXPECT_EQ(once, true);
+        EXPECT_EQ(mpmc.size(), 0u);
+    });
+
+    DEFINE_TEST("Containers", "MPMC ring overwrite",
+    {
+        for (u32 i = 0; i < 6; ++i) { mpmc_overwrite.push_overwrite(std::to_string(i)); }
+
+        std::string value;
+        EXPECT_EQ(mpmc_overwrite.size(), 4u);
+        EXPECT_EQ(mpmc_overwrite.pop(value), true);
+        EXPECT_EQ(value, std::string("2"));
+    });
+
+    DEFINE_TEST("Containers", "SPSC ring order",
+    {
+        constexpr u32 count = 200000;
+        std::thread producer([&]() {
+            for (u32 i = 0; i < count; ++i) {
+                while (!spsc.push(i)) { std::this_thread::yield(); }
+            }
+        });
+
+        b8 ordered = true;
+        u32 value;
+        for (u32 expected = 0; expected < count;) {
+            if (!spsc.pop(value)) { continue; }
+            ordered = ordered && value == expected++;
+        }
+        producer.join();
+
+        EXPECT_EQ(ordered, true);
+    });
+
+    DEFINE_TEST("Containers", "TLSF alignment and merge",
+    {
+        hk::bkr::TLSF tlsf;
+        tlsf.init(1024 * 1024);
+
+        u64 a_offset;
+        u64 b_offset;
+        u64 c_offset;
+        u32 a = tlsf.allocate(1000, 256, a_offset);
+        u32 b = tlsf.allocate(3000, 4096, b_offset);
+        u32 c = tlsf.allocate(64, 16, c_offset);
+
+        EXPECT_EQ(b_offset % 4096, 0ull);
+        EXPECT_EQ(a_offset + 1024 <= b_offset || b_offset + 3072 <= a_offset, true);
+        EXPECT_EQ(tlsf.allocations(), 3u);
+
+        tlsf.free(a);
+        tlsf.free(c);
+        tlsf.free(b);
+
+        // Everything merged back into one range
+        EXPECT_EQ(tlsf.used(), 0ull);
+        EXPECT_EQ(tlsf.free_ranges(), 1u);
+        EXPECT_EQ(tlsf.largest_free(), 1024ull * 1024);
+
+        u64 offset;
+        EXPECT_EQ(tlsf.allocate(2 * 1024 * 1024, 256, offset), hk::bkr::TLSF::invalid);
+    });
+
+    DEFINE_TEST("Containers", "Slot map rejects stale handles",
+    {
+        hk::slot_map<std::string> map;
+
+        auto a = map.insert("a");
+        auto b = map.insert("b");
+        auto c = map.insert("c");
+        EXPECT_EQ(a.value != 0, true);
+        EXPECT_EQ(map.size(), 3u);
+
+        EXPECT_EQ(map.erase(a), true);
+        EXPECT_EQ(map.erase(a), false);
+        EXPECT_EQ(map.contains(a), false);
+        EXPECT_EQ(map.get(a) == nullptr, true);
+
+        // Slot is reused with new generation
+        auto d = map.insert("d");
+        EXPECT_EQ(d.index, a.index);
+        EXPECT_EQ(map.contains(a), false);
+        EXPECT_EQ(map.at(d), std::string("d"));
+
+        // Erase keeps values packed and handles pointing at them
+        map.erase(b);
+        EXPECT_EQ(map.size(), 2u);
+        EXPECT_EQ(map.at(c), std::string("c"));
+
+        u32 visited = 0;
+        for (auto &value : map) {
+            EXPECT_EQ(value == "c" || value == "d", true);
+            ++visited;
+        }
+        EXPECT_EQ(visited, 2u);
+
+        for (u32 i = 0; i < map.size(); ++i) {
+            EXPECT_EQ(map.at(map.key_at(i)), map.value_at(i));
+        }
+
+        map.clear();
+        EXPECT_EQ(map.empty(), true);
+        EXPECT_EQ(map.contains(c) || map.contains(d), false);
+    });
+
+    // Every key lands in one slot, forces long probes and backward shifts
+    struct CollidingHash {
+        u64 operator()(u32) const { return 7; }
+    };
+    using StringMap = hk::flat_map<std::string, u32>;
+    using CollidingMap = hk::flat_map<u32, u32, CollidingHash>;
+
+    DEFINE_TEST("Containers", "Flat map insert, find and erase",
+    {
+        StringMap map;
+        EXPECT_EQ(map.find("none") == nullptr, true);
+        EXPECT_EQ(map.erase("none"), false);
+
+        for (u32 i = 0; i < 1000; ++i) {
+            EXPECT_EQ(map.insert("key" + std::to_string(i), i), true);
+        }
+        EXPECT_EQ(map.size(), 1000u);
+        EXPECT_EQ(map.insert("key7", 0), false);
+        EXPECT_EQ(map.at("key7"), 7u);
+
+        // Lookups don't have to build std::string
+        std::string_view view = "key42";
+        EXPECT_EQ(map.at(view), 42u);
+        EXPECT_EQ(*map.find(view, StringMap::hash_of(view)), 42u);
+
+        map.assign("key7", 70);
+        map["key8"] += 10;
+        map["new"] = 5;
+        EXPECT_EQ(map.at("key7"), 70u);
+        EXPECT_EQ(map.at("key8"), 18u);
+        EXPECT_EQ(map.size(), 1001u);
+
+        for (u32 i = 0; i < 1000; i += 2) {
+            EXPECT_EQ(map.erase("key" + std::to_string(i)), true);
+        }
+
+        u32 visited = 0;
+        for (auto &entry : map) {
+            if (entry.key != "new") { EXPECT_EQ(entry.key.back() % 2 == 1, true); }
+            ++visited;
+        }
+        EXPECT_EQ(visited, map.size());
+
+        StringMap copy = map;
+        map.clear();
+        EXPECT_EQ(map.empty(), true);
+        EXPECT_EQ(copy.size(), 501u);
+        EXPECT_EQ(copy.at("key999"), 999u);
+    });
+
+    DEFINE_TEST("Containers", "Flat map survives full collisions",
+    {
+        CollidingMap map;
+        for (u32 i = 0; i < 100; ++i) { map[i] = i * 2; }
+
+        for (u32 i = 0; i < 100; i += 3) { EXPECT_EQ(map.erase(i), true); }
+        for (u32 i = 0; i < 100; ++i) {
+            const u32 *value = map.find(i);
+            EXPECT_EQ(value != nullptr, i % 3 != 0);
+            if (value) { EXPECT_EQ(*value, i * 2); }
+        }
+
+        for (u32 i = 0; i < 100; i += 3) { map[i] = i * 2; }
+        EXPECT_EQ(map.size(), 100u);
+        EXPECT_EQ(map.at(99u), 198u);
+    });
+
+    DEFINE_TEST("Containers", "BVH queries match brute force",
+    {
+        constexpr u32 count = 500;
+
+        u32 seed = 3;
+        auto random = [&seed](f32 min, f32 max) {
+            seed = seed * 1664525u + 1013904223u;
+            return min + (max - min) * static_cast<f32>(seed >> 8) / static_cast<f32>(1u << 24);
+        };
+
+        hk::vector<hkm::aabb> boxes(count);
+        auto place = [&](u32 i) {
+            const hkm::vec3f center(random(-50.f, 50.f), random(-50.f, 50.f), random(-50.f, 50.f));
+            const hkm::vec3f extent(random(.1f, 2.f), random(.1f, 2.f), random(.1f, 2.f));
+            boxes[i] = hkm::aabb(center - extent, center + extent);
+        };
+
+        hk::bvh tree;
+        hk::vector<u32> proxies(count);
+        hk::vector<u8> alive(count, 1);
+
+        for (u32 i = 0; i < count; ++i) {
+            place(i);
+            proxies[i] = tree.insert(boxes[i], i);
+        }
+
+        // Every third jumps somewhere else, every fifth leaves
+        for (u32 i = 0; i < count; i += 3) {
+            place(i);
+            tree.move(proxies[i], boxes[i]);
+        }
+        for (u32 i = 1; i < count; i += 5) {
+            tree.remove(proxies[i]);
+            alive[i] = 0;
+        }
+        EXPECT_EQ(tree.size(), count - count / 5);
+
+        hk::vector<u8> found(count, 0);
+        hk::vector<u8> expected(count, 0);
+        auto matches = [&]() {
+            b8 same = true;
+            for (u32 i = 0; i < count; ++i) {
+                same = same && found[i] == expected[i];
+                found[i] = expected[i] = 0;
+            }
+            return same;
+        };
+
+        // Brute force frustum goes through flat culling kernel
+        hk::Camera camera;
+        camera.setPerspective(60.f, 1.f, .1f, 40.f);
+        camera.setWorldOffset({ 0.f, 0.f, -20.f });
+        camera.update();
+
+        hkm::vec4f planes[6];
+        hkm::frustumPlanes(camera.viewProjection(), planes);
+
+        hk::vector<f32> components[6];
+        for (auto &component : components) { component.resize(count); }
+        for (u32 i = 0; i < count; ++i) {
+            const hkm::vec3f center = boxes[i].center();
+            const hkm::vec3f extent = boxes[i].extent();
+            for (u32 axis = 0; axis < 3; ++axis) {
+                components[axis][i] = center[axis];
+                components[axis + 3][i] = extent[axis];
+            }
+        }
+
+        hkm::AABBArrays arrays;
+        for (u32 axis = 0; axis < 3; ++axis) {
+            arrays.center[axis] = components[axis].data();
+            arrays.extent[axis] = components[axis + 3].data();
+        }
+
+        hk::vector<u32> culled(count);
+        culled.resize(hkm::cullAABBs(planes, arrays, count, culled.data()));
+
+        b8 res = true;
+        for (u32 pass = 0; pass < 2; ++pass) {
+            for (u32 q = 0; q < 20; ++q) {
+                const hkm::vec3f point(random(-50.f, 50.f), random(-50.f, 50.f), random(-50.f, 50.f));
+                const f32 radius = random(1.f, 20.f);
+                const hkm::aabb area(point - hkm::vec3f(radius), point + hkm::vec3f(radius));
+
+                tree.query(area, [&](u32 value) { found[value] = 1; });
+                for (u32 i = 0; i < count; ++i) {
+                    expected[i] = alive[i] && hkm::overlaps(boxes[i], area);
+                }
+                res = res && matches();
+
+                tree.query(point, radius, [&](u32 value) { found[value] = 1; });
+                for (u32 i = 0; i < count; ++i) {
+                    expected[i] = alive[i] && hkm::distancesq(boxes[i], point) <= radius * radius;
+                }
+                res = res && matches();
+
+                f32 closest = FLT_MAX;
+                for (u32 i = 0; i < count; ++i) {
+                    const f32 distance = hkm::distancesq(boxes[i], point);
+                    if (alive[i] && distance < closest) { closest = distance; }
+                }
+                const u32 near = tree.nearest(point);
+                res = res && near != hk::bvh::none && hkm::distancesq(boxes[near], point) == closest;
+
+                // Along x, box is hit when point is inside its yz square
+                f32 first = FLT_MAX;
+                for (u32 i = 0; i < count; ++i) {
+                    const hkm::aabb &box = boxes[i];
+                    if (!alive[i] || box.max.x < point.x) { continue; }
+                    if (point.y < box.min.y || point.y > box.max.y) { continue; }
+                    if (point.z < box.min.z || point.z > box.max.z) { continue; }
+
+                    const f32 distance = box.min.x > point.x ? box.min.x - point.x : 0.f;
+                    if (distance < first) { first = distance; }
+                }
+
+                f32 hit = FLT_MAX;
+                tree.raycast(point, { 1.f, 0.f, 0.f }, FLT_MAX, [&](u32, f32 distance) {
+                    if (distance < hit) { hit = distance; }
+                    return hit;
+                });
+                res = res && hit == first;
+            }
+
+            tree.query(planes, [&](u32 value) { found[value] += 1; });
+            for (u32 idx : culled) { expected[idx] = alive[idx]; }
+            res = res && matches();
+
+            // Second pass runs same queries over rebuilt tree
+            tree.rebuild();
+        }
+
+        EXPECT_EQ(res, true);
+        EXPECT_EQ(tree.size(), count - count / 5);
+
+        for (u32 i = 0; i < count; ++i) {
+            if (alive[i]) { tree.remove(proxies[i]); }
+        }
+        EXPECT_EQ(tree.size(), 0u);
+        EXPECT_EQ(tree.root(), hk::bvh::none);
+    });
+
+    DEFINE_TEST("Containers", "Linear allocator stack order and spill",
+    {
+        hk::mem::Linear linear;
+        linear.init(256);
+
+        void *a = linear.allocate(64);
+        void *b = linear.allocate(32, 32);
+        EXPECT_EQ(reinterpret_cast<u64>(b) % 32, 0ull);
+        EXPECT_EQ(linear.owns(a) && linear.owns(b), true);
+
+        // Only the top allocation grows or goes back
+        EXPECT_EQ(linear.grow(a, 64, 128), false);
+        EXPECT_EQ(linear.grow(b, 32, 64), true);
+
+        hk::mem::Linear::Marker marker = linear.mark();
+        linear.allocate(16);
+        linear.rewind(marker);
+        EXPECT_EQ(linear.used(), marker);
+
+        void *spill = linear.allocate(1024);
+        EXPECT_EQ(linear.owns(spill), false);
+        EXPECT_EQ(linear.overflow(), 1024ull);
+        linear.deallocate(spill, 1024);
+
+        linear.deallocate(b, 64);
+        linear.deallocate(a, 64);
+        EXPECT_EQ(linear.used() <= 64, true);
+
+        linear.reset();
+        EXPECT_EQ(linear.used(), 0ull);
+        EXPECT_EQ(linear.overflow(), 0ull);
+    });
+
+    DEFINE_TEST("Containers", "Arena scopes reuse blocks",
+    {
+        hk::mem::Arena arena(1024);
+
+        arena.allocate(512);
+        hk::mem::Arena::Marker marker = arena.mark();
+        {
+            hk::mem::Arena::Scope scope(arena);
+            for (u32 i = 0; i < 16; ++i) { arena.allocate(256); }
+        }
+        const u64 reserved = arena.reserved();
+
+        // Same pattern fits into blocks left from the first pass
+        for (u32 i = 0; i < 16; ++i) { arena.allocate(256); }
+        EXPECT_EQ(arena.reserved(), reserved);
+
+        arena.rewind(marker);
+        void *big = arena.allocate(4096, 64);
+        EXPECT_EQ(reinterpret_cast<u64>(big) % 64, 0ull);
+        EXPECT_EQ(arena.reserved() > reserved, true);
+    });
+
+    DEFINE_TEST("Containers", "Pool reuses freed blocks",
+    {
+        hk::mem::Pool pool;
+        pool.init<Mock>(4);
+
+        Mock *first = hk::mem::create<Mock>(pool);
+        hk::vector<Mock*> mocks;
+        for (u32 i = 0; i < 9; ++i) {
+            mocks.push_back(hk::mem::create<Mock>(pool));
+            mocks.back()->id = i;
+        }
+        EXPECT_EQ(pool.used(), 10u);
+        EXPECT_EQ(pool.reserved(), 12u);
+
+        hk::mem::destroy(pool, first);
+        EXPECT_EQ(hk::mem::create<Mock>(pool), first);
+
+        for (u32 i = 0; i < mocks.size(); ++i) {
+            EXPECT_EQ(mocks[i]->id, i);
+            hk::mem::destroy(pool, mocks[i]);
+        }
+        hk::mem::destroy(pool, first);
+        EXPECT_EQ(pool.used(), 0u);
+    });
+
+    DEFINE_TEST("Containers", "Vector with allocator",
+    {
+        hk::mem::Linear linear;
+        linear.init(64 * 1024);
+
+        {
+            hk::vector<u32> nums(linear);
+            for (u32 i = 0; i < 1000; ++i) { nums.push_back(i); }
+
+            // Growing top allocation happens in place
+            EXPECT_EQ(linear.owns(nums.data()), true);
+            EXPECT_EQ(linear.used() <= nums.capacity() * sizeof(u32), true);
+
+            hk::vector<std::string> strings(2u, linear);
+            strings.push_back("long enough to skip small string optimization");
+            EXPECT_EQ(strings.size(), 3u);
+            EXPECT_EQ(linear.owns(strings.data()), true);
+
+            // Copy goes to heap, move between allocators moves elements
+            hk::vector<u32> copy = nums;
+            EXPECT_EQ(copy.allocator() == nullptr, true);
+            EXPECT_EQ(copy.size(), 1000u);
+
+            hk::vector<std::string> heap_strings;
+            heap_strings = hk::move(strings);
+            EXPECT_EQ(heap_strings.allocator() == nullptr, true);
+            EXPECT_EQ(heap_strings.back(), std::string("long enough to skip small string optimization"));
+
+            hk::vector<u32> moved = hk::move(nums);
+            EXPECT_EQ(moved.allocator() == &linear, true);
+            EXPECT_EQ(moved[999], 999u);
+        }
+    });
+
     DEFINE_TEST("Containers", "Bitset",
     {
         hk::bitset<4>   a{0};
@@ -196,6 +701,59 @@ void Tests::containersTests()
     });
 }
 
+// Hand assembled vertex shader module, only what reflection reads
+static hk::vector<u32> reflectionModule()
+{
+    hk::vector<u32> code = { 0x07230203, 0x00010000, 0, 26, 0 };
+
+    auto op = [&code](u16 opcode, std::initializer_list<u32> operands) {
+        code.push_back((static_cast<u32>(operands.size() + 1) << 16) | opcode);
+        for (u32 operand : operands) { code.push_back(operand); }
+    };
+
+    // OpEntryPoint Vertex %20 "main" %21 %23 %25
+    op(15, { 0, 20, 0x6e69616d, 0, 21, 23, 25 });
+
+    op(71, { 21, 30, 0 });  // Location 0
+    op(71, { 23, 30, 1 });  // Location 1
+    op(71, { 25, 11, 42 }); // BuiltIn VertexIndex
+    op(71, { 13, 34, 2 });  // DescriptorSet 2
+    op(71, { 13, 33, 0 });  // Binding 0
+    op(71, { 18, 34, 2 });
+    op(71, { 18, 33, 1 });
+    op(71, { 11, 2 });      // Block
+    op(71, { 8, 2 });
+    op(72, { 8, 0, 35, 0 });  // Offset 0
+    op(72, { 8, 0, 7, 16 });  // MatrixStride 16
+    op(72, { 8, 1, 35, 64 });
+
+    op(22, { 2, 32 });                  // float
+    op(23, { 3, 2, 3 });                // float3
+    op(23, { 4, 2, 2 });                // float2
+    op(23, { 5, 2, 4 });                // float4
+    op(24, { 6, 5, 4 });                // float4x4
+    op(21, { 7, 32, 0 });               // uint
+    op(30, { 8, 6, 7 });                // push struct
+    op(32, { 9, 9, 8 });
+    op(59, { 9, 10, 9 });
+    op(30, { 11, 5 });                  // cbuffer
+    op(32, { 12, 2, 11 });
+    op(59, { 12, 13, 2 });
+    op(25, { 14, 2, 1, 0, 0, 0, 1, 0 }); // Texture2D
+    op(43, { 7, 15, 4 });
+    op(28, { 16, 14, 15 });             // Texture2D[4]
+    op(32, { 17, 0, 16 });
+    op(59, { 17, 18, 0 });
+    op(32, { 19, 1, 3 });
+    op(59, { 19, 21, 1 });
+    op(32, { 22, 1, 4 });
+    op(59, { 22, 23, 1 });
+    op(32, { 24, 1, 7 });
+    op(59, { 24, 25, 1 });
+
+    return code;
+}
+
 void Tests::platformTests()
 {
     DEFINE_TEST("Platform", "File operations",
@@ -321,6 +879,183 @@ void Tests::mathTests()
 
         EXPECT_EQ(roundMat3f(rot, 4), expectedRot);
     });
+    DEFINE_TEST("Math", "SIMD kernels match scalar",
+    {
+        hkm::mat4f a(
+            .3f, -1.2f,  .5f,  0.f,
+            1.1f,  .4f, -.7f,  0.f,
+            -.2f,  .9f, 1.3f,  0.f,
+            4.f,  -2.f,  .5f,  1.f);
+        hkm::mat4f lhs[3];
+        hkm::mat4f rhs[3];
+        lhs[0] = a;
+        rhs[0] = hkm::transpose(a);
+        lhs[1] = hkm::transpose(a);
+        rhs[1] = a;
+        lhs[2] = hkm::inverse(a);
+        rhs[2] = a;
+        hkm::vec3f points[5];
+        for (u32 i = 0; i < 5; ++i) {
+            points[i] = hkm::vec3f(i * .5f - 1.f, 2.f - i, i * i * .3f);
+        }
+
+        const hkm::simd::Level best = hkm::simd::level();
+
+        hkm::simd::select(hkm::simd::Level::SCALAR);
+        hkm::mat4f mul[3];
+        hkm::vec3f transformed[5];
+        hkm::vec3f rotated[5];
+        hkm::mul(lhs, rhs, mul, 3);
+        hkm::transformPoints(a, points, transformed, 5);
+        hkm::transformVecs(a, points, rotated, 5);
+
+        b8 res = true;
+        for (u32 i = 1; i < static_cast<u32>(hkm::simd::Level::MAX_LEVELS); ++i) {
+            if (!hkm::simd::select(static_cast<hkm::simd::Level>(i))) { continue; }
+
+            hkm::mat4f simd_mul[3];
+            hkm::vec3f simd_transformed[5];
+            hkm::vec3f simd_rotated[5];
+            hkm::mul(lhs, rhs, simd_mul, 3);
+            hkm::transformPoints(a, points, simd_transformed, 5);
+            hkm::transformVecs(a, points, simd_rotated, 5);
+
+            res = res && closeEnough(*mul[0].n, *simd_mul[0].n, 48);
+            res = res && closeEnough(&transformed[0].x, &simd_transformed[0].x, 15);
+            res = res && closeEnough(&rotated[0].x, &simd_rotated[0].x, 15);
+        }
+
+        hkm::simd::select(best);
+
+        EXPECT_EQ(res, true);
+    });
+    DEFINE_TEST("Math", "Batch transforms match per element",
+    {
+        Transform locals[5];
+        hkm::mat4f parents[5];
+        for (u32 i = 0; i < 5; ++i) {
+            locals[i].pos = hkm::vec3f(i * 1.5f, -2.f + i, .5f * i);
+            locals[i].scale = hkm::vec3f(1.f + i, .5f, 2.f - .25f * i);
+            locals[i].rotation = hkm::fromAxisAngle({.3f * i, 1.f, -.5f}, .4f * i);
+            parents[i] = locals[(i + 2) % 5].toMat4f();
+        }
+
+        hkm::mat4f matrices[5];
+        hkm::mat4f composed[5];
+        toMat4f(locals, matrices, 5);
+        hkm::mul(matrices, parents, composed, 5);
+
+        b8 res = true;
+        for (u32 i = 0; i < 5; ++i) {
+            hkm::mat4f expected = locals[i].toMat4f();
+            hkm::mat4f expected_composed = expected * parents[i];
+
+            res = res && closeEnough(*expected.n, *matrices[i].n, 16);
+            res = res && closeEnough(*expected_composed.n, *composed[i].n, 16);
+        }
+
+        // Box corners transformed one by one must fit into transformed box
+        const hkm::mat4f &M = composed[1];
+        hkm::vec3f min(-1.f, -2.f, -.5f);
+        hkm::vec3f max(1.f, .5f, 3.f);
+        hkm::vec3f out_min;
+        hkm::vec3f out_max;
+        hkm::transformAABBs(M, &min, &max, &out_min, &out_max, 1);
+
+        hkm::vec3f lo(FLT_MAX);
+        hkm::vec3f hi(-FLT_MAX);
+        for (u32 c = 0; c < 8; ++c) {
+            hkm::vec3f corner((c & 1) ? max.x : min.x,
+                              (c & 2) ? max.y : min.y,
+                              (c & 4) ? max.z : min.z);
+            hkm::vec4f p = M * hkm::vec4f(corner.x, corner.y, corner.z, 1.f);
+
+            lo = hkm::vec3f(fmin(lo.x, p.x), fmin(lo.y, p.y), fmin(lo.z, p.z));
+            hi = hkm::vec3f(fmax(hi.x, p.x), fmax(hi.y, p.y), fmax(hi.z, p.z));
+        }
+        res = res && closeEnough(&lo.x, &out_min.x, 3);
+        res = res && closeEnough(&hi.x, &out_max.x, 3);
+
+        // Normals stay perpendicular to transformed tangent plane
+        hkm::vec3f normal = hkm::normalize(hkm::vec3f(1.f, 1.f, 0.f));
+        hkm::vec3f tangent = hkm::vec3f(1.f, -1.f, 0.f);
+        hkm::transformNormals(M, &normal, &normal, 1);
+        hkm::transformVecs(M, &tangent, &tangent, 1);
+        f32 dot = normal.x * tangent.x + normal.y * tangent.y + normal.z * tangent.z;
+        res = res && fabs(dot) < 1.0e-4f && fabs(normal.length() - 1.f) < 1.0e-4f;
+
+        EXPECT_EQ(res, true);
+    });
+    DEFINE_TEST("Math", "Frustum culling matches across levels",
+    {
+        hk::Camera camera;
+        camera.setPerspective(60.f, 1.f, .1f, 100.f);
+        camera.setWorldOffset({ 0.f, 0.f, 0.f });
+        camera.update();
+
+        hkm::vec4f planes[6];
+        hkm::frustumPlanes(camera.viewProjection(), planes);
+
+        // Grid of boxes around camera, odd count leaves tails for wide kernels
+        constexpr u32 count = 1003;
+        hk::vector<f32> components[6];
+        for (auto &component : components) { component.resize(count); }
+
+        for (u32 i = 0; i < count; ++i) {
+            components[0][i] = static_cast<f32>(i % 11) * 20.f - 100.f;
+            components[1][i] = static_cast<f32>(i / 11 % 7) * 5.f - 15.f;
+            components[2][i] = static_cast<f32>(i / 77) * 10.f - 30.f;
+            components[3][i] = .5f + static_cast<f32>(i % 3);
+            components[4][i] = .5f;
+            components[5][i] = 1.f;
+        }
+
+        hkm::AABBArrays boxes;
+        for (u32 axis = 0; axis < 3; ++axis) {
+            boxes.center[axis] = components[axis].data();
+            boxes.extent[axis] = components[axis + 3].data();
+        }
+
+        const hkm::simd::Level best = hkm::simd::level();
+
+        hkm::simd::select(hkm::simd::Level::SCALAR);
+        hk::vector<u32> expected(count);
+        expected.resize(hkm::cullAABBs(planes, boxes, count, expected.data()));
+
+        b8 res = expected.size() > 0 && expected.size() < count;
+        for (u32 i = 1; i < static_cast<u32>(hkm::simd::Level::MAX_LEVELS); ++i) {
+            if (!hkm::simd::select(static_cast<hkm::simd::Level>(i))) { continue; }
+
+            hk::vector<u32> visible(count);
+            visible.resize(hkm::cullAABBs(planes, boxes, count, visible.data()));
+
+            res = res && visible.size() == expected.size();
+            for (u32 j = 0; res && j < visible.size(); ++j) {
+                res = visible[j] == expected[j];
+            }
+        }
+
+        hkm::simd::select(best);
+
+        // Box right in front of camera is visible, box behind it is not
+        f32 x = 0.f;
+        f32 y = 0.f;
+        f32 front = 5.f;
+        f32 behind = -5.f;
+        f32 extent = .5f;
+        u32 index = 0;
+
+        boxes.center[0] = &x;
+        boxes.center[1] = &y;
+        boxes.extent[0] = boxes.extent[1] = boxes.extent[2] = &extent;
+
+        boxes.center[2] = &front;
+        res = res && hkm::cullAABBs(planes, boxes, 1, &index) == 1;
+        boxes.center[2] = &behind;
+        res = res && hkm::cullAABBs(planes, boxes, 1, &index) == 0;
+
+        EXPECT_EQ(res, true);
+    });
 }
 
 void Tests::numericsTests()
@@ -333,6 +1068,20 @@ void Tests::numericsTests()
             // EXPECT_EQ(rng(), 0ULL);
         }
     });
+
+    DEFINE_TEST("Numerics", "FNV-1a hash", {
+        // Reference values of 64-bit FNV-1a
+        EXPECT_EQ(hk::hash_bytes("", 0), 0xcbf29ce484222325ULL);
+        EXPECT_EQ(hk::hash_bytes("a", 1), 0xaf63dc4c8601ec8cULL);
+
+        // Chained hash is the same as hash of concatenation
+        u64 chained = hk::hash_bytes("fo", 2);
+        chained = hk::hash_bytes("o", 1, chained);
+        EXPECT_EQ(chained, hk::hash_bytes("foo", 3));
+
+        u32 value = 42;
+        EXPECT_EQ(hk::hash_value(value), hk::hash_bytes(&value, sizeof(value)));
+    });
 }
 
 void Tests::stringsTests()
@@ -343,4 +1092,935 @@ void Tests::stringsTests()
 
         EXPECT_EQ(str, hk::wstring_convert(wstr));
     });
+
+    DEFINE_TEST("Strings", "String id hashes literals at compile time",
+    {
+        using namespace hk::literals;
+
+        constexpr hk::string_id literal = "textures/albedo.png"_id;
+        static_assert(literal == hk::string_id("textures/albedo.png"));
+        static_assert(literal != hk::string_id("textures/normal.png"));
+
+        const std::string path = "textures/albedo.png";
+        EXPECT_EQ(hk::string_id(path) == literal, true);
+        EXPECT_EQ(literal.value(), hk::hash_bytes(path.data(), path.size()));
+        EXPECT_EQ(hk::string_id().valid(), false);
+    });
+
+    using IdMap = hk::flat_map<hk::string_id, u32>;
+
+    DEFINE_TEST("Strings", "String id keys flat map",
+    {
+        IdMap map;
+        for (u32 i = 0; i < 100; ++i) {
+            map[hk::string_id::intern("node_" + std::to_string(i))] = i;
+        }
+
+        EXPECT_EQ(map.at(hk::string_id("node_42")), 42u);
+        EXPECT_EQ(map.contains(hk::string_id("node_100")), false);
+    });
+
+#ifdef HKDEBUG
+    DEFINE_TEST("Strings", "Interned string id converts back",
+    {
+        hk::string_id id = hk::string_id::intern("Geometry Pass");
+        EXPECT_EQ(hk::to_string(id), std::string("Geometry Pass"));
+    });
+#endif
+}
+
+static std::mutex captured_mutex;
+static hk::vector<hk::log::Log> captured_logs;
+
+static u32 captureLogs()
+{
+    captured_logs.clear();
+    return hk::log::addMessageHandler([](const hk::log::Log &log) {
+        std::lock_guard<std::mutex> lock(captured_mutex);
+        captured_logs.push_back(log);
+    }, hk::log::Sink::BACKGROUND);
+}
+
+void Tests::loggerTests()
+{
+    DEFINE_TEST("Logger", "Arguments match stream output",
+    {
+        u32 handle = captureLogs();
+
+        std::string str = "str";
+        const char *null_str = nullptr;
+        LOG_INFO("Args", 1, -2, 3.5f, true, 'x', str, null_str, 18446744073709551615ull);
+        hk::log::flush();
+        hk::log::removeMessageHandler(handle);
+
+        std::string expected = hk::log::argsToString("Args", 1, -2, 3.5f, true, 'x',
+                                                     str, "(null)", 18446744073709551615ull);
+
+        EXPECT_EQ(captured_logs.size(), 1u);
+        EXPECT_EQ(captured_logs[0].args, expected);
+        EXPECT_EQ(captured_logs[0].file, std::string("Tests.cpp"));
+        EXPECT_EQ(captured_logs[0].level == hk::log::Level::LVL_INFO, true);
+    });
+
+    DEFINE_TEST("Logger", "Threads lose nothing and keep order",
+    {
+        constexpr u32 count = 64;
+
+        u32 handle = captureLogs();
+
+        std::vector<std::thread> threads;
+        for (u32 t = 0; t < 4; ++t) {
+            threads.emplace_back([t]() {
+                for (u32 i = 0; i < count; ++i) {
+                    LOG_INFO("Thread", t, "log", i);
+                }
+            });
+        }
+        for (auto &thread : threads) { thread.join(); }
+
+        hk::log::flush();
+        hk::log::removeMessageHandler(handle);
+
+        EXPECT_EQ(captured_logs.size(), 4u * count);
+
+        b8 ordered = true;
+        hk::vector<i32> last(4u, -1);
+        for (auto &log : captured_logs) {
+            u32 t = 0;
+            i32 i = 0;
+            std::sscanf(log.args.c_str(), "Thread %u log %d", &t, &i);
+            ordered = ordered && t < 4 && i > last[t];
+            if (t < 4) { last[t] = i; }
+        }
+        EXPECT_EQ(ordered, true);
+    });
+}
+
+void Tests::resourcesTests()
+{
+    DEFINE_TEST("Resources", "SPIR-V reflection",
+    {
+        const hk::dxc::ShaderReflection refl = hk::dxc::reflect(reflectionModule());
+
+        EXPECT_EQ(refl.stage, VK_SHADER_STAGE_VERTEX_BIT);
+
+        EXPECT_EQ(refl.bindings.size(), 2u);
+        EXPECT_EQ(refl.bindings[0].set, 2u);
+        EXPECT_EQ(refl.bindings[0].binding, 0u);
+        EXPECT_EQ(refl.bindings[0].type, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+        EXPECT_EQ(refl.bindings[1].binding, 1u);
+        EXPECT_EQ(refl.bindings[1].type, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
+        EXPECT_EQ(refl.bindings[1].count, 4u);
+
+        // float4x4 and uint at offset 64
+        EXPECT_EQ(refl.push_size, 68u);
+
+        // Builtin vertex index is skipped
+        EXPECT_EQ(refl.inputs.size(), 2u);
+        EXPECT_EQ(refl.inputs[0].format == hk::Format::R32G32B32_SFLOAT, true);
+        EXPECT_EQ(refl.inputs[1].format == hk::Format::R32G32_SFLOAT, true);
+
+        hk::vector<u32> garbage(16, 0);
+        EXPECT_EQ(hk::dxc::reflect(garbage).bindings.size(), 0u);
+    });
+    DEFINE_TEST("Resources", "Baked model round trip",
+    {
+        // Baked file is checked against write time of source
+        const std::string source = "bake_test.src";
+        const char stamp[] = "source";
+        hk::filesystem::write_file(source, stamp, sizeof(stamp));
+
+        hk::loader::ModelData model;
+        model.path = source;
+
+        model.meshes.resize(1);
+        hk::Mesh &mesh = model.meshes[0];
+        for (u32 i = 0; i < 4; ++i) {
+            Vertex v = {};
+            v.pos = hkm::vec3f(i * .5f, 1.f - i, i * i * .25f);
+            v.normal = hkm::vec3f(0.f, 1.f, 0.f);
+            v.tc = hkm::vec2f(i * .25f, 1.f - i * .25f);
+            v.tangent = hkm::vec3f(1.f, 0.f, 0.f);
+            v.bitangent = hkm::vec3f(0.f, 0.f, 1.f);
+            mesh.vertices.push_back(v);
+        }
+        mesh.indices.push_back(0);
+        mesh.indices.push_back(1);
+        mesh.indices.push_back(2);
+        mesh.indices.push_back(2);
+        mesh.indices.push_back(3);
+        mesh.indices.push_back(0);
+        mesh.min = hkm::vec3f(0.f, -2.f, 0.f);
+        mesh.max = hkm::vec3f(1.5f, 1.f, 2.25f);
+
+        model.mesh_materials.push_back(0);
+        model.materials.resize(1);
+        model.materials[0].name = "material";
+        model.nodes.resize(1);
+        model.nodes[0].name = "root";
+        model.nodes[0].meshes.push_back(0);
+
+        const std::string baked = hk::loader::bakedPath(source);
+        EXPECT_EQ(hk::loader::bakeModel(model, baked), true);
+
+        hk::loader::ModelData *loaded = hk::loader::loadBakedModel(baked, source);
+        EXPECT_EQ(loaded != nullptr, true);
+        EXPECT_EQ(loaded->meshes.size(), 1u);
+
+        const hk::Mesh &out = loaded->meshes[0];
+        EXPECT_EQ(out.vertices.size(), mesh.vertices.size());
+        EXPECT_EQ(out.indices.size(), mesh.indices.size());
+
+        b8 res = true;
+        for (u32 i = 0; i < mesh.vertices.size(); ++i) {
+            res = res && out.vertices[i] == mesh.vertices[i];
+            res = res && out.vertices[i].tangent == mesh.vertices[i].tangent;
+            res = res && out.vertices[i].bitangent == mesh.vertices[i].bitangent;
+        }
+        for (u32 i = 0; i < mesh.indices.size(); ++i) {
+            res = res && out.indices[i] == mesh.indices[i];
+        }
+        res = res && out.min == mesh.min && out.max == mesh.max;
+
+        EXPECT_EQ(loaded->nodes.size(), 1u);
+        EXPECT_EQ(loaded->nodes[0].name, model.nodes[0].name);
+
+        delete loaded;
+
+        EXPECT_EQ(res, true);
+    });
+}
+
+void Tests::jobsTests()
+{
+    DEFINE_TEST("Jobs", "Parallel for", {
+        hk::vector<u32> values(100000, 0);
+
+        hk::jobs::parallel_for(0, values.size(), 0, [&](u32 begin, u32 end) {
+            for (u32 i = begin; i < end; ++i) {
+                values[i] += i;
+            }
+        });
+
+        b8 res = true;
+        for (u32 i = 0; i < values.size(); ++i) {
+            res = res && (values[i] == i);
+        }
+        EXPECT_EQ(res, true);
+    });
+
+    DEFINE_TEST("Jobs", "Nested counters", {
+        static std::atomic<u32> sum;
+        sum = 0;
+
+        // Every job spawns more jobs and waits for them
+        auto node = [](void *data) {
+            (void)data;
+
+            hk::jobs::Counter counter;
+            for (u32 i = 0; i < 64; ++i) {
+                hk::jobs::submit({ [](void*) { ++sum; }, nullptr, &counter });
+            }
+            hk::jobs::wait(&counter);
+        };
+
+        hk::jobs::Counter counter;
+        for (u32 i = 0; i < 32; ++i) {
+            hk::jobs::submit({ node, nullptr, &counter });
+        }
+        hk::jobs::wait(&counter);
+
+        EXPECT_EQ(counter.value.load(), 0u);
+        EXPECT_EQ(sum.load(), 32u * 64u);
+    });
+}
+
+static void profiledWork()
+{
+    HK_PROFILE_SCOPE("Outer");
+    {
+        HK_PROFILE_SCOPE("Inner");
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    HK_PROFILE_SCOPE("Sibling");
+}
+
+void Tests::profilerTests()
+{
+    DEFINE_TEST("Profiler", "Nested scopes",
+    {
+        hk::profiler::capture(true);
+        hk::profiler::frame();
+
+        u64 index = hk::profiler::frame_index();
+        profiledWork();
+
+        hk::profiler::frame();
+        hk::profiler::capture(false);
+
+        const hk::profiler::Frame *frame = hk::profiler::find_frame(index);
+        EXPECT_EQ(frame != nullptr, true);
+
+        EXPECT_EQ(frame->events.size(), 3u);
+        EXPECT_EQ(frame->dropped, 0u);
+
+        const hk::profiler::Event &outer = frame->events[0];
+        const hk::profiler::Event &inner = frame->events[1];
+        const hk::profiler::Event &sibling = frame->events[2];
+
+        EXPECT_EQ(std::string(outer.name), std::string("Outer"));
+        EXPECT_EQ(std::string(inner.name), std::string("Inner"));
+        EXPECT_EQ(std::string(sibling.name), std::string("Sibling"));
+
+        EXPECT_EQ(outer.depth, 0u);
+        EXPECT_EQ(inner.depth, 1u);
+        EXPECT_EQ(sibling.depth, 1u);
+
+        EXPECT_EQ(outer.begin <= inner.begin && inner.end <= sibling.begin, true);
+        EXPECT_EQ(sibling.end <= outer.end, true);
+        EXPECT_EQ(inner.end - inner.begin >= 100000u, true);
+    });
+
+    DEFINE_TEST("Profiler", "Capture off records nothing",
+    {
+        hk::profiler::frame();
+        u64 index = hk::profiler::frame_index();
+        profiledWork();
+        hk::profiler::frame();
+
+        EXPECT_EQ(hk::profiler::find_frame(index) == nullptr, true);
+    });
+
+    DEFINE_TEST("Profiler", "Worker threads and trace export",
+    {
+        hk::profiler::capture(true);
+        hk::profiler::frame();
+
+        u64 index = hk::profiler::frame_index();
+        hk::jobs::parallel_for(0, 64, 1, [](u32 begin, u32 end) {
+            for (u32 i = begin; i < end; ++i) { profiledWork(); }
+        });
+
+        hk::profiler::frame();
+        hk::profiler::capture(false);
+
+        const hk::profiler::Frame *frame = hk::profiler::find_frame(index);
+        EXPECT_EQ(frame != nullptr, true);
+        EXPECT_EQ(frame->events.size(), 64u * 3u);
+
+        EXPECT_EQ(hk::profiler::export_trace("profile_test.json", index, index), true);
+
+        hk::vector<u8> json;
+        hk::filesystem::read_file("profile_test.json", json);
+        std::string text(json.begin(), json.end());
+        std::remove("profile_test.json");
+
+        EXPECT_EQ(text.find("\"traceEvents\"") != std::string::npos, true);
+        EXPECT_EQ(text.find("\"name\":\"Inner\"") != std::string::npos, true);
+        EXPECT_EQ(text.find("\"thread_name\"") != std::string::npos, true);
+    });
+}
+
+void Tests::eventsTests()
+{
+    DEFINE_TEST("Events", "Unsubscribe by handle",
+    {
+        u32 calls = 0;
+        auto callback = [&](const hk::event::EventContext&, void*) { ++calls; };
+
+        u32 first = hk::event::subscribe(hk::event::EVENT_WINDOW_RESIZE, callback);
+        u32 second = hk::event::subscribe(hk::event::EVENT_WINDOW_RESIZE, callback);
+
+        hk::event::fire(hk::event::EVENT_WINDOW_RESIZE, {});
+        hk::event::dispatch();
+        EXPECT_EQ(calls, 2u);
+
+        EXPECT_EQ(hk::event::unsubscribe(first), true);
+        EXPECT_EQ(hk::event::unsubscribe(first), false);
+
+        hk::event::fire(hk::event::EVENT_WINDOW_RESIZE, {});
+        hk::event::dispatch();
+        EXPECT_EQ(calls, 3u);
+
+        hk::event::unsubscribe(second);
+    });
+
+    DEFINE_TEST("Events", "Mouse moves are coalesced",
+    {
+        u32 calls = 0;
+        i32 x = 0;
+        i32 y = 0;
+        u32 handle = hk::event::subscribe(hk::event::EVENT_RAW_MOUSE_MOVED,
+            [&](const hk::event::EventContext &context, void*) {
+                ++calls;
+                x = context.i32[0];
+                y = context.i32[1];
+            });
+
+        for (i32 i = 0; i < 5000; ++i) {
+            hk::event::EventContext context;
+            context.i32[0] = 1;
+            context.i32[1] = -2;
+            hk::event::fire(hk::event::EVENT_RAW_MOUSE_MOVED, context);
+        }
+        hk::event::dispatch();
+
+        EXPECT_EQ(calls, 1u);
+        EXPECT_EQ(x, 5000);
+        EXPECT_EQ(y, -10000);
+
+        hk::event::unsubscribe(handle);
+    });
+
+    DEFINE_TEST("Events", "Flood does not drop events",
+    {
+        constexpr u32 count = 5000;
+
+        std::atomic<u32> received { 0 };
+        u32 handle = hk::event::subscribe(hk::event::EVENT_ASSET_LOADED,
+            [&](const hk::event::EventContext&, void*) { received.fetch_add(1); });
+
+        std::vector<std::thread> threads;
+        for (u32 t = 0; t < 4; ++t) {
+            threads.emplace_back([&]() {
+                for (u32 i = 0; i < count; ++i) {
+                    hk::event::fire(hk::event::EVENT_ASSET_LOADED, {});
+                }
+            });
+        }
+        for (auto &thread : threads) { thread.join(); }
+
+        hk::event::dispatch();
+        EXPECT_EQ(received.load(), 4u * count);
+
+        hk::event::unsubscribe(handle);
+    });
+}
+
+struct EcsPosition { f32 x; };
+struct EcsVelocity { f32 dx; };
+struct EcsName { std::string name; };
+
+void Tests::ecsTests()
+{
+    DEFINE_TEST("ECS", "Destroyed entities stay dead",
+    {
+        hk::ecs::Registry registry;
+
+        hk::ecs::Entity first = registry.create();
+        registry.emplace<EcsPosition>(first, EcsPosition{1.f});
+        registry.destroy(first);
+
+        // Index is reused with new generation
+        hk::ecs::Entity second = registry.create();
+        EXPECT_EQ(second.index == first.index, true);
+        EXPECT_EQ(registry.alive(first), false);
+        EXPECT_EQ(registry.alive(second), true);
+        EXPECT_EQ(registry.has<EcsPosition>(second), false);
+        EXPECT_EQ(registry.size(), 1u);
+    });
+
+    DEFINE_TEST("ECS", "Remove keeps other components",
+    {
+        hk::ecs::Registry registry;
+
+        hk::vector<hk::ecs::Entity> entities;
+        for (u32 i = 0; i < 16; ++i) {
+            entities.push_back(registry.create());
+            registry.emplace<EcsName>(entities.back(), EcsName{std::to_string(i)});
+        }
+
+        for (u32 i = 0; i < 16; i += 3) {
+            EXPECT_EQ(registry.remove<EcsName>(entities[i]), true);
+            EXPECT_EQ(registry.remove<EcsName>(entities[i]), false);
+        }
+
+        b8 res = true;
+        for (u32 i = 0; i < 16; ++i) {
+            EcsName *name = registry.try_get<EcsName>(entities[i]);
+            res = res && (i % 3 ? name && name->name == std::to_string(i) : !name);
+        }
+        EXPECT_EQ(res, true);
+    });
+
+    using Moving = hk::ecs::View<EcsPosition, EcsVelocity>;
+
+    DEFINE_TEST("ECS", "View visits only matching entities",
+    {
+        hk::ecs::Registry registry;
+
+        for (u32 i = 0; i < 1000; ++i) {
+            hk::ecs::Entity entity = registry.create();
+            registry.emplace<EcsPosition>(entity, EcsPosition{static_cast<f32>(i)});
+            if (i % 4 == 0) { registry.emplace<EcsVelocity>(entity, EcsVelocity{1.f}); }
+        }
+
+        u32 visited = 0;
+        b8 res = true;
+        Moving moving(registry.storage<EcsPosition>(), registry.storage<EcsVelocity>());
+        moving.each([&](hk::ecs::Entity, EcsPosition &position, EcsVelocity &velocity) {
+            res = res && (static_cast<u32>(position.x) % 4 == 0);
+            position.x += velocity.dx;
+            ++visited;
+        });
+
+        EXPECT_EQ(visited, 250u);
+        EXPECT_EQ(res, true);
+    });
+
+    DEFINE_TEST("ECS", "Parallel each visits every entity once",
+    {
+        hk::ecs::Registry registry;
+
+        for (u32 i = 0; i < 10000; ++i) {
+            registry.emplace<EcsPosition>(registry.create(), EcsPosition{0.f});
+        }
+
+        registry.view<EcsPosition>().parallel_each(
+            [](hk::ecs::Entity, EcsPosition &position) { position.x += 1.f; }, 64);
+
+        b8 res = true;
+        registry.view<EcsPosition>().each([&](hk::ecs::Entity, EcsPosition &position) {
+            res = res && position.x == 1.f;
+        });
+        EXPECT_EQ(res, true);
+    });
+}
+
+void Tests::benchmarks()
+{
+    std::ofstream out("benchmarks.txt");
+
+    jobsBenchmark(out);
+    mathBenchmark(out);
+    ringBenchmark(out);
+    mapBenchmark(out);
+    cullingBenchmark(out);
+}
+
+void Tests::jobsBenchmark(std::ofstream &out)
+{
+    constexpr u32 runs = 10;
+
+    out << "===== Jobs =====\n";
+    out << "Workers: " << hk::jobs::workers() << '\n';
+
+    auto measure = [&](const std::string &name, const hk::jobs::RangeFunc &func, u32 count) {
+        hk::Clock clock;
+
+        clock.record();
+        for (u32 i = 0; i < runs; ++i) { func(0, count); }
+        f64 serial = clock.update() / runs;
+
+        for (u32 i = 0; i < runs; ++i) { hk::jobs::parallel_for(count, func); }
+        f64 parallel = clock.update() / runs;
+
+        out << std::left << std::setw(16) << name
+            << std::fixed << std::setprecision(6)
+            << " serial: " << serial << "s"
+            << " parallel: " << parallel << "s"
+            << " speedup: " << std::setprecision(2) << serial / parallel << "x\n";
+    };
+
+    /* ===== Scene Update ===== */
+    // Same work SceneGraph does per dirty node
+    constexpr u32 node_count = 200000;
+    hk::vector<Transform> locals(node_count);
+    hk::vector<hkm::mat4f> matrices(node_count);
+
+    for (u32 i = 0; i < node_count; ++i) {
+        locals[i].pos = { static_cast<f32>(i), 1.f, 2.f };
+        locals[i].rotation = hkm::fromAxisAngle({0, 1, 0}, i * .001f);
+    }
+
+    // Parents are filled up front, workers never read what others write
+    hk::vector<hkm::mat4f> parents(node_count);
+    for (u32 i = 0; i < node_count; ++i) { parents[i] = locals[i].toMat4f(); }
+
+    measure("Scene update", [&](u32 begin, u32 end) {
+        for (u32 i = begin; i < end; ++i) {
+            matrices[i] = locals[i].toMat4f() * parents[i / 2];
+        }
+    }, node_count);
+
+    /* ===== Mesh Processing ===== */
+    // Transform positions and recompute face normals of a triangle soup
+    constexpr u32 tri_count = 300000;
+    hk::vector<hkm::vec3f> positions(tri_count * 3);
+    hk::vector<hkm::vec3f> transformed(tri_count * 3);
+    hk::vector<hkm::vec3f> normals(tri_count);
+
+    for (u32 i = 0; i < positions.size(); ++i) {
+        positions[i] = { static_cast<f32>(i % 7), static_cast<f32>(i % 11), static_cast<f32>(i % 13) };
+    }
+
+    const hkm::mat4f model = locals[42].toMat4f();
+
+    measure("Mesh processing", [&](u32 begin, u32 end) {
+        for (u32 tri = begin; tri < end; ++tri) {
+            for (u32 v = tri * 3; v < tri * 3 + 3; ++v) {
+                hkm::vec4f p = model * hkm::vec4f(positions[v], 1.f);
+                transformed[v] = { p.x, p.y, p.z };
+            }
+
+            hkm::vec3f e0 = transformed[tri * 3 + 1] - transformed[tri * 3];
+            hkm::vec3f e1 = transformed[tri * 3 + 2] - transformed[tri * 3];
+            normals[tri] = hkm::normalize(hkm::cross(e0, e1));
+        }
+    }, tri_count);
+
+    /* ===== SceneGraph ===== */
+    hk::SceneGraph scene;
+    scene.init();
+
+    hk::SceneNode group;
+    for (u32 i = 0; i < node_count / 10; ++i) {
+        group.name = "Node";
+        scene.addNode(group);
+    }
+
+    hk::Clock clock;
+    clock.record();
+    for (u32 i = 0; i < runs; ++i) {
+        for (auto node : scene.root()->children) { node->setLocal(node->local()); }
+        scene.update();
+        scene.discardDrawChanges();
+    }
+    out << std::left << std::setw(16) << "SceneGraph"
+        << std::fixed << std::setprecision(6)
+        << " update: " << clock.update() / runs << "s\n";
+
+    scene.deinit();
+}
+
+void Tests::mathBenchmark(std::ofstream &out)
+{
+    constexpr u32 runs = 1000000;
+    constexpr u32 point_count = 4096;
+
+    out << "===== Math Kernels =====\n";
+
+    hkm::mat4f a = Transform({1.f, 2.f, 3.f}, {2.f, 2.f, 2.f},
+                             hkm::fromAxisAngle({0, 1, 0}, .5f)).toMat4f();
+    hkm::mat4f b = hkm::inverse(a);
+    hkm::quaternion q1 = hkm::fromAxisAngle({1, 0, 0}, .3f);
+    hkm::quaternion q2 = hkm::fromAxisAngle({0, 0, 1}, 1.3f);
+
+    hk::vector<hkm::vec3f> points(point_count);
+    for (u32 i = 0; i < point_count; ++i) {
+        points[i] = { static_cast<f32>(i), static_cast<f32>(i % 5), 1.f };
+    }
+
+    // Results are accumulated so compiler can't drop the loops
+    f32 sink = 0.f;
+
+    hk::Clock clock;
+    auto report = [&](const char *name, u32 ops) {
+        out << "  " << std::left << std::setw(18) << name
+            << std::fixed << std::setprecision(3)
+            << clock.update() * 1.0e9 / ops << " ns/op\n";
+    };
+
+    // Single value operators are inline and don't depend on level
+    out << "Inline\n";
+    clock.record();
+
+    hkm::mat4f m = a;
+    for (u32 j = 0; j < runs; ++j) { m = m * b; }
+    sink += m(0, 0);
+    report("mat4 x mat4", runs);
+
+    hkm::vec4f v(1.f, 2.f, 3.f, 1.f);
+    for (u32 j = 0; j < runs; ++j) { v = a * v; v.w = 1.f; }
+    sink += v.x;
+    report("mat4 x vec4", runs);
+
+    for (u32 j = 0; j < runs; ++j) { m = hkm::inverse(m); }
+    sink += m(0, 0);
+    report("mat4 inverse", runs);
+
+    hkm::quaternion q = q1;
+    for (u32 j = 0; j < runs; ++j) { q = q * q2; }
+    sink += q.x;
+    report("quat multiply", runs);
+
+    for (u32 j = 0; j < runs; ++j) { q = hkm::slerp(q, q2, .01f); }
+    sink += q.x;
+    report("quat slerp", runs);
+
+    hk::vector<hkm::mat4f> lhs(point_count, a);
+    hk::vector<hkm::mat4f> products(point_count);
+
+    const hkm::simd::Level best = hkm::simd::level();
+
+    for (u32 i = 0; i < static_cast<u32>(hkm::simd::Level::MAX_LEVELS); ++i) {
+        hkm::simd::Level level = static_cast<hkm::simd::Level>(i);
+        if (!hkm::simd::select(level)) { continue; }
+
+        out << hkm::simd::to_string(level) << '\n';
+        clock.record();
+
+        constexpr u32 batches = runs / point_count * 16;
+        for (u32 j = 0; j < batches; ++j) {
+            hkm::mul(lhs.data(), b, products.data(), point_count);
+        }
+        sink += products[7](0, 0);
+        report("batch mat4 x mat4", batches * point_count);
+
+        for (u32 j = 0; j < batches; ++j) {
+            hkm::transformPoints(a, points.data(), points.data(), point_count);
+            hkm::transformPoints(b, points.data(), points.data(), point_count);
+        }
+        sink += points[7].x;
+        report("transform points", batches * point_count * 2);
+    }
+
+    hkm::simd::select(best);
+
+    out << "(" << sink << ")\n";
+}
+
+void Tests::ringBenchmark(std::ofstream &out)
+{
+    constexpr u32 per_producer = 1000000;
+
+    out << "===== Rings =====\n";
+
+    // Mutex guarded ring_buffer is the baseline
+    struct LockedRing {
+        std::mutex mutex;
+        hk::ring_buffer<u64, 1024> ring;
+
+        b8 push(u64 value)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return ring.push(value);
+        }
+
+        b8 pop(u64 &value)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return ring.pop(value);
+        }
+    };
+
+    static LockedRing locked;
+    static hk::mpmc_ring<u64, 1024> mpmc;
+    static hk::spsc_ring<u64, 1024> spsc;
+
+    // Single consumer drains what producers push
+    auto measure = [&](const char *name, auto &ring, u32 producers) {
+        hk::Clock clock;
+        clock.record();
+
+        std::vector<std::thread> threads;
+        for (u32 p = 0; p < producers; ++p) {
+            threads.emplace_back([&]() {
+                for (u32 i = 0; i < per_producer; ++i) {
+                    while (!ring.push(i)) { std::this_thread::yield(); }
+                }
+            });
+        }
+
+        u64 value;
+        u64 sum = 0;
+        for (u32 received = 0; received < producers * per_producer;) {
+            if (ring.pop(value)) { sum += value; ++received; }
+        }
+
+        for (auto &thread : threads) { thread.join(); }
+
+        f64 time = clock.update();
+        out << std::left << std::setw(24) << name
+            << std::fixed << std::setprecision(2)
+            << producers * per_producer / time / 1.0e6 << " Mops/s"
+            << " (" << sum << ")\n";
+    };
+
+    measure("ring_buffer+mutex 1:1", locked, 1);
+    measure("spsc_ring 1:1", spsc, 1);
+    measure("mpmc_ring 1:1", mpmc, 1);
+    measure("ring_buffer+mutex 4:1", locked, 4);
+    measure("mpmc_ring 4:1", mpmc, 4);
+}
+
+void Tests::mapBenchmark(std::ofstream &out)
+{
+    constexpr u32 count = 200000;
+    constexpr u32 runs = 10;
+
+    out << "===== Maps =====\n";
+
+    // Same keys for both maps, misses are keys that were never inserted
+    hk::vector<u64> keys(count * 2);
+    hk::vector<std::string> names(count * 2);
+    for (u32 i = 0; i < keys.size(); ++i) {
+        keys[i] = hk::hash_mix(i);
+        names[i] = "..\\assets\\textures\\texture_" + std::to_string(keys[i]) + ".png";
+    }
+
+    // Results are accumulated so compiler can't drop the loops
+    u64 sink = 0;
+
+    auto measure = [&](const char *name, auto &map, const auto &keys) {
+        hk::Clock clock;
+        f64 insert = 0, hit = 0, miss = 0, erase = 0;
+
+        for (u32 run = 0; run < runs; ++run) {
+            clock.record();
+            for (u32 i = 0; i < count; ++i) { map[keys[i]] = i; }
+            insert += clock.update();
+
+            // Lookups don't follow insertion order in real use
+            for (u32 i = 0; i < count; ++i) {
+                sink += map.find(keys[(i * 7919ull) % count]) != map.end();
+            }
+            hit += clock.update();
+
+            for (u32 i = count; i < count * 2; ++i) { sink += map.find(keys[i]) != map.end(); }
+            miss += clock.update();
+
+            for (u32 i = 0; i < count; ++i) { map.erase(keys[i]); }
+            erase += clock.update();
+        }
+
+        auto report = [&](f64 time) { return time * 1.0e9 / (runs * count); };
+
+        out << std::left << std::setw(28) << name
+            << std::fixed << std::setprecision(2)
+            << " insert: " << report(insert) << "ns"
+            << " hit: " << report(hit) << "ns"
+            << " miss: " << report(miss) << "ns"
+            << " erase: " << report(erase) << "ns\n";
+    };
+
+    // flat_map::find returns pointer, adapter gives it same shape as std
+    struct FlatInts {
+        hk::flat_map<u64, u32> map;
+        u32& operator[](u64 key) { return map[key]; }
+        const u32* find(u64 key) const { return map.find(key); }
+        const u32* end() const { return nullptr; }
+        void erase(u64 key) { map.erase(key); }
+    };
+
+    struct FlatStrings {
+        hk::flat_map<std::string, u32> map;
+        u32& operator[](const std::string &key) { return map[key]; }
+        const u32* find(const std::string &key) const { return map.find(key); }
+        const u32* end() const { return nullptr; }
+        void erase(const std::string &key) { map.erase(key); }
+    };
+
+    std::unordered_map<u64, u32> std_ints;
+    FlatInts flat_ints;
+    std::unordered_map<std::string, u32> std_strings;
+    FlatStrings flat_strings;
+
+    measure("std::unordered_map<u64>", std_ints, keys);
+    measure("hk::flat_map<u64>", flat_ints, keys);
+    measure("std::unordered_map<string>", std_strings, names);
+    measure("hk::flat_map<string>", flat_strings, names);
+
+    out << "(" << sink << ")\n";
+}
+
+void Tests::cullingBenchmark(std::ofstream &out)
+{
+    constexpr u32 count = 100000;
+    constexpr u32 runs = 200;
+
+    out << "===== Frustum Culling =====\n";
+    out << count << " boxes\n";
+
+    hk::Camera camera;
+    camera.setPerspective(60.f, 16.f / 9.f, .1f, 200.f);
+    camera.setWorldOffset({ 0.f, 0.f, 0.f });
+    camera.update();
+
+    hkm::vec4f planes[6];
+    hkm::frustumPlanes(camera.viewProjection(), planes);
+
+    // Scattered around camera, so roughly a tenth of them is visible
+    hk::vector<f32> components[6];
+    for (auto &component : components) { component.resize(count); }
+
+    u32 seed = 7;
+    auto random = [&seed](f32 min, f32 max) {
+        seed = seed * 1664525u + 1013904223u;
+        return min + (max - min) * static_cast<f32>(seed >> 8) / static_cast<f32>(1u << 24);
+    };
+
+    for (u32 i = 0; i < count; ++i) {
+        for (u32 axis = 0; axis < 3; ++axis) {
+            components[axis][i] = random(-200.f, 200.f);
+            components[axis + 3][i] = random(.1f, 2.f);
+        }
+    }
+
+    hkm::AABBArrays boxes;
+    for (u32 axis = 0; axis < 3; ++axis) {
+        boxes.center[axis] = components[axis].data();
+        boxes.extent[axis] = components[axis + 3].data();
+    }
+
+    hk::vector<u32> visible(count);
+    u32 sink = 0;
+
+    const hkm::simd::Level best = hkm::simd::level();
+
+    for (u32 i = 0; i < static_cast<u32>(hkm::simd::Level::MAX_LEVELS); ++i) {
+        hkm::simd::Level level = static_cast<hkm::simd::Level>(i);
+        if (!hkm::simd::select(level)) { continue; }
+
+        hk::Clock clock;
+        clock.record();
+
+        u32 passed = 0;
+        for (u32 j = 0; j < runs; ++j) {
+            passed = hkm::cullAABBs(planes, boxes, count, visible.data());
+            sink += visible[passed / 2];
+        }
+
+        out << "  " << std::left << std::setw(18) << hkm::simd::to_string(level)
+            << std::fixed << std::setprecision(3)
+            << clock.update() * 1.0e3 / runs << " ms/frame, "
+            << passed << " visible\n";
+    }
+
+    hkm::simd::select(best);
+
+    // Same boxes in hierarchy, only visible part of the tree is visited
+    hk::bvh tree;
+
+    hk::Clock clock;
+    clock.record();
+
+    for (u32 i = 0; i < count; ++i) {
+        const hkm::vec3f center(components[0][i], components[1][i], components[2][i]);
+        const hkm::vec3f extent(components[3][i], components[4][i], components[5][i]);
+        tree.insert(hkm::aabb(center - extent, center + extent), i);
+    }
+    const f64 inserted = clock.update() * 1.0e3;
+
+    tree.rebuild();
+    const f64 rebuilt = clock.update() * 1.0e3;
+
+    out << "  " << std::left << std::setw(18) << "BVH insert"
+        << std::fixed << std::setprecision(3) << inserted << " ms, cost " << tree.cost() << "\n";
+    out << "  " << std::left << std::setw(18) << "BVH rebuild"
+        << std::fixed << std::setprecision(3) << rebuilt << " ms, cost " << tree.cost() << "\n";
+
+    u32 passed = 0;
+    for (u32 j = 0; j < runs; ++j) {
+        passed = 0;
+        tree.query(planes, [&](u32 idx) { visible[passed++] = idx; });
+        sink += visible[passed / 2];
+    }
+
+    out << "  " << std::left << std::setw(18) << "BVH query"
+        << std::fixed << std::setprecision(3)
+        << clock.update() * 1.0e3 / runs << " ms/frame, "
+        << passed << " visible\n";
+
+    out << "(" << sink << ")\n";
 }
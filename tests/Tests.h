@@ -3,6 +3,8 @@
 
 #include "hikai.h"
 
+#include <fstream>
+
 class Tests final : public Application {
 public:
     Tests(const AppDesc &desc)
@@ -18,6 +20,22 @@ private:
     void containersTests();
     void numericsTests();
     void stringsTests();
+    void loggerTests();
+    void resourcesTests();
+
+    // Core
+    void jobsTests();
+    void eventsTests();
+    void profilerTests();
+    void ecsTests();
+
+    // Timings are written to benchmarks.txt, never fail
+    void benchmarks();
+    void jobsBenchmark(std::ofstream &out);
+    void mathBenchmark(std::ofstream &out);
+    void ringBenchmark(std::ofstream &out);
+    void mapBenchmark(std::ofstream &out);
+    void cullingBenchmark(std::ofstream &out);
 };
 
 #endif // HK_TESTS_H
@@ -9,5 +9,10 @@ Application* create_app()
     desc.width = 0;
     desc.height = 0;
 
+#ifdef HKLINUX
+    // No windowing backend on Linux yet
+    desc.headless = true;
+#endif
+
     return new Tests(desc);
 }